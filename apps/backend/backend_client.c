@@ -71,6 +71,7 @@
 #include "backend_handle.h"
 #include "backend_get.h"
 #include "backend_client.h"
+#include "backend_sched.h"
 
 /*! Find client by session-id 
  *
@@ -126,6 +127,113 @@ ce_client_descr(struct client_entry *ce,
     return retval;
 }
 
+#ifdef BACKEND_OUTPUT_QUEUE
+/*! Local client socket is writable: send queued output
+ *
+ * @param[in]  s    Socket
+ * @param[in]  arg  Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+backend_client_output(int   s,
+                      void *arg)
+{
+    struct client_entry *ce = (struct client_entry *)arg;
+    int                  ret;
+
+    if ((ret = clixon_msg_snd_flush(s, ce->ce_snd)) < 0)
+        return -1;
+    if (ret == 1) /* All sent */
+        clixon_event_unreg_fd(s, backend_client_output);
+    return 0;
+}
+
+/*! Queue message to a local client and send as much as possible without blocking
+ *
+ * Output that cannot be sent is kept in the output queue of the client and sent when the
+ * socket is writable, so that a slow client does not block the backend.
+ * If the client has not read earlier output:
+ * - A notification is dropped if the queue exceeds CLICON_SOCK_NOTIFY_HIGHWATER
+ * - The client is disconnected if the queue exceeds CLICON_SOCK_OUTPUT_HIGHWATER
+ * @param[in]  h      Clixon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  cb     Message
+ * @param[in]  notify Message is a notification
+ * @retval     1      Queued or sent
+ * @retval     0      Notification dropped
+ * @retval    -1      Error
+ * @see BACKEND_OUTPUT_QUEUE
+ */
+static int
+backend_client_send(clixon_handle        h,
+                    struct client_entry *ce,
+                    cbuf                *cb,
+                    int                  notify)
+{
+    int    retval = -1;
+    cbuf  *cbce = NULL;
+    size_t qlen;
+    size_t len;
+    int    max;
+    int    fdpass = 0;
+    int    ret;
+
+    if (ce->ce_snd == NULL &&
+        (ce->ce_snd = clixon_msg_snd_new()) == NULL)
+        goto done;
+    qlen = clixon_msg_snd_len(ce->ce_snd);
+    if (notify && qlen > 0 &&
+        (max = clicon_option_int(h, "CLICON_SOCK_NOTIFY_HIGHWATER")) > 0 &&
+        qlen >= max){
+        if (ce->ce_out_dropping++ == 0)
+            clixon_log(h, LOG_WARNING, "client %d: %zu bytes output queued, dropping notifications",
+                       ce->ce_nr, qlen);
+        ce->ce_out_notifications_dropped++;
+        retval = 0;
+        goto done;
+    }
+    if (notify && ce->ce_out_dropping){
+        clixon_log(h, LOG_NOTICE, "client %d: %d notifications dropped", ce->ce_nr, ce->ce_out_dropping);
+        ce->ce_out_dropping = 0;
+    }
+    if (ce_client_descr(ce, &cbce) < 0)
+        goto done;
+#ifdef PROTO_MSG_FD
+    /* Large reply to local client as file descriptor */
+    fdpass = !notify && ce->ce_msg_fd && cbuf_len(cb) >= PROTO_MSG_FD;
+#endif
+    /* Same framing as send_msg_reply: replies on the socket include null termination,
+     * notifications and replies passed as file descriptor do not */
+    len = cbuf_len(cb);
+    if (!notify && !fdpass)
+        len++;
+    if (clixon_msg_snd_add(ce->ce_snd, cbuf_get(cbce), cbuf_get(cb), len, fdpass) < 0)
+        goto done;
+    if (qlen == 0){ /* Not waiting for socket to be writable */
+        if ((ret = clixon_msg_snd_flush(ce->ce_s, ce->ce_snd)) < 0)
+            goto done;
+        if (ret == 0 &&
+            clixon_event_reg_fd_write(ce->ce_s, backend_client_output, ce, "local netconf client output") < 0)
+            goto done;
+    }
+    else if ((max = clicon_option_int(h, "CLICON_SOCK_OUTPUT_HIGHWATER")) > 0 &&
+             clixon_msg_snd_len(ce->ce_snd) > max){
+        clixon_log(h, LOG_WARNING, "client %d: %zu bytes output queued, disconnecting",
+                   ce->ce_nr, clixon_msg_snd_len(ce->ce_snd));
+        clixon_event_unreg_fd(ce->ce_s, backend_client_output);
+        clixon_msg_snd_reset(ce->ce_snd);
+        /* Client is removed on EOF, see from_client */
+        shutdown(ce->ce_s, SHUT_RDWR);
+    }
+    retval = 1;
+ done:
+    if (cbce)
+        cbuf_free(cbce);
+    return retval;
+}
+#endif /* BACKEND_OUTPUT_QUEUE */
+
 /*! Stream callback for netconf stream notification (RFC 5277)
  *
  * @param[in]  h     Clixon handle
@@ -145,6 +253,10 @@ ce_event_cb(clixon_handle h,
     int                  retval = -1;
     struct client_entry *ce = (struct client_entry *)arg;
     cbuf                *cbce = NULL;
+#ifdef BACKEND_OUTPUT_QUEUE
+    cbuf                *cb = NULL;
+    int                  ret;
+#endif
 
     clixon_debug(CLIXON_DBG_BACKEND, "op:%d", op);
     switch (op){
@@ -154,6 +266,18 @@ ce_event_cb(clixon_handle h,
             backend_client_rm(h, ce);
         break;
     default:
+#ifdef BACKEND_OUTPUT_QUEUE
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if (clixon_xml2cbuf(cb, event, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        if ((ret = backend_client_send(h, ce, cb, 1)) < 0)
+            goto done;
+        if (ret == 0) /* Dropped */
+            break;
+#else
         if (ce_client_descr(ce, &cbce) < 0)
             goto done;
         if (send_msg_notify_xml(h, ce->ce_s, cbuf_get(cbce), event) < 0){
@@ -162,12 +286,17 @@ ce_event_cb(clixon_handle h,
             }
             break;
         }
+#endif
         /* note there may be other notifications than RFC5277 streams */
         ce->ce_out_notifications++;
         netconf_monitoring_counter_inc(h, "out-notifications");
     }
     retval = 0;
  done:
+#ifdef BACKEND_OUTPUT_QUEUE
+    if (cb)
+        cbuf_free(cb);
+#endif
     if (cbce)
         cbuf_free(cbce);
     return retval;
@@ -281,6 +410,16 @@ backend_monitoring_state_get(clixon_handle h,
         cprintf(cb, "<in-bad-rpcs>%u</in-bad-rpcs>", ce->ce_in_bad_rpcs);
         cprintf(cb, "<out-rpc-errors>%u</out-rpc-errors>", ce->ce_out_rpc_errors);
         cprintf(cb, "<out-notifications>%u</out-notifications>", ce->ce_out_notifications);
+#ifdef BACKEND_OUTPUT_QUEUE
+        cprintf(cb, "<out-queued-bytes xmlns=\"%s\">%zu</out-queued-bytes>",
+                CLIXON_LIB_NS, ce->ce_snd ? clixon_msg_snd_len(ce->ce_snd) : 0);
+        cprintf(cb, "<out-notifications-dropped xmlns=\"%s\">%u</out-notifications-dropped>",
+                CLIXON_LIB_NS, ce->ce_out_notifications_dropped);
+#endif
+#ifdef BACKEND_SCHED
+        if (backend_sched_state(h, ce, cb) < 0)
+            goto done;
+#endif
         cprintf(cb, "</session>");
     }
     cprintf(cb, "</sessions>");
@@ -343,12 +482,20 @@ backend_client_rm(clixon_handle        h,
     clixon_debug(CLIXON_DBG_BACKEND, "");
     /* for all streams: XXX better to do it top-level? */
     stream_ss_delete_all(h, ce_event_cb, (void*)ce);
+#ifdef BACKEND_SCHED
+    backend_sched_rm(h, ce);
+#endif
     c0 = backend_client_list(h);
     ce_prev = &c0; /* this points to stack and is not real backpointer */
     for (c = *ce_prev; c; c = c->ce_next){
         if (c == ce){
             if (ce->ce_s){
-                clixon_event_unreg_fd(ce->ce_s, from_client);
+                if (!ce->ce_paused)
+                    clixon_event_unreg_fd(ce->ce_s, from_client);
+#ifdef BACKEND_OUTPUT_QUEUE
+                if (ce->ce_snd && clixon_msg_snd_len(ce->ce_snd))
+                    clixon_event_unreg_fd(ce->ce_s, backend_client_output);
+#endif
                 close(ce->ce_s);
                 ce->ce_s = 0;
                 if (release_all_dbs(h, ce->ce_id) < 0)
@@ -1480,6 +1627,20 @@ from_client_stats(clixon_handle h,
     nr=0;
     yang_stats_global(&nr);
     cprintf(cbret, "<yangnr>%" PRIu64 "</yangnr>", nr);
+#ifdef XPATH_CACHE_SIZE
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+
+        nr = 0;
+        xpath_cache_stats(&hits, &misses, &nr);
+        cprintf(cbret, "<xpath-cache>");
+        cprintf(cbret, "<nr>%" PRIu64 "</nr>", nr);
+        cprintf(cbret, "<hits>%" PRIu64 "</hits>", hits);
+        cprintf(cbret, "<misses>%" PRIu64 "</misses>", misses);
+        cprintf(cbret, "</xpath-cache>");
+    }
+#endif
     cprintf(cbret, "</global>");
     cprintf(cbret, "<datastores xmlns=\"%s\">", CLIXON_LIB_NS);
     if (clixon_stats_datastore_get(h, "running", cbret) < 0)
@@ -1636,12 +1797,19 @@ from_client_hello(clixon_handle       h,
 {
     int      retval = -1;
     char    *val;
+#if defined(PROTO_XML_BINARY) || defined(PROTO_MSG_FD)
+    cxobj   *xcaps;
+    cxobj   *xc = NULL;
+#endif
 
     if ((val = xml_find_type_value(x, "cl", "transport", CX_ATTR)) != NULL){
         if ((ce->ce_transport = strdup(val)) == NULL){
             clixon_err(OE_UNIX, errno, "strdup");
             goto done;
         }
+#ifdef BACKEND_SCHED
+        ce->ce_sched_weight = 0; /* Weight may depend on transport */
+#endif
     }
     if ((val = xml_find_type_value(x, "cl", "source-host", CX_ATTR)) != NULL){
         if ((ce->ce_source_host = strdup(val)) == NULL){
@@ -1649,13 +1817,95 @@ from_client_hello(clixon_handle       h,
             goto done;
         }
     }
-    cprintf(cbret, "<hello xmlns=\"%s\"><session-id>%u</session-id></hello>",
-            NETCONF_BASE_NAMESPACE, ce->ce_id);
+#if defined(PROTO_XML_BINARY) || defined(PROTO_MSG_FD)
+    /* Internal capabilities the client asks for */
+    if ((xcaps = xml_find_type(x, NULL, "capabilities", CX_ELMNT)) != NULL)
+        while ((xc = xml_child_each(xcaps, xc, CX_ELMNT)) != NULL){
+            if ((val = xml_body(xc)) == NULL)
+                continue;
+#ifdef PROTO_XML_BINARY
+            if (strcmp(val, CLIXON_XML_BIN_CAPABILITY) == 0)
+                ce->ce_xml_binary = 1;
+#endif
+#ifdef PROTO_MSG_FD
+            if (strcmp(val, CLIXON_MSG_FD_CAPABILITY) == 0 &&
+                clicon_sock_family(h) == AF_UNIX)
+                ce->ce_msg_fd = 1;
+#endif
+        }
+#endif
+    cprintf(cbret, "<hello xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    if (ce->ce_xml_binary || ce->ce_msg_fd){
+        cprintf(cbret, "<capabilities>");
+        if (ce->ce_xml_binary)
+            cprintf(cbret, "<capability>%s</capability>", CLIXON_XML_BIN_CAPABILITY);
+        if (ce->ce_msg_fd)
+            cprintf(cbret, "<capability>%s</capability>", CLIXON_MSG_FD_CAPABILITY);
+        cprintf(cbret, "</capabilities>");
+    }
+    cprintf(cbret, "<session-id>%u</session-id></hello>", ce->ce_id);
     retval = 0;
  done:
     return retval;
 }
 
+/*! Send reply to a local client
+ *
+ * @param[in]   h      Clixon handle
+ * @param[in]   ce     Client entry
+ * @param[in]   cbret  Reply message
+ * @retval      0      OK, also if client has closed the socket
+ * @retval     -1      Error
+ */
+int
+backend_client_reply(clixon_handle        h,
+                     struct client_entry *ce,
+                     cbuf                *cbret)
+{
+    int   retval = -1;
+#ifdef BACKEND_OUTPUT_QUEUE
+    if (backend_client_send(h, ce, cbret, 0) < 0)
+        goto done;
+#else
+    cbuf *cbce = NULL;
+    int   ret;
+
+    if (ce_client_descr(ce, &cbce) < 0)
+        goto done;
+#ifdef PROTO_MSG_FD
+    /* Large reply to local client as file descriptor */
+    if (ce->ce_msg_fd && cbuf_len(cbret) >= PROTO_MSG_FD)
+        ret = send_msg_reply_fd(ce->ce_s, cbuf_get(cbce), cbuf_get(cbret), cbuf_len(cbret)+1);
+    else
+#endif
+    ret = send_msg_reply(ce->ce_s, cbuf_get(cbce), cbuf_get(cbret), cbuf_len(cbret)+1);
+    if (ret < 0){
+        switch (errno){
+        case EPIPE:
+            /* man (2) write: 
+             * EPIPE  fd is connected to a pipe or socket whose reading end is 
+             * closed.  When this happens the writing process will also receive 
+             * a SIGPIPE signal. 
+             * In Clixon this means a client, eg restconf, netconf or cli closes
+             * the (UNIX domain) socket.
+             */
+        case ECONNRESET:
+            clixon_log(h, LOG_WARNING, "client rpc reset");
+            break;
+        default:
+            goto done;
+        }
+    }
+#endif /* BACKEND_OUTPUT_QUEUE */
+    retval = 0;
+ done:
+#ifndef BACKEND_OUTPUT_QUEUE
+    if (cbce)
+        cbuf_free(cbce);
+#endif
+    return retval;
+}
+
 /*! An internal clixon NETCONF message has arrived from a local client. Receive and dispatch.
  *
  * @param[in]   h    Clixon handle
@@ -1689,7 +1939,6 @@ from_client_msg(clixon_handle        h,
     char                *rpcprefix;
     char                *namespace = NULL;
     int                  nr = 0;
-    cbuf                *cbce = NULL;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     yspec = clicon_dbspec_yang(h);
@@ -1895,6 +2144,13 @@ from_client_msg(clixon_handle        h,
         }
     } /* while */
  reply:
+#ifdef BACKEND_READ_THREADS
+    /* Reply is sent when the read worker is done */
+    if (ce->ce_read_pending && cbuf_len(cbret) == 0){
+        retval = 0;
+        goto done;
+    }
+#endif
     if (cbuf_len(cbret) == 0)
         if (netconf_operation_failed(cbret, "application",
                                      clixon_err_category()?clixon_err_reason():"unknown")< 0)
@@ -1902,25 +2158,8 @@ from_client_msg(clixon_handle        h,
     // XXX    clixon_debug(CLIXON_DBG_MSG, "Reply:%s", cbuf_get(cbret));
     /* XXX problem here is that cbret has not been parsed so may contain 
        parse errors */
-    if (ce_client_descr(ce, &cbce) < 0)
+    if (backend_client_reply(h, ce, cbret) < 0)
         goto done;
-    if (send_msg_reply(ce->ce_s, cbuf_get(cbce), cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
-        switch (errno){
-        case EPIPE:
-            /* man (2) write: 
-             * EPIPE  fd is connected to a pipe or socket whose reading end is 
-             * closed.  When this happens the writing process will also receive 
-             * a SIGPIPE signal. 
-             * In Clixon this means a client, eg restconf, netconf or cli closes
-             * the (UNIX domain) socket.
-             */
-        case ECONNRESET:
-            clixon_log(h, LOG_WARNING, "client rpc reset");
-            break;
-        default:
-            goto done;
-        }
-    }
     // ok:
     retval = 0;
   done:
@@ -1934,8 +2173,6 @@ from_client_msg(clixon_handle        h,
         xml_free(xret);
     if (xt)
         xml_free(xt);
-    if (cbce)
-        cbuf_free(cbce);
     if (cbret)
         cbuf_free(cbret);
     /* Sanity: log if clixon_err() is not called ! */
@@ -1946,9 +2183,88 @@ from_client_msg(clixon_handle        h,
     return retval;// -1 here terminates backend
 }
 
+/*! Handle one request from a client and send the reply
+ *
+ * @param[in]   h    Clixon handle
+ * @param[in]   ce   Client entry
+ * @param[in]   msg  Request message
+ * @retval      1    OK
+ * @retval      0    OK, client is removed by the request, eg kill-session
+ * @retval     -1    Error
+ */
+int
+backend_client_request(clixon_handle        h,
+                       struct client_entry *ce,
+                       char                *msg)
+{
+    struct client_entry *c;
+
+    if (from_client_msg(h, ce, msg) < 0)
+        return -1;
+    for (c = backend_client_list(h); c && c != ce; c = c->ce_next);
+    return c != NULL;
+}
+
+/*! Stop reading requests from a client
+ *
+ * @param[in]   ce   Client entry
+ * @retval      0    OK
+ * @see backend_client_resume
+ */
+int
+backend_client_pause(struct client_entry *ce)
+{
+    if (ce->ce_paused)
+        return 0;
+    clixon_event_unreg_fd(ce->ce_s, from_client);
+    ce->ce_paused = 1;
+    return 0;
+}
+
+/*! Read requests from a client again, unless a reply is pending or requests are queued
+ *
+ * Requests already received are handled directly.
+ * A client that has closed its socket is removed when its queued requests are done
+ * @param[in]   h    Clixon handle
+ * @param[in]   ce   Client entry
+ * @retval      0    OK
+ * @retval     -1    Error
+ * @see backend_client_pause
+ */
+int
+backend_client_resume(clixon_handle        h,
+                      struct client_entry *ce)
+{
+    if (!ce->ce_paused)
+        return 0;
+#ifdef BACKEND_READ_THREADS
+    if (ce->ce_read_pending)
+        return 0;
+#endif
+#ifdef BACKEND_SCHED
+    if (ce->ce_sched_q != NULL)
+        return backend_sched_kick(h);
+    if (ce->ce_sched_eof){
+        backend_client_rm(h, ce);
+        netconf_monitoring_counter_inc(h, "dropped-sessions");
+        return 0;
+    }
+#endif
+    if (clixon_event_reg_fd_prio(ce->ce_s, from_client, (void*)ce, "local netconf client socket",
+                                 clicon_option_bool(h, "CLICON_SOCK_PRIO")) < 0)
+        return -1;
+    ce->ce_paused = 0;
+    if (clixon_msg_rcv_pending(ce->ce_rcv) &&
+        from_client(ce->ce_s, ce) < 0)
+        return -1;
+    return 0;
+}
+
 /*! Internal clixon message has arrived from a client. Receive and dispatch.
  *
  * Internal clixon is NETCONF 1.1 chunked encoding
+ * A client may send several requests without waiting for the replies. All complete requests
+ * read are handled in order, and a partial request is kept until more data arrives.
  * @param[in]   s    Socket where message arrived. read from this.
  * @param[in]   arg  Client entry (from).
  * @retval      0    OK
@@ -1965,6 +2281,7 @@ from_client(int   s,
     int                  eof = 0;
     cbuf                *cbce = NULL;
     cbuf                *cb = NULL;
+    int                  ret;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     if (s != ce->ce_s){
@@ -1973,14 +2290,55 @@ from_client(int   s,
     }
     if (ce_client_descr(ce, &cbce) < 0)
         goto done;
-    if (clixon_msg_rcv11(s, cbuf_get(cbce), 0, &cb, &eof) < 0) /* XXX why not descr here? */
-        goto done;
-    if (eof){
-        backend_client_rm(h, ce);
-        netconf_monitoring_counter_inc(h, "dropped-sessions");
-    }
-    else if (from_client_msg(h, ce, cbuf_get(cb)) < 0)
+    if (ce->ce_rcv == NULL &&
+        (ce->ce_rcv = clixon_msg_rcv_new(0)) == NULL)
         goto done;
+    do {
+        if (clixon_msg_rcv_next(s, cbuf_get(cbce), ce->ce_rcv, &cb, &eof) < 0)
+            goto done;
+        if (eof){
+#ifdef BACKEND_SCHED
+            /* Requests read before eof, eg a final commit, are run before the client is
+             * removed, see backend_client_resume */
+            if (ce->ce_sched_q != NULL){
+                ce->ce_sched_eof = 1;
+                backend_client_pause(ce);
+                break;
+            }
+#endif
+            backend_client_rm(h, ce);
+            netconf_monitoring_counter_inc(h, "dropped-sessions");
+            break;
+        }
+        if (cb == NULL) /* Partial request */
+            break;
+#ifdef BACKEND_SCHED
+        /* Request is dispatched by the scheduler */
+        ret = backend_sched_add(h, ce, cb);
+        cb = NULL;
+        if (ret < 0)
+            goto done;
+#else
+        if ((ret = backend_client_request(h, ce, cbuf_get(cb))) < 0)
+            goto done;
+        cbuf_free(cb);
+        cb = NULL;
+        if (ret == 0) /* Client removed */
+            break;
+#ifdef BACKEND_READ_THREADS
+        /* Keep order of replies: do not read more requests until the reply is sent */
+        if (ce->ce_read_pending){
+            backend_client_pause(ce);
+            break;
+        }
+#endif
+#endif /* BACKEND_SCHED */
+    } while (clixon_msg_rcv_pending(ce->ce_rcv));
+#ifdef BACKEND_SCHED
+    /* Do not read more requests until the queued requests are dispatched */
+    if (!eof && ce->ce_sched_q != NULL)
+        backend_client_pause(ce);
+#endif
     retval = 0;
   done:
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "retval:%d", retval);
@@ -42,6 +42,10 @@
  */
 int backend_monitoring_state_get(clixon_handle h, yang_stmt *yspec, char *xpath, cvec *nsc, cxobj **xret, cxobj **xerr);
 int backend_client_rm(clixon_handle h, struct client_entry *ce);
+int backend_client_reply(clixon_handle h, struct client_entry *ce, cbuf *cbret);
+int backend_client_pause(struct client_entry *ce);
+int backend_client_resume(clixon_handle h, struct client_entry *ce);
+int backend_client_request(clixon_handle h, struct client_entry *ce, char *msg);
 int from_client(int fd, void *arg);
 int backend_rpc_init(clixon_handle h);
 
@@ -1170,8 +1170,13 @@ system_only_data_add(clixon_handle h,
             goto done;
         if (xml_child_nr(x)){
             db_elmnt *de;
-            if ((de = clicon_db_elmnt_get(h, db)) != NULL)
-                de->de_xml = x;
+            db_elmnt  de0;
+            if ((de = clicon_db_elmnt_get(h, db)) != NULL){
+                de0 = *de;
+                de0.de_xml = x;
+                if (clicon_db_elmnt_set(h, db, &de0) < 0)
+                    goto done;
+            }
         }
         else
             xml_free(x);
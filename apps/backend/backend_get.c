@@ -71,6 +71,7 @@
 #include "backend_client.h"
 #include "backend_handle.h"
 #include "backend_get.h"
+#include "backend_read.h"
 
 /*! Restconf get capabilities
  *
@@ -391,6 +392,7 @@ filter_xpath_again(clixon_handle h,
  * @param[in]  username User name for NACM access
  * @param[in]  depth    Nr of levels to print, -1 is all, 0 is none
  * @param[in]  wdef     With-defaults parameter
+ * @param[in]  ce       Client entry, binary XML reply if negotiated
  * @param[out] cbret    Return xml tree, eg <rpc-reply>..., <rpc-error..
  * @retval     0        OK
  * @retval    -1        Error
@@ -405,18 +407,58 @@ get_nacm_and_reply(clixon_handle        h,
                    char                *username,
                    int32_t              depth,
                    withdefaults_type    wdef,
+                   struct client_entry *ce,
                    cbuf                *cbret)
 {
-    int     retval = -1;
-    cxobj  *xnacm = NULL;
+    int               retval = -1;
+    cxobj            *xnacm = NULL;
+    nacm_read_filter *nf = NULL;
 
     /* Pre-NACM access step */
     xnacm = clicon_nacm_cache(h);
     if (xnacm != NULL){ /* Do NACM validation */
+#ifdef NACM_READ_FILTER
+        /* NACM datanode/module read validation when printing */
+        if (xret != NULL && username != NULL){
+            if (nacm_read_filter_new(h, xret, username, xnacm, &nf) < 0)
+                goto done;
+        }
+        else
+#endif
         /* NACM datanode/module read validation */
         if (nacm_datanode_read(h, xret, xvec, xlen, username, xnacm) < 0)
             goto done;
     }
+#ifdef PROTO_XML_BINARY
+    /* Binary XML tree reply to frontends, tagged with-defaults is only in text */
+    if (ce != NULL && ce->ce_xml_binary && cbuf_len(cbret) == 0 &&
+        wdef != WITHDEFAULTS_REPORT_ALL_TAGGED){
+        if (clixon_xml2bin_start(cbret) < 0)
+            goto done;
+        if (clixon_xml2bin_elmnt(cbret, NULL, "rpc-reply") < 0)
+            goto done;
+        if (clixon_xml2bin_attr(cbret, NULL, "xmlns", NETCONF_BASE_NAMESPACE) < 0)
+            goto done;
+        if (xret == NULL){
+            if (clixon_xml2bin_elmnt(cbret, NULL, NETCONF_OUTPUT_DATA) < 0)
+                goto done;
+            if (clixon_xml2bin_end(cbret) < 0)
+                goto done;
+        }
+        else {
+            if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
+                goto done;
+            /* Top level is data, so add 1 to depth if significant */
+            if (clixon_xml2bin(cbret, xret, depth>0?depth+1:depth, wdef,
+                               nf?nacm_read_filter_fn:NULL, nf) < 0)
+                goto done;
+        }
+        if (clixon_xml2bin_end(cbret) < 0)
+            goto done;
+        retval = 0;
+        goto done;
+    }
+#endif
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);     /* OK */
     if (xret==NULL)
         cprintf(cbret, "<data/>");
@@ -424,12 +466,19 @@ get_nacm_and_reply(clixon_handle        h,
         if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
             goto done;
         /* Top level is data, so add 1 to depth if significant */
-        if (clixon_xml2cbuf1(cbret, xret, 0, 0, NULL, depth>0?depth+1:depth, 0, wdef) < 0)
+        if (nf != NULL){
+            if (clixon_xml2cbuf_filter(cbret, xret, 0, 0, NULL, depth>0?depth+1:depth, 0, wdef,
+                                       nacm_read_filter_fn, nf) < 0)
+                goto done;
+        }
+        else if (clixon_xml2cbuf1(cbret, xret, 0, 0, NULL, depth>0?depth+1:depth, 0, wdef) < 0)
             goto done;
     }
     cprintf(cbret, "</rpc-reply>");
     retval = 0;
  done:
+    if (nf)
+        nacm_read_filter_free(nf);
     return retval;
 }
 
@@ -905,7 +954,7 @@ get_list_pagination(clixon_handle        h,
             cbuf_free(cba);
     }
 #endif /* LIST_PAGINATION_REMAINING */
-    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, cbret) < 0)
+    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, ce, cbret) < 0)
         goto done;
  ok:
     retval = 0;
@@ -1032,6 +1081,17 @@ get_common(clixon_handle        h,
             goto ok;
         }
     }
+#ifdef BACKEND_READ_THREADS
+    /* Whole running config without NACM: print from snapshot in read worker thread */
+    if (content == CONTENT_CONFIG && strcmp(db, "running") == 0 &&
+        (xpath == NULL || strcmp(xpath, "/") == 0) &&
+        wdef == WITHDEFAULTS_EXPLICIT && clicon_nacm_cache(h) == NULL){
+        if ((ret = backend_read_submit(h, ce, depth)) < 0)
+            goto done;
+        if (ret == 1) /* Reply is sent when done */
+            goto ok;
+    }
+#endif
     /* Read configuration */
     switch (content){
     case CONTENT_CONFIG:    /* config data only */
@@ -1158,7 +1218,7 @@ get_common(clixon_handle        h,
         goto done;
     if (filter_xpath_again(h, yspec, xret, xvec, xlen, xpath, nsc) < 0)
         goto done;
-    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, cbret) < 0)
+    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, ce, cbret) < 0)
         goto done;
  ok:
     retval = 0;
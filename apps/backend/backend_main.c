@@ -77,6 +77,8 @@
 #include "backend_handle.h"
 #include "backend_startup.h"
 #include "backend_plugin_restconf.h"
+#include "backend_read.h"
+#include "backend_sched.h"
 
 /* Command line options to be passed to getopt(3) */
 #define BACKEND_OPTS "hVD:f:E:l:C:d:p:b:Fza:u:P:1qs:c:U:g:y:o:"
@@ -102,6 +104,13 @@ backend_terminate(clixon_handle h)
     clixon_debug(CLIXON_DBG_BACKEND, "");
     if ((ss = clicon_socket_get(h)) != -1)
         close(ss);
+#ifdef BACKEND_READ_THREADS
+    /* Stop read workers before datastore is freed */
+    backend_read_exit(h);
+#endif
+#ifdef BACKEND_SCHED
+    backend_sched_exit(h);
+#endif
     /* Disconnect datastore */
     xmldb_disconnect(h);
     /* Clear module state caches */
@@ -118,6 +127,7 @@ backend_terminate(clixon_handle h)
     clicon_data_cvec_del(h, "netconf-statistics");
     if ((x = clicon_nacm_ext(h)) != NULL)
         xml_free(x);
+    nacm_compiled_exit();
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     confirmed_commit_free(h);
@@ -128,6 +138,7 @@ backend_terminate(clixon_handle h)
     clixon_process_delete_all(h); 
 
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_pagination_free(h);
     
     if (pidfile)
@@ -529,6 +540,7 @@ main(int    argc,
     enum format_enum config_dump_format = FORMAT_XML;
     int           print_version = 0;
     int32_t       d;
+    int           ycache;
     
     /* Initiate CLICON handle */
     if ((h = backend_handle_init()) == NULL)
@@ -746,6 +758,12 @@ main(int    argc,
         clixon_err(OE_FATAL, 0, "CLICON_YANG_REGEXP set to libxml2, but HAVE_LIBXML2 not set (Either change CLICON_YANG_REGEXP to posix, or run: configure --with-libxml2))");
         goto done;
     }
+#endif
+#ifndef HAVE_LIBPCRE2_8
+    if (clicon_yang_regexp(h) ==  REGEXP_PCRE2){
+        clixon_err(OE_FATAL, 0, "CLICON_YANG_REGEXP set to pcre2, but HAVE_LIBPCRE2_8 not set (Either change CLICON_YANG_REGEXP to posix, or run: configure --with-pcre2))");
+        goto done;
+    }
 #endif
     /* Check pid-file, if zap kil the old daemon, else return here */
     if ((pidfile = clicon_backend_pidfile(h)) == NULL){
@@ -845,6 +863,9 @@ main(int    argc,
             goto done;
         goto ok;
     }
+    /* Load precompiled yang spec if CLICON_YANG_CACHE_DIR is set, loading below is then no-op */
+    if ((ycache = yang_spec_cache_load(h, "backend", yspec)) < 0)
+        goto done;
     /* Load Yang modules
      * 1. Load a yang module as a specific absolute filename */
     if ((str = clicon_yang_main_file(h)) != NULL)
@@ -884,6 +905,9 @@ main(int    argc,
     /* Here all modules are loaded 
      * Compute and set canonical namespace context
      */
+    if (ycache == 0 &&
+        yang_spec_cache_save(h, "backend", yspec) < 0)
+        goto done;
     if (xml_nsctx_yangspec(yspec, &nsctx_global) < 0)
         goto done;
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
@@ -0,0 +1,506 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2020-2025 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Backend read worker threads, see BACKEND_READ_THREADS
+ *
+ * get-config of the whole running datastore is printed by worker threads from an immutable
+ * snapshot of running, so that a large reply does not block other clients.
+ * The main thread creates the snapshot on the first request after running has changed, and
+ * owns its reference count. Workers print the reply from the snapshot tree without modifying
+ * it: the XML and binary printers iterate children by index, not with xml_child_each which
+ * sets an iterator in each child, so several workers may print the same snapshot.
+ * The tree is printed with with-defaults report-all, default values are trimmed when the
+ * snapshot is created. This avoids YANG lookups and any other shared state in the workers.
+ * The main thread sends the reply when the worker is done. Until then, no more requests are
+ * read from the client, so that replies are sent in order.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_client.h"
+#include "backend_handle.h"
+#include "backend_client.h"
+#include "backend_read.h"
+
+#ifdef BACKEND_READ_THREADS
+
+/* Name of read pool in clixon handle */
+#define BACKEND_READ_POOL "backend-read"
+
+/*
+ * Types
+ */
+/* Immutable snapshot of running */
+typedef struct {
+    cxobj   *rs_xt;     /* Config tree with top <data>, defaults trimmed */
+    uint64_t rs_gen;    /* Generation of running, see xmldb_generation_get */
+    int      rs_refs;   /* References: current snapshot and jobs. Main thread only */
+} read_snapshot;
+
+/* Read request of one client */
+typedef struct {
+    qelem_t              rj_qelem;  /* List header */
+    struct client_entry *rj_ce;     /* Client, may be removed before the job is done */
+    int                  rj_ce_nr;  /* Client number, to check that the client is still there */
+    read_snapshot       *rj_snap;   /* Snapshot to print */
+    int32_t              rj_depth;  /* Nr of levels to print, -1 is all */
+    int                  rj_binary; /* Binary XML reply, see PROTO_XML_BINARY */
+    cbuf                *rj_cbret;  /* Reply, set by worker */
+    int                  rj_ret;    /* 0: OK, -1: Failed, set by worker */
+} read_job;
+
+/* Pool of worker threads */
+typedef struct {
+    pthread_t       rp_threads[BACKEND_READ_THREADS];
+    int             rp_nthreads;  /* Started threads, 0 if workers are not used */
+    pthread_mutex_t rp_mutex;     /* Protects rp_todo, rp_done and rp_exit */
+    pthread_cond_t  rp_cond;      /* Signals rp_todo or rp_exit */
+    read_job       *rp_todo;      /* Jobs waiting for a worker */
+    read_job       *rp_done;      /* Jobs done, waiting for the main thread */
+    int             rp_exit;      /* Workers should exit */
+    int             rp_pipe[2];   /* Workers notify main thread of done jobs */
+    read_snapshot  *rp_snap;      /* Current snapshot, NULL if none */
+} read_pool;
+
+/*! Release reference to snapshot and free it if it was the last
+ *
+ * @param[in]  rs  Snapshot
+ */
+static void
+read_snapshot_release(read_snapshot *rs)
+{
+    if (--rs->rs_refs == 0){
+        if (rs->rs_xt)
+            xml_free(rs->rs_xt);
+        free(rs);
+    }
+}
+
+/*! Get snapshot of running, create it if running has changed
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  rp   Read pool
+ * @param[out] rsp  Current snapshot
+ * @retval     1    OK
+ * @retval     0    Not available, eg error reading running, handle request in main thread
+ * @retval    -1    Error
+ */
+static int
+read_snapshot_get(clixon_handle   h,
+                  read_pool      *rp,
+                  read_snapshot **rsp)
+{
+    int            retval = -1;
+    read_snapshot *rs;
+    cxobj         *xt = NULL;
+    uint64_t       gen;
+
+    gen = xmldb_generation_get(h, "running");
+    if ((rs = rp->rp_snap) != NULL && gen != 0 && rs->rs_gen == gen){
+        *rsp = rs;
+        goto ok;
+    }
+    if (xmldb_get0(h, "running", YB_MODULE, NULL, "/", 1, WITHDEFAULTS_REPORT_ALL, &xt, NULL, NULL) != 1){
+        clixon_err_reset();
+        retval = 0;
+        goto done;
+    }
+    /* As with-defaults explicit when printing, see xml2output_wdef */
+    if (xml_default_nopresence(xt, 1, 0) < 0)
+        goto done;
+    if (xml_name_set(xt, NETCONF_OUTPUT_DATA) < 0)
+        goto done;
+    if ((rs = calloc(1, sizeof(*rs))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    rs->rs_xt = xt;
+    xt = NULL;
+    /* Reading running may set its cache */
+    rs->rs_gen = xmldb_generation_get(h, "running");
+    rs->rs_refs = 1;
+    if (rp->rp_snap)
+        read_snapshot_release(rp->rp_snap);
+    rp->rp_snap = rs;
+    *rsp = rs;
+ ok:
+    retval = 1;
+ done:
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+
+/*! Print reply of read job in worker thread
+ *
+ * The snapshot tree is printed without modifying it. Its YANG specs are read as well:
+ * yang_keyword_get, yang_cv_get and, depending on with-defaults, yang_find. Child
+ * indexes that yang_find builds are protected by a lock, see YANG_FIND_INDEX, otherwise
+ * the specs are not modified.
+ * Errors are not reported with clixon_err, which is not thread-safe, instead an error
+ * reply is sent by the main thread.
+ * @param[in]  rj   Read job
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+read_job_print(read_job *rj)
+{
+    int32_t depth = rj->rj_depth;
+
+    if ((rj->rj_cbret = cbuf_new()) == NULL)
+        return -1;
+#ifdef PROTO_XML_BINARY
+    /* As get_nacm_and_reply */
+    if (rj->rj_binary){
+        if (clixon_xml2bin_start(rj->rj_cbret) < 0 ||
+            clixon_xml2bin_elmnt(rj->rj_cbret, NULL, "rpc-reply") < 0 ||
+            clixon_xml2bin_attr(rj->rj_cbret, NULL, "xmlns", NETCONF_BASE_NAMESPACE) < 0)
+            return -1;
+        /* Top level is data, so add 1 to depth if significant */
+        if (clixon_xml2bin(rj->rj_cbret, rj->rj_snap->rs_xt, depth>0?depth+1:depth,
+                           WITHDEFAULTS_REPORT_ALL, NULL, NULL) < 0)
+            return -1;
+        return clixon_xml2bin_end(rj->rj_cbret);
+    }
+#endif
+    cprintf(rj->rj_cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    /* Top level is data, so add 1 to depth if significant */
+    if (clixon_xml2cbuf1(rj->rj_cbret, rj->rj_snap->rs_xt, 0, 0, NULL,
+                         depth>0?depth+1:depth, 0, WITHDEFAULTS_REPORT_ALL) < 0)
+        return -1;
+    cprintf(rj->rj_cbret, "</rpc-reply>");
+    return 0;
+}
+
+/*! Worker thread: print replies of read jobs until exit
+ *
+ * @param[in] arg  Read pool
+ * @retval    NULL
+ */
+static void *
+read_worker(void *arg)
+{
+    read_pool *rp = (read_pool *)arg;
+    read_job  *rj;
+    char       c = 0;
+
+    while (1){
+        pthread_mutex_lock(&rp->rp_mutex);
+        while (rp->rp_todo == NULL && !rp->rp_exit)
+            pthread_cond_wait(&rp->rp_cond, &rp->rp_mutex);
+        if (rp->rp_exit){
+            pthread_mutex_unlock(&rp->rp_mutex);
+            break;
+        }
+        rj = rp->rp_todo;
+        DELQ(rj, rp->rp_todo, read_job *);
+        pthread_mutex_unlock(&rp->rp_mutex);
+        rj->rj_ret = read_job_print(rj);
+        pthread_mutex_lock(&rp->rp_mutex);
+        ADDQ(rj, rp->rp_done);
+        pthread_mutex_unlock(&rp->rp_mutex);
+        while (write(rp->rp_pipe[1], &c, 1) < 0 && errno == EINTR)
+            ;
+    }
+    return NULL;
+}
+
+/*! Free read job and release its snapshot
+ *
+ * @param[in]  rj   Read job
+ */
+static void
+read_job_free(read_job *rj)
+{
+    if (rj->rj_snap)
+        read_snapshot_release(rj->rj_snap);
+    if (rj->rj_cbret)
+        cbuf_free(rj->rj_cbret);
+    free(rj);
+}
+
+/*! Send reply of done read job and resume reading requests from the client
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  rj   Read job
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+read_job_reply(clixon_handle h,
+               read_job     *rj)
+{
+    int                  retval = -1;
+    struct client_entry *ce;
+
+    /* Client may be removed, eg by kill-session */
+    for (ce = backend_client_list(h); ce && ce != rj->rj_ce; ce = ce->ce_next);
+    if (ce == NULL || ce->ce_nr != rj->rj_ce_nr || !ce->ce_read_pending)
+        goto ok;
+    ce->ce_read_pending = 0;
+    if (rj->rj_ret < 0){
+        if (rj->rj_cbret == NULL &&
+            (rj->rj_cbret = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cbuf_reset(rj->rj_cbret);
+        if (netconf_operation_failed(rj->rj_cbret, "application", "Read worker failed") < 0)
+            goto done;
+    }
+    if (backend_client_reply(h, ce, rj->rj_cbret) < 0)
+        goto done;
+    /* Requests read or queued while the job was pending */
+    if (backend_client_resume(h, ce) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Main thread: read jobs are done, send replies
+ *
+ * @param[in]  fd   Read end of notification pipe
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+read_done(int   fd,
+          void *arg)
+{
+    int           retval = -1;
+    clixon_handle h = (clixon_handle)arg;
+    read_pool    *rp = NULL;
+    read_job     *done;
+    read_job     *rj;
+    char          buf[64];
+
+    while (read(fd, buf, sizeof(buf)) > 0)
+        ;
+    if (clicon_ptr_get(h, BACKEND_READ_POOL, (void**)&rp) < 0 || rp == NULL)
+        goto ok;
+    pthread_mutex_lock(&rp->rp_mutex);
+    done = rp->rp_done;
+    rp->rp_done = NULL;
+    pthread_mutex_unlock(&rp->rp_mutex);
+    while ((rj = done) != NULL){
+        DELQ(rj, done, read_job *);
+        if (read_job_reply(h, rj) < 0){
+            read_job_free(rj);
+            goto done;
+        }
+        read_job_free(rj);
+    }
+ ok:
+    retval = 0;
+ done:
+    while ((rj = done) != NULL){
+        DELQ(rj, done, read_job *);
+        read_job_free(rj);
+    }
+    return retval;
+}
+
+/*! Get read pool, start worker threads on first call
+ *
+ * Workers are not started if there is only one processor
+ * @param[in]  h    Clixon handle
+ * @retval     rp   Read pool, with no threads if workers are not used
+ * @retval     NULL Error
+ */
+static read_pool *
+read_pool_get(clixon_handle h)
+{
+    read_pool *rp = NULL;
+    int        i;
+
+    if (clicon_ptr_get(h, BACKEND_READ_POOL, (void**)&rp) == 0 && rp != NULL)
+        return rp;
+    if ((rp = calloc(1, sizeof(*rp))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    rp->rp_pipe[0] = rp->rp_pipe[1] = -1;
+    if (clicon_ptr_set(h, BACKEND_READ_POOL, rp) < 0){
+        free(rp);
+        return NULL;
+    }
+    if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+        return rp;
+    if (pipe(rp->rp_pipe) < 0){
+        clixon_err(OE_UNIX, errno, "pipe");
+        return NULL;
+    }
+    if (fcntl(rp->rp_pipe[0], F_SETFL, O_NONBLOCK) < 0){
+        clixon_err(OE_UNIX, errno, "fcntl");
+        return NULL;
+    }
+    if (clixon_event_reg_fd(rp->rp_pipe[0], read_done, h, "backend read workers") < 0)
+        return NULL;
+    pthread_mutex_init(&rp->rp_mutex, NULL);
+    pthread_cond_init(&rp->rp_cond, NULL);
+    for (i=0; i<BACKEND_READ_THREADS; i++){
+        /* If thread cannot be created, use the threads started so far */
+        if (pthread_create(&rp->rp_threads[i], NULL, read_worker, rp) != 0)
+            break;
+        rp->rp_nthreads++;
+    }
+    return rp;
+}
+
+/*! Print get-config of running in a read worker thread
+ *
+ * The caller has checked that the request is get-config (or get with content config) of the
+ * whole running datastore, with with-defaults explicit and without NACM.
+ * If submitted, the reply is sent when the worker is done, and cbret should be left empty.
+ * @param[in]  h      Clixon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  depth  Nr of levels to print, -1 is all
+ * @retval     1      Submitted, reply is sent later
+ * @retval     0      Not submitted, handle request in main thread
+ * @retval    -1      Error
+ */
+int
+backend_read_submit(clixon_handle        h,
+                    struct client_entry *ce,
+                    int32_t              depth)
+{
+    int            retval = -1;
+    read_pool     *rp;
+    read_snapshot *rs = NULL;
+    read_job      *rj;
+    int            ret;
+
+    /* System-only config is read from the system on every get */
+    if (ce == NULL || ce->ce_s <= 0 ||
+        clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG"))
+        goto notsubmitted;
+    if ((rp = read_pool_get(h)) == NULL)
+        goto done;
+    if (rp->rp_nthreads == 0)
+        goto notsubmitted;
+    if ((ret = read_snapshot_get(h, rp, &rs)) < 0)
+        goto done;
+    if (ret == 0)
+        goto notsubmitted;
+    if ((rj = calloc(1, sizeof(*rj))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    rj->rj_ce = ce;
+    rj->rj_ce_nr = ce->ce_nr;
+    rj->rj_snap = rs;
+    rs->rs_refs++;
+    rj->rj_depth = depth;
+    rj->rj_binary = ce->ce_xml_binary;
+    ce->ce_read_pending = 1;
+    pthread_mutex_lock(&rp->rp_mutex);
+    ADDQ(rj, rp->rp_todo);
+    pthread_cond_signal(&rp->rp_cond);
+    pthread_mutex_unlock(&rp->rp_mutex);
+    retval = 1;
+ done:
+    return retval;
+ notsubmitted:
+    retval = 0;
+    goto done;
+}
+
+/*! Stop read worker threads and free jobs and snapshot
+ *
+ * Replies of pending jobs are not sent
+ * @param[in]  h      Clixon handle
+ * @retval     0      OK
+ */
+int
+backend_read_exit(clixon_handle h)
+{
+    read_pool *rp = NULL;
+    read_job  *rj;
+    int        i;
+
+    if (clicon_ptr_get(h, BACKEND_READ_POOL, (void**)&rp) < 0 || rp == NULL)
+        return 0;
+    if (rp->rp_nthreads){
+        pthread_mutex_lock(&rp->rp_mutex);
+        rp->rp_exit = 1;
+        pthread_cond_broadcast(&rp->rp_cond);
+        pthread_mutex_unlock(&rp->rp_mutex);
+        for (i=0; i<rp->rp_nthreads; i++)
+            pthread_join(rp->rp_threads[i], NULL);
+        pthread_mutex_destroy(&rp->rp_mutex);
+        pthread_cond_destroy(&rp->rp_cond);
+    }
+    while ((rj = rp->rp_todo) != NULL){
+        DELQ(rj, rp->rp_todo, read_job *);
+        read_job_free(rj);
+    }
+    while ((rj = rp->rp_done) != NULL){
+        DELQ(rj, rp->rp_done, read_job *);
+        read_job_free(rj);
+    }
+    if (rp->rp_snap)
+        read_snapshot_release(rp->rp_snap);
+    if (rp->rp_pipe[0] != -1){
+        clixon_event_unreg_fd(rp->rp_pipe[0], read_done);
+        close(rp->rp_pipe[0]);
+    }
+    if (rp->rp_pipe[1] != -1)
+        close(rp->rp_pipe[1]);
+    free(rp);
+    clicon_ptr_del(h, BACKEND_READ_POOL);
+    return 0;
+}
+
+#endif /* BACKEND_READ_THREADS */
@@ -0,0 +1,407 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2020-2025 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Backend request scheduler, see BACKEND_SCHED
+ *
+ * Requests from clients are queued per session when read, and dispatched one at a time by
+ * weighted fair queueing between sessions: each session has a virtual time that advances
+ * by VSCALE/weight per dispatched request, and the session with the lowest virtual time is
+ * dispatched next. With equal weights this is round-robin. A session that becomes active
+ * starts at the current virtual time, so that idle time is not saved as credit.
+ * The weight of a session is given by its transport or user in CLICON_BACKEND_SCHED_WEIGHT.
+ * A session is not read while it has queued requests, which bounds the queue to one read.
+ * The scheduler is run from the event loop by a pipe that is readable while requests are
+ * queued, so that input on other sockets is read between dispatched requests.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_client.h"
+#include "backend_handle.h"
+#include "backend_client.h"
+#include "backend_sched.h"
+
+#ifdef BACKEND_SCHED
+
+/* Name of scheduler in clixon handle */
+#define BACKEND_SCHED_NAME "backend-sched"
+
+/* Virtual time of one request with weight 1 */
+#define VSCALE 65536
+
+/* Max weight of a session */
+#define WEIGHT_MAX 1024
+
+/*
+ * Types
+ */
+/* Queued request */
+struct backend_sched_req {
+    qelem_t        sr_qelem;  /* List header */
+    cbuf          *sr_cb;     /* Request message */
+    struct timeval sr_time;   /* Time when queued */
+};
+
+/* Scheduler */
+typedef struct {
+    int      bs_pipe[2]; /* Readable while requests are queued */
+    int      bs_armed;   /* A byte is written to pipe */
+    uint64_t bs_vtime;   /* Virtual time of last dispatched request */
+} backend_sched;
+
+/*! Get weight of a client session from CLICON_BACKEND_SCHED_WEIGHT
+ *
+ * The option is a list of <key>=<weight> separated by space, where key is a transport,
+ * eg cl:cli, or user:<name>. A user weight has precedence over a transport weight.
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ * @retval     w    Weight, 1 if not given
+ */
+static int
+sched_weight(clixon_handle        h,
+             struct client_entry *ce)
+{
+    char *str;
+    char *s0 = NULL;
+    char *s;
+    char *key;
+    char *val;
+    char *transport;
+    int   tweight = 0;
+    int   uweight = 0;
+    int   w;
+
+    if ((str = clicon_option_str(h, "CLICON_BACKEND_SCHED_WEIGHT")) == NULL ||
+        (s0 = strdup(str)) == NULL)
+        return 1;
+    transport = ce->ce_transport ? ce->ce_transport : "cl:netconf";
+    s = s0;
+    while ((key = strsep(&s, " \t\n")) != NULL){
+        if ((val = strchr(key, '=')) == NULL)
+            continue;
+        *val++ = '\0';
+        if ((w = atoi(val)) < 1)
+            continue;
+        if (w > WEIGHT_MAX)
+            w = WEIGHT_MAX;
+        if (strncmp(key, "user:", 5) == 0){
+            if (ce->ce_username && strcmp(key+5, ce->ce_username) == 0)
+                uweight = w;
+        }
+        else if (strcmp(key, transport) == 0)
+            tweight = w;
+    }
+    free(s0);
+    if (uweight)
+        return uweight;
+    return tweight ? tweight : 1;
+}
+
+/*! Get scheduler, create it on first call
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     bs   Scheduler
+ * @retval     NULL Error
+ */
+static backend_sched *sched_get(clixon_handle h);
+
+/*! Dispatch the next request, called from event loop when scheduler pipe is readable
+ *
+ * @param[in]  fd   Read end of scheduler pipe
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+sched_run(int   fd,
+          void *arg)
+{
+    int                       retval = -1;
+    clixon_handle             h = (clixon_handle)arg;
+    backend_sched            *bs;
+    struct client_entry      *ce;
+    struct client_entry      *cemin = NULL;
+    struct backend_sched_req *sr = NULL;
+    struct timeval            now;
+    struct timeval            t;
+    uint64_t                  wait;
+    int                       ret;
+
+    if ((bs = sched_get(h)) == NULL)
+        goto done;
+    /* Eligible session with lowest virtual time, then lowest number */
+    for (ce = backend_client_list(h); ce; ce = ce->ce_next){
+        if (ce->ce_sched_q == NULL)
+            continue;
+#ifdef BACKEND_READ_THREADS
+        if (ce->ce_read_pending)
+            continue;
+#endif
+        if (cemin == NULL ||
+            ce->ce_sched_vtime < cemin->ce_sched_vtime ||
+            (ce->ce_sched_vtime == cemin->ce_sched_vtime && ce->ce_nr < cemin->ce_nr))
+            cemin = ce;
+    }
+    if ((ce = cemin) == NULL){ /* Nothing to dispatch, disarm until backend_sched_kick */
+        if (bs->bs_armed){
+            char c;
+            while (read(fd, &c, 1) < 0 && errno == EINTR)
+                ;
+            bs->bs_armed = 0;
+        }
+        goto ok;
+    }
+    sr = ce->ce_sched_q;
+    DELQ(sr, ce->ce_sched_q, struct backend_sched_req *);
+    ce->ce_sched_len--;
+    gettimeofday(&now, NULL);
+    timersub(&now, &sr->sr_time, &t);
+    wait = (uint64_t)t.tv_sec*1000000 + t.tv_usec;
+    ce->ce_sched_wait_total += wait;
+    if (wait > ce->ce_sched_wait_max)
+        ce->ce_sched_wait_max = wait;
+    if (ce->ce_sched_weight == 0) /* Reset by hello */
+        ce->ce_sched_weight = sched_weight(h, ce);
+    bs->bs_vtime = ce->ce_sched_vtime;
+    ce->ce_sched_vtime += VSCALE/ce->ce_sched_weight;
+    if ((ret = backend_client_request(h, ce, cbuf_get(sr->sr_cb))) < 0)
+        goto done;
+    /* Read more requests from client when its queue is empty */
+    if (ret == 1 && ce->ce_sched_q == NULL &&
+        backend_client_resume(h, ce) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (sr){
+        cbuf_free(sr->sr_cb);
+        free(sr);
+    }
+    return retval;
+}
+
+static backend_sched *
+sched_get(clixon_handle h)
+{
+    backend_sched *bs = NULL;
+
+    if (clicon_ptr_get(h, BACKEND_SCHED_NAME, (void**)&bs) == 0 && bs != NULL)
+        return bs;
+    if ((bs = calloc(1, sizeof(*bs))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return NULL;
+    }
+    bs->bs_pipe[0] = bs->bs_pipe[1] = -1;
+    if (pipe(bs->bs_pipe) < 0){
+        clixon_err(OE_UNIX, errno, "pipe");
+        goto err;
+    }
+    if (fcntl(bs->bs_pipe[0], F_SETFL, O_NONBLOCK) < 0){
+        clixon_err(OE_UNIX, errno, "fcntl");
+        goto err;
+    }
+    /* Same priority as client sockets */
+    if (clixon_event_reg_fd_prio(bs->bs_pipe[0], sched_run, h, "backend request scheduler",
+                                 clicon_option_bool(h, "CLICON_SOCK_PRIO")) < 0)
+        goto err;
+    /* Set only when complete, so that a failed setup is retried on next call */
+    if (clicon_ptr_set(h, BACKEND_SCHED_NAME, bs) < 0){
+        clixon_event_unreg_fd(bs->bs_pipe[0], sched_run);
+        goto err;
+    }
+    return bs;
+ err:
+    if (bs->bs_pipe[0] != -1)
+        close(bs->bs_pipe[0]);
+    if (bs->bs_pipe[1] != -1)
+        close(bs->bs_pipe[1]);
+    free(bs);
+    return NULL;
+}
+
+/*! Run scheduler if requests are queued
+ *
+ * Call when a session may be dispatched again, eg when a read worker is done
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_sched_kick(clixon_handle h)
+{
+    backend_sched *bs;
+    char           c = 0;
+
+    if ((bs = sched_get(h)) == NULL)
+        return -1;
+    if (bs->bs_armed)
+        return 0;
+    while (write(bs->bs_pipe[1], &c, 1) < 0){
+        if (errno == EINTR)
+            continue;
+        clixon_err(OE_UNIX, errno, "write");
+        return -1;
+    }
+    bs->bs_armed = 1;
+    return 0;
+}
+
+/*! Queue request from client, dispatched later by scheduler
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ * @param[in]  cb   Request message, consumed
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_sched_add(clixon_handle        h,
+                  struct client_entry *ce,
+                  cbuf                *cb)
+{
+    backend_sched            *bs;
+    struct backend_sched_req *sr;
+
+    if ((bs = sched_get(h)) == NULL)
+        goto err;
+    if ((sr = calloc(1, sizeof(*sr))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto err;
+    }
+    sr->sr_cb = cb;
+    gettimeofday(&sr->sr_time, NULL);
+    if (ce->ce_sched_q == NULL){
+        /* Session becomes active: no credit for idle time */
+        if (ce->ce_sched_vtime < bs->bs_vtime)
+            ce->ce_sched_vtime = bs->bs_vtime;
+    }
+    ADDQ(sr, ce->ce_sched_q);
+    if (++ce->ce_sched_len > ce->ce_sched_len_max)
+        ce->ce_sched_len_max = ce->ce_sched_len;
+    return backend_sched_kick(h);
+ err:
+    cbuf_free(cb);
+    return -1;
+}
+
+/*! Remove queued requests of a client that is removed
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ * @retval     0    OK
+ */
+int
+backend_sched_rm(clixon_handle        h,
+                 struct client_entry *ce)
+{
+    struct backend_sched_req *sr;
+
+    while ((sr = ce->ce_sched_q) != NULL){
+        DELQ(sr, ce->ce_sched_q, struct backend_sched_req *);
+        cbuf_free(sr->sr_cb);
+        free(sr);
+    }
+    ce->ce_sched_len = 0;
+    return 0;
+}
+
+/*! Print scheduler state of a client as netconf-monitoring session leafs in clixon-lib
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ * @param[out] cb   Session state
+ * @retval     0    OK
+ */
+int
+backend_sched_state(clixon_handle        h,
+                    struct client_entry *ce,
+                    cbuf                *cb)
+{
+    if (ce->ce_sched_weight == 0)
+        ce->ce_sched_weight = sched_weight(h, ce);
+    cprintf(cb, "<sched-weight xmlns=\"%s\">%d</sched-weight>", CLIXON_LIB_NS, ce->ce_sched_weight);
+    cprintf(cb, "<queued-rpcs xmlns=\"%s\">%u</queued-rpcs>", CLIXON_LIB_NS, ce->ce_sched_len);
+    cprintf(cb, "<queued-rpcs-max xmlns=\"%s\">%u</queued-rpcs-max>", CLIXON_LIB_NS, ce->ce_sched_len_max);
+    cprintf(cb, "<rpc-wait-total xmlns=\"%s\">%" PRIu64 "</rpc-wait-total>",
+            CLIXON_LIB_NS, ce->ce_sched_wait_total);
+    cprintf(cb, "<rpc-wait-max xmlns=\"%s\">%" PRIu64 "</rpc-wait-max>",
+            CLIXON_LIB_NS, ce->ce_sched_wait_max);
+    return 0;
+}
+
+/*! Free scheduler and queued requests of all clients
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ */
+int
+backend_sched_exit(clixon_handle h)
+{
+    backend_sched       *bs = NULL;
+    struct client_entry *ce;
+
+    for (ce = backend_client_list(h); ce; ce = ce->ce_next)
+        backend_sched_rm(h, ce);
+    if (clicon_ptr_get(h, BACKEND_SCHED_NAME, (void**)&bs) < 0 || bs == NULL)
+        return 0;
+    if (bs->bs_pipe[0] != -1){
+        clixon_event_unreg_fd(bs->bs_pipe[0], sched_run);
+        close(bs->bs_pipe[0]);
+    }
+    if (bs->bs_pipe[1] != -1)
+        close(bs->bs_pipe[1]);
+    free(bs);
+    clicon_ptr_del(h, BACKEND_SCHED_NAME);
+    return 0;
+}
+
+#endif /* BACKEND_SCHED */
@@ -73,6 +73,22 @@ struct client_entry{
     uint32_t              ce_in_bad_rpcs;    /* Not correct <rpc> messages */
     uint32_t              ce_out_rpc_errors; /*  <rpc-error> messages*/
     uint32_t              ce_out_notifications; /* Outgoing notifications */
+    uint32_t              ce_out_notifications_dropped; /* Notifications dropped, see CLICON_SOCK_NOTIFY_HIGHWATER */
+    int                   ce_out_dropping; /* Notifications dropped since last sent */
+    int                   ce_xml_binary; /* Client accepts binary XML replies, see PROTO_XML_BINARY */
+    int                   ce_msg_fd;  /* Client accepts replies as file descriptor, see PROTO_MSG_FD */
+    clixon_msg_rcv       *ce_rcv;     /* Receive state of requests from client */
+    clixon_msg_snd       *ce_snd;     /* Output queue to client, see BACKEND_OUTPUT_QUEUE */
+    int                   ce_read_pending; /* Reply by read worker pending, see BACKEND_READ_THREADS */
+    int                   ce_paused;  /* Not reading requests, see backend_client_pause */
+    struct backend_sched_req *ce_sched_q; /* Queued requests, see BACKEND_SCHED */
+    uint32_t              ce_sched_len;     /* Number of queued requests */
+    uint32_t              ce_sched_len_max; /* Max number of queued requests */
+    uint64_t              ce_sched_wait_total; /* Total wait time of requests in queue (us) */
+    uint64_t              ce_sched_wait_max;   /* Max wait time of a request in queue (us) */
+    int                   ce_sched_weight;  /* Scheduling weight, 0 if not yet set */
+    uint64_t              ce_sched_vtime;   /* Virtual time of next request */
+    int                   ce_sched_eof;     /* Client closed, remove when queued requests are done */
 };
 typedef struct client_entry client_entry;
 
@@ -203,6 +203,10 @@ backend_client_delete(clixon_handle        h,
                 free(ce->ce_transport);
             if (ce->ce_source_host)
                 free(ce->ce_source_host);
+            if (ce->ce_rcv)
+                clixon_msg_rcv_free(ce->ce_rcv);
+            if (ce->ce_snd)
+                clixon_msg_snd_free(ce->ce_snd);
             ce->ce_next = NULL;
             free(ce);
             break;
@@ -532,7 +532,7 @@ yang2cli_var_pattern(clixon_handle h,
         pattern = cv_string_get(cvp);
         invert = cv_flag(cvp, V_INVERT);
         cprintf(cb, " regexp:%s\"", invert?"!":"");
-        if (mode == REGEXP_POSIX){
+        if (mode != REGEXP_LIBXML2){ /* CLIgen has no pcre2 engine, use posix */
             posix = NULL;
             if (regexp_xsd2posix(pattern, &posix) < 0)
                 goto done;
@@ -184,6 +184,7 @@ cli_terminate(clixon_handle h)
     clicon_data_cvec_del(h, "cli-edit-cvv");;
     clicon_data_cvec_del(h, "cli-edit-filter");;
     xpath_optimize_exit();
+    xpath_cache_exit();
     /* Delete all plugins, and RPC callbacks */
     clixon_plugin_module_exit(h);
     /* Delete CLI syntax et al */
@@ -572,6 +573,7 @@ main(int    argc,
     enum format_enum config_dump_format = FORMAT_XML;
     int            print_version = 0;
     int32_t        d;
+    int            ycache;
 
     /* Defaults */
     once = 0;
@@ -849,6 +851,9 @@ main(int    argc,
     if ((yspec = yspec_new1(h, YANG_DOMAIN_TOP, YANG_DATA_TOP)) == NULL)
         goto done;
 
+    /* Load precompiled yang spec if CLICON_YANG_CACHE_DIR is set, loading below is then no-op */
+    if ((ycache = yang_spec_cache_load(h, "cli", yspec)) < 0)
+        goto done;
     /* Load Yang modules
      * 1. Load a yang module as a specific absolute filename */
     if ((str = clicon_yang_main_file(h)) != NULL){
@@ -881,6 +886,9 @@ main(int    argc,
     /* Here all modules are loaded 
      * Compute and set canonical namespace context
      */
+    if (ycache == 0 &&
+        yang_spec_cache_save(h, "cli", yspec) < 0)
+        goto done;
     if (xml_nsctx_yangspec(yspec, &nsctx_global) < 0)
         goto done;
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
@@ -592,6 +592,7 @@ netconf_terminate(clixon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_event_exit();
     clixon_handle_exit(h);
     clixon_err_exit();
@@ -687,6 +688,7 @@ main(int    argc,
     enum format_enum config_dump_format = FORMAT_XML;
     int              print_version = 0;
     int32_t          d;
+    int              ycache;
 
     /* Create handle */
     if ((h = clixon_handle_init()) == NULL)
@@ -886,6 +888,9 @@ main(int    argc,
             goto done;
         goto ok;
     }
+    /* Load precompiled yang spec if CLICON_YANG_CACHE_DIR is set, loading below is then no-op */
+    if ((ycache = yang_spec_cache_load(h, "netconf", yspec)) < 0)
+        goto done;
     /* Load Yang modules
      * 1. Load a yang module as a specific absolute filename */
     if ((str = clicon_yang_main_file(h)) != NULL){
@@ -915,6 +920,9 @@ main(int    argc,
     /* Here all modules are loaded
      * Compute and set canonical namespace context
      */
+    if (ycache == 0 &&
+        yang_spec_cache_save(h, "netconf", yspec) < 0)
+        goto done;
     if (xml_nsctx_yangspec(yspec, &nsctx_global) < 0)
         goto done;
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
@@ -330,6 +330,7 @@ main(int    argc,
     int              print_version = 0;
     int              stream_timeout = 0;
     int32_t          d;
+    int              ycache;
     
     /* Create handle */
     if ((h = restconf_handle_init()) == NULL)
@@ -524,6 +525,9 @@ main(int    argc,
         goto done;
     clixon_plugin_api_get(cp)->ca_extension = restconf_main_extension_cb;
 
+    /* Load precompiled yang spec if CLICON_YANG_CACHE_DIR is set, loading below is then no-op */
+    if ((ycache = yang_spec_cache_load(h, "restconf", yspec)) < 0)
+        goto done;
     /* Load Yang modules
      * 1. Load a yang module as a specific absolute filename */
     if ((str = clicon_yang_main_file(h)) != NULL){
@@ -574,6 +578,9 @@ main(int    argc,
     /* Here all modules are loaded 
      * Compute and set canonical namespace context
      */
+    if (ycache == 0 &&
+        yang_spec_cache_save(h, "restconf", yspec) < 0)
+        goto done;
     if (xml_nsctx_yangspec(yspec, &nsctx_global) < 0)
         goto done;
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
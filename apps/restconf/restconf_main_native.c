@@ -945,6 +945,7 @@ restconf_clixon_init(clixon_handle h,
     cxobj         *xerr = NULL;
     int            ret;
     size_t         sz;
+    int            ycache;
 
     /* Set default namespace according to CLICON_NAMESPACE_NETCONF_DEFAULT */
     xml_nsctx_namespace_netconf_default(h);
@@ -986,6 +987,9 @@ restconf_clixon_init(clixon_handle h,
         goto done;
     clixon_plugin_api_get(cp)->ca_extension = restconf_main_extension_cb;
 
+    /* Load precompiled yang spec if CLICON_YANG_CACHE_DIR is set, loading below is then no-op */
+    if ((ycache = yang_spec_cache_load(h, "restconf", yspec)) < 0)
+        goto done;
     /* Load Yang modules
      * 1. Load a yang module as a specific absolute filename */
     if ((str = clicon_yang_main_file(h)) != NULL){
@@ -1033,6 +1037,9 @@ restconf_clixon_init(clixon_handle h,
     /* Here all modules are loaded 
      * Compute and set canonical namespace context
      */
+    if (ycache == 0 &&
+        yang_spec_cache_save(h, "restconf", yspec) < 0)
+        goto done;
     if (xml_nsctx_yangspec(yspec, &nsctx_global) < 0)
         goto done;
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
@@ -1045,7 +1045,7 @@ restconf_connection(int   s,
 static int
 restconf_idle_timer_unreg(restconf_conn *rc)
 {
-    return clixon_event_unreg_timeout(restconf_idle_cb, rc);
+    return clixon_event_unreg_timer(&rc->rc_idle_timer);
 }
 
 /*! Close Restconf native connection socket and unregister callback
@@ -1456,7 +1456,7 @@ restconf_ssl_accept_client(clixon_handle    h,
 
 static int
 restconf_idle_timer_set(struct timeval t,
-                        void          *arg,
+                        restconf_conn *rc,
                         char          *descr)
 {
     int   retval = -1;
@@ -1467,10 +1467,11 @@ restconf_idle_timer_set(struct timeval t,
         goto done;
     }
     cprintf(cb, "restconf idle timer %s", descr);
-    if (clixon_event_reg_timeout(t,
-                                 restconf_idle_cb,
-                                 arg,
-                                 cbuf_get(cb)) < 0)
+    if (clixon_event_reg_timer(t,
+                               restconf_idle_cb,
+                               rc,
+                               cbuf_get(cb),
+                               &rc->rc_idle_timer) < 0)
         goto done;
     retval = 0;
  done:
@@ -1641,7 +1642,7 @@ restconf_callhome_cb(int   fd,
 int
 restconf_callhome_timer_unreg(restconf_socket *rsock)
 {
-    return clixon_event_unreg_timeout(restconf_callhome_cb, rsock);
+    return clixon_event_unreg_timer(&rsock->rs_callhome_timer);
 }
 
 /*! Set callhome timer, which tries to connect to callhome client
@@ -1700,10 +1701,11 @@ restconf_callhome_timer(restconf_socket *rsock,
     else
         clixon_debug(CLIXON_DBG_RESTCONF, "%lu", t.tv_sec);
     /* Should be only place restconf_callhome_cb is registered */
-    if (clixon_event_reg_timeout(t,
-                                 restconf_callhome_cb,
-                                 rsock,
-                                 cbuf_get(cb)) < 0)
+    if (clixon_event_reg_timer(t,
+                               restconf_callhome_cb,
+                               rsock,
+                               cbuf_get(cb),
+                               &rsock->rs_callhome_timer) < 0)
         goto done;
  ok:
     retval = 0;
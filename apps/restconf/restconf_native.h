@@ -122,6 +122,7 @@ typedef struct restconf_conn {
     struct timeval        rc_t;         /* Timestamp of last read/write activity, used by callhome
                                            idle-timeout algorithm */
     int                   rc_event_stream;    /* Event notification stream socket (maybe in sd?) */
+    clixon_event_timer   *rc_idle_timer; /* Callhome idle-timeout timer, see restconf_idle_timer */
 } restconf_conn;
 
 /* Restconf per socket handle
@@ -158,6 +159,7 @@ typedef struct restconf_socket{
     restconf_conn *rs_conns;  /* List of transient connect sockets */
     char          *rs_from_addr; /* From IP address as seen by accept (mv to rc?) */
     int            rs_stream_timeout; /* Close stream after <s> (debug) */
+    clixon_event_timer *rs_callhome_timer; /* Callhome connect timer, see restconf_callhome_timer */
 } restconf_socket;
 
 /* Restconf handle 
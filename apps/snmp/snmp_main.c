@@ -129,6 +129,7 @@ snmp_terminate(clixon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_event_exit();
     clixon_handle_exit(h);
     clixon_err_exit();
@@ -364,6 +365,7 @@ main(int    argc,
     char            *buf = NULL;
     size_t           bufsize = 0;
     int              ret;
+    int              ycache;
 
     /* Create handle */
     if ((h = clixon_handle_init()) == NULL)
@@ -540,6 +542,9 @@ main(int    argc,
     if ((yspec = yspec_new1(h, YANG_DOMAIN_TOP, YANG_DATA_TOP)) == NULL)
         goto done;
 
+    /* Load precompiled yang spec if CLICON_YANG_CACHE_DIR is set, loading below is then no-op */
+    if ((ycache = yang_spec_cache_load(h, "snmp", yspec)) < 0)
+        goto done;
     /* Load Yang modules
      * 1. Load a yang module as a specific absolute filename */
     if ((str = clicon_yang_main_file(h)) != NULL){
@@ -569,6 +574,9 @@ main(int    argc,
     /* Here all modules are loaded 
      * Compute and set canonical namespace context
      */
+    if (ycache == 0 &&
+        yang_spec_cache_save(h, "snmp", yspec) < 0)
+        goto done;
     if (xml_nsctx_yangspec(yspec, &nsctx_global) < 0)
         goto done;
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
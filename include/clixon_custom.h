@@ -55,6 +55,43 @@
  */
 #define XPATH_LIST_OPTIMIZE
 
+/*! Cache parsed XPath expressions
+ *
+ * Size of a global LRU cache of parsed XPath trees keyed on the XPath string, used by
+ * xpath_vec_ctx() and thereby xpath_first(), xpath_vec(), etc. This avoids running the XPath
+ * parser for recurring expressions such as the ones used in NACM.
+ * Hits and misses are shown in the clixon-lib stats rpc.
+ * If undefined, every XPath is parsed on each call.
+ */
+#define XPATH_CACHE_SIZE 1024
+
+/*! Compile cached XPath trees to flat programs
+ *
+ * Simple location paths with equality predicates, such as /a:x/a:y[a:k='foo'], are compiled
+ * to a vector of steps where prefixes are resolved to namespaces in advance. Other XPaths are
+ * evaluated by the regular XPath evaluator.
+ * Requires XPATH_CACHE_SIZE
+ */
+#define XPATH_COMPILE
+
+/*! Prune descendant XPath searches using YANG
+ *
+ * In searches such as //interface[name='x'], subtrees whose YANG cannot contain a node with
+ * the given name are skipped. The set of YANG nodes that may contain a name is computed from
+ * the YANG spec on first use and cached.
+ * Nodes without YANG, anydata and mount-points are always searched.
+ */
+#define XPATH_DESCENDANT_PRUNE
+
+/*! Pool XPath contexts during an XPath evaluation
+ *
+ * Contexts freed during evaluation are reused, together with their nodeset buffers, instead
+ * of being freed and allocated again. All pooled contexts are released when the top-level
+ * XPath call returns. Allocation counts of the last evaluation are logged with XPath debug
+ * and available with ctx_arena_stats().
+ */
+#define XPATH_ARENA
+
 /*! Add explicit search indexes, so that binary search can be made for non-key list indexes
  *
  * This also applies if there are multiple keys and you want to search on only the second for 
@@ -196,6 +233,23 @@
  */
 #define YANG_SCHEMA_MOUNT_YANG_LIB_FORCE
 
+/*! Hashed index of mounted yang-specs by mount xpath and by yang-library content
+ *
+ * Mount-points with the same yang-library share one yspec found by a hash lookup instead
+ * of querying the yang-library of all other mount-points. Finding the yspec of a mount
+ * xpath is also a hash lookup. Intended for many (eg thousands) of mount-points.
+ * Undefine to search all mount-points
+ */
+#define YANG_SCHEMA_MOUNT_INDEX
+
+/*! Do not resolve the yang-library of empty mount-points when binding
+ *
+ * The yang-library of a mount-point is fetched and its yspec found or parsed first when
+ * the mount-point has content. Empty mount-points are then not visible in schema mount
+ * statistics until they get content.
+ */
+#undef YANG_SCHEMA_MOUNT_LAZY
+
 /*! For debug, YANG linenr shown in some YANG error-messages
  *
  * If set, report line-numbers in some error-messages (grouping/mandatory key),
@@ -246,3 +300,139 @@
  * see xml_default
  */
 #define OPTIMIZE_NO_PRESENCE_CONTAINER
+
+/*! Hashed index of yang children used by yang_find and yang_find_datanode
+ *
+ * Built on demand for yang statements with at least this many children, including
+ * the resolution of included submodules. Invalidated when the yang tree is modified.
+ * Lookups are thread-safe: indexes are built and used with a lock held, since yang_find is
+ * also called by YANG_PARSE_THREADS and BACKEND_READ_THREADS workers.
+ * Undefine to always search children linearly
+ */
+#define YANG_FIND_INDEX 8
+
+/*! Max number of threads parsing YANG files in parallel when loading YANG
+ *
+ * Files in a YANG directory and their import/include closure are first parsed by a pool
+ * of worker threads, then linked and expanded in order by the main thread as before.
+ * Also limited by the number of online processors. Parsing is sequential if debugging.
+ * Undefine to always parse YANG files sequentially
+ */
+#define YANG_PARSE_THREADS 8
+
+/*! Share read-only substatements of grouping nodes expanded by uses without refine
+ *
+ * Statements such as description, reference, units and status are not copied to the
+ * expanded nodes, yang_find looks them up in the original grouping node instead.
+ * A refine or deviation of an expanded node copies them back before modifying it.
+ * Schema nodes and their types are still copied per uses, since they need their own
+ * parent and position in the tree. The saving is thus in the leaf substatements, see
+ * test_grouping_shared.sh for a comparison with inline nodes.
+ * Undefine to always deep-copy groupings on uses expansion
+ */
+#define YANG_USES_SHARED
+
+/*! Compiled validator per resolved yang type used by ys_cv_validate
+ *
+ * Built with the yang type cache when types are resolved at load: interval table of
+ * ranges or lengths, compiled patterns, enum and bit names, and union member types.
+ * Validation then avoids resolving the type and copying its restrictions per value.
+ * Undefine to validate via yang_type_get for each value
+ */
+#define YANG_TYPE_VALIDATOR
+
+/*! Precomputed identity derivation as bitsets over dense identity numbers
+ *
+ * Each identity is numbered when populated at load and each base identity has a bitset of
+ * all identities transitively derived from it. Identityref validation and the XPath
+ * functions derived-from() and derived-from-or-self() then test a single bit instead of
+ * searching the list of derived <module>:<id> strings.
+ * Undefine to search the derived identity list
+ */
+#define YANG_IDENTITY_BITSET
+
+/*! Reuse compiled NACM configuration until the NACM tree changes
+ *
+ * The NACM tree is compiled to groups hashed by user-name and parsed rule-lists and rules.
+ * Per user, the applicable rules per access operation and rpc decisions are resolved on
+ * first use. The compiled form is kept as long as the NACM tree of a request is equal to
+ * the tree it was compiled from, ie it is rebuilt when NACM config is changed.
+ * Undefine to compile the NACM tree on every access validation
+ */
+#define NACM_COMPILED
+
+/*! Apply NACM read access when printing the reply of get and get-config
+ *
+ * Instead of marking the result tree with NACM decisions, pruning it, and resetting the
+ * marks, the first matching rule of each node is checked when the tree is printed and
+ * denied subtrees are skipped. The result tree is not modified.
+ * The result tree is still a copy of the datastore, since the get code modifies it for
+ * xpath filtering, defaults and state data, so only the NACM passes are saved.
+ * Undefine to mark and prune the result tree before printing
+ */
+#define NACM_READ_FILTER
+
+/*! Replies of get and get-config to internal clients as binary XML trees
+ *
+ * Internal clients send the CLIXON_XML_BIN_CAPABILITY in the internal hello and the backend
+ * then encodes get and get-config replies as binary XML trees, where YANG schema nodes
+ * are referred to by node ids, and integer and boolean values are typed. Clients build
+ * the reply tree without text parsing and skip YANG binding if all of it is bound.
+ * External NETCONF and RESTCONF clients are not affected.
+ * Undefine to use XML text on the internal protocol
+ */
+#define PROTO_XML_BINARY
+
+/*! Pass large replies to local internal clients as a memory file descriptor
+ *
+ * Internal clients on a UNIX socket send the CLIXON_MSG_FD_CAPABILITY in the internal hello.
+ * The backend then writes replies of at least this many bytes to a memfd and passes the
+ * descriptor with SCM_RIGHTS instead of copying the reply through the socket.
+ * The client reads the reply directly from the descriptor.
+ * Requires memfd_create, otherwise replies are always sent on the socket.
+ * Undefine to always send replies on the socket
+ */
+#define PROTO_MSG_FD 65536
+
+/*! Event loop with epoll instead of select
+ *
+ * File descriptors are registered persistently in an epoll instance when registered with
+ * clixon_event_reg_fd and removed when unregistered, instead of building a select fdset for
+ * every loop. Ready descriptors are dispatched in batches and there is no FD_SETSIZE limit.
+ * Requires epoll_create1, otherwise select is used.
+ * Undefine to use select
+ */
+#define EVENT_LOOP_EPOLL
+
+/*! Number of backend worker threads serving get-config of running from a snapshot
+ *
+ * get-config and get with content=config of the whole running datastore are printed by worker
+ * threads from an immutable snapshot of running, while the main thread handles other requests.
+ * The snapshot is created on the first such request after running has changed.
+ * Requests with filters, list-pagination, with-defaults other than explicit, or with NACM
+ * enabled are handled by the main thread. Workers are not started with a single processor.
+ * Undefine to handle all requests in the main thread
+ */
+#define BACKEND_READ_THREADS 4
+
+/*! Non-blocking output to backend clients with per-client output queues
+ *
+ * Replies and notifications are sent without blocking, and output that cannot be sent is
+ * queued and sent when the client socket is writable. A slow or stuck client, such as a
+ * stream consumer, then does not block the backend and other sessions.
+ * See CLICON_SOCK_NOTIFY_HIGHWATER and CLICON_SOCK_OUTPUT_HIGHWATER for queue limits.
+ * Undefine to write to clients with blocking writes
+ */
+#define BACKEND_OUTPUT_QUEUE
+
+/*! Fair scheduling of backend client requests
+ *
+ * Requests read from clients are queued per session and dispatched one at a time, with weighted
+ * fair queueing between sessions. A session with a long sequence of requests, or a pipelining
+ * client, then does not delay other sessions more than its share.
+ * A session is not read while it has queued requests. Weights per transport or user are set by
+ * CLICON_BACKEND_SCHED_WEIGHT, eg to give CLI sessions precedence.
+ * Queue lengths and wait times are shown in netconf-monitoring sessions.
+ * Undefine to handle requests in the order they are read
+ */
+#define BACKEND_SCHED
@@ -56,6 +56,7 @@ struct db_elmnt {
                                  */
     int            de_empty;    /* Empty on read from file, xmldb_readfile and xmldb_put sets it */
     int            de_volatile; /* Disable auto-sync of cache to disk on every update (ie xmldb_put) */
+    uint64_t       de_generation; /* Set on every update, see xmldb_generation_get */
 };
 typedef struct db_elmnt db_elmnt;
 
@@ -96,6 +97,7 @@ int xmldb_create(clixon_handle h, const char *db);
 /* utility functions */
 int xmldb_db_reset(clixon_handle h, const char *db);
 cxobj *xmldb_cache_get(clixon_handle h, const char *db);
+uint64_t xmldb_generation_get(clixon_handle h, const char *db);
 int xmldb_modified_get(clixon_handle h, const char *db);
 int xmldb_modified_set(clixon_handle h, const char *db, int value);
 int xmldb_empty_get(clixon_handle h, const char *db);
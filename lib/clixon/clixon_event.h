@@ -40,6 +40,12 @@
 #ifndef _CLIXON_EVENT_H_
 #define _CLIXON_EVENT_H_
 
+/*
+ * Types
+ */
+/* Timer handle, see clixon_event_reg_timer */
+typedef struct event_data clixon_event_timer;
+
 /*
  * Prototypes
  */
@@ -51,10 +57,14 @@ int clicon_sig_ignore_set(int val);
 int clicon_sig_ignore_get(void);
 int clixon_event_reg_fd(int fd, int (*fn)(int, void*), void *arg, char *str);
 int clixon_event_reg_fd_prio(int fd, int (*fn)(int, void*), void *arg, char *str, int prio);
+int clixon_event_reg_fd_write(int fd, int (*fn)(int, void*), void *arg, char *str);
 int clixon_event_unreg_fd(int s, int (*fn)(int, void*));
 int clixon_event_reg_timeout(struct timeval t,  int (*fn)(int, void*),
                              void *arg, char *str);
 int clixon_event_unreg_timeout(int (*fn)(int, void*), void *arg);
+int clixon_event_reg_timer(struct timeval t, int (*fn)(int, void*), void *arg,
+                           char *str, clixon_event_timer **th);
+int clixon_event_unreg_timer(clixon_event_timer **th);
 int clixon_event_poll(int fd);
 int clixon_event_loop(clixon_handle h);
 int clixon_event_exit(void);
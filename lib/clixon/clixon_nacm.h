@@ -53,6 +53,8 @@ enum nacm_access{
     NACM_EXEC
 };
 
+typedef struct nacm_read_filter nacm_read_filter;
+
 /*
  * Prototypes
  */
@@ -62,7 +64,12 @@ int nacm_datanode_read(clixon_handle h, cxobj *xt, cxobj **xvec, size_t xlen, ch
 int nacm_datanode_write(clixon_handle h, cxobj *xr, cxobj *xt,
                         enum nacm_access access,
                         char *username, cxobj *xnacm, cbuf *cbret);
+int nacm_read_filter_new(clixon_handle h, cxobj *xt, char *username, cxobj *xnacm,
+                         nacm_read_filter **nfp);
+int nacm_read_filter_free(nacm_read_filter *nf);
+int nacm_read_filter_fn(cxobj *x, void *arg, int state, int *statep);
 int nacm_access_pre(clixon_handle h, char *peername, char *username, cxobj **xnacmp, cbuf *cbret);
+int nacm_compiled_exit(void);
 int verify_nacm_user(clixon_handle h, enum nacm_credentials_t cred, char *peername, char *nacmname, char *rpcname, cbuf *cbret);
 
 #endif /* _CLIXON_NACM_H */
@@ -91,7 +91,8 @@ enum nacm_credentials_t{
  */
 enum regexp_mode{
     REGEXP_POSIX,
-    REGEXP_LIBXML2
+    REGEXP_LIBXML2,
+    REGEXP_PCRE2
 };
 
 /*
@@ -40,10 +40,22 @@
 #ifndef _CLIXON_PROTO_H_
 #define _CLIXON_PROTO_H_
 
+/*
+ * Constants
+ */
+/* Internal hello capability of replies passed as file descriptor, see PROTO_MSG_FD */
+#define CLIXON_MSG_FD_CAPABILITY "http://clicon.org/msg-fd"
+
 /*
  * Types
  */
 
+/* Incremental receive state, see clixon_msg_rcv_next */
+typedef struct clixon_msg_rcv clixon_msg_rcv;
+
+/* Non-blocking output queue, see clixon_msg_snd_flush */
+typedef struct clixon_msg_snd clixon_msg_snd;
+
 /*! Protocol message header (histoorical)
  * Current use is a shim layer for sending packets
  */
@@ -73,9 +85,21 @@ int clixon_msg_send10(int s, const char *descr, cbuf *cb);
 int clixon_rpc10(int sock, const char *descr, cbuf *msgin, cbuf *msgret, int *eof);
 
 /* NETCONF 1.1 */
+int clixon_msg_send11(int s, const char *descr, cbuf *cb);
 int clixon_msg_rcv11(int s, const char *descr, int intr, cbuf **cb, int *eof);
+clixon_msg_rcv *clixon_msg_rcv_new(int fdpass);
+int clixon_msg_rcv_free(clixon_msg_rcv *mr);
+int clixon_msg_rcv_pending(clixon_msg_rcv *mr);
+int clixon_msg_rcv_next(int s, const char *descr, clixon_msg_rcv *mr, cbuf **cb, int *eof);
 int clicon_rpc(int sock, const char *descr, struct clicon_msg *msg, char **xret, int *eof);
 int send_msg_reply(int s, const char *descr, char *data, uint32_t datalen);
+int send_msg_reply_fd(int s, const char *descr, char *data, uint32_t datalen);
+clixon_msg_snd *clixon_msg_snd_new(void);
+int clixon_msg_snd_reset(clixon_msg_snd *ms);
+int clixon_msg_snd_free(clixon_msg_snd *ms);
+size_t clixon_msg_snd_len(clixon_msg_snd *ms);
+int clixon_msg_snd_add(clixon_msg_snd *ms, const char *descr, char *data, size_t len, int fdpass);
+int clixon_msg_snd_flush(int s, clixon_msg_snd *ms);
 int send_msg_notify_xml(clixon_handle h, int s, const char *descr, cxobj *xev);
 
 #endif  /* _CLIXON_PROTO_H_ */
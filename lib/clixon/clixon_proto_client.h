@@ -42,6 +42,22 @@
 #ifndef _CLIXON_PROTO_CLIENT_H_
 #define _CLIXON_PROTO_CLIENT_H_
 
+/*
+ * Types
+ */
+/*! Reply callback of asynchronous rpc, see clicon_rpc_async
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  xret  Reply as XML tree, or NULL if no reply. Freed when callback returns
+ * @param[in]  arg   Argument given to clicon_rpc_async
+ * @retval     0     OK
+ * @retval    -1     Error, terminates event loop
+ */
+typedef int (clicon_rpc_async_cb)(clixon_handle h, cxobj *xret, void *arg);
+
+/*
+ * Prototypes
+ */
 int clicon_rpc_connect(clixon_handle h, int *sock0);
 int clicon_rpc_msg(clixon_handle h, struct clicon_msg *msg, cxobj **xret0);
 int clicon_rpc_msg_persistent(clixon_handle h, struct clicon_msg *msg, cxobj **xret0, int *sock0);
@@ -71,5 +87,8 @@ int clicon_rpc_debug(clixon_handle h, int level);
 int clicon_rpc_restconf_debug(clixon_handle h, int level);
 int clicon_hello_req(clixon_handle h, char *transport, char *source_host, uint32_t *id);
 int clicon_rpc_restart_plugin(clixon_handle h, char *plugin);
+int clicon_rpc_async(clixon_handle h, char *xmlstr, clicon_rpc_async_cb *fn, void *arg, uint32_t *idp);
+int clicon_rpc_async_pending(clixon_handle h);
+int clicon_rpc_async_close(clixon_handle h);
 
 #endif  /* _CLIXON_PROTO_CLIENT_H_ */
@@ -0,0 +1,59 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2020-2025 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Binary XML tree encoding of the internal protocol, see PROTO_XML_BINARY
+ */
+#ifndef _CLIXON_XML_BIN_H
+#define _CLIXON_XML_BIN_H
+
+/*
+ * Constants
+ */
+/* Internal hello capability of the binary XML tree encoding */
+#define CLIXON_XML_BIN_CAPABILITY "http://clicon.org/xml-binary"
+
+/*
+ * Prototypes
+ */
+int clixon_xml2bin_start(cbuf *cb);
+int clixon_xml2bin_elmnt(cbuf *cb, char *prefix, char *name);
+int clixon_xml2bin_attr(cbuf *cb, char *prefix, char *name, char *value);
+int clixon_xml2bin_end(cbuf *cb);
+int clixon_xml2bin(cbuf *cb, cxobj *x, int32_t depth, withdefaults_type wdef,
+                   xml2cbuf_filter_fn *fn, void *arg);
+int clixon_xml_bin_is(const char *str);
+int clixon_xml_bin_parse(const char *buf, size_t len, yang_stmt *yspec, cxobj **xt);
+int clixon_xml_bin_bound(cxobj *xt);
+int clixon_xml_bin_index(cxobj *xt);
+
+#endif /* _CLIXON_XML_BIN_H */
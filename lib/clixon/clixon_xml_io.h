@@ -40,9 +40,26 @@
 #ifndef _CLIXON_XML_IO_H_
 #define _CLIXON_XML_IO_H_
 
+/*
+ * Types
+ */
+/*! Filter of elements when printing an XML tree
+ *
+ * @param[in]  x      XML element
+ * @param[in]  arg    Filter argument
+ * @param[in]  state  Filter state of parent, 0 at top
+ * @param[out] statep Filter state of x passed to its children
+ * @retval     1      Print x
+ * @retval     0      Skip x and its subtree
+ * @retval    -1      Error
+ * @see clixon_xml2cbuf_filter
+ */
+typedef int (xml2cbuf_filter_fn)(cxobj *x, void *arg, int state, int *statep);
+
 /*
  * Prototypes
  */
+int   xml2output_wdef(cxobj *x, withdefaults_type wdef, int *tag);
 int   clixon_xml2file1(FILE *f, cxobj *xn, int level, int pretty, char *prefix,
                        clicon_output_cb *fn, int skiptop, int autocliext, withdefaults_type wdef,
                        int multi, int system_only);
@@ -56,6 +73,9 @@ int   clixon_xml2cbuf1(cbuf *cb, cxobj *x, int level, int prettyprint, char *pre
                        int32_t depth, int skiptop, withdefaults_type wdef);
 int   clixon_xml2cbuf(cbuf *cb, cxobj *x, int level, int prettyprint, char *prefix, int32_t depth, 
 int skiptop);
+int   clixon_xml2cbuf_filter(cbuf *cb, cxobj *xn, int level, int pretty, char *prefix,
+                             int32_t depth, int skiptop, withdefaults_type wdef,
+                             xml2cbuf_filter_fn *fn, void *arg);
 int   xmltree2cbuf(cbuf *cb, cxobj *x, int level);
 int   clixon_xml_parse_file(FILE *f, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
 int   clixon_xml_parse_string(const char *str, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
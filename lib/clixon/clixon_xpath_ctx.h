@@ -80,6 +80,7 @@ struct xp_ctx{
     enum xp_objtype xc_type;
     cxobj         **xc_nodeset; /* if type XT_NODESET */
     int             xc_size;    /* Length of nodeset */
+    int             xc_max;     /* Allocated length of nodeset, see ctx_nodeset_append */
     int             xc_position;
     int             xc_bool;    /* if xc_type XT_BOOL */
     double          xc_number;  /* if xc_type XT_NUMBER */
@@ -99,8 +100,14 @@ extern const map_str2int ctxmap[];
 /*
  * Prototypes
  */
+xp_ctx *ctx_new(void);
 int ctx_free(xp_ctx *xc);
+int ctx_vec_append(cxobj *x, cxobj ***vec, int *len, int *max);
+int ctx_nodeset_append(xp_ctx *xc, cxobj *x);
 xp_ctx *ctx_dup(xp_ctx *xc);
+void ctx_arena_enter(void);
+void ctx_arena_exit(void);
+int ctx_arena_stats(uint64_t *allocs, uint64_t *reuses, uint64_t *vecallocs);
 int ctx_nodeset_replace(xp_ctx *xc, cxobj **vec, size_t veclen);
 int ctx_print_cb(cbuf *cb, xp_ctx *xc, int indent, char *str);
 int ctx_print(FILE *f, xp_ctx *xc, char *str);
@@ -38,7 +38,23 @@
 #ifndef _CLIXON_XPATH_OPTIMIZE_H
 #define _CLIXON_XPATH_OPTIMIZE_H
 
+/*
+ * Types
+ */
+/* XPath optimization patterns, see xpath_list_optimize_pattern_stats */
+enum xpath_optimize_pattern{
+    XPATH_OPTIMIZE_KEY,      /* List with single key: y[k='a'] */
+    XPATH_OPTIMIZE_MULTIKEY, /* List with several keys in any order: y[k2='b'][k1='a'] */
+    XPATH_OPTIMIZE_INDEX,    /* List with explicit search index: y[i='a'] */
+    XPATH_OPTIMIZE_LEAFLIST, /* Leaf-list value: y[.='a'] */
+    XPATH_OPTIMIZE_MAX
+};
+
+/*
+ * Prototypes
+ */
 int  xpath_list_optimize_stats(int *hits);
+int  xpath_list_optimize_pattern_stats(int *hits);
 int  xpath_list_optimize_set(int enable);
 void xpath_optimize_exit(void);
 int  xpath_optimize_check(xpath_tree *xs, cxobj *xv, cxobj ***xvec0, int *xlen0);
@@ -100,6 +100,9 @@
                                       * may be different from orig, therefore do not use link to
                                       * original. May also be due to deviations of derived trees
                                       */
+#define YANG_FLAG_SHARED      0x4000 /* Node expanded from grouping without refine: read-only
+                                      * substatements are not copied but found in original,
+                                      * see YANG_USES_SHARED and yang_unshare */
 /*! Names of top-level data YANGs
  */
 #define YANG_DOMAIN_TOP "top"
@@ -302,8 +305,11 @@ int        ys_free(yang_stmt *ys);
 int        ys_cp_one(yang_stmt *nw, yang_stmt *old);
 int        ys_cp(yang_stmt *nw, yang_stmt *old);
 yang_stmt *ys_dup(yang_stmt *old);
+yang_stmt *ys_dup_shared(yang_stmt *old);
+int        yang_unshare(yang_stmt *ys);
 int        yn_insert(yang_stmt *ys_parent, yang_stmt *ys_child);
 int        yn_insert1(yang_stmt *ys_parent, yang_stmt *ys_child);
+int        yang_changed(void);
 yang_stmt *yn_iter(yang_stmt *yparent, int *inext);
 char      *yang_key2str(int keyword);
 int        yang_str2key(char *str);
@@ -337,6 +343,8 @@ int        ys_populate(yang_stmt *ys, void *arg);
 int        ys_populate2(yang_stmt *ys, void *arg);
 int        yang_apply(yang_stmt *yn, enum rfc_6020 key, yang_applyfn_t fn, int from, void *arg);
 int        yang_datanode(yang_stmt *ys);
+int        yang_name_ancestors(yang_stmt *yspec, const char *name, yang_stmt ***vec, int *len);
+int        yang_name_ancestor(yang_stmt **vec, int len, yang_stmt *ys);
 int        yang_abs_schema_nodeid(yang_stmt *ys, char *schema_nodeid, yang_stmt **yres);
 int        yang_desc_schema_nodeid(yang_stmt *yn, char *schema_nodeid, yang_stmt **yres);
 int        yang_config(yang_stmt *ys);
@@ -348,6 +356,11 @@ int        yang_type_cache_get2(yang_stmt *ytype, yang_stmt **resolved, int *opt
                                 cvec **cvv, cvec *patterns, cvec *regexps, uint8_t *fraction);
 int        yang_type_cache_set2(yang_stmt *ys, yang_stmt *resolved, int options, cvec *cvv,
                                 cvec *patterns, uint8_t fraction, int rxmode, cvec *regexps);
+struct yang_type_validator *yang_type_cache_validator(yang_stmt *ytype);
+int        yang_identity_derived(yang_stmt *ybaseid, yang_stmt *yid, int *derived);
+int        yang_identity_bitset_build(yang_stmt *yspec);
+int        yang_mount_index_get(yang_stmt *ymounts, int yanglib, const char *key, yang_stmt **yspecp);
+int        yang_mount_index_set(yang_stmt *ymounts, int yanglib, const char *key, yang_stmt *yspec);
 yang_stmt *yang_anydata_add(yang_stmt *yp, char *name);
 int        yang_extension_value(yang_stmt *ys, char *name, char *ns, int *exist, char **value);
 int        yang_sort_subelements(yang_stmt *ys);
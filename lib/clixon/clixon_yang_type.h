@@ -52,14 +52,21 @@
 /* declared in clixon_yang_internal */
 typedef struct yang_type_cache yang_type_cache;
 
+/* declared in clixon_yang_type.c */
+typedef struct yang_type_validator yang_type_validator;
+
 /*
  * Prototypes
  */
 int        ys_resolve_type(yang_stmt *ys, void *arg);
+int        compile_pattern2regexp(clixon_handle h, yang_stmt *ytype, cvec *patterns, cvec *regexps);
 int        yang2cv_type(char *ytype, enum cv_type *cv_type);
 char      *cv2yang_type(enum cv_type cv_type);
 yang_stmt *yang_find_identity(yang_stmt *ys, char *identity);
 yang_stmt *yang_find_identity_nsc(yang_stmt *yspec, char *identity, cvec *nsc);
+int        yang_type_validator_new(yang_stmt *yrestype, int options, cvec *cvv, cvec *regexps,
+                                   uint8_t fraction, yang_type_validator **yvp);
+int        yang_type_validator_free(yang_type_validator *yv);
 int        ys_cv_validate(clixon_handle h, cg_var *cv, yang_stmt *ys, yang_stmt **ysub, char **reason);
 int        clicon_type2cv(char *type, char *rtype, yang_stmt *ys, enum cv_type *cvtype);
 int        yang_type_get(yang_stmt *ys, char **otype, yang_stmt **restype,
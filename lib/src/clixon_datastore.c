@@ -85,6 +85,9 @@
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
 
+/* Last datastore generation, see xmldb_generation_get */
+static uint64_t _xmldb_generation = 0;
+
 /*! Get xml database element including id, xml cache, empty on startup and dirty bit
  *
  * @param[in]  h    Clixon handle
@@ -120,6 +123,7 @@ clicon_db_elmnt_set(clixon_handle h,
 {
     clicon_hash_t  *cdat = clicon_db_elmnt(h);
 
+    de->de_generation = ++_xmldb_generation;
     if (clicon_hash_add(cdat, db, de, sizeof(*de))==NULL)
         return -1;
     return 0;
@@ -564,6 +568,7 @@ xmldb_clear(clixon_handle h,
             xml_free(xt);
             de->de_xml = NULL;
         }
+        de->de_generation = ++_xmldb_generation;
         de->de_modified = 0;
         de->de_id = 0;
         memset(&de->de_tv, 0, sizeof(struct timeval));
@@ -663,6 +668,7 @@ xmldb_create(clixon_handle h,
             xml_free(xt);
             de->de_xml = NULL;
         }
+        de->de_generation = ++_xmldb_generation;
     }
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, db, &subdir) < 0)
@@ -731,6 +737,26 @@ xmldb_cache_get(clixon_handle h,
     return de->de_xml;
 }
 
+/*! Get generation of datastore content
+ *
+ * A new generation is assigned whenever the datastore element or its cache is set or cleared,
+ * eg by xmldb_put, xmldb_copy or xmldb_clear. Equal generations mean the content is unchanged.
+ * Generations are unique across datastores.
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Database name
+ * @retval     gen   Generation, 0 if the datastore does not exist
+ */
+uint64_t
+xmldb_generation_get(clixon_handle h,
+                     const char   *db)
+{
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL)
+        return 0;
+    return de->de_generation;
+}
+
 /*! Get modified flag from datastore
  *
  * @param[in]  h     Clixon handle
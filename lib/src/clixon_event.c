@@ -69,7 +69,16 @@
 #include "clixon_options.h"
 #include "clixon_event.h"
 
-#ifdef CLIXON_EVENT_POLL
+#if defined(EVENT_LOOP_EPOLL) && !defined(HAVE_EPOLL_CREATE1)
+#undef EVENT_LOOP_EPOLL /* No epoll on this platform, use select */
+#endif
+
+#ifdef EVENT_LOOP_EPOLL
+#include <limits.h>
+#include <sys/epoll.h>
+#endif
+
+#if defined(CLIXON_EVENT_POLL) || defined(EVENT_LOOP_EPOLL)
 #include <poll.h>
 #endif
 
@@ -78,6 +87,9 @@
  */
 #define EVENT_STRLEN 32
 
+/* Max number of ready file descriptors returned by one epoll_wait */
+#define EVENT_EPOLL_MAXEVENTS 64
+
 /*
  * Types
  */
@@ -87,6 +99,13 @@ struct event_data{
     enum {EVENT_FD, EVENT_TIME} e_type;                 /* Type of event */
     int                         e_fd;                   /* File descriptor */
     int                         e_prio;                 /* 1: high-prio FD:s only*/
+    int                         e_write;                /* 1: call when writable, 0: readable */
+#ifdef EVENT_LOOP_EPOLL
+    struct event_data          *e_fdnext;               /* Next with same fd */
+#endif
+    int                         e_heapidx;              /* Index in timer heap */
+    uint64_t                    e_seq;                  /* Registration order of timers with same time */
+    struct event_data         **e_handle;               /* Cleared when timer is removed */
     struct timeval              e_time;                 /* Timeout */
     void                       *e_arg;                  /* Function argument */
     char                        e_string[EVENT_STRLEN]; /* String for debugging */
@@ -97,11 +116,33 @@ struct event_data{
  * XXX consider use handle variables instead of global
  */
 static struct event_data *ee = NULL;
-static struct event_data *ee_timers = NULL;
+
+/* Timers in a binary min-heap ordered by time and registration order */
+static struct event_data **ee_timers = NULL;
+static int                 _ee_timerlen = 0;  /* Number of timers */
+static int                 _ee_timermax = 0;  /* Allocated length of ee_timers */
+static uint64_t            _ee_timerseq = 0;  /* Last timer registration */
 
 /* Set if element in ee is deleted (clixon_event_unreg_fd). Check in ee loops */
 static int _ee_unreg = 0;
 
+#ifdef EVENT_LOOP_EPOLL
+/* Registrations of one file descriptor in the epoll instance */
+struct event_fd{
+    struct event_data *ef_list;   /* Registrations of fd, linked with e_fdnext */
+    uint32_t           ef_gen;    /* Generation, events of earlier registrations of fd are stale */
+    uint32_t           ef_events; /* Events of fd in epoll instance */
+    int                ef_always; /* Not pollable by epoll (eg regular file), always ready */
+};
+
+static int              _ee_epfd = -1;   /* epoll instance */
+static pid_t            _ee_pid = 0;     /* Process that created the epoll instance */
+static struct event_fd *_ee_fds = NULL;  /* Registrations indexed by fd */
+static int              _ee_fdlen = 0;   /* Length of _ee_fds */
+static uint32_t         _ee_gen = 0;     /* Last generation */
+static int              _ee_always = 0;  /* Number of always ready fds */
+#endif
+
 /* If set (eg by signal handler) exit select loop on next run and return 0 */
 static int _clicon_exit = 0;
 
@@ -172,26 +213,188 @@ clicon_sig_ignore_get(void)
     return _clicon_sig_ignore;
 }
 
-/*! Register a callback function to be called on input on a file descriptor.
+#ifdef EVENT_LOOP_EPOLL
+static int clixon_event_epoll_add(struct event_data *e);
+
+/*! Create the epoll instance, or a new instance in a forked child
+ *
+ * A forked child shares the epoll instance with its parent, and would modify the
+ * registrations of the parent. Instead, the child creates its own instance and adds
+ * its inherited registrations to it.
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+clixon_event_epoll_init(void)
+{
+    struct event_data *e;
+    int                fd;
+
+    if (_ee_epfd != -1 && _ee_pid == getpid())
+        return 0;
+    if (_ee_epfd != -1){
+        close(_ee_epfd);
+        for (fd = 0; fd < _ee_fdlen; fd++){
+            _ee_fds[fd].ef_list = NULL;
+            _ee_fds[fd].ef_always = 0;
+        }
+        _ee_always = 0;
+    }
+    if ((_ee_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0){
+        clixon_err(OE_EVENTS, errno, "epoll_create1");
+        return -1;
+    }
+    _ee_pid = getpid();
+    for (e = ee; e; e = e->e_next)
+        if (clixon_event_epoll_add(e) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Events of all registrations of a file descriptor
+ *
+ * @param[in]  ef  File descriptor registrations
+ * @retval     events  EPOLLIN and/or EPOLLOUT
+ */
+static uint32_t
+clixon_event_epoll_events(struct event_fd *ef)
+{
+    struct event_data *e;
+    uint32_t           events = 0;
+
+    for (e = ef->ef_list; e; e = e->e_fdnext){
+        events |= e->e_write ? EPOLLOUT : EPOLLIN;
+    }
+    return events;
+}
+
+/*! Add file descriptor registration to epoll instance
+ *
+ * The fd is added to the epoll instance on its first registration, the event data
+ * is the fd and a generation number. The events of the fd are modified if a registration
+ * for writing is added to one for reading, or vice-versa.
+ * Regular files cannot be polled by epoll but are always ready, as with select.
+ * @param[in]  e   File descriptor event
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+clixon_event_epoll_add(struct event_data *e)
+{
+    struct epoll_event ev = {0,};
+    struct event_fd   *ef;
+    int                len;
+
+    if (clixon_event_epoll_init() < 0)
+        return -1;
+    if (e->e_fd < 0){
+        clixon_err(OE_EVENTS, EBADF, "Invalid fd %d", e->e_fd);
+        return -1;
+    }
+    if (e->e_fd >= _ee_fdlen){
+        len = _ee_fdlen ? _ee_fdlen : 64;
+        while (len <= e->e_fd)
+            len *= 2;
+        if ((ef = realloc(_ee_fds, len*sizeof(*ef))) == NULL){
+            clixon_err(OE_EVENTS, errno, "realloc");
+            return -1;
+        }
+        memset(ef + _ee_fdlen, 0, (len - _ee_fdlen)*sizeof(*ef));
+        _ee_fds = ef;
+        _ee_fdlen = len;
+    }
+    ef = &_ee_fds[e->e_fd];
+    if (ef->ef_list == NULL){
+        ef->ef_gen = ++_ee_gen;
+        ev.events = e->e_write ? EPOLLOUT : EPOLLIN;
+        ev.data.u64 = ((uint64_t)ef->ef_gen << 32) | (uint32_t)e->e_fd;
+        if (epoll_ctl(_ee_epfd, EPOLL_CTL_ADD, e->e_fd, &ev) < 0){
+            if (errno == EPERM){
+                ef->ef_always = 1;
+                _ee_always++;
+            }
+            else if (errno != EEXIST ||
+                     epoll_ctl(_ee_epfd, EPOLL_CTL_MOD, e->e_fd, &ev) < 0){
+                clixon_err(OE_EVENTS, errno, "epoll_ctl %s", e->e_string);
+                return -1;
+            }
+        }
+        ef->ef_events = ev.events;
+    }
+    e->e_fdnext = ef->ef_list;
+    ef->ef_list = e;
+    if (!ef->ef_always &&
+        (ev.events = clixon_event_epoll_events(ef)) != ef->ef_events){
+        ev.data.u64 = ((uint64_t)ef->ef_gen << 32) | (uint32_t)e->e_fd;
+        if (epoll_ctl(_ee_epfd, EPOLL_CTL_MOD, e->e_fd, &ev) < 0){
+            ef->ef_list = e->e_fdnext;
+            clixon_err(OE_EVENTS, errno, "epoll_ctl %s", e->e_string);
+            return -1;
+        }
+        ef->ef_events = ev.events;
+    }
+    return 0;
+}
+
+/*! Remove file descriptor registration from epoll instance
+ *
+ * The fd is removed from the epoll instance when its last registration is removed.
+ * The fd may already be closed, in which case epoll has removed it.
+ * @param[in]  e   File descriptor event
+ */
+static void
+clixon_event_epoll_del(struct event_data *e)
+{
+    struct event_fd    *ef;
+    struct event_data **ep;
+    struct epoll_event  ev = {0,};
+
+    if (clixon_event_epoll_init() < 0 || e->e_fd >= _ee_fdlen)
+        return;
+    ef = &_ee_fds[e->e_fd];
+    for (ep = &ef->ef_list; *ep; ep = &(*ep)->e_fdnext)
+        if (*ep == e){
+            *ep = e->e_fdnext;
+            break;
+        }
+    if (ef->ef_list != NULL){
+        if (!ef->ef_always &&
+            (ev.events = clixon_event_epoll_events(ef)) != ef->ef_events){
+            ev.data.u64 = ((uint64_t)ef->ef_gen << 32) | (uint32_t)e->e_fd;
+            if (epoll_ctl(_ee_epfd, EPOLL_CTL_MOD, e->e_fd, &ev) == 0)
+                ef->ef_events = ev.events;
+        }
+        return;
+    }
+    if (ef->ef_always){
+        ef->ef_always = 0;
+        _ee_always--;
+    }
+    else
+        (void)epoll_ctl(_ee_epfd, EPOLL_CTL_DEL, e->e_fd, NULL);
+    ef->ef_gen = 0;
+    ef->ef_events = 0;
+}
+#endif /* EVENT_LOOP_EPOLL */
+
+/*! Register a file descriptor callback
  *
  * @param[in]  fd   File descriptor
  * @param[in]  fn   Function to call when input available on fd
  * @param[in]  arg  Argument to function fn
  * @param[in]  str  Describing string for logging
  * @param[in]  prio Priority (0 or 1)
- * @code
- * int fn(int fd, void *arg){
- * }
- * clixon_event_reg_fd(fd, fn, (void*)42, "call fn on input on fd");
- * @endcode 
- * @see clixon_event_unreg_fd
+ * @param[in]  wr   Call fn when fd is writable instead of readable (0 or 1)
+ * @retval     0    OK
+ * @retval    -1    Error
  */
-int
-clixon_event_reg_fd_prio(int   fd,
-                         int (*fn)(int, void*),
-                         void *arg,
-                         char *str,
-                         int   prio)
+static int
+clixon_event_reg_fd_all(int   fd,
+                        int (*fn)(int, void*),
+                        void *arg,
+                        char *str,
+                        int   prio,
+                        int   wr)
 {
     struct event_data *e;
 
@@ -206,19 +409,70 @@ clixon_event_reg_fd_prio(int   fd,
     e->e_arg = arg;
     e->e_type = EVENT_FD;
     e->e_prio = prio;
+    e->e_write = wr;
+#ifdef EVENT_LOOP_EPOLL
+    if (clixon_event_epoll_add(e) < 0){
+        free(e);
+        return -1;
+    }
+#endif
     e->e_next = ee;
     ee = e;
     clixon_debug(CLIXON_DBG_EVENT, "registering %s", e->e_string);
     return 0;
 }
 
+/*! Register a callback function to be called on input on a file descriptor.
+ *
+ * @param[in]  fd   File descriptor
+ * @param[in]  fn   Function to call when input available on fd
+ * @param[in]  arg  Argument to function fn
+ * @param[in]  str  Describing string for logging
+ * @param[in]  prio Priority (0 or 1)
+ * @code
+ * int fn(int fd, void *arg){
+ * }
+ * clixon_event_reg_fd(fd, fn, (void*)42, "call fn on input on fd");
+ * @endcode 
+ * @see clixon_event_unreg_fd
+ */
+int
+clixon_event_reg_fd_prio(int   fd,
+                         int (*fn)(int, void*),
+                         void *arg,
+                         char *str,
+                         int   prio)
+{
+    return clixon_event_reg_fd_all(fd, fn, arg, str, prio, 0);
+}
+
 int
 clixon_event_reg_fd(int   fd,
                     int (*fn)(int, void*),
                     void *arg,
                     char *str)
 {
-    return clixon_event_reg_fd_prio(fd, fn, arg, str, 0);
+    return clixon_event_reg_fd_all(fd, fn, arg, str, 0, 0);
+}
+
+/*! Register a callback function to be called when a file descriptor is writable
+ *
+ * Use when output is queued on a non-blocking fd, and unregister with clixon_event_unreg_fd
+ * when the queue is empty, otherwise fn is called in every event loop.
+ * The same fd may also be registered for input, with another function.
+ * @param[in]  fd   File descriptor
+ * @param[in]  fn   Function to call when fd is writable
+ * @param[in]  arg  Argument to function fn
+ * @param[in]  str  Describing string for logging
+ * @see clixon_event_unreg_fd
+ */
+int
+clixon_event_reg_fd_write(int   fd,
+                          int (*fn)(int, void*),
+                          void *arg,
+                          char *str)
+{
+    return clixon_event_reg_fd_all(fd, fn, arg, str, 0, 1);
 }
 
 /*! Deregister a file descriptor callback
@@ -245,6 +499,9 @@ clixon_event_unreg_fd(int   s,
             found++;
             *e_prev = e->e_next;
             _ee_unreg++;
+#ifdef EVENT_LOOP_EPOLL
+            clixon_event_epoll_del(e);
+#endif
             free(e);
             break;
         }
@@ -253,48 +510,124 @@ clixon_event_unreg_fd(int   s,
     return found?0:-1;
 }
 
-/*! Call a callback function at an absolute time
+/*! Timer a expires before timer b, timers with same time in registration order
+ */
+static inline int
+clixon_event_timer_less(struct event_data *a,
+                        struct event_data *b)
+{
+    if (timercmp(&a->e_time, &b->e_time, !=))
+        return timercmp(&a->e_time, &b->e_time, <);
+    return a->e_seq < b->e_seq;
+}
+
+/*! Move timer at index i towards the top of the heap until in order
+ */
+static void
+clixon_event_timer_up(int i)
+{
+    struct event_data *e = ee_timers[i];
+    int                parent;
+
+    while (i > 0){
+        parent = (i - 1) / 2;
+        if (!clixon_event_timer_less(e, ee_timers[parent]))
+            break;
+        ee_timers[i] = ee_timers[parent];
+        ee_timers[i]->e_heapidx = i;
+        i = parent;
+    }
+    ee_timers[i] = e;
+    e->e_heapidx = i;
+}
+
+/*! Move timer at index i towards the bottom of the heap until in order
+ */
+static void
+clixon_event_timer_down(int i)
+{
+    struct event_data *e = ee_timers[i];
+    int                child;
+
+    while ((child = 2*i + 1) < _ee_timerlen){
+        if (child + 1 < _ee_timerlen &&
+            clixon_event_timer_less(ee_timers[child+1], ee_timers[child]))
+            child++;
+        if (!clixon_event_timer_less(ee_timers[child], e))
+            break;
+        ee_timers[i] = ee_timers[child];
+        ee_timers[i]->e_heapidx = i;
+        i = child;
+    }
+    ee_timers[i] = e;
+    e->e_heapidx = i;
+}
+
+/*! Remove timer from heap and clear its handle, but do not free it
+ *
+ * @param[in]  e   Timer event
+ */
+static void
+clixon_event_timer_rm(struct event_data *e)
+{
+    int i = e->e_heapidx;
+
+    _ee_timerlen--;
+    if (i < _ee_timerlen){
+        ee_timers[i] = ee_timers[_ee_timerlen];
+        ee_timers[i]->e_heapidx = i;
+        if (i > 0 && clixon_event_timer_less(ee_timers[i], ee_timers[(i-1)/2]))
+            clixon_event_timer_up(i);
+        else
+            clixon_event_timer_down(i);
+    }
+    if (e->e_handle && *e->e_handle == e)
+        *e->e_handle = NULL;
+}
+
+/*! Call a callback function at an absolute time, and return a handle for removal
  *
+ * Same as clixon_event_reg_timeout, but the timer can be removed with
+ * clixon_event_unreg_timer using the handle, without searching for it.
+ * The handle is set to NULL when the timer is called or removed, so that the caller
+ * does not keep a stale handle. The handle must be valid while the timer is registered.
  * @param[in]  t   Absolute (not relative!) timestamp when callback is called
  * @param[in]  fn  Function to call at time t
  * @param[in]  arg Argument to function fn
  * @param[in]  str Describing string for logging
+ * @param[out] th  Timer handle, may be NULL
  * @retval     0   OK
  * @retval    -1   Error
- * @code
- * int fn(int d, void *arg){
- *   struct timeval t, t1;
- *   gettimeofday(&t, NULL);
- *   t1.tv_sec = 1; t1.tv_usec = 0;
- *   timeradd(&t, &t1, &t);
- *   clixon_event_reg_timeout(t, fn, NULL, "call every second");
- * } 
- * @endcode 
- * 
- * @note  The timestamp is an absolute timestamp, not relative.
- * @note  The callback is not periodic, you need to make a new registration for each period, see example.
- * @note  The first argument to fn is a dummy, just to get the same signature as for file-descriptor callbacks.
- * @see clixon_event_reg_fd
- * @see clixon_event_unreg_timeout
+ * @see clixon_event_unreg_timer
  */
 int
-clixon_event_reg_timeout(struct timeval t, 
-                         int          (*fn)(int, void*),
-                         void          *arg,
-                         char          *str)
+clixon_event_reg_timer(struct timeval       t,
+                       int                (*fn)(int, void*),
+                       void                *arg,
+                       char                *str,
+                       clixon_event_timer **th)
 {
     int                 retval = -1;
     struct event_data  *e;
-    struct event_data  *e1;
-    struct event_data **e_prev;
+    struct event_data **heap;
+    int                 len;
 
     if (str == NULL || fn == NULL){
         clixon_err(OE_CFG, EINVAL, "str or fn is NULL");
         goto done;
     }
+    if (_ee_timerlen == _ee_timermax){
+        len = _ee_timermax ? 2*_ee_timermax : 64;
+        if ((heap = realloc(ee_timers, len*sizeof(*heap))) == NULL){
+            clixon_err(OE_EVENTS, errno, "realloc");
+            goto done;
+        }
+        ee_timers = heap;
+        _ee_timermax = len;
+    }
     if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
         clixon_err(OE_EVENTS, errno, "malloc");
-        return -1;
+        goto done;
     }
     memset(e, 0, sizeof(struct event_data));
     strncpy(e->e_string, str, EVENT_STRLEN-1);
@@ -302,21 +635,71 @@ clixon_event_reg_timeout(struct timeval t,
     e->e_arg = arg;
     e->e_type = EVENT_TIME;
     e->e_time = t;
-    /* Sort into right place */
-    e_prev = &ee_timers;
-    for (e1=ee_timers; e1; e1=e1->e_next){
-        if (timercmp(&e->e_time, &e1->e_time, <))
-            break;
-        e_prev = &e1->e_next;
+    e->e_seq = ++_ee_timerseq;
+    if (th){
+        e->e_handle = th;
+        *th = e;
     }
-    e->e_next = e1;
-    *e_prev = e;
+    ee_timers[_ee_timerlen++] = e;
+    clixon_event_timer_up(_ee_timerlen - 1);
     clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "%s", str);
     retval = 0;
  done:
     return retval;
 }
 
+/*! Deregister a timer using the handle returned by clixon_event_reg_timer
+ *
+ * @param[in,out] th  Timer handle, set to NULL
+ * @retval        0   OK, timer unregistered
+ * @retval       -1   OK, but timer not registered (handle is NULL)
+ * @see clixon_event_reg_timer
+ */
+int
+clixon_event_unreg_timer(clixon_event_timer **th)
+{
+    struct event_data *e;
+
+    if (th == NULL || (e = *th) == NULL)
+        return -1;
+    clixon_event_timer_rm(e);
+    free(e);
+    return 0;
+}
+
+/*! Call a callback function at an absolute time
+ *
+ * @param[in]  t   Absolute (not relative!) timestamp when callback is called
+ * @param[in]  fn  Function to call at time t
+ * @param[in]  arg Argument to function fn
+ * @param[in]  str Describing string for logging
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @code
+ * int fn(int d, void *arg){
+ *   struct timeval t, t1;
+ *   gettimeofday(&t, NULL);
+ *   t1.tv_sec = 1; t1.tv_usec = 0;
+ *   timeradd(&t, &t1, &t);
+ *   clixon_event_reg_timeout(t, fn, NULL, "call every second");
+ * } 
+ * @endcode 
+ * 
+ * @note  The timestamp is an absolute timestamp, not relative.
+ * @note  The callback is not periodic, you need to make a new registration for each period, see example.
+ * @note  The first argument to fn is a dummy, just to get the same signature as for file-descriptor callbacks.
+ * @see clixon_event_reg_fd
+ * @see clixon_event_unreg_timeout
+ */
+int
+clixon_event_reg_timeout(struct timeval t, 
+                         int          (*fn)(int, void*),
+                         void          *arg,
+                         char          *str)
+{
+    return clixon_event_reg_timer(t, fn, arg, str, NULL);
+}
+
 /*! Deregister a timeout callback as previosly registered by clixon_event_reg_timeout()
  *
  * Note: deregister when exactly function and function arguments match, not time. So you
@@ -326,6 +709,7 @@ clixon_event_reg_timeout(struct timeval t,
  * @param[in]  arg  Argument to function fn
  * @retval     0    OK, timeout unregistered
  * @retval    -1    OK, but timeout not found
+ * @note Searches all timers, use clixon_event_unreg_timer with a handle for many timers
  * @see clixon_event_reg_timeout
  * @see clixon_event_unreg_fd
  */
@@ -333,21 +717,18 @@ int
 clixon_event_unreg_timeout(int (*fn)(int, void*),
                            void *arg)
 {
-    struct event_data  *e;
-    int                 found = 0;
-    struct event_data **e_prev;
+    struct event_data *e;
+    int                i;
 
-    e_prev = &ee_timers;
-    for (e = ee_timers; e; e = e->e_next){
+    for (i = 0; i < _ee_timerlen; i++){
+        e = ee_timers[i];
         if (fn == e->e_fn && arg == e->e_arg) {
-            found++;
-            *e_prev = e->e_next;
+            clixon_event_timer_rm(e);
             free(e);
-            break;
+            return 0;
         }
-        e_prev = &e->e_next;
     }
-    return found?0:-1;
+    return -1;
 }
 
 /*! Poll to see if there is any data available on this file descriptor.
@@ -357,7 +738,7 @@ clixon_event_unreg_timeout(int (*fn)(int, void*),
  * @retval     0    Nothing to read/empty fd
  * @retval    -1    Error
  */
-#ifdef CLIXON_EVENT_POLL
+#if defined(CLIXON_EVENT_POLL) || defined(EVENT_LOOP_EPOLL)
 int
 clixon_event_poll(int fd) {
     struct pollfd 	pfd;
@@ -390,7 +771,222 @@ clixon_event_poll(int fd)
 }
 #endif
 
-/*! Dispatch file descriptor events (and timeouts) by invoking callbacks.
+/*! Handle error of select or epoll_wait
+ *
+ * Signals are checked and are in three classes:
+ * (1) Signals that exit gracefully, the function returns 0
+ *     Must be registered such as by set_signal() of SIGTERM,SIGINT, etc with a handler that calls
+ *     clicon_exit_set().
+ * (2) SIGCHILD Childs that exit(), go through clixon_proc list and cal waitpid
+ *     New select loop is called
+ * (2) Signals are ignored, and the select is rerun, ie handler calls clicon_sig_ignore_get
+ *     New select loop is called
+ * (3) Other signals result in an error and return -1.
+ * @param[in] h    Clixon handle
+ * @param[in] call Name of failed call for logging
+ * @retval    1    Interrupted, continue event loop
+ * @retval   -1    Error or exit, break event loop
+ */
+static int
+clixon_event_intr(clixon_handle h,
+                  const char   *call)
+{
+    if (errno == EINTR){
+        clixon_debug(CLIXON_DBG_EVENT, "%s: %s", call, strerror(errno));
+        if (clixon_exit_get() == 1)
+            clixon_err(OE_EVENTS, errno, "%s", call);
+        else if (clicon_sig_child_get()){
+            /* Go through processes and wait for child processes */
+            if (clixon_process_waitpid(h) < 0)
+                return -1;
+            clicon_sig_child_set(0);
+            return 1;
+        }
+        else if (clicon_sig_ignore_get()){
+            clicon_sig_ignore_set(0);
+            return 1;
+        }
+        else
+            clixon_err(OE_EVENTS, errno, "%s", call);
+    }
+    else
+        clixon_err(OE_EVENTS, errno, "%s", call);
+    return -1;
+}
+
+/*! Call and remove first timeout
+ *
+ * @retval    0  OK
+ * @retval   -1  Error in callback
+ */
+static int
+clixon_event_timeout(void)
+{
+    struct event_data *e;
+
+    e = ee_timers[0];
+    clixon_event_timer_rm(e);
+    clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout: %s", e->e_string);
+    if ((*e->e_fn)(0, e->e_arg) < 0){
+        free(e);
+        return -1;
+    }
+    free(e);
+    return 0;
+}
+
+#ifdef EVENT_LOOP_EPOLL
+/*! Call callbacks of a ready file descriptor
+ *
+ * @param[in]  fd     File descriptor
+ * @param[in]  gen    Generation of event, if not current the event is stale
+ * @param[in]  events Ready events of fd
+ * @param[in]  prio   Only call callbacks of this priority
+ * @retval     1      Callback called
+ * @retval     0      No callback called
+ * @retval    -1      Error in callback
+ */
+static int
+clixon_event_epoll_dispatch(int      fd,
+                            uint32_t gen,
+                            uint32_t events,
+                            int      prio)
+{
+    struct event_data *e;
+    struct event_data *e_next;
+    int                called = 0;
+
+    if (fd < 0 || fd >= _ee_fdlen || _ee_fds[fd].ef_gen != gen)
+        return 0;
+    for (e = _ee_fds[fd].ef_list; e; e = e_next){
+        if (clixon_exit_get() == 1)
+            break;
+        e_next = e->e_fdnext;
+        if (e->e_prio != prio)
+            continue;
+        /* Errors and hangup are reported to both readers and writers */
+        if ((events & (e->e_write?EPOLLOUT:EPOLLIN)) == 0 &&
+            (events & (EPOLLERR|EPOLLHUP)) == 0)
+            continue;
+        clixon_debug(CLIXON_DBG_EVENT, "%s: %s prio:%d",
+                     e->e_write?"EPOLLOUT":"EPOLLIN", e->e_string, e->e_prio);
+        called++;
+        if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
+            clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
+            return -1;
+        }
+        /* Other fds are looked up by fd and generation, only this list may be changed */
+        if (_ee_unreg){
+            _ee_unreg = 0;
+            break;
+        }
+    }
+    return called?1:0;
+}
+
+/*! Dispatch file descriptor events (and timeouts) using epoll
+ *
+ * Registrations are kept in the epoll instance, and up to EVENT_EPOLL_MAXEVENTS ready
+ * file descriptors are dispatched in each loop.
+ * @param[in] h  Clixon handle
+ * @retval    0  OK
+ * @retval   -1  Error: eg epoll, callback, timer,
+ * @see clixon_event_loop_select  for the select variant
+ */
+static int
+clixon_event_loop_epoll(clixon_handle h)
+{
+    struct epoll_event evs[EVENT_EPOLL_MAXEVENTS];
+    struct timeval     t;
+    struct timeval     t0;
+    int                timeout;
+    int                n;
+    int                i;
+    int                fd;
+    int                prio;
+    int                sockprio;
+    int                stop;
+    int                ret;
+    int                retval = -1;
+
+    while (clixon_exit_get() != 1){
+        if (clicon_sig_child_get()){
+            /* Go through processes and wait for child processes */
+            if (clixon_process_waitpid(h) < 0)
+                goto err;
+            clicon_sig_child_set(0);
+        }
+        if (clixon_event_epoll_init() < 0)
+            goto err;
+        timeout = -1;
+        if (_ee_timerlen){
+            gettimeofday(&t0, NULL);
+            timersub(&ee_timers[0]->e_time, &t0, &t);
+            if (t.tv_sec < 0)
+                timeout = 0;
+            else if (t.tv_sec >= INT_MAX/1000 - 1)
+                timeout = INT_MAX;
+            else /* Round up to ms, not to wake up before the timeout */
+                timeout = t.tv_sec*1000 + (t.tv_usec+999)/1000;
+        }
+        if (_ee_always)
+            timeout = 0;
+        n = epoll_wait(_ee_epfd, evs, EVENT_EPOLL_MAXEVENTS, timeout);
+        if (clixon_exit_get() == 1){
+            break;
+        }
+        if (n == -1) {
+            if (clixon_event_intr(h, "epoll_wait") == 1)
+                continue;
+            goto err;
+        }
+        if (n == 0 && _ee_timerlen){ /* Timeout */
+            gettimeofday(&t0, NULL);
+            if (!timercmp(&t0, &ee_timers[0]->e_time, <) &&
+                clixon_event_timeout() < 0)
+                goto err;
+        }
+        _ee_unreg = 0;
+        /* First prio fds, then unprio. With prio, only one unprio fd as in select loop */
+        sockprio = clicon_option_bool(h, "CLICON_SOCK_PRIO");
+        stop = 0;
+        for (prio = sockprio; prio >= 0 && !stop; prio--){
+            for (i = 0; i < n && !stop; i++){
+                if (clixon_exit_get() == 1)
+                    break;
+                fd = (int)(evs[i].data.u64 & 0xffffffff);
+                if ((ret = clixon_event_epoll_dispatch(fd, (uint32_t)(evs[i].data.u64 >> 32),
+                                                       evs[i].events, prio)) < 0)
+                    goto err;
+                if (ret && sockprio && prio == 0)
+                    stop++;
+            }
+            for (fd = 0; _ee_always && fd < _ee_fdlen && !stop; fd++){
+                if (clixon_exit_get() == 1)
+                    break;
+                if (!_ee_fds[fd].ef_always)
+                    continue;
+                if ((ret = clixon_event_epoll_dispatch(fd, _ee_fds[fd].ef_gen,
+                                                       EPOLLIN|EPOLLOUT, prio)) < 0)
+                    goto err;
+                if (ret && sockprio && prio == 0)
+                    stop++;
+            }
+        }
+        clixon_exit_decr(); /* If exit is set and > 1, decrement it (and exit when 1) */
+        continue;
+      err:
+        clixon_debug(CLIXON_DBG_EVENT, "err");
+        break;
+    }
+    if (clixon_exit_get() == 1)
+        retval = 0;
+    clixon_debug(CLIXON_DBG_EVENT, "retval:%d", retval);
+    return retval;
+}
+#endif /* EVENT_LOOP_EPOLL */
+
+/*! Dispatch file descriptor events (and timeouts) using select
  *
  * @param[in] h  Clixon handle
  * @retval    0  OK
@@ -399,8 +995,8 @@ clixon_event_poll(int fd)
  *       Currently a socket that is not read/emptied properly starve timeouts.
  *       One could try to poll the file descriptors after a timeout?
  */
-int
-clixon_event_loop(clixon_handle h)
+static int
+clixon_event_loop_select(clixon_handle h)
 {
     struct event_data *e;
     int                n;
@@ -408,11 +1004,13 @@ clixon_event_loop(clixon_handle h)
     struct timeval     t0;
     struct timeval     tnull = {0,};
     fd_set             fdset;
+    fd_set             wfdset;
     int                retval = -1;
     struct event_data *e_next;
 
     while (clixon_exit_get() != 1){
         FD_ZERO(&fdset);
+        FD_ZERO(&wfdset);
         if (clicon_sig_child_get()){
             /* Go through processes and wait for child processes */
             if (clixon_process_waitpid(h) < 0)
@@ -421,64 +1019,28 @@ clixon_event_loop(clixon_handle h)
         }
         for (e=ee; e; e=e->e_next)
             if (e->e_type == EVENT_FD)
-                FD_SET(e->e_fd, &fdset);
-        if (ee_timers != NULL){
+                FD_SET(e->e_fd, e->e_write?&wfdset:&fdset);
+        if (_ee_timerlen){
             gettimeofday(&t0, NULL);
-            timersub(&ee_timers->e_time, &t0, &t);
+            timersub(&ee_timers[0]->e_time, &t0, &t);
             if (t.tv_sec < 0)
-                n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull);
+                n = select(FD_SETSIZE, &fdset, &wfdset, NULL, &tnull);
             else
-                n = select(FD_SETSIZE, &fdset, NULL, NULL, &t);
+                n = select(FD_SETSIZE, &fdset, &wfdset, NULL, &t);
         }
         else
-            n = select(FD_SETSIZE, &fdset, NULL, NULL, NULL);
+            n = select(FD_SETSIZE, &fdset, &wfdset, NULL, NULL);
         if (clixon_exit_get() == 1){
             break;
         }
         if (n == -1) {
-            if (errno == EINTR){
-                /* Signals are checked and are in three classes:
-                 * (1) Signals that exit gracefully, the function returns 0
-                 *     Must be registered such as by set_signal() of SIGTERM,SIGINT, etc with a handler that calls
-                 *     clicon_exit_set().
-                 * (2) SIGCHILD Childs that exit(), go through clixon_proc list and cal waitpid
-                 *     New select loop is called
-                 * (2) Signals are ignored, and the select is rerun, ie handler calls clicon_sig_ignore_get
-                 *     New select loop is called
-                 * (3) Other signals result in an error and return -1.
-                 */
-                clixon_debug(CLIXON_DBG_EVENT, "select: %s", strerror(errno));
-                if (clixon_exit_get() == 1){
-                    clixon_err(OE_EVENTS, errno, "select");
-                    retval = 0;
-                }
-                else if (clicon_sig_child_get()){
-                    /* Go through processes and wait for child processes */
-                    if (clixon_process_waitpid(h) < 0)
-                        goto err;
-                    clicon_sig_child_set(0);
-                    continue;
-                }
-                else if (clicon_sig_ignore_get()){
-                    clicon_sig_ignore_set(0);
-                    continue;
-                }
-                else
-                    clixon_err(OE_EVENTS, errno, "select");
-            }
-            else
-                clixon_err(OE_EVENTS, errno, "select");
+            if (clixon_event_intr(h, "select") == 1)
+                continue;
             goto err;
         }
         if (n==0){ /* Timeout */
-            e = ee_timers;
-            ee_timers = ee_timers->e_next;
-            clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout: %s", e->e_string);
-            if ((*e->e_fn)(0, e->e_arg) < 0){
-                free(e);
+            if (clixon_event_timeout() < 0)
                 goto err;
-            }
-            free(e);
         }
         _ee_unreg = 0;
         if (clicon_option_bool(h, "CLICON_SOCK_PRIO")){
@@ -486,7 +1048,7 @@ clixon_event_loop(clixon_handle h)
                 if (clixon_exit_get() == 1)
                     break;
                 e_next = e->e_next;
-                if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset) && e->e_prio){
+                if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, e->e_write?&wfdset:&fdset) && e->e_prio){
                     clixon_debug(CLIXON_DBG_EVENT, "FD_ISSET: %s prio:%d", e->e_string, e->e_prio);
                     if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
                         clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
@@ -506,7 +1068,7 @@ clixon_event_loop(clixon_handle h)
             if (clixon_exit_get() == 1)
                 break;
             e_next = e->e_next;
-            if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset) && e->e_prio==0){
+            if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, e->e_write?&wfdset:&fdset) && e->e_prio==0){
                 clixon_debug(CLIXON_DBG_EVENT, "FD_ISSET: %s", e->e_string);
                 if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
                     clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_string);
@@ -532,6 +1094,23 @@ clixon_event_loop(clixon_handle h)
     return retval;
 }
 
+/*! Dispatch file descriptor events (and timeouts) by invoking callbacks.
+ *
+ * @param[in] h  Clixon handle
+ * @retval    0  OK
+ * @retval   -1  Error: eg select, callback, timer, 
+ * @see EVENT_LOOP_EPOLL
+ */
+int
+clixon_event_loop(clixon_handle h)
+{
+#ifdef EVENT_LOOP_EPOLL
+    return clixon_event_loop_epoll(h);
+#else
+    return clixon_event_loop_select(h);
+#endif
+}
+
 int
 clixon_event_exit(void)
 {
@@ -544,11 +1123,24 @@ clixon_event_exit(void)
         free(e);
     }
     ee = NULL;
-    e_next = ee_timers;
-    while ((e = e_next) != NULL){
-        e_next = e->e_next;
+    while (_ee_timerlen){
+        e = ee_timers[0];
+        clixon_event_timer_rm(e);
         free(e);
     }
+    if (ee_timers)
+        free(ee_timers);
     ee_timers = NULL;
+    _ee_timermax = 0;
+#ifdef EVENT_LOOP_EPOLL
+    if (_ee_epfd != -1)
+        close(_ee_epfd);
+    _ee_epfd = -1;
+    if (_ee_fds)
+        free(_ee_fds);
+    _ee_fds = NULL;
+    _ee_fdlen = 0;
+    _ee_always = 0;
+#endif
     return 0;
 }
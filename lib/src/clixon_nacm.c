@@ -81,43 +81,505 @@
 /* NACM namespace for use with xml namespace contexts and xpath */
 #define NACM_NS "urn:ietf:params:xml:ns:yang:ietf-netconf-acm"
 
-/*! Match nacm access operations according to RFC8341 3.4.4.  
+/* Compiled access-operations bit of enum nacm_access */
+#define NACM_OP(access) (1 << (access))
+#define NACM_OPS_ALL    (NACM_OP(NACM_CREATE)|NACM_OP(NACM_READ)|NACM_OP(NACM_UPDATE)|NACM_OP(NACM_DELETE)|NACM_OP(NACM_EXEC))
+
+/* Rpc decisions, also values of per-user rpc decision cache */
+#define NACM_RPC_DENY         0 /* Matching rule with deny action */
+#define NACM_RPC_PERMIT       1
+#define NACM_RPC_DEFAULT_DENY 2 /* No matching rule and default deny */
+
+/* Compiled NACM rule
+ * Strings point into the NACM tree of the compiled NACM, except path
+ */
+struct nacm_rule{
+    char    *nr_module;  /* module-name, NULL if not present */
+    char    *nr_rpc;     /* rpc-name, NULL if not present */
+    int      nr_notif;   /* notification-name is present */
+    char    *nr_path;    /* Trimmed path (malloced), NULL if not present */
+    int      nr_ops;     /* access-operations as NACM_OP() bits */
+    int      nr_action;  /* 1: permit, 0: deny, -1: not present */
+};
+typedef struct nacm_rule nacm_rule;
+
+/* Compiled NACM rule-list */
+struct nacm_rulelist{
+    char     **nrl_groups;  /* group leaf-list */
+    int        nrl_ngroups;
+    nacm_rule *nrl_rules;   /* Rules in configured order */
+    int        nrl_nrules;
+};
+typedef struct nacm_rulelist nacm_rulelist;
+
+/* Per-user part of compiled NACM, groups and cached decisions */
+struct nacm_user{
+    char          **nu_groups;              /* Groups of the user */
+    int             nu_ngroups;
+    int             nu_resolved;            /* NACM_OP() bits of resolved nu_rules */
+    nacm_rule     **nu_rules[NACM_EXEC+1];  /* Rules per access in rule-list order */
+    int             nu_nrules[NACM_EXEC+1];
+    clicon_hash_t  *nu_rpc;                 /* Rpc decisions keyed by "module:rpc" */
+};
+typedef struct nacm_user nacm_user;
+
+/* NACM configuration compiled from a NACM tree */
+struct nacm_compiled{
+    cxobj          *nc_xnacm;         /* Copy of the NACM tree, not modified */
+    cxobj          *nc_xlast;         /* NACM tree of last call, not dereferenced */
+    uint64_t        nc_gen;           /* Generation of NACM tree of last call */
+    char           *nc_read_default;
+    char           *nc_write_default;
+    char           *nc_exec_default;
+    nacm_rulelist  *nc_rlists;        /* Rule-lists in configured order */
+    int             nc_nrlists;
+    clicon_hash_t  *nc_users;         /* user-name -> nacm_user* */
+};
+typedef struct nacm_compiled nacm_compiled;
+
+/* Compiled NACM of last request
+ * With NACM_COMPILED it is reused as long as the NACM tree is unchanged.
+ */
+static nacm_compiled *_nacm_compiled = NULL;
+
+/* Generation of the NACM tree of the current request, see nacm_access_pre
+ * Generation of running in internal mode, 0 in external mode
+ */
+static uint64_t _nacm_gen = 0;
+
+/*! Compile nacm access operations according to RFC8341 3.4.4.  
  *
- * Incoming RPC Message Validation Step 7 (c)
- *  The rule's "access-operations" leaf has the "exec" bit set or
- *  has the special value "*".
- * @param[in] mode  Primary mode, eg read, create, update, delete, exec
- * @param[in] mode2 Secondary mode, eg "write"
- * @retval    1     Match
- * @retval    0     No match
- * @note access_operations is bit-fields
+ * "write" is short-hand for create, update and delete
+ * @param[in] access_operations  Value of access-operations leaf, or NULL
+ * @retval    ops                NACM_OP() bits
  */
 static int
-match_access(char *access_operations,
-             char *mode,
-             char *mode2)
+nacm_access_ops(char *access_operations)
 {
-    if (access_operations==NULL)
+    int ops = 0;
+
+    if (access_operations == NULL)
         return 0;
-    if (strcmp(access_operations,"*")==0)
-        return 1;
-    if (strstr(access_operations, mode)!=NULL)
-        return 1;
-    if (mode2 && strstr(access_operations, mode2)!=NULL)
-        return 1;
+    if (strcmp(access_operations, "*") == 0)
+        return NACM_OPS_ALL;
+    if (strstr(access_operations, "create") != NULL)
+        ops |= NACM_OP(NACM_CREATE);
+    if (strstr(access_operations, "read") != NULL)
+        ops |= NACM_OP(NACM_READ);
+    if (strstr(access_operations, "update") != NULL)
+        ops |= NACM_OP(NACM_UPDATE);
+    if (strstr(access_operations, "delete") != NULL)
+        ops |= NACM_OP(NACM_DELETE);
+    if (strstr(access_operations, "exec") != NULL)
+        ops |= NACM_OP(NACM_EXEC);
+    if (strstr(access_operations, "write") != NULL)
+        ops |= NACM_OP(NACM_CREATE)|NACM_OP(NACM_UPDATE)|NACM_OP(NACM_DELETE);
+    return ops;
+}
+
+/*! Compare two NACM trees by name, body and children in order
+ *
+ * @param[in]  x0   First XML tree
+ * @param[in]  x1   Second XML tree
+ * @retval     1    Equal
+ * @retval     0    Not equal
+ * @note Does not depend on YANG binding, since an external NACM tree may be unbound
+ */
+static int
+nacm_xml_equal(cxobj *x0,
+               cxobj *x1)
+{
+    cxobj *x0c = NULL;
+    cxobj *x1c = NULL;
+
+    if (strcmp(xml_name(x0), xml_name(x1)) != 0)
+        return 0;
+    if (clicon_strcmp(xml_body(x0), xml_body(x1)) != 0)
+        return 0;
+    for (;;){
+        x0c = xml_child_each(x0, x0c, CX_ELMNT);
+        x1c = xml_child_each(x1, x1c, CX_ELMNT);
+        if (x0c == NULL || x1c == NULL)
+            break;
+        if (!nacm_xml_equal(x0c, x1c))
+            return 0;
+    }
+    return x0c == NULL && x1c == NULL;
+}
+
+/*! Free compiled NACM user
+ */
+static int
+nacm_user_free(nacm_user *nu)
+{
+    int i;
+
+    if (nu->nu_groups)
+        free(nu->nu_groups);
+    for (i=0; i<=NACM_EXEC; i++)
+        if (nu->nu_rules[i])
+            free(nu->nu_rules[i]);
+    if (nu->nu_rpc)
+        clicon_hash_free(nu->nu_rpc);
+    free(nu);
+    return 0;
+}
+
+/*! Free compiled NACM
+ */
+static int
+nacm_compiled_free(nacm_compiled *nc)
+{
+    nacm_rulelist *nrl;
+    nacm_user     *nu;
+    char         **keys = NULL;
+    size_t         klen = 0;
+    int            i;
+    int            j;
+
+    if (nc->nc_users){
+        if (clicon_hash_keys(nc->nc_users, &keys, &klen) == 0)
+            for (i=0; i<klen; i++){
+                nu = *(nacm_user**)clicon_hash_value(nc->nc_users, keys[i], NULL);
+                nacm_user_free(nu);
+            }
+        if (keys)
+            free(keys);
+        clicon_hash_free(nc->nc_users);
+    }
+    for (i=0; i<nc->nc_nrlists; i++){
+        nrl = &nc->nc_rlists[i];
+        if (nrl->nrl_groups)
+            free(nrl->nrl_groups);
+        for (j=0; j<nrl->nrl_nrules; j++)
+            if (nrl->nrl_rules[j].nr_path)
+                free(nrl->nrl_rules[j].nr_path);
+        if (nrl->nrl_rules)
+            free(nrl->nrl_rules);
+    }
+    if (nc->nc_rlists)
+        free(nc->nc_rlists);
+    if (nc->nc_xnacm)
+        xml_free(nc->nc_xnacm);
+    free(nc);
+    return 0;
+}
+
+/*! Append a string pointer to a vector
+ */
+static int
+nacm_strvec_append(char ***vecp,
+                   int    *lenp,
+                   char   *str)
+{
+    char **vec;
+
+    if ((vec = realloc(*vecp, (*lenp+1)*sizeof(char*))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    vec[(*lenp)++] = str;
+    *vecp = vec;
+    return 0;
+}
+
+/*! Compile a NACM rule
+ *
+ * @param[in]  xrule  NACM rule XML tree
+ * @param[out] nr     Compiled rule
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+nacm_rule_compile(cxobj     *xrule,
+                  nacm_rule *nr)
+{
+    int    retval = -1;
+    cxobj *pathobj;
+    char  *action;
+    char  *path0;
+    char  *path = NULL;
+
+    nr->nr_module = xml_find_body(xrule, "module-name");
+    nr->nr_rpc = xml_find_body(xrule, "rpc-name");
+    nr->nr_notif = xml_find_body(xrule, "notification-name") != NULL;
+    nr->nr_ops = nacm_access_ops(xml_find_body(xrule, "access-operations"));
+    nr->nr_action = -1;
+    if ((action = xml_find_body(xrule, "action")) != NULL){
+        if (strcmp(action, "deny") == 0)
+            nr->nr_action = 0;
+        else if (strcmp(action, "permit") == 0)
+            nr->nr_action = 1;
+    }
+    if ((pathobj = xml_find_type(xrule, NULL, "path", CX_ELMNT)) != NULL){
+        /* Trim a copy, the NACM tree is compared with later NACM trees */
+        if ((path = strdup(xml_body(pathobj)?xml_body(pathobj):"")) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        path0 = clixon_trim2(path, " \t\n");
+        if ((nr->nr_path = strdup(path0)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+    }
+    retval = 0;
+ done:
+    if (path)
+        free(path);
+    return retval;
+}
+
+/*! Get compiled NACM user, create if not found
+ */
+static nacm_user *
+nacm_user_add(nacm_compiled *nc,
+              char          *username)
+{
+    nacm_user  *nu;
+    nacm_user **nup;
+
+    if ((nup = clicon_hash_value(nc->nc_users, username, NULL)) != NULL)
+        return *nup;
+    if ((nu = malloc(sizeof(*nu))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(nu, 0, sizeof(*nu));
+    if ((nu->nu_rpc = clicon_hash_init()) == NULL ||
+        clicon_hash_add(nc->nc_users, username, &nu, sizeof(nu)) == NULL){
+        nacm_user_free(nu);
+        return NULL;
+    }
+    return nu;
+}
+
+/*! Compile a NACM tree
+ *
+ * Groups are hashed by user-name, and rule-lists and rules are parsed in configured order.
+ * @param[in]  xnacm  NACM XML tree, root is "nacm". Copied
+ * @param[out] ncp    Compiled NACM, free with nacm_compiled_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+nacm_compile(cxobj          *xnacm,
+             nacm_compiled **ncp)
+{
+    int            retval = -1;
+    nacm_compiled *nc = NULL;
+    nacm_rulelist *nrl;
+    nacm_user     *nu;
+    cxobj         *xgroups;
+    cxobj         *xg;
+    cxobj         *xu;
+    cxobj         *xrl;
+    cxobj         *x;
+    char          *gname;
+    int            n;
+
+    if ((nc = malloc(sizeof(*nc))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(nc, 0, sizeof(*nc));
+    if ((nc->nc_xnacm = xml_dup(xnacm)) == NULL)
+        goto done;
+    if ((nc->nc_users = clicon_hash_init()) == NULL)
+        goto done;
+    xnacm = nc->nc_xnacm;
+    nc->nc_read_default = xml_find_body(xnacm, "read-default");
+    nc->nc_write_default = xml_find_body(xnacm, "write-default");
+    nc->nc_exec_default = xml_find_body(xnacm, "exec-default");
+    /* Groups by user-name */
+    if ((xgroups = xml_find_type(xnacm, NULL, "groups", CX_ELMNT)) != NULL){
+        xg = NULL;
+        while ((xg = xml_child_each(xgroups, xg, CX_ELMNT)) != NULL) {
+            if (strcmp(xml_name(xg), "group") != 0 ||
+                (gname = xml_find_body(xg, "name")) == NULL)
+                continue;
+            xu = NULL;
+            while ((xu = xml_child_each(xg, xu, CX_ELMNT)) != NULL) {
+                if (strcmp(xml_name(xu), "user-name") != 0 || xml_body(xu) == NULL)
+                    continue;
+                if ((nu = nacm_user_add(nc, xml_body(xu))) == NULL)
+                    goto done;
+                if (nacm_strvec_append(&nu->nu_groups, &nu->nu_ngroups, gname) < 0)
+                    goto done;
+            }
+        }
+    }
+    /* Rule-lists and rules in order */
+    n = xml_child_nr_type(xnacm, CX_ELMNT);
+    if (n && (nc->nc_rlists = calloc(n, sizeof(nacm_rulelist))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    xrl = NULL;
+    while ((xrl = xml_child_each(xnacm, xrl, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(xrl), "rule-list") != 0)
+            continue;
+        nrl = &nc->nc_rlists[nc->nc_nrlists++];
+        n = xml_child_nr_type(xrl, CX_ELMNT);
+        if (n && (nrl->nrl_rules = calloc(n, sizeof(nacm_rule))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        x = NULL;
+        while ((x = xml_child_each(xrl, x, CX_ELMNT)) != NULL) {
+            if (strcmp(xml_name(x), "group") == 0 && xml_body(x) != NULL){
+                if (nacm_strvec_append(&nrl->nrl_groups, &nrl->nrl_ngroups, xml_body(x)) < 0)
+                    goto done;
+            }
+            else if (strcmp(xml_name(x), "rule") == 0){
+                if (nacm_rule_compile(x, &nrl->nrl_rules[nrl->nrl_nrules++]) < 0)
+                    goto done;
+            }
+        }
+    }
+    *ncp = nc;
+    nc = NULL;
+    retval = 0;
+ done:
+    if (nc)
+        nacm_compiled_free(nc);
+    return retval;
+}
+
+/*! Get compiled NACM of a NACM tree
+ *
+ * With NACM_COMPILED, the NACM tree is compiled only when it differs from the tree
+ * of the previous call, otherwise it is compiled on every call.
+ * The trees are only compared when the generation of running has changed since the previous
+ * call, ie once after a commit, not on every access check. In external mode, where there
+ * is no generation, they are compared once per request.
+ * @note xnacm is assumed to be the NACM tree of the current request, see nacm_access_pre
+ * @param[in]  xnacm  NACM XML tree, root is "nacm"
+ * @param[out] ncp    Compiled NACM, valid until next call. Do not free
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+nacm_compiled_get(cxobj          *xnacm,
+                  nacm_compiled **ncp)
+{
+#ifdef NACM_COMPILED
+    nacm_compiled *nc;
+
+    if ((nc = _nacm_compiled) != NULL){
+        /* Running is unchanged since compiled or compared, or in external mode same tree
+         * as last call, or else equal tree */
+        if ((_nacm_gen != 0 && nc->nc_gen == _nacm_gen) ||
+            (_nacm_gen == 0 && nc->nc_xlast == xnacm) ||
+            nacm_xml_equal(nc->nc_xnacm, xnacm)){
+            nc->nc_xlast = xnacm;
+            nc->nc_gen = _nacm_gen;
+            *ncp = nc;
+            return 0;
+        }
+    }
+#endif
+    if (_nacm_compiled != NULL){
+        nacm_compiled_free(_nacm_compiled);
+        _nacm_compiled = NULL;
+    }
+    if (nacm_compile(xnacm, &_nacm_compiled) < 0)
+        return -1;
+    _nacm_compiled->nc_xlast = xnacm;
+    _nacm_compiled->nc_gen = _nacm_gen;
+    *ncp = _nacm_compiled;
+    return 0;
+}
+
+/*! Free compiled NACM, eg on exit
+ */
+int
+nacm_compiled_exit(void)
+{
+    if (_nacm_compiled != NULL){
+        nacm_compiled_free(_nacm_compiled);
+        _nacm_compiled = NULL;
+    }
     return 0;
 }
 
+/*! Get rules of a user that apply to an access operation
+ *
+ * Rules of rule-lists with any of the user's groups, in order, whose access-operations
+ * match the access and whose rule-type is consistent with it. Resolved on first use.
+ * @param[in]  nu      Compiled NACM user
+ * @param[in]  nc      Compiled NACM
+ * @param[in]  access  NACM access
+ * @param[out] rulesp  Vector of rules, do not free
+ * @param[out] lenp    Length of rule vector
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+nacm_user_rules(nacm_compiled    *nc,
+                nacm_user        *nu,
+                enum nacm_access  access,
+                nacm_rule      ***rulesp,
+                int              *lenp)
+{
+    int            retval = -1;
+    nacm_rulelist *nrl;
+    nacm_rule     *nr;
+    nacm_rule    **vec;
+    int            i;
+    int            j;
+    int            k;
+
+    if ((nu->nu_resolved & NACM_OP(access)) == 0){
+        for (i=0; i<nc->nc_nrlists; i++){
+            nrl = &nc->nc_rlists[i];
+            /* If a rule-list's "group" leaf-list does not match any of the user's groups,
+             * proceed to the next rule-list entry. */
+            for (j=0; j<nrl->nrl_ngroups; j++){
+                for (k=0; k<nu->nu_ngroups; k++)
+                    if (strcmp(nrl->nrl_groups[j], nu->nu_groups[k]) == 0)
+                        break;
+                if (k<nu->nu_ngroups)
+                    break;
+            }
+            if (j == nrl->nrl_ngroups)
+                continue;
+            for (j=0; j<nrl->nrl_nrules; j++){
+                nr = &nrl->nrl_rules[j];
+                if ((nr->nr_ops & NACM_OP(access)) == 0)
+                    continue;
+                if (access == NACM_EXEC){
+                    /* Either no rule-type or protocol-operation */
+                    if (nr->nr_rpc == NULL && (nr->nr_path || nr->nr_notif))
+                        continue;
+                }
+                else if (nr->nr_path == NULL && (nr->nr_rpc || nr->nr_notif))
+                    continue; /* Either no rule-type or data-node */
+                if ((vec = realloc(nu->nu_rules[access],
+                                   (nu->nu_nrules[access]+1)*sizeof(nacm_rule*))) == NULL){
+                    clixon_err(OE_UNIX, errno, "realloc");
+                    goto done;
+                }
+                vec[nu->nu_nrules[access]++] = nr;
+                nu->nu_rules[access] = vec;
+            }
+        }
+        nu->nu_resolved |= NACM_OP(access);
+    }
+    *rulesp = nu->nu_rules[access];
+    *lenp = nu->nu_nrules[access];
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Match nacm single rule. Either match with access or deny. Or not match.
  *
  * @param[in]  rpc    rpc name
  * @param[in]  module Yang module name
- * @param[in]  xrule  NACM rule XML tree
- * @param[out] cbret  Cligen buffer result. Set to an error msg if retval=0.
- * @retval     2      No matching rule Goto step 10
- * @retval     1      Matching rule AND Access
- * @retval     0      Matching rule AND Not access and cbret set
- * @retval    -1      Error
+ * @param[in]  nr     Compiled NACM rule, access-operations and rule-type already matched
+ * @retval     1      Matching rule
+ * @retval     0      Not matching rule
  * @see RFC8341 3.4.4.  Incoming RPC Message Validation
  7.(cont) A rule matches if all of the following criteria are met: 
         *  The rule's "module-name" leaf is "*" or equals the name of
@@ -130,48 +592,94 @@ match_access(char *access_operations,
 
         *  The rule's "access-operations" leaf has the "exec" bit set or
            has the special value "*".
+ * @see nacm_user_rules where rule-type and access-operations are matched
  */
 static int
-nacm_rule_rpc(char         *rpc,
-              char         *module,
-              cxobj        *xrule)
+nacm_rule_rpc(char      *rpc,
+              char      *module,
+              nacm_rule *nr)
 {
-    int    retval = -1;
-    char  *module_rule; /* rule module name */
-    char  *rpc_rule;
-    char  *access_operations;
-
     /*  7a) The rule's "module-name" leaf is "*" or equals the name of
         the YANG module where the protocol operation is defined. */
-    if ((module_rule = xml_find_body(xrule, "module-name")) == NULL)
-        goto nomatch;
-    if (strcmp(module_rule,"*") && strcmp(module_rule,module))
-        goto nomatch;
-    /*  7b) Either (1) the rule does not have a "rule-type" defined or
-        (2) the "rule-type" is "protocol-operation" and the
+    if (nr->nr_module == NULL)
+        return 0;
+    if (strcmp(nr->nr_module, "*") && strcmp(nr->nr_module, module))
+        return 0;
+    /*  7b) (2) the "rule-type" is "protocol-operation" and the
         "rpc-name" is "*" or equals the name of the requested
         protocol operation. */
-    if ((rpc_rule = xml_find_body(xrule, "rpc-name")) == NULL){
-        if (xml_find_body(xrule, "path") || xml_find_body(xrule, "notification-name"))
-            goto nomatch;
+    if (nr->nr_rpc && (strcmp(nr->nr_rpc, "*") && strcmp(nr->nr_rpc, rpc)))
+        return 0;
+    return 1;
+}
+
+/*! Decide on incoming RPC message according to compiled NACM
+ *
+ * @param[in]  nc      Compiled NACM
+ * @param[in]  nu      Compiled NACM user, or NULL if no user or no groups
+ * @param[in]  rpc     rpc name
+ * @param[in]  module  Yang module name
+ * @param[out] decision  NACM_RPC_PERMIT, NACM_RPC_DENY or NACM_RPC_DEFAULT_DENY
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+nacm_rpc_decide(nacm_compiled *nc,
+                nacm_user     *nu,
+                char          *rpc,
+                char          *module,
+                int           *decision)
+{
+    nacm_rule **rules;
+    int         rlen;
+    int         i;
+
+    /* 5. If no groups are found, continue with step 10. */
+    if (nu == NULL)
+        goto step10;
+    /* 6. Process all rule-list entries, in the order they appear in the
+        configuration.
+       7. For each rule-list entry found, process all rules, in order,
+          until a rule that matches the requested access operation is
+          found.
+    */
+    if (nacm_user_rules(nc, nu, NACM_EXEC, &rules, &rlen) < 0)
+        return -1;
+    for (i=0; i<rlen; i++){
+        if (nacm_rule_rpc(rpc, module, rules[i])){
+            if (rules[i]->nr_action == 0){
+                *decision = NACM_RPC_DENY;
+                return 0;
+            }
+            else if (rules[i]->nr_action == 1){
+                *decision = NACM_RPC_PERMIT;
+                return 0;
+            }
+            break;
+        }
     }
-    if (rpc_rule && (strcmp(rpc_rule, "*") && strcmp(rpc_rule, rpc)))
-        goto nomatch;
-    /* 7c) The rule's "access-operations" leaf has the "exec" bit set or
-        has the special value "*". */
-    access_operations = xml_find_body(xrule, "access-operations");
-    if (!match_access(access_operations, "exec", NULL))
-        goto nomatch;
-    retval = 1;
- done:
-    return retval;
- nomatch:
-    retval = 0;
-    goto done;
+ step10:
+    /*   10.  If the requested protocol operation is defined in a YANG module
+        advertised in the server capabilities and the "rpc" statement
+        contains a "nacm:default-deny-all" statement, then the protocol
+        operation is denied. */
+    /* 11.  If the requested protocol operation is the NETCONF
+        <kill-session> or <delete-config>, then the protocol operation
+        is denied. */
+    if (strcmp(rpc, "kill-session")==0 || strcmp(rpc, "delete-config")==0)
+        *decision = NACM_RPC_DEFAULT_DENY;
+    /*   12.  If the "exec-default" leaf is set to "permit", then permit the
+         protocol operation; otherwise, deny the request. */
+    else if (nc->nc_exec_default == NULL || strcmp(nc->nc_exec_default, "permit")==0)
+        *decision = NACM_RPC_PERMIT;
+    else
+        *decision = NACM_RPC_DEFAULT_DENY;
+    return 0;
 }
 
 /*! Process nacm incoming RPC message validation steps
  *
+ * Decisions are cached per user, module and rpc in the compiled NACM
  * @param[in]  module   Yang module name
  * @param[in]  rpc      rpc name
  * @param[in]  username User name of requestor
@@ -191,125 +699,69 @@ nacm_rpc(char         *rpc,
          cxobj        *xnacm,
          cbuf         *cbret)
 {
-    int     retval = -1;
-    cxobj  *xrule;
-    cxobj **gvec = NULL; /* groups */
-    size_t  glen;
-    cxobj  *rlist;
-    cxobj **rlistvec = NULL; /* rule-list */
-    size_t  rlistlen;
-    cxobj **rvec = NULL; /* rules */
-    size_t  rlen;
-    int     i, j;
-    char   *exec_default = NULL;
-    char   *gname;
-    char   *action;
-    int     match= 0;
-    cvec   *nsc = NULL;
-
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-        goto done;
+    int            retval = -1;
+    nacm_compiled *nc;
+    nacm_user     *nu = NULL;
+    nacm_user    **nup;
+    cbuf          *cbkey = NULL;
+    int           *dp;
+    int            decision;
+
     /* 3.   If the requested operation is the NETCONF <close-session>
        protocol operation, then the protocol operation is permitted.
     */
     if (strcmp(rpc, "close-session") == 0)
         goto permit;
+    if (nacm_compiled_get(xnacm, &nc) < 0)
+        goto done;
     /* 4.   Check all the "group" entries to see if any of them contain a
        "user-name" entry that equals the username for the session
        making the request.  (If the "enable-external-groups" leaf is
        "true", add to these groups the set of groups provided by the
        transport layer.)               */
-    if (username == NULL)
-        goto step10;
-
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
-        goto done;
-    /* 5. If no groups are found, continue with step 10. */
-    if (glen == 0)
-        goto step10;
-    /* 6. Process all rule-list entries, in the order they appear in the
-        configuration.  If a rule-list's "group" leaf-list does not
-        match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-        goto done;
-    for (i=0; i<rlistlen; i++){
-        rlist = rlistvec[i];
-        /* Loop through user's group to find match in this rule-list */
-        for (j=0; j<glen; j++){
-            gname = xml_find_body(gvec[j], "name");
-            if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-                break; /* found */
-        }
-        if (j==glen) /* not found */
-            continue;
-        /* 7. For each rule-list entry found, process all rules, in order,
-           until a rule that matches the requested access operation is
-           found.
-        */
-        if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
+    if (username != NULL &&
+        (nup = clicon_hash_value(nc->nc_users, username, NULL)) != NULL)
+        nu = *nup;
+    if (nu == NULL){
+        if (nacm_rpc_decide(nc, NULL, rpc, module, &decision) < 0)
             goto done;
-        for (j=0; j<rlen; j++){
-            xrule = rvec[j];
-            if ((match = nacm_rule_rpc(rpc, module, xrule)) < 0)
-                goto done;
-            if (match)
-                break;
-        }
-        if (match)
-            break;
-        if (rvec){
-            free(rvec);
-            rvec=NULL;
-        }
     }
-    if (match){
-        if ((action = xml_find_body(xrule, "action")) == NULL)
-            goto step10;
-        if (strcmp(action, "deny")==0){
-            if (netconf_access_denied(cbret, "application", "access denied") < 0)
+    else {
+        if ((cbkey = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cbkey, "%s:%s", module, rpc);
+        if ((dp = clicon_hash_value(nu->nu_rpc, cbuf_get(cbkey), NULL)) != NULL)
+            decision = *dp;
+        else {
+            if (nacm_rpc_decide(nc, nu, rpc, module, &decision) < 0)
+                goto done;
+            if (clicon_hash_add(nu->nu_rpc, cbuf_get(cbkey), &decision, sizeof(decision)) == NULL)
                 goto done;
-            goto deny;
         }
-        else if (strcmp(action, "permit")==0)
-            goto permit;
-
     }
- step10:
-    /*   10.  If the requested protocol operation is defined in a YANG module
-        advertised in the server capabilities and the "rpc" statement
-        contains a "nacm:default-deny-all" statement, then the protocol
-        operation is denied. */
-    /* 11.  If the requested protocol operation is the NETCONF
-        <kill-session> or <delete-config>, then the protocol operation
-        is denied. */
-    if (strcmp(rpc, "kill-session")==0 || strcmp(rpc, "delete-config")==0){
+    switch (decision){
+    case NACM_RPC_PERMIT:
+        goto permit;
+        break;
+    case NACM_RPC_DENY:
+        if (netconf_access_denied(cbret, "application", "access denied") < 0)
+            goto done;
+        goto deny;
+        break;
+    default:
         if (netconf_access_denied(cbret, "application", "default deny") < 0)
             goto done;
         goto deny;
+        break;
     }
-    /*   12.  If the "exec-default" leaf is set to "permit", then permit the
-         protocol operation; otherwise, deny the request. */
-    exec_default = xml_find_body(xnacm, "exec-default");
-    if (exec_default ==NULL || strcmp(exec_default, "permit")==0)
-        goto permit;
-    if (netconf_access_denied(cbret, "application", "default deny") < 0)
-        goto done;
-    goto deny;
  permit:
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_NACM, "retval:%d (0:deny 1:permit)", retval);
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
-    if (rvec)
-        free(rvec);
+    if (cbkey)
+        cbuf_free(cbkey);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
@@ -320,7 +772,7 @@ nacm_rpc(char         *rpc,
 /* Local struct for keeping preparation/compiled data in NACM data path code */
 struct prepvec{
     qelem_t       pv_q;
-    cxobj        *pv_xrule;
+    nacm_rule    *pv_rule;
     clixon_xvec  *pv_xpathvec;
 };
 typedef struct prepvec prepvec;
@@ -343,7 +795,7 @@ prepvec_free(prepvec *pv_list)
 
 prepvec *
 prepvec_add(prepvec  **pv_listp,
-            cxobj     *xrule)
+            nacm_rule *nr)
 {
     prepvec *pv;
 
@@ -353,7 +805,7 @@ prepvec_add(prepvec  **pv_listp,
     }
     memset(pv, 0, sizeof(*pv));
     ADDQ(pv, *pv_listp);
-    pv->pv_xrule = xrule;
+    pv->pv_rule = nr;
     if ((pv->pv_xpathvec = clixon_xvec_new()) == NULL)
         return NULL;
     return pv;
@@ -362,166 +814,104 @@ prepvec_add(prepvec  **pv_listp,
 /*! Prepare datastructures before running through XML tree
  *
  * Save rules in a "cache"
- * These rules match:
- *  - user/group
- *  - have read access-op, etc
- * Also make instance-id lookups on top object for each rule. Assume at most one result
- * @param[in] h      Clixon handle
- * @retval    0      OK
- * @retval   -1      Error
+ * The rules already match user/group, access-op and rule-type, see nacm_user_rules
+ * Make instance-id lookups on top object for each rule with a path.
+ * @param[in]  h        Clixon handle
+ * @param[in]  xt       XML root tree
+ * @param[in]  rules    Rules of the user that apply to the access
+ * @param[in]  rlen     Length of rules
+ * @param[out] pv_listp Rules and their path lookups
+ * @retval     0        OK
+ * @retval    -1        Error
  */
 static int
-nacm_datanode_prepare(clixon_handle     h,
-                      cxobj            *xt,
-                      enum nacm_access  access,
-                      cxobj           **gvec,
-                      size_t            glen,
-                      cxobj           **rlistvec,
-                      size_t            rlistlen,
-                      cvec             *nsc,
-                      prepvec         **pv_listp)
+nacm_datanode_prepare(clixon_handle h,
+                      cxobj        *xt,
+                      nacm_rule   **rules,
+                      int           rlen,
+                      prepvec     **pv_listp)
 {
     int        retval = -1;
-    cxobj     *rlist;
-    int        i;
     int        j;
     int        k;
-    char      *gname;
-    cxobj    **rvec = NULL; /* rules */
-    size_t     rlen;
-    cxobj     *xrule;
-    cxobj     *pathobj;
-    char      *access_operations;
-    char      *path0;         /* Non-canonical path */
-    char      *path=NULL;     /* Canonical path */
-    cvec      *nsc0 = NULL;   /* Non-canonical namespace context */
+    nacm_rule *nr;
     yang_stmt *yspec;
-    cxobj   **xvec = NULL;
-    int       xlen = 0;
-    int       ret;
-    prepvec *pv;
+    cxobj    **xvec = NULL;
+    int        xlen = 0;
+    int        ret;
+    prepvec   *pv;
 
     yspec = clicon_dbspec_yang(h);
-    for (i=0; i<rlistlen; i++){         /* Loop through rule list */
-        rlist = rlistvec[i];
-        /* Loop through user's group to find match in this rule-list */
-        for (j=0; j<glen; j++){
-            gname = xml_find_body(gvec[j], "name");
-            if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-                break; /* found */
+    for (j=0; j<rlen; j++){ /* Loop through rules */
+        nr = rules[j];
+        /*  6b) Either (1) the rule does not have a "rule-type" defined or
+            (2) the "rule-type" is "data-node" and the "path" matches the
+            requested data node, action node, or notification node. */    
+        if (nr->nr_path == NULL){
+            /* Here a new rule is found, add it */
+            if (prepvec_add(pv_listp, nr) == NULL)
+                goto done;
+            continue;
         }
-        if (j==glen) /* not found */
+        /* Non-canonical path, see https://github.com/clicon/clixon/issues/129 */
+        if ((ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", nr->nr_path)) < 0)
+            goto done;
+        if (ret == 0)
             continue;
-        /* 6. For each rule-list entry found, process all rules, in order,
-           until a rule that matches the requested access operation is
-           found. (see 6 sub rules in nacm_rule_datanode
-        */
-        if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
+        /* Here a new rule is found, add it */
+        if ((pv = prepvec_add(pv_listp, nr)) == NULL)
             goto done;
-        for (j=0; j<rlen; j++){ /* Loop through rules */
-            xrule = rvec[j];
-            /* 6c) For a "read" access operation, the rule's "access-operations"
-               leaf has the "read" bit set or has the special value "*" */
-            access_operations = xml_find_body(xrule, "access-operations");
-            switch (access){
-            case NACM_READ:
-                /* 6c) For a "read" access operation, the rule's "access-operations"
-                   leaf has the "read" bit set or has the special value "*" */
-                if (!match_access(access_operations, "read", NULL))
-                    continue;
-                break;
-            case NACM_CREATE:
-                /* 6d) For a "create" access operation, the rule's "access-operations"
-                   leaf has the "create" bit set or has the special value "*". */
-                if (!match_access(access_operations, "create", "write"))
-                    continue;
-                break;
-            case NACM_DELETE:
-                /* 6e) For a "delete" access operation, the rule's "access-operations" 
-                   leaf has the "delete" bit set or has the  special value "*". */
-                if (!match_access(access_operations, "delete", "write"))
-                    continue;
-                break;
-            case NACM_UPDATE:
-                /* 6f) For an "update" access operation, the rule's "access-operations"
-                   leaf has the "update" bit set or has the special value "*". */ 
-                if (!match_access(access_operations, "update", "write"))
-                    continue;
-                break;
-            default:
-                clixon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+        for (k=0; k<xlen; k++){
+            if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
                 goto done;
-                break;
-            }
-            /*  6b) Either (1) the rule does not have a "rule-type" defined or
-                (2) the "rule-type" is "data-node" and the "path" matches the
-                requested data node, action node, or notification node. */    
-            if ((pathobj = xml_find_type(xrule, NULL, "path", CX_ELMNT)) == NULL){
-                if (xml_find_body(xrule, "rpc-name") || xml_find_body(xrule, "notification-name"))
-                    continue;
-                /* Here a new xrule is found, add it */
-                if (prepvec_add(pv_listp, xrule) == NULL)
-                    goto done;
-            }
-            else{
-                path0 = clixon_trim2(xml_body(pathobj), " \t\n");
-                /* Get canonical namespace context for nacm paths */
-                if ((path = strdup(path0)) == NULL){
-                    clixon_err(OE_UNIX, errno, "strdup");
-                    goto done;
-                }
-#if 0
-                /* See https://github.com/clicon/clixon/issues/129:
-                 * If this is enabled, you are back to the problem of JSON encodings
-                 */
-                /* Create namespace context for with nacm namespace as default */
-                if (xml_nsctx_node(pathobj, &nsc0) < 0)
-                    goto done;
-                /* instance-id requires canonical paths */
-                if (xpath2canonical(path0, nsc0, yspec, &path, NULL) < 0)
-                    goto done;
-#endif
-                if ((ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", path)) < 0)
-                    goto done;
-                if (ret == 0)
-                    continue;
-                /* Here a new xrule is found, add it */
-                if ((pv = prepvec_add(pv_listp, xrule)) == NULL)
-                    goto done;
-                for (k=0; k<xlen; k++){
-                    if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
-                        goto done;
-                }
-                if (xvec){
-                    free(xvec);
-                    xvec = NULL;
-                }
-                if (nsc0){
-                    cvec_free(nsc0);
-                    nsc0 = NULL;
-                }
-                if (path){
-                    free(path);
-                    path = NULL;
-                }
-            }
         }
-        if (rvec){
-            free(rvec);
-            rvec=NULL;
+        if (xvec){
+            free(xvec);
+            xvec = NULL;
         }
     }
     retval = 0;
  done:
     if (xvec)
         free(xvec);
-    if (path)
-        free(path);
-    if (nsc0)
-        cvec_free(nsc0);
     return retval;
 }
 
+/*! Match module-name of a rule with the module of a requested node
+ *
+ * 6a) The rule's "module-name" leaf is "*" or equals the name of
+ * the YANG module where the requested data node is defined. 
+ * @param[in]     xn        XML node (requested node)
+ * @param[in]     nr        Compiled NACM rule
+ * @param[in]     yspec     YANG spec
+ * @param[in,out] ymodp     Module of xn, looked up once per node
+ * @param[in,out] resolvedp Set when ymodp is looked up
+ * @retval        1         Match
+ * @retval        0         No match
+ * @retval       -1         Error
+ */
+static int
+nacm_rule_module_match(cxobj      *xn,
+                       nacm_rule  *nr,
+                       yang_stmt  *yspec,
+                       yang_stmt **ymodp,
+                       int        *resolvedp)
+{
+    if (nr->nr_module == NULL)
+        return 0;
+    if (strcmp(nr->nr_module, "*") == 0)
+        return 1;
+    if (*resolvedp == 0){
+        if (ys_module_by_xml(yspec, xn, ymodp) < 0)
+            return -1;
+        *resolvedp = 1;
+    }
+    /* ymod is NULL (xn is "config") Can this breach the NACM rule? */
+    if (*ymodp && strcmp(yang_argument_get(*ymodp), nr->nr_module) != 0)
+        return 0;
+    return 1;
+}
+
 /*---------------------------------------------------------------
  * Datanode write
  */
@@ -529,76 +919,40 @@ nacm_datanode_prepare(clixon_handle     h,
 /*! Match specific rule to specific requested node
  *
  * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
- * @param[in]  xp       Xpath match
- * @param[in]  yspec    YANG spec
+ * @param[in]  nr       Compiled NACM rule
+ * @param[in]  xpathvec Xpath matches of rule path
  * @retval  2  OK and rule matches permit
  * @retval  1  OK and rule matches deny
  * @retval  0  OK and rule does not match
- * @retval -1  Error
+ * @note module-name is matched by caller
  */
 static int
 nacm_data_write_xrule_xml(cxobj       *xn,
-                          cxobj       *xrule,
-                          clixon_xvec *xpathvec,
-                          yang_stmt   *yspec)
+                          nacm_rule   *nr,
+                          clixon_xvec *xpathvec)
 {
-    int        retval = -1;
-    yang_stmt *ymod;
-    char      *module_pattern; /* rule module name */
-    char      *action;
-    cxobj     *xp;
-    int        i;
+    cxobj *xp;
+    int    i;
 
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
-        goto nomatch;
-    /* 6a) The rule's "module-name" leaf is "*" or equals the name of
-     * the YANG module where the requested data node is defined. 
-     */
-    if (strcmp(module_pattern, "*") != 0){
-        if (ys_module_by_xml(yspec, xn, &ymod) < 0)
-            goto done;
-        /* ymod is NULL (xn is "config") Can this breach the NACM rule? */
-        if (ymod && strcmp(yang_argument_get(ymod), module_pattern) != 0)
-            goto nomatch;
-    }
-    action = xml_find_body(xrule, "action"); /* mandatory */
     /*  6b) Either (1) the rule does not have a "rule-type" defined or
         (2) the "rule-type" is "data-node" and the "path" matches the
         Requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
-        if (strcmp(action, "deny")==0)
-            goto deny;
-        goto permit;
-    }
+    if (nr->nr_path == NULL)
+        return nr->nr_action == 0 ? 1 : 2;
     for (i=0; i<clixon_xvec_len(xpathvec); i++){
         xp = clixon_xvec_i(xpathvec, i);
         /* Check if ancestor is xp (for every xpathvec?) */
-        if (xn == xp || xml_isancestor(xn, xp)){
-            if (strcmp(action, "deny")==0)
-                goto deny;
-            goto permit;
-        }
+        if (xn == xp || xml_isancestor(xn, xp))
+            return nr->nr_action == 0 ? 1 : 2;
     }
-    goto nomatch;
- permit:
-    retval = 2;       /* rule match and permit */
- done:
-    return retval;
- nomatch :  /* rule does not match */
-    retval = 0;
-    goto done;
- deny:      /* rule match and deny */
-    retval = 1;
-    goto done;
+    return 0;
 }
 
 /*! Recursive check for NACM write rules among all XML nodes
  *
  * @param[in]  h         Clixon handle
  * @param[in]  xn        XML node (requested node)
- * @param[in]  rulevec   Precomputed rules that apply to this user group
- * @param[in]  xpathvec  Precomputed xpath results that apply to this XML tree
+ * @param[in]  pv_list   Precomputed rules + paths that apply to this user group
  * @param[in]  defpermit 0 if default deny, 1 is default permit
  * @param[in]  yspec     YANG spec
  * @param[out] cbret     Error message if retval = 0
@@ -618,18 +972,22 @@ nacm_datanode_write_recurse(clixon_handle h,
                             yang_stmt    *yspec,
                             cbuf         *cbret)
 {
-    int       retval = -1;
-    cxobj   *x;
-    int      ret = 0;
-    prepvec *pv;
+    int        retval = -1;
+    cxobj     *x;
+    int        ret = 0;
+    prepvec   *pv;
+    yang_stmt *ymod = NULL;
+    int        resolved = 0;
 
     pv = pv_list;
     if (pv){
         do {
             /* return values: -1:Error /0:no match /1: deny /2: permit
              */
-            if ((ret = nacm_data_write_xrule_xml(xn, pv->pv_xrule, pv->pv_xpathvec, yspec)) < 0)
+            if ((ret = nacm_rule_module_match(xn, pv->pv_rule, yspec, &ymod, &resolved)) < 0)
                 goto done;
+            if (ret == 1)
+                ret = nacm_data_write_xrule_xml(xn, pv->pv_rule, pv->pv_xpathvec);
             switch(ret){
             case 0: /* No match, continue with next rule */
                 break;
@@ -696,24 +1054,25 @@ nacm_datanode_write(clixon_handle    h,
                     cxobj           *xnacm,
                     cbuf            *cbret)
 {
-    int      retval = -1;
-    cxobj  **gvec = NULL; /* groups */
-    size_t   glen;
-    cxobj  **rlistvec = NULL; /* rule-list */
-    size_t   rlistlen;
-    cxobj  **rvec = NULL; /* rules */
-    char    *write_default = NULL;
-    cvec    *nsc = NULL;
-    int      ret;
-    prepvec *pv_list = NULL;
-
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-        goto done;
+    int            retval = -1;
+    nacm_compiled *nc;
+    nacm_user    **nup;
+    nacm_rule    **rules;
+    int            rlen;
+    char          *write_default = NULL;
+    int            ret;
+    prepvec       *pv_list = NULL;
+
     if (xnacm == NULL)
         goto permit;
+    if (access == NACM_EXEC){
+        clixon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+        goto done;
+    }
+    if (nacm_compiled_get(xnacm, &nc) < 0)
+        goto done;
     /* write-default (create, update, or delete) has default deny so should never be NULL */
-    if ((write_default = xml_find_body(xnacm, "write-default")) == NULL){
+    if ((write_default = nc->nc_write_default) == NULL){
         clixon_err(OE_XML, EINVAL, "No nacm write-default rule");
         goto done;
     }
@@ -724,21 +1083,19 @@ nacm_datanode_write(clixon_handle    h,
        transport layer.)               */
     if (username == NULL)
         goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
-        goto done;
-    /* 4. If no groups are found, continue with step 9. */
-    if (glen == 0)
+    /* User's group
+     * 4. If no groups are found, continue with step 9. */
+    if ((nup = clicon_hash_value(nc->nc_users, username, NULL)) == NULL)
         goto step9;
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
         entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
+    if (nacm_user_rules(nc, *nup, access, &rules, &rlen) < 0)
         goto done;
-    /* First run through rules and cache rules as well as lookup objects in xt. 
+    /* First run through rules and lookup objects in xt. 
      */
-    if (nacm_datanode_prepare(h, xt, access, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, rules, rlen, &pv_list) < 0)
         goto done;
     /* Then recursivelyy traverse all requested nodes */
     if ((ret = nacm_datanode_write_recurse(h, xreq, pv_list,
@@ -775,14 +1132,6 @@ nacm_datanode_write(clixon_handle    h,
     clixon_debug(CLIXON_DBG_NACM, "retval:%d (0:deny 1:permit)", retval);
     if (pv_list)
         prepvec_free(pv_list);
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
-    if (rvec)
-        free(rvec);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
@@ -796,25 +1145,22 @@ nacm_datanode_write(clixon_handle    h,
 
 /*! Perform NACM action: mark if permit, del if deny
  *
- * @param[in] xrule    NACM rule
+ * @param[in] nr       Compiled NACM rule
  * @param[in] xn       XML node (requested node)
  * @retval    0        OK
  * @retval   -1        Error
 
  */
 static int
-nacm_data_read_action(cxobj *xrule,
-                      cxobj *xn)
+nacm_data_read_action(nacm_rule *nr,
+                      cxobj     *xn)
 {
     int   retval = -1;
-    char *action;
 
-    if ((action = xml_find_body(xrule, "action")) != NULL){
-        if (strcmp(action, "deny")==0)
-            xml_flag_set(xn, XML_FLAG_DEL);
-        else if (strcmp(action, "permit")==0)
-            xml_flag_set(xn, XML_FLAG_MARK);
-    }
+    if (nr->nr_action == 0)
+        xml_flag_set(xn, XML_FLAG_DEL);
+    else if (nr->nr_action == 1)
+        xml_flag_set(xn, XML_FLAG_MARK);
     retval = 0;
     //done:
     return retval;
@@ -823,11 +1169,12 @@ nacm_data_read_action(cxobj *xrule,
 /*! Match specific rule to specific requested node
  *
  * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
- * @param[in]  yspec    YANG spec
+ * @param[in]  nr       Compiled NACM rule
+ * @param[in]  xpathvec Xpath matches of rule path
  * @retval     1        OK and rule matches
  * @retval     0        OK and rule does not match
  * @retval    -1        Error
+ * @note module-name is matched by caller
  * Two distinct cases:
  * (1) read_default is permit
  *     mark all deny rules and remove them
@@ -836,32 +1183,18 @@ nacm_data_read_action(cxobj *xrule,
  */
 static int
 nacm_data_read_xrule_xml(cxobj        *xn,
-                         cxobj        *xrule,
-                         clixon_xvec  *xpathvec,
-                         yang_stmt    *yspec)
+                         nacm_rule    *nr,
+                         clixon_xvec  *xpathvec)
 {
     int        retval = -1;
-    yang_stmt *ymod;
-    char      *module_pattern; /* rule module name */
     cxobj     *xp;
     int        i;
 
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
-        goto nomatch;
-    /* 6a) The rule's "module-name" leaf is "*" or equals the name of
-     * the YANG module where the requested data node is defined. 
-     */
-    if (strcmp(module_pattern, "*") != 0){
-        if (ys_module_by_xml(yspec, xn, &ymod) < 0)
-            goto done;
-        if (strcmp(yang_argument_get(ymod), module_pattern) != 0)
-            goto nomatch;
-    }
     /*  6b) Either (1) the rule does not have a "rule-type" defined or
         (2) the "rule-type" is "data-node" and the "path" matches the
         requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
-        if (nacm_data_read_action(xrule, xn) < 0)
+    if (nr->nr_path == NULL){
+        if (nacm_data_read_action(nr, xn) < 0)
             goto done;
         goto match;
     }
@@ -869,12 +1202,11 @@ nacm_data_read_xrule_xml(cxobj        *xn,
         xp = clixon_xvec_i(xpathvec, i);
         /* Check if ancestor is xp (for every xpathvec?) */
         if (xn == xp || xml_isancestor(xn, xp)){
-            if (nacm_data_read_action(xrule, xn) < 0)
+            if (nacm_data_read_action(nr, xn) < 0)
                 goto done;
             goto match;
         }
     }
- nomatch:
     retval = 0;
  done:
     return retval;
@@ -898,20 +1230,22 @@ nacm_datanode_read_recurse(clixon_handle h,
                            prepvec      *pv_list,
                            yang_stmt    *yspec)
 {
-    int      retval = -1;
-    cxobj   *x;
-    cxobj   *xprev;
-    int      ret;
-    prepvec *pv;
+    int        retval = -1;
+    cxobj     *x;
+    cxobj     *xprev;
+    int        ret;
+    prepvec   *pv;
+    yang_stmt *ymod = NULL;
+    int        resolved = 0;
 
     if (xml_spec(xn)){ /* Check this node */
         pv = pv_list;
         if (pv){
             do {
-                if ((ret = nacm_data_read_xrule_xml(xn,
-                                                    pv->pv_xrule,
-                                                    pv->pv_xpathvec,
-                                                    yspec)) < 0)
+                if ((ret = nacm_rule_module_match(xn, pv->pv_rule, yspec, &ymod, &resolved)) < 0)
+                    goto done;
+                if (ret == 1 &&
+                    (ret = nacm_data_read_xrule_xml(xn, pv->pv_rule, pv->pv_xpathvec)) < 0)
                     goto done;
                 if (ret == 1)
                     break; /* stop at first match */
@@ -1005,17 +1339,15 @@ nacm_datanode_read(clixon_handle h,
                    cxobj        *xnacm)
 {
     int             retval = -1;
-    cxobj         **gvec = NULL; /* groups */
-    size_t          glen;
-    cxobj         **rlistvec = NULL; /* rule-list */
-    size_t          rlistlen;
+    nacm_compiled  *nc;
+    nacm_user     **nup;
+    nacm_rule     **rules = NULL;
+    int             rlen = 0;
     int             i;
     char           *read_default = NULL;
-    cvec           *nsc = NULL;
     prepvec        *pv_list = NULL;
 
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
+    if (nacm_compiled_get(xnacm, &nc) < 0)
         goto done;
     /* 3.   Check all the "group" entries to see if any of them contain a
        "user-name" entry that equals the username for the session
@@ -1024,26 +1356,25 @@ nacm_datanode_read(clixon_handle h,
        transport layer.)               */
     if (username == NULL)
         goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
-        goto done;
-    /* 4. If no groups are found (glen=0), continue and check read-default 
+    /* User's group
+     * 4. If no groups are found, continue and check read-default 
           in step 11. */
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
         entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-        goto done;
+    if ((nup = clicon_hash_value(nc->nc_users, username, NULL)) != NULL)
+        if (nacm_user_rules(nc, *nup, NACM_READ, &rules, &rlen) < 0)
+            goto done;
     /* read-default has default permit so should never be NULL */
-    if ((read_default = xml_find_body(xnacm, "read-default")) == NULL){
+    if ((read_default = nc->nc_read_default) == NULL){
         clixon_err(OE_XML, EINVAL, "No nacm read-default rule");
         goto done;
     }
-    /* First run through rules and cache rules as well as lookup objects in xt. 
+    /* First run through rules and lookup objects in xt. 
      * DANGER: objects could be stale if they are removed?
      */
-    if (nacm_datanode_prepare(h, xt, NACM_READ, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, rules, rlen, &pv_list) < 0)
         goto done;
     /* Then recursivelyy traverse all nodes */
     if (nacm_datanode_read_recurse(h, xt, pv_list, clicon_dbspec_yang(h)) < 0)
@@ -1079,15 +1410,252 @@ nacm_datanode_read(clixon_handle h,
     clixon_debug(CLIXON_DBG_NACM, "retval:%d", retval);
     if (pv_list)
         prepvec_free(pv_list);
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
     return retval;
 }
 
+/*---------------------------------------------------------------
+ * Datanode read filter when printing
+ */
+
+/* Filter states of nacm_read_filter_fn */
+#define NACM_RF_NONE    0  /* No ancestor matches a permit rule */
+#define NACM_RF_PERMIT  1  /* An ancestor matches a permit rule */
+
+/* NACM read filter applied when printing a tree */
+struct nacm_read_filter{
+    prepvec   *nf_pv_list;    /* Rules and their path lookups */
+    int        nf_permit;     /* read-default is permit */
+    int        nf_anypermit;  /* There is a permit rule without path */
+    yang_stmt *nf_yspec;
+};
+
+/*! Create NACM read filter of a tree to be used when printing it
+ *
+ * Instead of marking and pruning the tree as nacm_datanode_read, decisions are made per node
+ * by nacm_read_filter_fn when the tree is printed.
+ * @param[in]  h        Clixon handle
+ * @param[in]  xt       XML root tree
+ * @param[in]  username User name, not NULL
+ * @param[in]  xnacm    NACM xml tree
+ * @param[out] nfp      NACM read filter, free with nacm_read_filter_free
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @code
+ *   if (nacm_read_filter_new(h, xt, username, xnacm, &nf) < 0)
+ *     err;
+ *   if (clixon_xml2cbuf_filter(cb, xt, 0, 0, NULL, -1, 0, 0, nacm_read_filter_fn, nf) < 0)
+ *     err;
+ *   nacm_read_filter_free(nf);
+ * @endcode
+ * @see nacm_datanode_read  which has the same semantics
+ */
+int
+nacm_read_filter_new(clixon_handle      h,
+                     cxobj             *xt,
+                     char              *username,
+                     cxobj             *xnacm,
+                     nacm_read_filter **nfp)
+{
+    int               retval = -1;
+    nacm_read_filter *nf = NULL;
+    nacm_compiled    *nc;
+    nacm_user       **nup;
+    nacm_rule       **rules = NULL;
+    int               rlen = 0;
+    int               i;
+
+    if (nacm_compiled_get(xnacm, &nc) < 0)
+        goto done;
+    /* read-default has default permit so should never be NULL */
+    if (nc->nc_read_default == NULL){
+        clixon_err(OE_XML, EINVAL, "No nacm read-default rule");
+        goto done;
+    }
+    if ((nf = malloc(sizeof(*nf))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(nf, 0, sizeof(*nf));
+    nf->nf_yspec = clicon_dbspec_yang(h);
+    nf->nf_permit = strcmp(nc->nc_read_default, "deny") != 0;
+    if ((nup = clicon_hash_value(nc->nc_users, username, NULL)) != NULL)
+        if (nacm_user_rules(nc, *nup, NACM_READ, &rules, &rlen) < 0)
+            goto done;
+    for (i=0; i<rlen; i++)
+        if (rules[i]->nr_path == NULL && rules[i]->nr_action == 1)
+            nf->nf_anypermit = 1;
+    if (nacm_datanode_prepare(h, xt, rules, rlen, &nf->nf_pv_list) < 0)
+        goto done;
+    *nfp = nf;
+    nf = NULL;
+    retval = 0;
+ done:
+    if (nf)
+        nacm_read_filter_free(nf);
+    return retval;
+}
+
+/*! Free NACM read filter
+ */
+int
+nacm_read_filter_free(nacm_read_filter *nf)
+{
+    if (nf->nf_pv_list)
+        prepvec_free(nf->nf_pv_list);
+    free(nf);
+    return 0;
+}
+
+/*! Match the first matching read rule of a node, without modifying it
+ *
+ * @param[in]  nf       NACM read filter
+ * @param[in]  xn       XML node with yang spec
+ * @retval     2        Match of permit rule
+ * @retval     1        Match of deny rule
+ * @retval     0        No match, or match of rule without action
+ * @retval    -1        Error
+ */
+static int
+nacm_read_filter_match(nacm_read_filter *nf,
+                       cxobj            *xn)
+{
+    prepvec   *pv;
+    nacm_rule *nr;
+    yang_stmt *ymod = NULL;
+    int        resolved = 0;
+    cxobj     *xp;
+    int        i;
+    int        ret;
+
+    if ((pv = nf->nf_pv_list) == NULL)
+        return 0;
+    do {
+        nr = pv->pv_rule;
+        if ((ret = nacm_rule_module_match(xn, nr, nf->nf_yspec, &ymod, &resolved)) < 0)
+            return -1;
+        if (ret == 1){
+            if (nr->nr_path == NULL)
+                goto match;
+            for (i=0; i<clixon_xvec_len(pv->pv_xpathvec); i++){
+                xp = clixon_xvec_i(pv->pv_xpathvec, i);
+                if (xn == xp || xml_isancestor(xn, xp))
+                    goto match;
+            }
+        }
+        pv = NEXTQ(prepvec *, pv);
+    } while (pv && pv != nf->nf_pv_list);
+    return 0;
+ match: /* stop at first match */
+    return nr->nr_action == -1 ? 0 : nr->nr_action + 1;
+}
+
+/*! Check if a node may have a descendant matching a permit rule
+ *
+ * Without permit rules without path, the node must be an ancestor of, or below, a
+ * path of a permit rule.
+ */
+static int
+nacm_read_filter_candidate(nacm_read_filter *nf,
+                           cxobj            *xn)
+{
+    prepvec *pv;
+    cxobj   *xp;
+    int      i;
+
+    if (nf->nf_anypermit)
+        return 1;
+    if ((pv = nf->nf_pv_list) == NULL)
+        return 0;
+    do {
+        if (pv->pv_rule->nr_action == 1)
+            for (i=0; i<clixon_xvec_len(pv->pv_xpathvec); i++){
+                xp = clixon_xvec_i(pv->pv_xpathvec, i);
+                if (xn == xp || xml_isancestor(xp, xn) || xml_isancestor(xn, xp))
+                    return 1;
+            }
+        pv = NEXTQ(prepvec *, pv);
+    } while (pv && pv != nf->nf_pv_list);
+    return 0;
+}
+
+/*! Check if a node has a descendant matching a permit rule, not below a deny match
+ *
+ * @param[in]  nf       NACM read filter
+ * @param[in]  xn       XML node
+ * @retval     1        Yes
+ * @retval     0        No
+ * @retval    -1        Error
+ */
+static int
+nacm_read_filter_permit_below(nacm_read_filter *nf,
+                              cxobj            *xn)
+{
+    cxobj *x;
+    int    ret;
+
+    if (!nacm_read_filter_candidate(nf, xn))
+        return 0;
+    x = NULL;
+    while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
+        ret = 0;
+        if (xml_spec(x) && (ret = nacm_read_filter_match(nf, x)) < 0)
+            return -1;
+        if (ret == 2)
+            return 1;
+        if (ret == 1)
+            continue;
+        if ((ret = nacm_read_filter_permit_below(nf, x)) != 0)
+            return ret;
+    }
+    return 0;
+}
+
+/*! NACM read filter function of a node when printing a tree
+ *
+ * Same semantics as nacm_datanode_read: The first matching rule of a node decides, deny
+ * skips the subtree. With read-default deny, a node is printed if it or an ancestor
+ * matches a permit rule, if a descendant does, or if it is a key of a printed list entry.
+ * @param[in]  x      XML node
+ * @param[in]  arg    NACM read filter
+ * @param[in]  state  NACM_RF_PERMIT if an ancestor matches a permit rule
+ * @param[out] statep State of x
+ * @retval     1      Print x
+ * @retval     0      Skip x and its subtree
+ * @retval    -1      Error
+ * @see clixon_xml2cbuf_filter
+ */
+int
+nacm_read_filter_fn(cxobj *x,
+                    void  *arg,
+                    int    state,
+                    int   *statep)
+{
+    nacm_read_filter *nf = (nacm_read_filter *)arg;
+    yang_stmt        *yp;
+    int               ret = 0;
+
+    *statep = state;
+    if (xml_spec(x) && (ret = nacm_read_filter_match(nf, x)) < 0)
+        return -1;
+    if (ret == 1) /* deny */
+        return 0;
+    if (ret == 2){ /* permit */
+        *statep = NACM_RF_PERMIT;
+        return 1;
+    }
+    if (nf->nf_permit || state == NACM_RF_PERMIT)
+        return 1;
+    /* read-default deny: keys of list entries, which are printed if reached */
+    if (xml_parent(x) && (yp = xml_spec(xml_parent(x))) != NULL &&
+        yang_keyword_get(yp) == Y_LIST){
+        if ((ret = yang_key_match(yp, xml_name(x), NULL)) < 0)
+            return -1;
+        if (ret == 1)
+            return 1;
+    }
+    return nacm_read_filter_permit_below(nf, x);
+}
+
 /*---------------------------------------------------------------
  * NACM pre-procesing
  */
@@ -1240,6 +1808,7 @@ nacm_access_pre(clixon_handle  h,
         if ((x = clicon_nacm_ext(h)))
             if ((xnacm0 = xml_dup(x)) == NULL)
                 goto done;
+        _nacm_gen = 0;
     }
     else if (strcmp(mode, "internal")==0){
         if ((ret = xmldb_get0(h, "running", YB_MODULE, nsc, "nacm", 1, 0, &xnacm0, NULL, &xerr)) < 0)
@@ -1249,6 +1818,8 @@ nacm_access_pre(clixon_handle  h,
                 goto done;
             goto fail;
         }
+        /* Changed by commit of running, see nacm_compiled_get */
+        _nacm_gen = xmldb_generation_get(h, "running");
     }
     else{
         clixon_err(OE_XML, 0, "Invalid NACM mode: %s", mode);
@@ -133,7 +133,6 @@ netconf_input_read2(int            s,
     int     restarts = 0;
     int     maxrestarts = 5;
 
-    memset(buf, 0, buflen);
     while ((len = read(s, buf, buflen)) < 0) {
         switch (errno){
         case EINTR:
@@ -166,6 +165,32 @@ netconf_input_read2(int            s,
     return retval;
 }
 
+/*! Find NETCONF 1.0 end-of-message trailer in a string
+ *
+ * @param[in]  str   String to search (not necessarily null-terminated)
+ * @param[in]  len   Length of str
+ * @retval     pos   Offset of first "]]>]]>" in str
+ * @retval    -1     Not found
+ * Scan for ']' with memchr and compare the rest, instead of matching one char at a time
+ */
+static ssize_t
+netconf_eom_find(const char *str,
+                 size_t      len)
+{
+    const char *eom = "]]>]]>";
+    size_t      eomlen = 6;
+    const char *p = str;
+    const char *end = str + len;
+
+    while ((size_t)(end - p) >= eomlen &&
+           (p = memchr(p, ']', end - p - eomlen + 1)) != NULL){
+        if (memcmp(p, eom, eomlen) == 0)
+            return p - str;
+        p++;
+    }
+    return -1;
+}
+
 /*! Get netconf message using NETCONF framing
  *
  * @param[in,out] bufp         Input data, incremented as read
@@ -182,6 +207,12 @@ netconf_input_read2(int            s,
  * - bufp/lenp
  * - cbmsg
  * - frame_state/frame_size
+ * Input is scanned in runs between NULL chars (which are skipped), and each run is appended
+ * to cbmsg in one operation:
+ * - EOM: the run is appended and the end of cbmsg is searched for the trailer. The search
+ *   starts a trailer length before the run so that a trailer split between reads is found.
+ * - Chunked: chunk-data is appended up to the remaining chunk size, only chunk headers
+ *   are parsed one char at a time.
  */
 int
 netconf_input_msg2(unsigned char      **bufp,
@@ -192,51 +223,78 @@ netconf_input_msg2(unsigned char      **bufp,
                    size_t              *frame_size,
                    int                 *eom)
 {
-    int       retval = -1;
-    int       i;
-    int       ret;
-    int       found = 0;
-    size_t    len;
-    char      ch;
+    int            retval = -1;
+    unsigned char *buf = *bufp;
+    size_t         len = *lenp;
+    size_t         i = 0;
+    size_t         n;
+    size_t         cblen;
+    size_t         from;
+    ssize_t        pos;
+    unsigned char *p;
+    int            ret;
+    int            found = 0;
 
     clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
-    len = *lenp;
-    for (i=0; i<len; i++){
-        if ((ch = (*bufp)[i]) == 0)
+    while (i < len && !found){
+        if (buf[i] == 0){
+            i++;
             continue; /* Skip NULL chars (eg from terminals) */
+        }
         if (framing_type == NETCONF_SSH_CHUNKED){
             /* Track chunked framing defined in RFC6242 */
-            if ((ret = netconf_input_chunked_framing(ch, frame_state, frame_size)) < 0)
+            if (*frame_state == 4 && *frame_size > 0){
+                /* chunk-data: append run up to chunk size or next NULL char */
+                n = len - i;
+                if (n > *frame_size)
+                    n = *frame_size;
+                if ((p = memchr(buf + i, 0, n)) != NULL)
+                    n = p - (buf + i);
+                if (cbuf_append_buf(cbmsg, buf + i, n) < 0){
+                    clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                    goto done;
+                }
+                *frame_size -= n;
+                i += n;
+                continue;
+            }
+            if ((ret = netconf_input_chunked_framing(buf[i], frame_state, frame_size)) < 0)
                 goto done;
-            switch (ret){
-            case 1: /* chunk-data */
-                cbuf_append(cbmsg, ch);
-                break;
-            case 2: /* end-of-data */
+            i++;
+            /* Chunk-data is appended above, as a run */
+            if (ret == 2){ /* end-of-data */
                 /* Somewhat complex error-handling:
                  * Ignore packet errors, UNLESS an explicit termination request (eof)
                  */
                 found++;
-                break;
-            default:
-                break;
             }
         }
         else{
-            cbuf_append(cbmsg, ch);
-            if (detect_endtag("]]>]]>", ch, frame_state)){
-                *frame_state = 0;
-                /* OK, we have an xml string from a client */
-                /* Remove trailer */
-                *(((char*)cbuf_get(cbmsg)) + cbuf_len(cbmsg) - strlen("]]>]]>")) = '\0';
-                found++;
+            /* Append run up to next NULL char */
+            n = len - i;
+            if ((p = memchr(buf + i, 0, n)) != NULL)
+                n = p - (buf + i);
+            cblen = cbuf_len(cbmsg);
+            if (cbuf_append_buf(cbmsg, buf + i, n) < 0){
+                clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                goto done;
             }
+            from = cblen > 5 ? cblen - 5 : 0;
+            if ((pos = netconf_eom_find(cbuf_get(cbmsg) + from, cbuf_len(cbmsg) - from)) < 0){
+                i += n;
+                continue;
+            }
+            /* OK, we have an xml string from a client */
+            pos += from;
+            /* Consume input up to and including the trailer */
+            if (pos + strlen("]]>]]>") > cblen)
+                i += pos + strlen("]]>]]>") - cblen;
+            /* Remove trailer */
+            cbuf_trunc(cbmsg, pos);
+            *frame_state = 0;
+            found++;
         }
-        if (found){
-            i++;
-            break;
-        }
-    } /* for */
+    } /* while */
     *bufp += i;
     *lenp -= i;
     *eom = found;
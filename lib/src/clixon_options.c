@@ -123,6 +123,7 @@ static const map_str2int nacm_credentials_map[] = {
 static const map_str2int yang_regexp_map[] = {
     {"posix",               REGEXP_POSIX},
     {"libxml2",             REGEXP_LIBXML2},
+    {"pcre2",               REGEXP_PCRE2},
     {NULL,                 -1}
 };
 
@@ -42,6 +42,9 @@
 #include "clixon_config.h" /* generated by config & autoconf */
 #endif
 
+#ifdef HAVE_MEMFD_CREATE /* linux memfd */
+#define _GNU_SOURCE
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -52,11 +55,13 @@
 #include <syslog.h>
 #include <signal.h>
 #include <ctype.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/param.h>
+#include <sys/mman.h>
 #include <netinet/in.h>
 #include <sys/un.h>
 #include <arpa/inet.h>
@@ -82,8 +87,47 @@
 #include "clixon_options.h"
 #include "clixon_proto.h"
 
+/*
+ * Types
+ */
+/* Incremental receive state of chunked framed messages on a socket
+ * @see clixon_msg_rcv_next
+ */
+struct clixon_msg_rcv {
+    unsigned char  mr_buf[BUFSIZ]; /* Read buffer */
+    unsigned char *mr_p;           /* Start of unprocessed data in mr_buf */
+    size_t         mr_plen;        /* Length of unprocessed data in mr_buf */
+    cbuf          *mr_cb;          /* Message being received */
+    int            mr_state;       /* Chunked framing state */
+    size_t         mr_size;        /* Chunked framing size */
+    int            mr_fdpass;      /* Accept messages passed as file descriptor */
+    int            mr_fd;          /* Passed file descriptor, or -1 */
+};
+
+/* Queued message, see clixon_msg_snd_add */
+struct clixon_msg_out {
+    qelem_t  mo_qelem;  /* List header */
+    cbuf    *mo_cb;     /* Framed message */
+    size_t   mo_off;    /* Start of unsent data in mo_cb */
+    int      mo_fd;     /* File descriptor to pass with first byte, or -1 */
+    size_t   mo_len;    /* Length of message, including data passed in mo_fd */
+};
+
+/* Output queue of chunked framed messages on a socket
+ * @see clixon_msg_snd_flush
+ */
+struct clixon_msg_snd {
+    struct clixon_msg_out *ms_queue; /* Queued messages, first is partially sent */
+    size_t                 ms_len;   /* Length of queued messages */
+};
+
 static int _atomicio_sig = 0;
 
+#ifdef PROTO_MSG_FD
+/* Message body of a reply passed as file descriptor, see send_msg_reply_fd */
+#define CLIXON_MSG_FD_BODY "<fd-reply xmlns=\"" CLIXON_LIB_NS "\"/>"
+#endif
+
 /*! Given family, addr str, port, return sockaddr and length
  *
  * @param[in]  addrtype  Address family: inet:ipv4-address or inet:ipv6-address
@@ -396,32 +440,29 @@ clixon_msg_rcv10(int         s,
                  cbuf       *cb,
                  int        *eof)
 {
-    int           retval = -1;
-    unsigned char buf[BUFSIZ];
-    int           i;
-    int           len;
-    int           xml_state = 0;
-    int           poll;
+    int            retval = -1;
+    unsigned char  buf[BUFSIZ];
+    unsigned char *p;
+    size_t         plen;
+    ssize_t        len;
+    int            frame_state = 0;
+    size_t         frame_size = 0;
+    int            eom = 0;
+    int            poll;
 
     clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "");
     *eof = 0;
-    memset(buf, 0, sizeof(buf));
     while (1){
         if ((len = netconf_input_read2(s, buf, sizeof(buf), eof)) < 0)
             goto done;
-        for (i=0; i<len; i++){
-            if (buf[i] == 0)
-                continue; /* Skip NULL chars (eg from terminals) */
-            cprintf(cb, "%c", buf[i]);
-            if (detect_endtag("]]>]]>",
-                              buf[i],
-                              &xml_state)) {
-                /* OK, we have an xml string from a client */
-                /* Remove trailer */
-                *(((char*)cbuf_get(cb)) + cbuf_len(cb) - strlen("]]>]]>")) = '\0';
-                goto ok;
-            }
-        }
+        p = buf;
+        plen = len;
+        /* Scan whole read buffer for end-of-message, see netconf_input_msg2 */
+        if (netconf_input_msg2(&p, &plen, cb, NETCONF_SSH_EOM,
+                               &frame_state, &frame_size, &eom) < 0)
+            goto done;
+        if (eom)
+            goto ok;
         /* poll==1 if more, poll==0 if none */
         if ((poll = clixon_event_poll(s)) < 0)
             goto done;
@@ -518,7 +559,7 @@ clixon_rpc10(int         sock,
  * @param[out]  msg    CLICON msg data reply structure. Free with free()
  * @see clixon_msg_send10  1.0 EOM
  */
-static int
+int
 clixon_msg_send11(int         s,
                   const char *descr,
                   cbuf       *cb)
@@ -540,24 +581,182 @@ atomicio_sig_handler(int arg)
     _atomicio_sig++;
 }
 
-/*! Receive a message using unified NETCONF w chunked framing
+#ifdef PROTO_MSG_FD
+/*! Read data from socket and accept a file descriptor passed with SCM_RIGHTS
+ *
+ * @param[in]     s      UNIX socket
+ * @param[in]     buf    Buffer to read into
+ * @param[in]     buflen Length of buf
+ * @param[in,out] fdp    Passed file descriptor, replaces and closes any previous
+ * @param[out]    eof    Set if eof encountered
+ * @retval        len    Bytes read
+ * @retval       -1      Error
+ * @see netconf_input_read2  Without file descriptor
+ */
+static ssize_t
+clixon_msg_read_fd(int            s,
+                   unsigned char *buf,
+                   ssize_t        buflen,
+                   int           *fdp,
+                   int           *eof)
+{
+    ssize_t         len;
+    int             restarts = 0;
+    struct msghdr   mh = {0,};
+    struct iovec    iov;
+    struct cmsghdr *cmsg;
+    int             fd;
+    union {
+        struct cmsghdr cm;
+        char           buf[CMSG_SPACE(sizeof(int))];
+    } ctl;
+
+    iov.iov_base = buf;
+    iov.iov_len = buflen;
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = ctl.buf;
+    mh.msg_controllen = sizeof(ctl.buf);
+    while ((len = recvmsg(s, &mh, 0)) < 0) {
+        switch (errno){
+        case EINTR:
+        case EAGAIN:
+            if (restarts++ >= 5){
+                clixon_log(NULL, LOG_ERR, "%s: recvmsg: %s", __FUNCTION__, strerror(errno));
+                return -1;
+            }
+            break;       /* Try again */
+        case ECONNRESET: /* Connection reset by peer */
+        case EPIPE:      /* Client shutdown */
+        case EBADF:      /* Client shutdown - freebsd */
+            len = 0;     /* Emulate EOF */
+            break;
+        default:
+            clixon_log(NULL, LOG_ERR, "%s: recvmsg: %s", __FUNCTION__, strerror(errno));
+            return -1;
+        }
+        if (len == 0)
+            break;
+    }
+    for (cmsg = CMSG_FIRSTHDR(&mh); len > 0 && cmsg != NULL; cmsg = CMSG_NXTHDR(&mh, cmsg)){
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+            cmsg->cmsg_len == CMSG_LEN(sizeof(int))){
+            memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+            if (*fdp != -1)
+                close(*fdp);
+            *fdp = fd;
+        }
+    }
+    if (len == 0)
+        *eof = 1;
+    return len;
+}
+
+/*! Read a reply passed as file descriptor into a string
+ *
+ * @param[in]  fd    Memory file descriptor, see send_msg_reply_fd
+ * @param[out] ret   Reply as string. Free with free()
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+clixon_msg_fd_read(int    fd,
+                   char **ret)
+{
+    int         retval = -1;
+    struct stat st;
+    char       *str = NULL;
+    size_t      pos = 0;
+    ssize_t     n;
+
+    if (fstat(fd, &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat");
+        goto done;
+    }
+    if ((str = malloc(st.st_size + 1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    while (pos < st.st_size){
+        if ((n = pread(fd, str + pos, st.st_size - pos, pos)) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "pread");
+            goto done;
+        }
+        if (n == 0)
+            break;
+        pos += n;
+    }
+    str[pos] = '\0';
+    clixon_debug(CLIXON_DBG_MSG, "Recv fd len: %lu", pos);
+    *ret = str;
+    str = NULL;
+    retval = 0;
+ done:
+    if (str)
+        free(str);
+    return retval;
+}
+
+/*! Replace message with a reply passed as file descriptor
+ *
+ * @param[in]  fd    Memory file descriptor, see send_msg_reply_fd
+ * @param[out] cb    Reply
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+clixon_msg_fd_cbuf(int   fd,
+                   cbuf *cb)
+{
+    int         retval = -1;
+    struct stat st;
+    void       *p = MAP_FAILED;
+
+    if (fstat(fd, &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat");
+        goto done;
+    }
+    cbuf_reset(cb);
+    if (st.st_size > 0){
+        if ((p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+            clixon_err(OE_UNIX, errno, "mmap");
+            goto done;
+        }
+        if (cbuf_append_buf(cb, p, st.st_size) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+    }
+    clixon_debug(CLIXON_DBG_MSG, "Recv fd len: %lu", cbuf_len(cb));
+    retval = 0;
+ done:
+    if (p != MAP_FAILED)
+        munmap(p, st.st_size);
+    return retval;
+}
+#endif /* PROTO_MSG_FD */
+
+/*! Receive a message using chunked framing and optionally accept a passed file descriptor
  *
  * @param[in]   s      socket (unix or inet) to communicate with backend
- * @param[in]   descr Description of peer for logging
- * @param[in]   intr  If set, make a ^C cause an error   (OBSOLETE?)
+ * @param[in]   descr  Description of peer for logging
+ * @param[in]   intr   If set, make a ^C cause an error
  * @param[out]  cb     cligen buf struct containing the incoming message
+ * @param[out]  fdp    If not NULL, file descriptor passed with the message, or -1
  * @param[out]  eof    Set if eof encountered
  * @retval      0      OK (check eof)
  * @retval     -1      Error
- * @see netconf_input_cb()
- * @see clixon_msg_rcv10  For EOM framing
+ * @see clixon_msg_rcv11
  */
-int
-clixon_msg_rcv11(int         s,
-                 const char *descr,
-                 int         intr,
-                 cbuf      **cb,
-                 int        *eof)
+static int
+clixon_msg_rcv11_fd(int         s,
+                    const char *descr,
+                    int         intr,
+                    cbuf      **cb,
+                    int        *fdp,
+                    int        *eof)
 {
     int              retval = -1;
     unsigned char    buf[BUFSIZ];
@@ -591,7 +790,13 @@ clixon_msg_rcv11(int         s,
     }
     while (*eof == 0 && eom == 0) {
         /* Read input data from socket and append to cbbuf */
-        if ((len = netconf_input_read2(s, buf, buflen, eof)) < 0)
+#ifdef PROTO_MSG_FD
+        if (fdp != NULL)
+            len = clixon_msg_read_fd(s, buf, buflen, fdp, eof);
+        else
+#endif
+        len = netconf_input_read2(s, buf, buflen, eof);
+        if (len < 0)
             goto done;
         p = buf;
         plen = len;
@@ -607,8 +812,8 @@ clixon_msg_rcv11(int         s,
                 cbuf_reset(cbmsg);
                 break;
             }
-            if (eom == 0)
-                continue;
+            if (eom)
+                break;
         }
     }
     if (*eof ){
@@ -653,6 +858,184 @@ clixon_msg_rcv11(int         s,
     return retval;
 }
 
+/*! Receive a message using unified NETCONF w chunked framing
+ *
+ * @param[in]   s      socket (unix or inet) to communicate with backend
+ * @param[in]   descr Description of peer for logging
+ * @param[in]   intr  If set, make a ^C cause an error   (OBSOLETE?)
+ * @param[out]  cb     cligen buf struct containing the incoming message
+ * @param[out]  eof    Set if eof encountered
+ * @retval      0      OK (check eof)
+ * @retval     -1      Error
+ * @see netconf_input_cb()
+ * @see clixon_msg_rcv10  For EOM framing
+ */
+int
+clixon_msg_rcv11(int         s,
+                 const char *descr,
+                 int         intr,
+                 cbuf      **cb,
+                 int        *eof)
+{
+    return clixon_msg_rcv11_fd(s, descr, intr, cb, NULL, eof);
+}
+
+/*! Create incremental receive state of chunked framed messages
+ *
+ * @param[in]  fdpass  Accept messages passed as file descriptor, see PROTO_MSG_FD
+ * @retval     mr      Receive state, free with clixon_msg_rcv_free
+ * @retval     NULL    Error
+ * @see clixon_msg_rcv_next
+ */
+clixon_msg_rcv *
+clixon_msg_rcv_new(int fdpass)
+{
+    clixon_msg_rcv *mr;
+
+    if ((mr = malloc(sizeof(*mr))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(mr, 0, sizeof(*mr));
+    if ((mr->mr_cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        free(mr);
+        return NULL;
+    }
+    mr->mr_p = mr->mr_buf;
+    mr->mr_fdpass = fdpass;
+    mr->mr_fd = -1;
+    return mr;
+}
+
+/*! Free incremental receive state
+ *
+ * @param[in]  mr   Receive state
+ * @retval     0    OK
+ */
+int
+clixon_msg_rcv_free(clixon_msg_rcv *mr)
+{
+    if (mr->mr_cb)
+        cbuf_free(mr->mr_cb);
+    if (mr->mr_fd != -1)
+        close(mr->mr_fd);
+    free(mr);
+    return 0;
+}
+
+/*! Check if there is data left in the receive buffer
+ *
+ * @param[in]  mr   Receive state
+ * @retval     1    Data left, clixon_msg_rcv_next does not read the socket
+ * @retval     0    No data left
+ */
+int
+clixon_msg_rcv_pending(clixon_msg_rcv *mr)
+{
+    return mr->mr_plen > 0;
+}
+
+/*! Receive next message using chunked framing without waiting for a complete message
+ *
+ * Reads the socket once if the receive buffer is empty, and returns the next complete
+ * message, if any. Remaining data is kept in the receive state, and a partial message
+ * is completed on later calls. Use this in event callbacks where a peer may send several
+ * messages without waiting, or a message in several parts.
+ * @param[in]   s      Socket (unix or inet)
+ * @param[in]   descr  Description of peer for logging
+ * @param[in]   mr     Receive state
+ * @param[out]  cb     Complete message, or NULL. Free with cbuf_free
+ * @param[out]  eof    Set if eof encountered
+ * @retval      0      OK (check eof and cb)
+ * @retval     -1      Error
+ * @code
+ *   do {
+ *      if (clixon_msg_rcv_next(s, descr, mr, &cb, &eof) < 0)
+ *         err;
+ *      if (eof || cb == NULL)
+ *         break;
+ *      ... handle cb ...
+ *      cbuf_free(cb);
+ *   } while (clixon_msg_rcv_pending(mr));
+ * @endcode
+ * @see clixon_msg_rcv11  Blocks until a complete message and discards remaining data
+ */
+int
+clixon_msg_rcv_next(int             s,
+                    const char     *descr,
+                    clixon_msg_rcv *mr,
+                    cbuf          **cb,
+                    int            *eof)
+{
+    int     retval = -1;
+    ssize_t len;
+    int     eom = 0;
+
+    *cb = NULL;
+    *eof = 0;
+    if (mr->mr_plen == 0){
+#ifdef PROTO_MSG_FD
+        if (mr->mr_fdpass)
+            len = clixon_msg_read_fd(s, mr->mr_buf, sizeof(mr->mr_buf), &mr->mr_fd, eof);
+        else
+#endif
+        len = netconf_input_read2(s, mr->mr_buf, sizeof(mr->mr_buf), eof);
+        if (len < 0)
+            goto done;
+        mr->mr_p = mr->mr_buf;
+        mr->mr_plen = *eof ? 0 : len;
+    }
+    while (!(*eof) && mr->mr_plen > 0){
+        if (netconf_input_msg2(&mr->mr_p, &mr->mr_plen,
+                               mr->mr_cb,
+                               NETCONF_SSH_CHUNKED,
+                               &mr->mr_state,
+                               &mr->mr_size,
+                               &eom) < 0){
+            /* Errors from input are only framing errors, non-fatal, return eof */
+            *eof = 1;
+            cbuf_reset(mr->mr_cb);
+            mr->mr_plen = 0;
+            break;
+        }
+        if (eom)
+            break;
+    }
+    if (*eof){
+        if (descr)
+            clixon_debug(CLIXON_DBG_MSG, "Recv [%s]: EOF", descr);
+        else
+            clixon_debug(CLIXON_DBG_MSG, "Recv: EOF");
+        goto ok;
+    }
+    if (!eom)
+        goto ok;
+#ifdef PROTO_MSG_FD
+    if (mr->mr_fd != -1){
+        if (strcmp(cbuf_get(mr->mr_cb), CLIXON_MSG_FD_BODY) == 0 &&
+            clixon_msg_fd_cbuf(mr->mr_fd, mr->mr_cb) < 0)
+            goto done;
+        close(mr->mr_fd);
+        mr->mr_fd = -1;
+    }
+#endif
+    if (descr)
+        clixon_debug(CLIXON_DBG_MSG, "Recv [%s] len: %lu", descr, cbuf_len(mr->mr_cb));
+    else
+        clixon_debug(CLIXON_DBG_MSG, "Recv len: %lu", cbuf_len(mr->mr_cb));
+    /* Hand over message and start a new */
+    *cb = mr->mr_cb;
+    if ((mr->mr_cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Send a NETCONF message and wait for result.
  *
  * TBD: timeout, interrupt?
@@ -679,6 +1062,7 @@ clicon_rpc(int                sock,
     struct clicon_msg *reply = NULL;
     cbuf              *cbsend = NULL;
     cbuf              *cbrcv = NULL;
+    int                fd = -1;
 
     clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "");
     if ((cbsend = cbuf_new()) == NULL){
@@ -688,10 +1072,23 @@ clicon_rpc(int                sock,
     cprintf(cbsend, "%s", msg->op_body);
     if (clixon_msg_send11(sock, descr, cbsend) < 0)
         goto done;
+#ifdef PROTO_MSG_FD
+    if (clixon_msg_rcv11_fd(sock, descr, 0, &cbrcv, &fd, eof) < 0)
+        goto done;
+#else
     if (clixon_msg_rcv11(sock, descr, 0, &cbrcv, eof) < 0)
         goto done;
+#endif
     if (*eof)
         goto ok;
+#ifdef PROTO_MSG_FD
+    /* Large reply passed as file descriptor */
+    if (fd != -1 && cbrcv && strcmp(cbuf_get(cbrcv), CLIXON_MSG_FD_BODY) == 0){
+        if (clixon_msg_fd_read(fd, ret) < 0)
+            goto done;
+        goto ok;
+    }
+#endif
     if (cbrcv){
         if ((*ret = strdup(cbuf_get(cbrcv))) == NULL){
             clixon_err(OE_UNIX, errno, "strdup");
@@ -705,6 +1102,8 @@ clicon_rpc(int                sock,
         cbuf_free(cbsend);
     if (cbrcv)
         cbuf_free(cbrcv);
+    if (fd != -1)
+        close(fd);
     clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "retval:%d", retval);
     if (reply)
         free(reply);
@@ -746,6 +1145,350 @@ send_msg_reply(int         s,
     return retval;
 }
 
+#if defined(PROTO_MSG_FD) && defined(HAVE_MEMFD_CREATE)
+/*! Wait until a socket is writable
+ *
+ * Used when a send on a non-blocking socket would block, instead of retrying at once
+ * @param[in]  s    Socket
+ * @retval     0    OK, writable or interrupted, retry send
+ * @retval    -1    Error
+ */
+static int
+send_msg_wait_write(int s)
+{
+    struct pollfd pfd = {0,};
+
+    pfd.fd = s;
+    pfd.events = POLLOUT;
+    if (poll(&pfd, 1, -1) < 0 && errno != EINTR){
+        clixon_err(OE_UNIX, errno, "poll");
+        return -1;
+    }
+    return 0;
+}
+#endif
+
+/*! Send a reply to a local client by passing a memory file descriptor
+ *
+ * The reply is written to a memfd, and a short message is sent with the descriptor
+ * attached as SCM_RIGHTS. The client reads the reply from the descriptor.
+ * If memfd is not available, the reply is sent on the socket as in send_msg_reply
+ * @param[in]  s       UNIX socket to communicate with client
+ * @param[in]  descr   Description of peer for logging
+ * @param[in]  data    Returned data as string
+ * @param[in]  datalen Length of returned data including null termination
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see send_msg_reply
+ * @see PROTO_MSG_FD
+ */
+int
+send_msg_reply_fd(int         s,
+                  const char *descr,
+                  char       *data,
+                  uint32_t    datalen)
+{
+#if defined(PROTO_MSG_FD) && defined(HAVE_MEMFD_CREATE)
+    int             retval = -1;
+    int             fd = -1;
+    size_t          len;
+    size_t          off = 0;
+    cbuf           *cb = NULL;
+    struct msghdr   mh = {0,};
+    struct iovec    iov;
+    struct cmsghdr *cmsg;
+    ssize_t         n;
+    union {
+        struct cmsghdr cm;
+        char           buf[CMSG_SPACE(sizeof(int))];
+    } ctl;
+
+    len = strnlen(data, datalen);
+    if ((fd = memfd_create("clixon-reply", MFD_CLOEXEC)) < 0){
+        clixon_err(OE_UNIX, errno, "memfd_create");
+        goto done;
+    }
+    if (atomicio((ssize_t (*)(int, void *, size_t))write, fd, data, len) != len){
+        clixon_err(OE_UNIX, errno, "write");
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s", CLIXON_MSG_FD_BODY);
+    if (netconf_output_encap(NETCONF_SSH_CHUNKED, cb) < 0)
+        goto done;
+    if (descr)
+        clixon_debug(CLIXON_DBG_MSG, "Send [%s] fd len: %lu", descr, len);
+    else
+        clixon_debug(CLIXON_DBG_MSG, "Send fd len: %lu", len);
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = ctl.buf;
+    mh.msg_controllen = sizeof(ctl.buf);
+    cmsg = CMSG_FIRSTHDR(&mh);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    while (off < cbuf_len(cb)){
+        iov.iov_base = cbuf_get(cb) + off;
+        iov.iov_len = cbuf_len(cb) - off;
+        if ((n = sendmsg(s, &mh, 0)) < 0){
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK){
+                if (send_msg_wait_write(s) < 0)
+                    goto done;
+                continue;
+            }
+            if (errno == EPIPE || errno == ECONNRESET) /* Client shutdown */
+                break;
+            clixon_err(OE_UNIX, errno, "sendmsg");
+            goto done;
+        }
+        /* Descriptor is passed with the first part */
+        mh.msg_control = NULL;
+        mh.msg_controllen = 0;
+        off += n;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (fd != -1)
+        close(fd);
+    return retval;
+#else
+    return send_msg_reply(s, descr, data, datalen);
+#endif
+}
+
+/*! Create output queue
+ *
+ * @retval     ms   Output queue. Free with clixon_msg_snd_free
+ * @retval     NULL Error
+ */
+clixon_msg_snd *
+clixon_msg_snd_new(void)
+{
+    clixon_msg_snd *ms;
+
+    if ((ms = malloc(sizeof(*ms))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(ms, 0, sizeof(*ms));
+    return ms;
+}
+
+/*! Remove first message in output queue
+ *
+ * @param[in]  ms   Output queue
+ */
+static void
+clixon_msg_snd_pop(clixon_msg_snd *ms)
+{
+    struct clixon_msg_out *mo;
+
+    mo = ms->ms_queue;
+    DELQ(mo, ms->ms_queue, struct clixon_msg_out *);
+    ms->ms_len -= mo->mo_len;
+    if (mo->mo_cb)
+        cbuf_free(mo->mo_cb);
+    if (mo->mo_fd != -1)
+        close(mo->mo_fd);
+    free(mo);
+}
+
+/*! Discard all queued messages
+ *
+ * @param[in]  ms   Output queue
+ * @retval     0    OK
+ */
+int
+clixon_msg_snd_reset(clixon_msg_snd *ms)
+{
+    while (ms->ms_queue)
+        clixon_msg_snd_pop(ms);
+    return 0;
+}
+
+/*! Free output queue and discard queued messages
+ *
+ * @param[in]  ms   Output queue
+ * @retval     0    OK
+ */
+int
+clixon_msg_snd_free(clixon_msg_snd *ms)
+{
+    clixon_msg_snd_reset(ms);
+    free(ms);
+    return 0;
+}
+
+/*! Length of queued messages, not yet sent
+ *
+ * @param[in]  ms   Output queue
+ * @retval     len  Bytes, including messages passed as file descriptor
+ */
+size_t
+clixon_msg_snd_len(clixon_msg_snd *ms)
+{
+    return ms->ms_len;
+}
+
+/*! Add a message to output queue using chunked framing
+ *
+ * The message is copied. Call clixon_msg_snd_flush to send it.
+ * If fdpass is set, the message is written to a memory file descriptor which is passed with
+ * a short message, as in send_msg_reply_fd.
+ * @param[in]  ms     Output queue
+ * @param[in]  descr  Description of peer for logging
+ * @param[in]  data   Message
+ * @param[in]  len    Length of message
+ * @param[in]  fdpass Pass message as file descriptor, see PROTO_MSG_FD
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+clixon_msg_snd_add(clixon_msg_snd *ms,
+                   const char     *descr,
+                   char           *data,
+                   size_t          len,
+                   int             fdpass)
+{
+    int                    retval = -1;
+    struct clixon_msg_out *mo = NULL;
+
+    if ((mo = malloc(sizeof(*mo))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(mo, 0, sizeof(*mo));
+    mo->mo_fd = -1;
+    if ((mo->mo_cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+#if defined(PROTO_MSG_FD) && defined(HAVE_MEMFD_CREATE)
+    if (fdpass){
+        if ((mo->mo_fd = memfd_create("clixon-reply", MFD_CLOEXEC)) < 0){
+            clixon_err(OE_UNIX, errno, "memfd_create");
+            goto done;
+        }
+        if (atomicio((ssize_t (*)(int, void *, size_t))write, mo->mo_fd, data, len) != len){
+            clixon_err(OE_UNIX, errno, "write");
+            goto done;
+        }
+        cprintf(mo->mo_cb, "%s", CLIXON_MSG_FD_BODY);
+    }
+    else
+#endif
+    if (cbuf_append_buf(mo->mo_cb, data, len) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        goto done;
+    }
+    if (netconf_output_encap(NETCONF_SSH_CHUNKED, mo->mo_cb) < 0)
+        goto done;
+    mo->mo_len = cbuf_len(mo->mo_cb);
+    if (mo->mo_fd != -1)
+        mo->mo_len += len;
+    if (descr)
+        clixon_debug(CLIXON_DBG_MSG, "Send [%s]%s len: %lu", descr, mo->mo_fd!=-1?" fd":"", len);
+    else
+        clixon_debug(CLIXON_DBG_MSG, "Send%s len: %lu", mo->mo_fd!=-1?" fd":"", len);
+    ADDQ(mo, ms->ms_queue);
+    ms->ms_len += mo->mo_len;
+    mo = NULL;
+    retval = 0;
+ done:
+    if (mo){
+        if (mo->mo_cb)
+            cbuf_free(mo->mo_cb);
+        if (mo->mo_fd != -1)
+            close(mo->mo_fd);
+        free(mo);
+    }
+    return retval;
+}
+
+/*! Send queued messages without blocking
+ *
+ * Sends until all messages are sent or the socket would block. If the peer has closed the
+ * socket, all queued messages are discarded, as with send_msg_reply.
+ * @param[in]  s    Socket
+ * @param[in]  ms   Output queue
+ * @retval     1    All messages sent, queue is empty
+ * @retval     0    Messages remain, call again when the socket is writable
+ * @retval    -1    Error
+ * @see clixon_event_reg_fd_write
+ */
+int
+clixon_msg_snd_flush(int             s,
+                     clixon_msg_snd *ms)
+{
+    struct clixon_msg_out *mo;
+    struct msghdr          mh;
+    struct iovec           iov;
+    struct cmsghdr        *cmsg;
+    ssize_t                n;
+    int                    flags = MSG_DONTWAIT;
+    union {
+        struct cmsghdr cm;
+        char           buf[CMSG_SPACE(sizeof(int))];
+    } ctl;
+
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+    while ((mo = ms->ms_queue) != NULL){
+        iov.iov_base = cbuf_get(mo->mo_cb) + mo->mo_off;
+        iov.iov_len = cbuf_len(mo->mo_cb) - mo->mo_off;
+        memset(&mh, 0, sizeof(mh));
+        mh.msg_iov = &iov;
+        mh.msg_iovlen = 1;
+        if (mo->mo_fd != -1){ /* Descriptor is passed with the first part */
+            mh.msg_control = ctl.buf;
+            mh.msg_controllen = sizeof(ctl.buf);
+            cmsg = CMSG_FIRSTHDR(&mh);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(cmsg), &mo->mo_fd, sizeof(int));
+        }
+        if ((n = sendmsg(s, &mh, flags)) < 0){
+            switch (errno){
+            case EINTR:
+                continue;
+            case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+            case EWOULDBLOCK:
+#endif
+                return 0;
+            case ECONNRESET: /* Connection reset by peer */
+            case EPIPE:      /* Client shutdown */
+            case EBADF:      /* Client shutdown - freebsd */
+                clixon_debug(CLIXON_DBG_MSG, "Send: %s, discard %lu", strerror(errno), ms->ms_len);
+                clixon_msg_snd_reset(ms);
+                return 1;
+            default:
+                clixon_err(OE_UNIX, errno, "sendmsg");
+                return -1;
+            }
+        }
+        if (mo->mo_fd != -1){
+            close(mo->mo_fd);
+            mo->mo_fd = -1;
+        }
+        mo->mo_off += n;
+        if (mo->mo_off == cbuf_len(mo->mo_cb))
+            clixon_msg_snd_pop(ms);
+    }
+    return 1;
+}
+
 /*! Send a clicon_msg NOTIFY message asynchronously to client
  *
  * @param[in]  s       Socket to communicate with client
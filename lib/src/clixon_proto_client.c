@@ -83,6 +83,7 @@
 #include "clixon_xml_sort.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_xml_io.h"
+#include "clixon_xml_bin.h"
 #include "clixon_proto_client.h"
 
 #define PERSIST_ID_XML_FMT "<persist-id>%s</persist-id>"
@@ -184,6 +185,30 @@ clicon_rpc_msg_once(clixon_handle      h,
     return retval;
 }
 
+/*! Parse reply data from backend to XML tree
+ *
+ * @param[in]  h        Clixon handle
+ * @param[in]  retdata  Reply data as string
+ * @param[out] xret     Reply as XML tree. Free with xml_free
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+clicon_rpc_reply_parse(clixon_handle h,
+                       char         *retdata,
+                       cxobj       **xret)
+{
+#ifdef PROTO_XML_BINARY
+    /* Binary XML reply if negotiated in hello, elements are bound to yang when known */
+    if (clixon_xml_bin_is(retdata))
+        return clixon_xml_bin_parse(retdata, strlen(retdata), clicon_dbspec_yang(h), xret);
+#endif
+    /* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
+     * to reply.
+     */
+    return clixon_xml_parse_string(retdata, YB_NONE, NULL, xret, NULL);
+}
+
 /*! Send internal netconf rpc from client to backend
  *
  * @param[in]    h      Clixon handle
@@ -241,13 +266,9 @@ clicon_rpc_msg(clixon_handle      h,
 #endif
     }
 
-    if (retdata){
-        /* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
-         * to reply.
-         */
-        if (clixon_xml_parse_string(retdata, YB_NONE, NULL, &xret, NULL) < 0)
-            goto done;
-    }
+    if (retdata &&
+        clicon_rpc_reply_parse(h, retdata, &xret) < 0)
+        goto done;
     if (xret0){
         *xret0 = xret;
         xret = NULL;
@@ -309,13 +330,9 @@ clicon_rpc_msg_persistent(clixon_handle      h,
     }
     clixon_debug(CLIXON_DBG_DEFAULT, "retdata:%s", retdata);
 
-    if (retdata){
-        /* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
-         * to reply.
-         */
-        if (clixon_xml_parse_string(retdata, YB_NONE, NULL, &xret, NULL) < 0)
-            goto done;
-    }
+    if (retdata &&
+        clicon_rpc_reply_parse(h, retdata, &xret) < 0)
+        goto done;
     if (xret0){
         *xret0 = xret;
         xret = NULL;
@@ -581,6 +598,14 @@ clicon_rpc_get_config(clixon_handle h,
     else{
         if (xml_bind_special(xd, yspec, "/nc:get-config/output/data") < 0)
             goto done;
+#ifdef PROTO_XML_BINARY
+        if (clixon_xml_bin_bound(xd)){ /* Decoded binary XML already bound */
+            if (clixon_xml_bin_index(xd) < 0)
+                goto done;
+            ret = 1;
+        }
+        else
+#endif
         if ((ret = xml_bind_yang(h, xd, YB_MODULE, yspec, &xerr)) < 0)
             goto done;
         if (ret == 0){
@@ -1087,6 +1112,14 @@ clicon_rpc_get2(clixon_handle   h,
         if (xml_bind_special(xd, yspec, "/nc:get/output/data") < 0)
             goto done;
         if (bind){
+#ifdef PROTO_XML_BINARY
+            if (clixon_xml_bin_bound(xd)){ /* Decoded binary XML already bound */
+                if (clixon_xml_bin_index(xd) < 0)
+                    goto done;
+                ret = 1;
+            }
+            else
+#endif
             if ((ret = xml_bind_yang(h, xd, YB_MODULE, yspec, &xerr)) < 0)
                 goto done;
             if (ret == 0){
@@ -1258,6 +1291,14 @@ clicon_rpc_get_pageable_list(clixon_handle   h,
     else{
         if (xml_bind_special(xd, yspec, "/nc:get/output/data") < 0)
             goto done;
+#ifdef PROTO_XML_BINARY
+        if (clixon_xml_bin_bound(xd)){ /* Decoded binary XML already bound */
+            if (clixon_xml_bin_index(xd) < 0)
+                goto done;
+            ret = 1;
+        }
+        else
+#endif
         if ((ret = xml_bind_yang(h, xd, YB_MODULE, yspec, &xerr)) < 0)
             goto done;
         if (ret == 0){
@@ -1829,35 +1870,22 @@ clicon_rpc_restconf_debug(clixon_handle h,
     return retval;
 }
 
-/*! Send a hello request to the backend server on INTERNAL netconf connection
+/*! Encode internal hello request
  *
  * @param[in]  h           Clixon handle
- * @param[in]  transport   RFC 6022 transport.
- * @param[in]  source_host RFC 6022 source-host
- * @param[out] id          Session id returned by backend
- * @retval     0           OK
- * @retval    -1           Error and logged to syslog
- * @note this is internal netconf to backend, not northbound to user client
- * @note this deviates from RFC6241 slightly in that it waits for a reply, the RFC does not
- *       stipulate that.
- * @note transport is an identity defined in RFC6022 with added values in clixon-lib.yang for clixon,
- *       and should in those cases be prefixed with the localname "cl:", 
- *       Example: cl:cli, cl:restconf, cl:netconf
+ * @param[in]  transport   RFC 6022 transport, or NULL
+ * @param[in]  source_host RFC 6022 source-host, or NULL
+ * @retval     msg         Encoded message, free with free()
+ * @retval     NULL        Error
+ * @see clicon_hello_req
  */
-int
-clicon_hello_req(clixon_handle h,
-                 char         *transport,
-                 char         *source_host,
-                 uint32_t     *id)
+static struct clicon_msg *
+clicon_hello_encode(clixon_handle h,
+                    char         *transport,
+                    char         *source_host)
 {
-    int                retval = -1;
     struct clicon_msg *msg = NULL;
-    cxobj             *xret = NULL;
-    cxobj             *xerr;
-    cxobj             *x;
     char              *username;
-    char              *b;
-    int                ret;
     cbuf              *cb = NULL;
     int                clixon_lib = 0;
     char              *ns = NULL;
@@ -1890,31 +1918,89 @@ clicon_hello_req(clixon_handle h,
     if (clixon_lib)
         cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
     cprintf(cb, ">");
-    cprintf(cb, "<capabilities><capability>%s</capability></capabilities>",
-            NETCONF_BASE_CAPABILITY_1_1);
+    cprintf(cb, "<capabilities><capability>%s</capability>", NETCONF_BASE_CAPABILITY_1_1);
+#ifdef PROTO_XML_BINARY
+    /* Ask backend for binary XML replies */
+    cprintf(cb, "<capability>%s</capability>", CLIXON_XML_BIN_CAPABILITY);
+#endif
+#ifdef PROTO_MSG_FD
+    /* Local client may receive large replies as file descriptor */
+    if (clicon_sock_family(h) == AF_UNIX)
+        cprintf(cb, "<capability>%s</capability>", CLIXON_MSG_FD_CAPABILITY);
+#endif
+    cprintf(cb, "</capabilities>");
     cprintf(cb, "</hello>");
+    msg = clicon_msg_encode(0, "%s", cbuf_get(cb));
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return msg;
+}
+
+/*! Get session-id from internal hello reply
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  xret  Hello reply
+ * @param[out] id    Session id returned by backend
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+clicon_hello_reply(clixon_handle h,
+                   cxobj        *xret,
+                   uint32_t     *id)
+{
+    cxobj *xerr;
+    cxobj *x;
 
-    if ((msg = clicon_msg_encode(0, "%s", cbuf_get(cb))) == NULL)
-        goto done;
-    if (clicon_rpc_msg(h, msg, &xret) < 0)
-        goto done;
     if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
         clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Hello");
-        goto done;
+        return -1;
     }
     if ((x = xpath_first(xret, NULL, "hello/session-id")) == NULL){
         clixon_err(OE_XML, 0, "hello session-id");
-        goto done;
+        return -1;
     }
-    b = xml_body(x);
-    if ((ret = parse_uint32(b, id, NULL)) <= 0){
+    if (parse_uint32(xml_body(x), id, NULL) <= 0){
         clixon_err(OE_XML, errno, "parse_uint32");
-        goto done;
+        return -1;
     }
+    return 0;
+}
+
+/*! Send a hello request to the backend server on INTERNAL netconf connection
+ *
+ * @param[in]  h           Clixon handle
+ * @param[in]  transport   RFC 6022 transport.
+ * @param[in]  source_host RFC 6022 source-host
+ * @param[out] id          Session id returned by backend
+ * @retval     0           OK
+ * @retval    -1           Error and logged to syslog
+ * @note this is internal netconf to backend, not northbound to user client
+ * @note this deviates from RFC6241 slightly in that it waits for a reply, the RFC does not
+ *       stipulate that.
+ * @note transport is an identity defined in RFC6022 with added values in clixon-lib.yang for clixon,
+ *       and should in those cases be prefixed with the localname "cl:", 
+ *       Example: cl:cli, cl:restconf, cl:netconf
+ */
+int
+clicon_hello_req(clixon_handle h,
+                 char         *transport,
+                 char         *source_host,
+                 uint32_t     *id)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xret = NULL;
+
+    if ((msg = clicon_hello_encode(h, transport, source_host)) == NULL)
+        goto done;
+    if (clicon_rpc_msg(h, msg, &xret) < 0)
+        goto done;
+    if (clicon_hello_reply(h, xret, id) < 0)
+        goto done;
     retval = 0;
  done:
-    if (cb)
-        cbuf_free(cb);
     if (msg)
         free(msg);
     if (xret)
@@ -1980,3 +2066,358 @@ clicon_rpc_restart_plugin(clixon_handle h,
         xml_free(xret);
     return retval;
 }
+
+/*! Asynchronous rpc request waiting for its reply, see clicon_rpc_async
+ */
+struct rpc_async_req {
+    qelem_t              ra_qelem;   /* List header */
+    uint32_t             ra_id;      /* Message-id of request */
+    clicon_rpc_async_cb *ra_fn;      /* Reply callback */
+    void                *ra_arg;     /* Callback argument */
+};
+
+/*! Asynchronous rpc session to backend, see clicon_rpc_async
+ *
+ * A reply is delivered to the request with the same message-id. A reply without
+ * message-id is delivered to the oldest request, since the backend handles the requests
+ * of a session in order.
+ */
+struct rpc_async {
+    int                   as_s;          /* Socket to backend */
+    uint32_t              as_session_id; /* Backend session-id of this socket */
+    clixon_msg_rcv       *as_rcv;        /* Receive state */
+    struct rpc_async_req *as_reqs;       /* Requests in flight, oldest first */
+    int                   as_nr;         /* Nr of requests in flight */
+};
+
+static int clicon_rpc_async_input(int s, void *arg);
+
+/*! Get asynchronous rpc session of handle, if any
+ */
+static struct rpc_async *
+clicon_rpc_async_get(clixon_handle h)
+{
+    struct rpc_async *as = NULL;
+
+    if (clicon_ptr_get(h, "rpc-async", (void**)&as) < 0)
+        return NULL;
+    return as;
+}
+
+/*! Close asynchronous rpc session and call callbacks of requests in flight without reply
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see clicon_rpc_async
+ */
+int
+clicon_rpc_async_close(clixon_handle h)
+{
+    int                   retval = 0;
+    struct rpc_async     *as;
+    struct rpc_async_req *ra;
+
+    if ((as = clicon_rpc_async_get(h)) == NULL)
+        return 0;
+    clicon_ptr_del(h, "rpc-async");
+    clixon_event_unreg_fd(as->as_s, clicon_rpc_async_input);
+    close(as->as_s);
+    while ((ra = as->as_reqs) != NULL){
+        DELQ(ra, as->as_reqs, struct rpc_async_req *);
+        if (ra->ra_fn(h, NULL, ra->ra_arg) < 0)
+            retval = -1;
+        free(ra);
+    }
+    if (as->as_rcv)
+        clixon_msg_rcv_free(as->as_rcv);
+    free(as);
+    return retval;
+}
+
+/*! Open asynchronous rpc session to backend
+ *
+ * Connect a separate socket and send a hello on it synchronously
+ * @param[in]  h     Clixon handle
+ * @param[out] asp   Asynchronous rpc session
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+clicon_rpc_async_open(clixon_handle      h,
+                      struct rpc_async **asp)
+{
+    int                retval = -1;
+    struct rpc_async  *as = NULL;
+    struct clicon_msg *msg = NULL;
+    char              *retdata = NULL;
+    cxobj             *xret = NULL;
+    int                s = -1;
+    int                eof = 0;
+    int                fdpass = 0;
+
+    if (clicon_rpc_connect(h, &s) < 0)
+        goto done;
+    if ((msg = clicon_hello_encode(h, NULL, NULL)) == NULL)
+        goto done;
+    if (clicon_rpc(s, clicon_sock_str(h), msg, &retdata, &eof) < 0)
+        goto done;
+    if (eof || retdata == NULL){
+        clixon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+        goto done;
+    }
+    if (clicon_rpc_reply_parse(h, retdata, &xret) < 0)
+        goto done;
+    if ((as = malloc(sizeof(*as))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(as, 0, sizeof(*as));
+    as->as_s = s;
+    if (clicon_hello_reply(h, xret, &as->as_session_id) < 0)
+        goto done;
+#ifdef PROTO_MSG_FD
+    fdpass = (clicon_sock_family(h) == AF_UNIX);
+#endif
+    if ((as->as_rcv = clixon_msg_rcv_new(fdpass)) == NULL)
+        goto done;
+    if (clixon_event_reg_fd(s, clicon_rpc_async_input, h, "backend rpc async") < 0)
+        goto done;
+    if (clicon_ptr_set(h, "rpc-async", as) < 0){
+        clixon_event_unreg_fd(s, clicon_rpc_async_input);
+        goto done;
+    }
+    clixon_debug(CLIXON_DBG_DEFAULT, "session-id:%u", as->as_session_id);
+    *asp = as;
+    as = NULL;
+    s = -1;
+    retval = 0;
+ done:
+    if (as){
+        if (as->as_rcv)
+            clixon_msg_rcv_free(as->as_rcv);
+        free(as);
+    }
+    if (s != -1)
+        close(s);
+    if (msg)
+        free(msg);
+    if (retdata)
+        free(retdata);
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Find request in flight that a reply belongs to, and remove it from the session
+ *
+ * @param[in]  as    Asynchronous rpc session
+ * @param[in]  xret  Reply, or NULL if invalid
+ * @retval     ra    Request, free with free()
+ * @retval     NULL  No matching request
+ */
+static struct rpc_async_req *
+clicon_rpc_async_match(struct rpc_async *as,
+                       cxobj            *xret)
+{
+    struct rpc_async_req *ra;
+    cxobj                *xr = NULL;
+    char                 *idstr = NULL;
+    uint32_t              id;
+
+    if ((ra = as->as_reqs) == NULL)
+        return NULL;
+    if (xret != NULL &&
+        (xr = xml_find_type(xret, NULL, "rpc-reply", CX_ELMNT)) != NULL)
+        idstr = xml_find_type_value(xr, NULL, "message-id", CX_ATTR);
+    if (idstr != NULL){
+        if (parse_uint32(idstr, &id, NULL) <= 0)
+            return NULL;
+        do {
+            if (ra->ra_id == id)
+                break;
+            ra = NEXTQ(struct rpc_async_req *, ra);
+        } while (ra != as->as_reqs);
+        if (ra->ra_id != id)
+            return NULL;
+    }
+    DELQ(ra, as->as_reqs, struct rpc_async_req *);
+    as->as_nr--;
+    return ra;
+}
+
+/*! Replies have arrived on asynchronous rpc session, deliver them to callbacks
+ *
+ * Notifications are not replies and are discarded, use a separate session for a
+ * notification stream
+ * @param[in]  s    Socket to backend
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error, from callback
+ */
+static int
+clicon_rpc_async_input(int   s,
+                       void *arg)
+{
+    int                   retval = -1;
+    clixon_handle         h = (clixon_handle)arg;
+    struct rpc_async     *as;
+    struct rpc_async_req *ra = NULL;
+    cbuf                 *cb = NULL;
+    cxobj                *xret = NULL;
+    int                   eof = 0;
+    int                   ret;
+
+    if ((as = clicon_rpc_async_get(h)) == NULL || as->as_s != s){
+        clixon_err(OE_PROTO, EINVAL, "No asynchronous rpc session on socket %d", s);
+        goto done;
+    }
+    do {
+        if (clixon_msg_rcv_next(s, clicon_sock_str(h), as->as_rcv, &cb, &eof) < 0)
+            goto done;
+        if (eof){
+            clixon_log(h, LOG_WARNING, "%s: Unexpected close of CLICON_SOCK", __FUNCTION__);
+            if (clicon_rpc_async_close(h) < 0)
+                goto done;
+            break;
+        }
+        if (cb == NULL) /* Partial reply */
+            break;
+        if (clicon_rpc_reply_parse(h, cbuf_get(cb), &xret) < 0){
+            clixon_log(h, LOG_WARNING, "%s: Invalid reply: %s", __FUNCTION__, clixon_err_reason());
+            xret = NULL;
+        }
+        cbuf_free(cb);
+        cb = NULL;
+        if (xret && xml_find_type(xret, NULL, "notification", CX_ELMNT) != NULL){
+            clixon_debug(CLIXON_DBG_DEFAULT, "Notification on rpc async session discarded");
+            xml_free(xret);
+            xret = NULL;
+            continue;
+        }
+        if ((ra = clicon_rpc_async_match(as, xret)) == NULL){
+            /* Replies and requests are out of sync, fail all requests in flight */
+            clixon_log(h, LOG_WARNING, "%s: Reply without request, closing session", __FUNCTION__);
+            if (xret){
+                xml_free(xret);
+                xret = NULL;
+            }
+            if (clicon_rpc_async_close(h) < 0)
+                goto done;
+            break;
+        }
+        ret = ra->ra_fn(h, xret, ra->ra_arg);
+        free(ra);
+        ra = NULL;
+        if (xret){
+            xml_free(xret);
+            xret = NULL;
+        }
+        if (ret < 0)
+            goto done;
+        /* Callback may close the session */
+        if (clicon_rpc_async_get(h) != as)
+            break;
+    } while (clixon_msg_rcv_pending(as->as_rcv));
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Send internal netconf rpc to backend without waiting for the reply
+ *
+ * The request is sent on a separate backend session, opened on first use, and tagged
+ * with a message-id. Several requests may be in flight. When the reply arrives, it is
+ * delivered to fn from the clixon event loop. A reply is matched to its request by
+ * message-id, or in the order the requests are sent if the reply has no message-id.
+ * Notifications on the session are discarded. A reply that matches no request in flight
+ * closes the session.
+ * xret is NULL if the session is closed before the reply arrives. xret is freed when fn
+ * returns. If fn returns -1, the event loop is terminated.
+ * @param[in]  h      Clixon handle
+ * @param[in]  xmlstr RPC operation as XML string, eg "<get/>", without rpc element
+ * @param[in]  fn     Reply callback
+ * @param[in]  arg    Argument to fn
+ * @param[out] idp    Message-id of request, or NULL
+ * @retval     0      OK, request sent
+ * @retval    -1      Error
+ * @code
+ *   int reply_cb(clixon_handle h, cxobj *xret, void *arg){ ... }
+ *
+ *   if (clicon_rpc_async(h, "<get/>", reply_cb, arg, NULL) < 0)
+ *      err;
+ * @endcode
+ * @note The asynchronous session is a separate backend session, locks are not shared
+ *       with the session of clicon_rpc_msg
+ * @see clicon_rpc_netconf  Synchronous
+ */
+int
+clicon_rpc_async(clixon_handle        h,
+                 char                *xmlstr,
+                 clicon_rpc_async_cb *fn,
+                 void                *arg,
+                 uint32_t            *idp)
+{
+    int                   retval = -1;
+    struct rpc_async     *as;
+    struct rpc_async_req *ra = NULL;
+    cbuf                 *cb = NULL;
+    char                 *username;
+    uint32_t              id;
+
+    if ((as = clicon_rpc_async_get(h)) == NULL &&
+        clicon_rpc_async_open(h, &as) < 0)
+        goto done;
+    if ((ra = malloc(sizeof(*ra))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(ra, 0, sizeof(*ra));
+    id = netconf_message_id_next(h);
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL){
+        cprintf(cb, " %s:username=\"%s\"", CLIXON_LIB_PREFIX, username);
+        cprintf(cb, " xmlns:%s=\"%s\"", CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    }
+    cprintf(cb, " message-id=\"%u\">%s</rpc>", id, xmlstr);
+    if (clixon_msg_send11(as->as_s, clicon_sock_str(h), cb) < 0)
+        goto done;
+    ra->ra_id = id;
+    ra->ra_fn = fn;
+    ra->ra_arg = arg;
+    ADDQ(ra, as->as_reqs);
+    as->as_nr++;
+    ra = NULL;
+    if (idp)
+        *idp = id;
+    retval = 0;
+ done:
+    if (ra)
+        free(ra);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Get number of asynchronous rpc requests waiting for reply
+ *
+ * @param[in]  h     Clixon handle
+ * @retval     nr   Number of requests in flight
+ */
+int
+clicon_rpc_async_pending(clixon_handle h)
+{
+    struct rpc_async *as;
+
+    if ((as = clicon_rpc_async_get(h)) == NULL)
+        return 0;
+    return as->as_nr;
+}
@@ -37,7 +37,7 @@
   *
   * Clixon regular expression code for Yang type patterns following XML Schema
   * regex. 
-  * Two modes: libxml2 and posix-translation
+  * Three modes: libxml2, posix-translation and pcre2-translation
  * @see http://www.w3.org/TR/2004/REC-xmlschema-2-20041028
  */
 
@@ -53,6 +53,11 @@
 #include <regex.h>
 #include <ctype.h>
 
+#ifdef HAVE_LIBPCRE2_8
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+#endif
+
 #include <cligen/cligen.h>
 
 /* clixon */
@@ -368,6 +373,358 @@ regexp_xsd2posix(char  *xsd,
     return retval;
 }
 
+/*-------------------------- PCRE2 translation -------------------------*/
+
+/* XML NameStartChar and NameChar ranges without brackets, for \i and \c
+ * @see https://www.w3.org/TR/2008/REC-xml-20081126/#NT-NameStartChar
+ */
+#define XSD_PCRE2_NAMESTART ":A-Z_a-z\\x{C0}-\\x{D6}\\x{D8}-\\x{F6}\\x{F8}-\\x{2FF}\\x{370}-\\x{37D}\\x{37F}-\\x{1FFF}\\x{200C}-\\x{200D}\\x{2070}-\\x{218F}\\x{2C00}-\\x{2FEF}\\x{3001}-\\x{D7FF}\\x{F900}-\\x{FDCF}\\x{FDF0}-\\x{FFFD}\\x{10000}-\\x{EFFFF}"
+#define XSD_PCRE2_NAMECHAR XSD_PCRE2_NAMESTART "\\-.0-9\\x{B7}\\x{300}-\\x{36F}\\x{203F}-\\x{2040}"
+
+static int xsd2pcre2_class(char *xsd, size_t len, size_t *ip, cbuf *cb);
+
+/*! Translate one XSD escape sequence to PCRE2
+ *
+ * @param[in]     xsd     Input regex string according XSD
+ * @param[in]     len     Length of xsd
+ * @param[in,out] ip      Index of character following backslash, on exit last consumed
+ * @param[in]     inclass Escape is inside a character class
+ * @param[out]    cb      PCRE2 output
+ * @retval        1       OK
+ * @retval        0       Unsupported escape
+ */
+static int
+xsd2pcre2_escape(char   *xsd,
+                 size_t  len,
+                 size_t *ip,
+                 int     inclass,
+                 cbuf   *cb)
+{
+    size_t       i = *ip;
+    unsigned int h = 0;
+
+    switch (xsd[i]){
+    case 'c': /* XML NameChar */
+        cprintf(cb, inclass?"%s":"[%s]", XSD_PCRE2_NAMECHAR);
+        break;
+    case 'C':
+        if (inclass)
+            return 0;
+        cprintf(cb, "[^%s]", XSD_PCRE2_NAMECHAR);
+        break;
+    case 'i': /* XML NameStartChar */
+        cprintf(cb, inclass?"%s":"[%s]", XSD_PCRE2_NAMESTART);
+        break;
+    case 'I':
+        if (inclass)
+            return 0;
+        cprintf(cb, "[^%s]", XSD_PCRE2_NAMESTART);
+        break;
+    case 's': /* XSD whitespace is exactly these four */
+        cprintf(cb, inclass?" \\t\\n\\r":"[ \\t\\n\\r]");
+        break;
+    case 'S':
+        cprintf(cb, inclass?"\\S":"[^ \\t\\n\\r]");
+        break;
+    case 'w': /* [#x0000-#x10FFFF]-[\p{P}\p{Z}\p{C}], approximated by \w in classes */
+        cprintf(cb, inclass?"\\w":"[^\\p{P}\\p{Z}\\p{C}]");
+        break;
+    case 'W':
+        cprintf(cb, inclass?"\\W":"[\\p{P}\\p{Z}\\p{C}]");
+        break;
+    case 'p': /* Category escape, PCRE2 has the same syntax for general categories */
+    case 'P':
+        if (i+1 >= len || xsd[i+1] != '{')
+            return 0;
+        cprintf(cb, "\\%c", xsd[i]);
+        for (i++; i<len && xsd[i] != '}'; i++)
+            cbuf_append(cb, xsd[i]);
+        if (i == len)
+            return 0;
+        cbuf_append(cb, '}');
+        break;
+    case 'u': /* \uXXXX as in posix translation */
+        if (i+4 >= len || parse_hex4((const unsigned char*)xsd+i+1, &h) != 0)
+            return 0;
+        cprintf(cb, "\\x{%X}", h);
+        i += 4;
+        break;
+    case 'd': case 'D': case 'n': case 'r': case 't':
+    case '\\': case '|': case '.': case '-': case '^': case '?': case '*':
+    case '+': case '{': case '}': case '(': case ')': case '[': case ']':
+        cprintf(cb, "\\%c", xsd[i]);
+        break;
+    default:
+        return 0;
+    }
+    *ip = i;
+    return 1;
+}
+
+/*! Translate an XSD character class to PCRE2, including class subtraction
+ *
+ * XSD class subtraction [a-z-[aeiou]] has no PCRE2 counterpart and is translated
+ * to a negative lookahead: (?:(?![aeiou])[a-z])
+ * @param[in]     xsd  Input regex string according XSD
+ * @param[in]     len  Length of xsd
+ * @param[in,out] ip   Index of opening bracket, on exit index of closing bracket
+ * @param[out]    cb   PCRE2 output
+ * @retval        1    OK
+ * @retval        0    Syntax error or unsupported construct
+ * @retval       -1    Error
+ */
+static int
+xsd2pcre2_class(char   *xsd,
+                size_t  len,
+                size_t *ip,
+                cbuf   *cb)
+{
+    int    retval = -1;
+    cbuf  *cls = NULL;
+    cbuf  *sub = NULL;
+    size_t i = *ip + 1;
+    int    ret;
+
+    if ((cls = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cbuf_append(cls, '[');
+    if (i < len && xsd[i] == '^')
+        cbuf_append(cls, xsd[i++]);
+    for (; i<len && xsd[i] != ']'; i++){
+        if (xsd[i] == '\\'){
+            if (++i == len || xsd2pcre2_escape(xsd, len, &i, 1, cls) == 0)
+                goto fail;
+        }
+        else if (xsd[i] == '-' && i+1 < len && xsd[i+1] == '['){
+            if ((sub = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            i++;
+            if ((ret = xsd2pcre2_class(xsd, len, &i, sub)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            /* Subtraction must be last in class */
+            if (++i == len || xsd[i] != ']')
+                goto fail;
+            break;
+        }
+        else if (xsd[i] == '[')
+            cprintf(cls, "\\[");
+        else
+            cbuf_append(cls, xsd[i]);
+    }
+    if (i == len)
+        goto fail;
+    cbuf_append(cls, ']');
+    if (sub)
+        cprintf(cb, "(?:(?!%s)%s)", cbuf_get(sub), cbuf_get(cls));
+    else
+        cprintf(cb, "%s", cbuf_get(cls));
+    *ip = i;
+    retval = 1;
+ done:
+    if (cls)
+        cbuf_free(cls);
+    if (sub)
+        cbuf_free(sub);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Transform from XSD regex to PCRE2
+ *
+ * Unlike the posix translation this is intended to be complete, with the following
+ * exceptions:
+ * - Block escapes \p{IsBlock} are not supported by PCRE2 and fail at compile time
+ * - \S, \w and \W inside character classes use the PCRE2 (unicode) definitions
+ * - \C and \I inside character classes are not supported
+ * XSD regexps are implicitly anchored and ^ and $ are normal characters, except a leading
+ * ^ and a trailing $ which are accepted as redundant anchors for compatibility with posix mode
+ * @param[in]  xsd    Input regex string according XSD
+ * @param[out] pcre2  Output (malloced) string according to PCRE2, NULL if unsupported
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see regexp_xsd2posix
+ */
+int
+regexp_xsd2pcre2(char  *xsd,
+                 char **pcre2)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    size_t len;
+    size_t i;
+    int    ret;
+
+    *pcre2 = NULL;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "\\A(?:");
+    len = strlen(xsd);
+    for (i=0; i<len; i++){
+        switch (xsd[i]){
+        case '\\':
+            if (++i == len || xsd2pcre2_escape(xsd, len, &i, 0, cb) == 0)
+                goto ok;
+            break;
+        case '[':
+            if ((ret = xsd2pcre2_class(xsd, len, &i, cb)) < 0)
+                goto done;
+            if (ret == 0)
+                goto ok;
+            break;
+        case '^': /* Leading ^ and trailing $ are anchors as in posix (eg openconfig) */
+            if (i != 0)
+                cprintf(cb, "\\^");
+            break;
+        case '$':
+            if (i != len-1)
+                cprintf(cb, "\\$");
+            break;
+        case '.': /* XSD: any character except newline and carriage return */
+            cprintf(cb, "[^\\n\\r]");
+            break;
+        default:
+            cbuf_append(cb, xsd[i]);
+            break;
+        }
+    }
+    cprintf(cb, ")\\z");
+    if ((*pcre2 = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+#ifdef HAVE_LIBPCRE2_8
+
+/*! Compiled PCRE2 regexp with match data allocated once at compile time
+ */
+struct regex_pcre2 {
+    pcre2_code       *rp_code;
+    pcre2_match_data *rp_md;
+};
+
+/*! Compile XSD regexp with PCRE2 and JIT
+ *
+ * @param[in]   regexp  Regular expression string in XSD regex format
+ * @param[out]  recomp  Compiled regular expression (malloc:d, should be freed)
+ * @retval      1       OK
+ * @retval      0       Invalid regular expression (syntax error?)
+ * @retval     -1       Error
+ */
+static int
+regex_pcre2_compile(char  *regexp,
+                    void **recomp)
+{
+    int                 retval = -1;
+    char               *pattern = NULL;
+    struct regex_pcre2 *rp = NULL;
+    int                 errcode;
+    PCRE2_SIZE          erroffset;
+    PCRE2_UCHAR         errmsg[128];
+
+    if (regexp_xsd2pcre2(regexp, &pattern) < 0)
+        goto done;
+    if (pattern == NULL){
+        clixon_debug(CLIXON_DBG_DEFAULT, "Unsupported XSD regexp: %s", regexp);
+        retval = 0;
+        goto done;
+    }
+    if ((rp = malloc(sizeof(*rp))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(rp, 0, sizeof(*rp));
+    if ((rp->rp_code = pcre2_compile((PCRE2_SPTR)pattern, PCRE2_ZERO_TERMINATED,
+                                     PCRE2_UTF | PCRE2_UCP | PCRE2_NO_AUTO_CAPTURE,
+                                     &errcode, &erroffset, NULL)) == NULL){
+        pcre2_get_error_message(errcode, errmsg, sizeof(errmsg));
+        clixon_debug(CLIXON_DBG_DEFAULT, "pcre2_compile %s at %zu: %s",
+                     pattern, (size_t)erroffset, errmsg);
+        retval = 0;
+        goto done;
+    }
+    /* JIT is optional, pcre2_match falls back to the interpreter */
+    (void)pcre2_jit_compile(rp->rp_code, PCRE2_JIT_COMPLETE);
+    if ((rp->rp_md = pcre2_match_data_create_from_pattern(rp->rp_code, NULL)) == NULL){
+        clixon_err(OE_UNIX, errno, "pcre2_match_data_create_from_pattern");
+        goto done;
+    }
+    *recomp = rp;
+    rp = NULL;
+    retval = 1;
+ done:
+    if (rp)
+        regex_pcre2_free(rp);
+    if (pattern)
+        free(pattern);
+    return retval;
+}
+
+/*! Match string with compiled PCRE2 regexp
+ *
+ * @param[in]  recomp  Compiled regular expression
+ * @param[in]  string  Content string to match
+ * @retval     1       Match
+ * @retval     0       No match
+ * @retval    -1       Error
+ */
+static int
+regex_pcre2_exec(void *recomp,
+                 char *string)
+{
+    struct regex_pcre2 *rp = (struct regex_pcre2 *)recomp;
+    int                 ret;
+
+    ret = pcre2_match(rp->rp_code, (PCRE2_SPTR)string, strlen(string), 0, 0,
+                      rp->rp_md, NULL);
+    if (ret >= 0)
+        return 1;
+    if (ret == PCRE2_ERROR_NOMATCH)
+        return 0;
+    clixon_err(OE_REGEX, 0, "pcre2_match: %d", ret);
+    return -1;
+}
+#endif /* HAVE_LIBPCRE2_8 */
+
+/*! Free compiled PCRE2 regexp including the regexp itself
+ *
+ * Not static since type cache needs to free without handle
+ * @param[in]  recomp  Compiled regular expression
+ * @retval     0       OK
+ */
+int
+regex_pcre2_free(void *recomp)
+{
+#ifdef HAVE_LIBPCRE2_8
+    struct regex_pcre2 *rp = (struct regex_pcre2 *)recomp;
+
+    if (rp == NULL)
+        return 0;
+    if (rp->rp_md)
+        pcre2_match_data_free(rp->rp_md);
+    if (rp->rp_code)
+        pcre2_code_free(rp->rp_code);
+    free(rp);
+#endif
+    return 0;
+}
+
 /*-------------------------- Generic API functions ------------------------*/
 
 /*! Compilation of regular expression / pattern
@@ -399,6 +756,13 @@ regex_compile(clixon_handle h,
     case REGEXP_LIBXML2:
         retval = cligen_regex_libxml2_compile(regexp, recomp);
         break;
+    case REGEXP_PCRE2:
+#ifdef HAVE_LIBPCRE2_8
+        retval = regex_pcre2_compile(regexp, recomp);
+#else
+        clixon_err(OE_CFG, 0, "CLICON_YANG_REGEXP set to pcre2, but HAVE_LIBPCRE2_8 not set (Either change CLICON_YANG_REGEXP to posix, or run: configure --with-pcre2)");
+#endif
+        break;
     default:
         clixon_err(OE_CFG, 0, "clicon_yang_regexp invalid value: %d", clicon_yang_regexp(h));
         break;
@@ -432,6 +796,11 @@ regex_exec(clixon_handle h,
     case REGEXP_LIBXML2:
         retval = cligen_regex_libxml2_exec(recomp, string);
         break;
+#ifdef HAVE_LIBPCRE2_8
+    case REGEXP_PCRE2:
+        retval = regex_pcre2_exec(recomp, string);
+        break;
+#endif
     default:
         clixon_err(OE_CFG, 0, "clicon_yang_regexp invalid value: %d",
                    clicon_yang_regexp(h));
@@ -462,6 +831,9 @@ regex_free(clixon_handle h,
     case REGEXP_LIBXML2:
         retval = cligen_regex_libxml2_free(recomp);
         break;
+    case REGEXP_PCRE2:
+        retval = regex_pcre2_free(recomp);
+        break;
     default:
         clixon_err(OE_CFG, 0, "clicon_yang_regexp invalid value: %d", clicon_yang_regexp(h));
         goto done;
@@ -242,6 +242,7 @@ validate_identityref(cxobj     *xt,
     cbuf       *cb = NULL;
     cvec       *idrefvec; /* Derived identityref list: (module:id)**/
     yang_stmt  *ymod;
+    int         derived;
 
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
@@ -291,13 +292,16 @@ validate_identityref(cxobj     *xt,
             goto done;
         goto fail;
     }
-    cprintf(cb, "%s:%s", yang_argument_get(ymod), id);
-    idref = cbuf_get(cb);
     /* Here check if node is in the derived node list of the base identity
-     * The derived node list is a cvec computed XXX
+     * First try the derived bitset, else the derived list computed in ys_populate_identity
      */
-    idrefvec = yang_cvec_get(ybaseid);
-    if (cvec_find(idrefvec, idref) == NULL){
+    if (yang_identity_derived(ybaseid, yang_find(ymod, Y_IDENTITY, id), &derived) == 0){
+        cprintf(cb, "%s:%s", yang_argument_get(ymod), id);
+        idref = cbuf_get(cb);
+        idrefvec = yang_cvec_get(ybaseid);
+        derived = cvec_find(idrefvec, idref) != NULL;
+    }
+    if (!derived){
 
         cprintf(cberr, "Identityref validation failed, %s not derived from %s in %s.yang",
                 node,
@@ -0,0 +1,973 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2020-2025 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Binary XML tree encoding of the internal protocol
+ *
+ * Replies from the backend to internal clients (cli, netconf, restconf, snmp) may be sent
+ * as an encoded XML tree instead of XML text if the client sent the
+ * CLIXON_XML_BIN_CAPABILITY in its internal hello. The client then builds the tree
+ * directly from the tokens without text parsing, and binds YANG once per schema node.
+ *
+ * Encoding:
+ *   magic, version, token*
+ * Tokens:
+ *   dict-reset
+ *   elmnt-new <name> <prefix>  Element with YANG, next node id is assigned to its schema node
+ *   elmnt-ref <id> <prefix>    Element with YANG, same schema node as a previous elmnt-new
+ *   elmnt-str <name> <prefix>  Element without YANG
+ *   attr <prefix> <name> <value>
+ *   body <value>
+ *   body-uint <n>, body-nint <n>, body-true, body-false   Typed leaf values
+ *   end                        End of element, after its attributes and children
+ * Strings are a length followed by the characters. An empty prefix means no prefix.
+ * Numbers are LEB128 encoded as n+1 so that the encoding contains no zero bytes and can be
+ * sent as a string in the same way as XML text.
+ * Node ids are assigned per message in order of first use and reset by dict-reset. A YANG
+ * schema node of a client is found by name from its parent the first time, so that the
+ * encoding does not depend on the order of YANG statements in backend and client.
+ * Typed values are only used when the text is the canonical form of the value, so that
+ * decoding gives the same text as the backend XML tree.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <string.h>
+#include <syslog.h>
+#include <sys/types.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_xml_io.h"
+#include "clixon_yang_module.h"
+#include "clixon_xml_bin.h"
+
+/* First bytes of an encoded message, XML text never starts with these */
+#define XB_MAGIC         0x01
+#define XB_VERSION       0x01
+
+/* Tokens */
+#define XB_DICT_RESET    0x02
+#define XB_ELMNT_NEW     0x03
+#define XB_ELMNT_REF     0x04
+#define XB_ELMNT_STR     0x05
+#define XB_ATTR          0x06
+#define XB_BODY          0x07
+#define XB_BODY_UINT     0x08
+#define XB_BODY_NINT     0x09
+#define XB_BODY_TRUE     0x0a
+#define XB_BODY_FALSE    0x0b
+#define XB_END           0x0c
+
+/* Typed value kind of a schema node */
+#define XB_KIND_STRING   0
+#define XB_KIND_INT      1
+#define XB_KIND_BOOL     2
+
+/* Max digits of a typed integer value, so that n+1 fits in uint64 */
+#define XB_INT_DIGITS    19
+
+/*! Encoder dictionary: schema node to node id, open addressing on pointer
+ */
+struct xml_bin_enc {
+    yang_stmt **be_keys;
+    uint32_t   *be_ids;
+    uint8_t    *be_kinds;
+    size_t      be_size;   /* Power of 2 */
+    uint32_t    be_nr;     /* Next node id */
+};
+
+/*! Decoder dictionary entry: node id to name and client schema node
+ */
+struct xml_bin_dent {
+    char       *bd_name;
+    yang_stmt  *bd_y;
+    int         bd_resolved;
+};
+
+/*! Decoder state
+ */
+struct xml_bin_dec {
+    const unsigned char *bd_buf;
+    size_t               bd_len;
+    size_t               bd_pos;
+    yang_stmt           *bd_yspec;
+    struct xml_bin_dent *bd_vec;
+    size_t               bd_vlen;
+    size_t               bd_vmax;
+    cbuf                *bd_str;    /* Current string */
+};
+
+/*------------------------------------------------------------------------
+ * Encoding
+ *------------------------------------------------------------------------*/
+
+/*! Append a number as LEB128 of n+1
+ *
+ * @param[in]  cb   Buffer
+ * @param[in]  n    Number, less than UINT64_MAX
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xb_num_put(cbuf    *cb,
+           uint64_t n)
+{
+    unsigned char buf[10];
+    size_t        len = 0;
+
+    n++;
+    do {
+        buf[len] = n & 0x7f;
+        n >>= 7;
+        if (n)
+            buf[len] |= 0x80;
+        len++;
+    } while (n);
+    if (cbuf_append_buf(cb, buf, len) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Append a string as length and characters, NULL is the empty string
+ *
+ * @param[in]  cb   Buffer
+ * @param[in]  str  String or NULL
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xb_str_put(cbuf *cb,
+           char *str)
+{
+    size_t len;
+
+    len = str ? strlen(str) : 0;
+    if (xb_num_put(cb, len) < 0)
+        return -1;
+    if (len && cbuf_append_buf(cb, str, len) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Get typed value kind of a YANG leaf or leaf-list
+ *
+ * @param[in]  y     Schema node
+ * @retval     kind  XB_KIND_INT, XB_KIND_BOOL or XB_KIND_STRING
+ */
+static int
+xb_kind(yang_stmt *y)
+{
+    cg_var *cv;
+
+    switch (yang_keyword_get(y)){
+    case Y_LEAF:
+    case Y_LEAF_LIST:
+        if ((cv = yang_cv_get(y)) == NULL)
+            break;
+        switch (cv_type_get(cv)){
+        case CGV_INT8:
+        case CGV_INT16:
+        case CGV_INT32:
+        case CGV_INT64:
+        case CGV_UINT8:
+        case CGV_UINT16:
+        case CGV_UINT32:
+        case CGV_UINT64:
+            return XB_KIND_INT;
+        case CGV_BOOL:
+            return XB_KIND_BOOL;
+        default:
+            break;
+        }
+        break;
+    default:
+        break;
+    }
+    return XB_KIND_STRING;
+}
+
+/*! Look up schema node in encoder dictionary, add it if not found
+ *
+ * @param[in]  be    Encoder dictionary
+ * @param[in]  y     Schema node
+ * @param[out] id    Node id
+ * @param[out] kind  Typed value kind
+ * @retval     1     Found
+ * @retval     0     Added with new id
+ * @retval    -1     Error
+ */
+static int
+xb_enc_lookup(struct xml_bin_enc *be,
+              yang_stmt          *y,
+              uint32_t           *id,
+              uint8_t            *kind)
+{
+    size_t      i;
+    size_t      j;
+    size_t      size;
+    yang_stmt **keys;
+    uint32_t   *ids;
+    uint8_t    *kinds;
+
+    if (2 * (be->be_nr + 1) > be->be_size){
+        size = be->be_size ? 2 * be->be_size : 64;
+        if ((keys = calloc(size, sizeof(*keys))) == NULL ||
+            (ids = calloc(size, sizeof(*ids))) == NULL ||
+            (kinds = calloc(size, sizeof(*kinds))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            return -1;
+        }
+        for (i=0; i<be->be_size; i++){
+            if (be->be_keys[i] == NULL)
+                continue;
+            j = ((uintptr_t)be->be_keys[i] >> 4) & (size - 1);
+            while (keys[j] != NULL)
+                j = (j + 1) & (size - 1);
+            keys[j] = be->be_keys[i];
+            ids[j] = be->be_ids[i];
+            kinds[j] = be->be_kinds[i];
+        }
+        if (be->be_keys){
+            free(be->be_keys);
+            free(be->be_ids);
+            free(be->be_kinds);
+        }
+        be->be_keys = keys;
+        be->be_ids = ids;
+        be->be_kinds = kinds;
+        be->be_size = size;
+    }
+    i = ((uintptr_t)y >> 4) & (be->be_size - 1);
+    while (be->be_keys[i] != NULL){
+        if (be->be_keys[i] == y){
+            *id = be->be_ids[i];
+            *kind = be->be_kinds[i];
+            return 1;
+        }
+        i = (i + 1) & (be->be_size - 1);
+    }
+    be->be_keys[i] = y;
+    be->be_ids[i] = be->be_nr++;
+    be->be_kinds[i] = xb_kind(y);
+    *id = be->be_ids[i];
+    *kind = be->be_kinds[i];
+    return 0;
+}
+
+/*! Encode a body, typed if the schema node is typed and the value is canonical
+ *
+ * @param[in]  cb    Buffer
+ * @param[in]  val   Body value
+ * @param[in]  kind  Typed value kind of parent schema node
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xb_body_put(cbuf   *cb,
+            char   *val,
+            uint8_t kind)
+{
+    char    *s;
+    uint64_t n = 0;
+    int      neg = 0;
+    int      i;
+
+    switch (kind){
+    case XB_KIND_INT:
+        s = val;
+        if (*s == '-'){
+            neg = 1;
+            s++;
+        }
+        /* Canonical decimal: no sign other than -, no leading zeros, no -0 */
+        if (*s == '\0' || (s[0] == '0' && (s[1] != '\0' || neg)))
+            break;
+        for (i=0; s[i] != '\0'; i++){
+            if (i == XB_INT_DIGITS || s[i] < '0' || s[i] > '9')
+                break;
+            n = n*10 + (s[i] - '0');
+        }
+        if (s[i] != '\0')
+            break;
+        cbuf_append(cb, neg ? XB_BODY_NINT : XB_BODY_UINT);
+        return xb_num_put(cb, n);
+    case XB_KIND_BOOL:
+        if (strcmp(val, "true") == 0){
+            cbuf_append(cb, XB_BODY_TRUE);
+            return 0;
+        }
+        if (strcmp(val, "false") == 0){
+            cbuf_append(cb, XB_BODY_FALSE);
+            return 0;
+        }
+        break;
+    default:
+        break;
+    }
+    cbuf_append(cb, XB_BODY);
+    return xb_str_put(cb, val);
+}
+
+/*! Encode an XML tree recursively
+ *
+ * @param[in]  cb     Buffer
+ * @param[in]  be     Encoder dictionary
+ * @param[in]  x      XML element
+ * @param[in]  depth  Limit levels of child resources: -1: all, 0: none, 1: node itself
+ * @param[in]  wdef   With-defaults parameter, except WITHDEFAULTS_REPORT_ALL_TAGGED
+ * @param[in]  fn     Filter function or NULL
+ * @param[in]  arg    Argument to filter function
+ * @param[in]  state  Filter state of x
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xml2cbuf_recurse  for XML text
+ */
+static int
+xml2bin_recurse(cbuf               *cb,
+                struct xml_bin_enc *be,
+                cxobj              *x,
+                int32_t             depth,
+                withdefaults_type   wdef,
+                xml2cbuf_filter_fn *fn,
+                void               *arg,
+                int                 state)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    cxobj     *xc;
+    uint32_t   id;
+    uint8_t    kind = XB_KIND_STRING;
+    int        cstate;
+    int        ret;
+    int        i;
+
+    if (depth == 0)
+        goto ok;
+    if ((y = xml_spec(x)) != NULL){
+        /* with-defaults: if object should be printed or not */
+        if ((ret = xml2output_wdef(x, wdef, NULL)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+        if ((ret = xb_enc_lookup(be, y, &id, &kind)) < 0)
+            goto done;
+        if (ret == 1){
+            cbuf_append(cb, XB_ELMNT_REF);
+            if (xb_num_put(cb, id) < 0)
+                goto done;
+        }
+        else {
+            cbuf_append(cb, XB_ELMNT_NEW);
+            if (xb_str_put(cb, xml_name(x)) < 0)
+                goto done;
+        }
+    }
+    else {
+        cbuf_append(cb, XB_ELMNT_STR);
+        if (xb_str_put(cb, xml_name(x)) < 0)
+            goto done;
+    }
+    if (xb_str_put(cb, xml_prefix(x)) < 0)
+        goto done;
+    /* Attributes first
+     * Children are iterated by index, so that the tree is not modified, see xml2cbuf_recurse */
+    for (i=0; i<xml_child_nr(x); i++)
+        if ((xc = xml_child_i(x, i)) != NULL && xml_type(xc) == CX_ATTR &&
+            clixon_xml2bin_attr(cb, xml_prefix(xc), xml_name(xc), xml_value(xc)) < 0)
+            goto done;
+    for (i=0; i<xml_child_nr(x); i++){
+        if ((xc = xml_child_i(x, i)) == NULL)
+            continue;
+        switch (xml_type(xc)){
+        case CX_BODY:
+            if (xml_value(xc) == NULL) /* incomplete tree */
+                break;
+            if (xb_body_put(cb, xml_value(xc), kind) < 0)
+                goto done;
+            break;
+        case CX_ELMNT:
+            cstate = 0;
+            if (fn != NULL){
+                if ((ret = fn(xc, arg, state, &cstate)) < 0)
+                    goto done;
+                if (ret == 0) /* Skip subtree */
+                    break;
+            }
+            if (xml2bin_recurse(cb, be, xc, depth-1, wdef, fn, arg, cstate) < 0)
+                goto done;
+            break;
+        default:
+            break;
+        }
+    }
+    cbuf_append(cb, XB_END);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Start a binary XML message
+ *
+ * @param[in,out] cb  Buffer, should be empty
+ * @retval        0   OK
+ * @retval       -1   Error
+ * @code
+ *   clixon_xml2bin_start(cb);
+ *   clixon_xml2bin_elmnt(cb, NULL, "rpc-reply");
+ *   clixon_xml2bin_attr(cb, NULL, "xmlns", NETCONF_BASE_NAMESPACE);
+ *   clixon_xml2bin(cb, xdata, -1, WITHDEFAULTS_REPORT_ALL, NULL, NULL);
+ *   clixon_xml2bin_end(cb);
+ * @endcode
+ */
+int
+clixon_xml2bin_start(cbuf *cb)
+{
+    cbuf_append(cb, XB_MAGIC);
+    cbuf_append(cb, XB_VERSION);
+    return 0;
+}
+
+/*! Start an element without YANG, end it with clixon_xml2bin_end
+ *
+ * @param[in,out] cb      Buffer
+ * @param[in]     prefix  Namespace prefix or NULL
+ * @param[in]     name    Element name
+ * @retval        0       OK
+ * @retval       -1       Error
+ */
+int
+clixon_xml2bin_elmnt(cbuf *cb,
+                     char *prefix,
+                     char *name)
+{
+    cbuf_append(cb, XB_ELMNT_STR);
+    if (xb_str_put(cb, name) < 0)
+        return -1;
+    return xb_str_put(cb, prefix);
+}
+
+/*! Add an attribute to the current element, before its children
+ *
+ * @param[in,out] cb      Buffer
+ * @param[in]     prefix  Namespace prefix or NULL
+ * @param[in]     name    Attribute name
+ * @param[in]     value   Attribute value
+ * @retval        0       OK
+ * @retval       -1       Error
+ */
+int
+clixon_xml2bin_attr(cbuf *cb,
+                    char *prefix,
+                    char *name,
+                    char *value)
+{
+    cbuf_append(cb, XB_ATTR);
+    if (xb_str_put(cb, prefix) < 0)
+        return -1;
+    if (xb_str_put(cb, name) < 0)
+        return -1;
+    return xb_str_put(cb, value);
+}
+
+/*! End the current element
+ *
+ * @param[in,out] cb      Buffer
+ * @retval        0       OK
+ */
+int
+clixon_xml2bin_end(cbuf *cb)
+{
+    cbuf_append(cb, XB_END);
+    return 0;
+}
+
+/*! Encode an XML tree as binary XML, skipping subtrees rejected by a filter
+ *
+ * @param[in,out] cb     Buffer, started with clixon_xml2bin_start
+ * @param[in]     x      Top-level xml object, not filtered
+ * @param[in]     depth  Limit levels of child resources: -1: all, 0: none, 1: node itself
+ * @param[in]     wdef   With-defaults parameter, WITHDEFAULTS_REPORT_ALL_TAGGED not supported
+ * @param[in]     fn     Filter function or NULL
+ * @param[in]     arg    Argument to filter function
+ * @retval        0      OK
+ * @retval       -1      Error
+ * @see clixon_xml2cbuf_filter  for XML text
+ */
+int
+clixon_xml2bin(cbuf               *cb,
+               cxobj              *x,
+               int32_t             depth,
+               withdefaults_type   wdef,
+               xml2cbuf_filter_fn *fn,
+               void               *arg)
+{
+    int                retval = -1;
+    struct xml_bin_enc be = {0,};
+
+    if (wdef == WITHDEFAULTS_REPORT_ALL_TAGGED){
+        clixon_err(OE_XML, EINVAL, "with-defaults report-all-tagged not supported");
+        goto done;
+    }
+    cbuf_append(cb, XB_DICT_RESET);
+    if (xml2bin_recurse(cb, &be, x, depth, wdef, fn, arg, 0) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (be.be_keys){
+        free(be.be_keys);
+        free(be.be_ids);
+        free(be.be_kinds);
+    }
+    return retval;
+}
+
+/*------------------------------------------------------------------------
+ * Decoding
+ *------------------------------------------------------------------------*/
+
+/*! Reset decoder dictionary
+ */
+static void
+xb_dict_reset(struct xml_bin_dec *bd)
+{
+    size_t i;
+
+    for (i=0; i<bd->bd_vlen; i++)
+        if (bd->bd_vec[i].bd_name)
+            free(bd->bd_vec[i].bd_name);
+    bd->bd_vlen = 0;
+}
+
+/*! Read a number
+ *
+ * @param[in]  bd  Decoder
+ * @param[out] n   Number
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+xb_num_get(struct xml_bin_dec *bd,
+           uint64_t           *n)
+{
+    uint64_t v = 0;
+    int      shift = 0;
+    uint8_t  b;
+
+    do {
+        if (bd->bd_pos >= bd->bd_len || shift > 63){
+            clixon_err(OE_XML, EINVAL, "Invalid binary XML: bad number");
+            return -1;
+        }
+        b = bd->bd_buf[bd->bd_pos++];
+        v |= (uint64_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    if (v == 0){
+        clixon_err(OE_XML, EINVAL, "Invalid binary XML: bad number");
+        return -1;
+    }
+    *n = v - 1;
+    return 0;
+}
+
+/*! Read a string into the decoder string buffer
+ *
+ * @param[in]  bd         Decoder
+ * @param[in]  nullempty  Return NULL for the empty string, eg no prefix
+ * @param[out] str        String, valid until next call
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xb_str_get(struct xml_bin_dec *bd,
+           int                 nullempty,
+           char              **str)
+{
+    uint64_t len;
+
+    if (xb_num_get(bd, &len) < 0)
+        return -1;
+    if (len > bd->bd_len - bd->bd_pos){
+        clixon_err(OE_XML, EINVAL, "Invalid binary XML: bad string length");
+        return -1;
+    }
+    cbuf_reset(bd->bd_str);
+    if (len && cbuf_append_buf(bd->bd_str, (void*)(bd->bd_buf + bd->bd_pos), len) < 0){
+        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+        return -1;
+    }
+    bd->bd_pos += len;
+    *str = (len == 0 && nullempty) ? NULL : cbuf_get(bd->bd_str);
+    return 0;
+}
+
+/*! Find client schema node of an element the first time its node id is used
+ *
+ * @param[in]  bd   Decoder
+ * @param[in]  x    XML element with attributes decoded
+ * @param[in]  bde  Dictionary entry
+ * @retval     0    OK, schema node or NULL if not found, then x is left without YANG
+ * @retval    -1    Error
+ */
+static int
+xb_resolve(struct xml_bin_dec  *bd,
+           cxobj               *x,
+           struct xml_bin_dent *bde)
+{
+    int        retval = -1;
+    char      *ns = NULL;
+    char      *myns;
+    yang_stmt *yp;
+    yang_stmt *ymod;
+    yang_stmt *y = NULL;
+
+    if (xml2ns(x, xml_prefix(x), &ns) < 0)
+        goto done;
+    if ((yp = xml_spec(xml_parent(x))) != NULL)
+        y = yang_find_datanode(yp, bde->bd_name);
+    else if (ns && bd->bd_yspec &&
+             (ymod = yang_find_module_by_namespace(bd->bd_yspec, ns)) != NULL)
+        y = yang_find_datanode(ymod, bde->bd_name);
+    if (y != NULL &&
+        (ns == NULL || (myns = yang_find_mynamespace(y)) == NULL || strcmp(ns, myns) != 0))
+        y = NULL;
+    bde->bd_y = y;
+    bde->bd_resolved = 1;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Decode an element and its children
+ *
+ * Bodies of lists and containers are skipped as in strip_body_objects
+ * @param[in]  bd   Decoder
+ * @param[in]  xp   Parent
+ * @param[in]  tag  Element token, already read
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xb_elmnt_get(struct xml_bin_dec *bd,
+             cxobj              *xp,
+             uint8_t             tag)
+{
+    int                  retval = -1;
+    cxobj               *x;
+    cxobj               *xc;
+    struct xml_bin_dent *bde = NULL;
+    uint64_t             id;
+    uint64_t             n;
+    char                *str;
+    char                *prefix;
+    char                *name;
+    char                 numstr[24];
+    int                  pending = 0;
+    uint8_t              t;
+    yang_stmt           *y;
+
+    switch (tag){
+    case XB_ELMNT_REF:
+        if (xb_num_get(bd, &id) < 0)
+            goto done;
+        if (id >= bd->bd_vlen){
+            clixon_err(OE_XML, EINVAL, "Invalid binary XML: unknown node id %" PRIu64, id);
+            goto done;
+        }
+        bde = &bd->bd_vec[id];
+        name = bde->bd_name;
+        break;
+    case XB_ELMNT_NEW:
+        if (bd->bd_vlen == bd->bd_vmax){
+            bd->bd_vmax = bd->bd_vmax ? 2 * bd->bd_vmax : 32;
+            if ((bd->bd_vec = realloc(bd->bd_vec, bd->bd_vmax * sizeof(*bd->bd_vec))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+        }
+        if (xb_str_get(bd, 0, &str) < 0)
+            goto done;
+        bde = &bd->bd_vec[bd->bd_vlen];
+        memset(bde, 0, sizeof(*bde));
+        if ((bde->bd_name = strdup(str)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        bd->bd_vlen++;
+        name = bde->bd_name;
+        pending = 1;
+        break;
+    default: /* XB_ELMNT_STR */
+        if (xb_str_get(bd, 0, &name) < 0)
+            goto done;
+        break;
+    }
+    if ((x = xml_new(name, xp, CX_ELMNT)) == NULL)
+        goto done;
+    if (xb_str_get(bd, 1, &prefix) < 0)
+        goto done;
+    if (prefix && xml_prefix_set(x, prefix) < 0)
+        goto done;
+    if (bde && !pending && bde->bd_y)
+        xml_spec_set(x, bde->bd_y);
+    while (1){
+        if (bd->bd_pos >= bd->bd_len){
+            clixon_err(OE_XML, EINVAL, "Invalid binary XML: missing end");
+            goto done;
+        }
+        t = bd->bd_buf[bd->bd_pos++];
+        if (t == XB_ATTR){
+            if (xb_str_get(bd, 1, &prefix) < 0)
+                goto done;
+            if (prefix && (prefix = strdup(prefix)) == NULL){
+                clixon_err(OE_UNIX, errno, "strdup");
+                goto done;
+            }
+            if (xb_str_get(bd, 0, &str) < 0 ||
+                (xc = xml_new(str, x, CX_ATTR)) == NULL ||
+                (prefix && xml_prefix_set(xc, prefix) < 0) ||
+                xb_str_get(bd, 0, &str) < 0 ||
+                xml_value_set(xc, str) < 0){
+                if (prefix)
+                    free(prefix);
+                goto done;
+            }
+            if (prefix)
+                free(prefix);
+            continue;
+        }
+        /* Attributes are decoded, ie namespace is known */
+        if (pending){
+            if (xb_resolve(bd, x, bde) < 0)
+                goto done;
+            if (bde->bd_y)
+                xml_spec_set(x, bde->bd_y);
+            pending = 0;
+        }
+        str = NULL;
+        switch (t){
+        case XB_END:
+            goto ok;
+        case XB_ELMNT_NEW:
+        case XB_ELMNT_REF:
+        case XB_ELMNT_STR:
+            if (xb_elmnt_get(bd, x, t) < 0)
+                goto done;
+            continue;
+        case XB_BODY:
+            if (xb_str_get(bd, 0, &str) < 0)
+                goto done;
+            break;
+        case XB_BODY_UINT:
+        case XB_BODY_NINT:
+            if (xb_num_get(bd, &n) < 0)
+                goto done;
+            snprintf(numstr, sizeof(numstr), "%s%" PRIu64, t==XB_BODY_NINT?"-":"", n);
+            str = numstr;
+            break;
+        case XB_BODY_TRUE:
+            str = "true";
+            break;
+        case XB_BODY_FALSE:
+            str = "false";
+            break;
+        default:
+            clixon_err(OE_XML, EINVAL, "Invalid binary XML: unknown token %u", t);
+            goto done;
+        }
+        /* As strip_body_objects */
+        if ((y = xml_spec(x)) != NULL &&
+            (yang_keyword_get(y) == Y_LIST || yang_keyword_get(y) == Y_CONTAINER))
+            continue;
+        if ((xc = xml_new("body", x, CX_BODY)) == NULL)
+            goto done;
+        if (xml_value_set(xc, str) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if a string is a binary XML message
+ *
+ * @param[in]  str  Message from backend
+ * @retval     1    Binary XML, decode with clixon_xml_bin_parse
+ * @retval     0    Not binary XML, eg XML text
+ */
+int
+clixon_xml_bin_is(const char *str)
+{
+    return str != NULL && str[0] == XB_MAGIC;
+}
+
+/*! Decode a binary XML message to an XML tree
+ *
+ * Elements the backend had YANG for are bound to the YANG spec of the client
+ * @param[in]  buf    Binary XML message
+ * @param[in]  len    Length of message
+ * @param[in]  yspec  Yang spec of client, or NULL
+ * @param[out] xt     Top of XML tree, as from clixon_xml_parse_string. Free with xml_free()
+ * @retval     0      OK
+ * @retval    -1      Error, including invalid encoding
+ * @see clixon_xml_parse_string  for XML text
+ * @see clixon_xml_bin_bound     Check if YANG binding is complete
+ */
+int
+clixon_xml_bin_parse(const char *buf,
+                     size_t      len,
+                     yang_stmt  *yspec,
+                     cxobj     **xt)
+{
+    int                retval = -1;
+    struct xml_bin_dec bd = {0,};
+    cxobj             *xtop = NULL;
+    uint8_t            t;
+
+    if (len < 2 || buf[0] != XB_MAGIC || buf[1] != XB_VERSION){
+        clixon_err(OE_XML, EINVAL, "Invalid binary XML: bad header");
+        goto done;
+    }
+    bd.bd_buf = (const unsigned char *)buf;
+    bd.bd_len = len;
+    bd.bd_pos = 2;
+    bd.bd_yspec = yspec;
+    if ((bd.bd_str = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((xtop = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    while (bd.bd_pos < bd.bd_len){
+        t = bd.bd_buf[bd.bd_pos++];
+        switch (t){
+        case XB_DICT_RESET:
+            xb_dict_reset(&bd);
+            break;
+        case XB_ELMNT_NEW:
+        case XB_ELMNT_REF:
+        case XB_ELMNT_STR:
+            if (xb_elmnt_get(&bd, xtop, t) < 0)
+                goto done;
+            break;
+        default:
+            clixon_err(OE_XML, EINVAL, "Invalid binary XML: unknown token %u", t);
+            goto done;
+        }
+    }
+    *xt = xtop;
+    xtop = NULL;
+    retval = 0;
+ done:
+    xb_dict_reset(&bd);
+    if (bd.bd_vec)
+        free(bd.bd_vec);
+    if (bd.bd_str)
+        cbuf_free(bd.bd_str);
+    if (xtop)
+        xml_free(xtop);
+    return retval;
+}
+
+/*! Check if all elements of an XML tree are bound to YANG
+ *
+ * A decoded binary XML tree is bound except below mount-points and anydata, and where
+ * backend and client YANG differ. Then xml_bind_yang is needed as for XML text.
+ * Otherwise call clixon_xml_bin_index instead of xml_bind_yang.
+ * @param[in]  xt   XML tree, xt itself is not checked
+ * @retval     1    All elements below xt have YANG
+ * @retval     0    At least one element below xt has no YANG
+ */
+int
+clixon_xml_bin_bound(cxobj *xt)
+{
+    cxobj *x = NULL;
+
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL){
+        if (xml_spec(x) == NULL)
+            return 0;
+        if (clixon_xml_bin_bound(x) == 0)
+            return 0;
+    }
+    return 1;
+}
+
+/*! Make the side-effects of xml_bind_yang on a decoded and bound binary XML tree
+ *
+ * Insert search indexes, as populate_self_parent. Bodies of lists and containers are
+ * already skipped by the decoder.
+ * @param[in]  xt   XML tree where all elements below xt are bound, see clixon_xml_bin_bound
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clixon_xml_bin_index(cxobj *xt)
+{
+#ifdef XML_EXPLICIT_INDEX
+    cxobj *x = NULL;
+
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL){
+        if (xml_search_index_p(x) &&
+            xml_search_child_insert(xt, x) < 0)
+            return -1;
+        if (clixon_xml_bin_index(x) < 0)
+            return -1;
+    }
+#endif
+    return 0;
+}
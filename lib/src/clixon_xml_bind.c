@@ -471,6 +471,10 @@ xml_bind_yang0_opt(clixon_handle h,
                 ybc = YB_MODULE;
             else if (h == NULL)
                 goto ok; /* treat as anydata */
+#ifdef YANG_SCHEMA_MOUNT_LAZY
+            else if (xml_child_nr_type(xt, CX_ELMNT) == 0)
+                goto ok; /* Resolve yang-library on first bind with content */
+#endif
             else{
                 if ((ret = yang_schema_yanglib_get_mount_parse(h, xt)) < 0)
                     goto done;
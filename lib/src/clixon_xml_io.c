@@ -108,7 +108,7 @@ static int xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop)
  * @retval      0    Remove it
  * @retval     -1    Error
  */
-static int
+int
 xml2output_wdef(cxobj            *x,
                 withdefaults_type wdef,
                 int              *tag)
@@ -565,13 +565,16 @@ xml_dump(FILE  *f,
  * @see xml2file_recurse  same with FILE
  */
 static int
-xml2cbuf_recurse(cbuf             *cb,
-                 cxobj            *x,
-                 int               level,
-                 int               pretty,
-                 char             *prefix,
-                 int32_t           depth,
-                 withdefaults_type wdef)
+xml2cbuf_recurse(cbuf               *cb,
+                 cxobj              *x,
+                 int                 level,
+                 int                 pretty,
+                 char               *prefix,
+                 int32_t             depth,
+                 withdefaults_type   wdef,
+                 xml2cbuf_filter_fn *fn,
+                 void               *arg,
+                 int                 state)
 {
     int        retval = -1;
     cxobj     *xc;
@@ -584,6 +587,8 @@ xml2cbuf_recurse(cbuf             *cb,
     yang_stmt *y;
     int        tag = 0;
     int        ret;
+    int        cstate = 0;
+    int        i;
 
     if (depth == 0)
         goto ok;
@@ -631,23 +636,34 @@ xml2cbuf_recurse(cbuf             *cb,
             cbuf_append_str(cb, " wd:default=\"true\"");
         hasbody = 0;
         haselement = 0;
-        xc = NULL;
-        /* print attributes only */
-        while ((xc = xml_child_each(x, xc, -1)) != NULL)
+        /* print attributes only
+         * Children are iterated by index, not xml_child_each, so that the tree is not
+         * modified and may be printed by several threads, see BACKEND_READ_THREADS */
+        for (i=0; i<xml_child_nr(x); i++){
+            if ((xc = xml_child_i(x, i)) == NULL)
+                continue;
             switch (xml_type(xc)){
             case CX_ATTR:
-                if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, -1, wdef) < 0)
+                if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, -1, wdef, NULL, NULL, 0) < 0)
                     goto done;
                 break;
             case CX_BODY:
                 hasbody=1;
                 break;
             case CX_ELMNT:
+                /* With filter, only count children that are printed */
+                if (fn != NULL && haselement == 0){
+                    if ((ret = fn(xc, arg, state, &cstate)) < 0)
+                        goto done;
+                    if (ret == 0)
+                        break;
+                }
                 haselement=1;
                 break;
             default:
                 break;
             }
+        }
         /* Check for special case <a/> instead of <a></a> */
         if (hasbody==0 && haselement==0)
             cbuf_append_str(cb, "/>");
@@ -655,12 +671,17 @@ xml2cbuf_recurse(cbuf             *cb,
             cbuf_append_str(cb, ">");
             if (pretty && hasbody == 0)
                 cbuf_append_str(cb, "\n");
-            xc = NULL;
-            while ((xc = xml_child_each(x, xc, -1)) != NULL)
-                if (xml_type(xc) != CX_ATTR){
+            for (i=0; i<xml_child_nr(x); i++)
+                if ((xc = xml_child_i(x, i)) != NULL && xml_type(xc) != CX_ATTR){
                     cxobj *xa = NULL;
                     char  *ns = NULL;
 
+                    if (fn != NULL && xml_type(xc) == CX_ELMNT){
+                        if ((ret = fn(xc, arg, state, &cstate)) < 0)
+                            goto done;
+                        if (ret == 0) /* Skip subtree */
+                            continue;
+                    }
                     /* If tagged withdefaults */
                     if (wdef == WITHDEFAULTS_REPORT_ALL_TAGGED &&
                         y == NULL &&
@@ -673,7 +694,7 @@ xml2cbuf_recurse(cbuf             *cb,
                             xa = xml_find_type(xc, IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX, IETF_NETCONF_WITH_DEFAULTS_ATTR_NAMESPACE, CX_ATTR);
                         }
                     }
-                    if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, depth-1, wdef) < 0)
+                    if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, depth-1, wdef, fn, arg, cstate) < 0)
                         goto done;
                     if (xa){
                         if (xml_purge(xa) < 0)
@@ -740,15 +761,78 @@ clixon_xml2cbuf1(cbuf             *cb,
 {
     int    retval = -1;
     cxobj *xc;
+    int    i;
 
     if (skiptop){
-        xc = NULL;
-        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
-            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef) < 0)
+        for (i=0; i<xml_child_nr(xn); i++){
+            if ((xc = xml_child_i(xn, i)) == NULL || xml_type(xc) != CX_ELMNT)
+                continue;
+            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef, NULL, NULL, 0) < 0)
+                goto done;
+        }
+    }
+    else {
+        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef, NULL, NULL, 0) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print an XML tree structure to a cligen buffer, skipping subtrees rejected by a filter
+ *
+ * As clixon_xml2cbuf1 but the filter is called for every element below the top object
+ * before it is printed. The tree is not modified.
+ * There is no JSON variant, since backend replies are XML and restconf encodes the already
+ * filtered reply as JSON.
+ * @param[in,out] cb      Cligen buffer to write to
+ * @param[in]     xn      Top-level xml object, not filtered
+ * @param[in]     level   Indentation level for pretty
+ * @param[in]     pretty  Insert \n and spaces to make the xml more readable.
+ * @param[in]     prefix  Add string to beginning of each line (or NULL) (if pretty)
+ * @param[in]     depth   Limit levels of child resources: -1: all, 0: none, 1: node itself
+ * @param[in]     skiptop 0: Include top object 1: Skip top-object, only children,
+ * @param[in]     wdef    With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     fn      Filter function
+ * @param[in]     arg     Argument to filter function
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @see nacm_read_filter_fn
+ */
+int
+clixon_xml2cbuf_filter(cbuf               *cb,
+                       cxobj              *xn,
+                       int                 level,
+                       int                 pretty,
+                       char               *prefix,
+                       int32_t             depth,
+                       int                 skiptop,
+                       withdefaults_type   wdef,
+                       xml2cbuf_filter_fn *fn,
+                       void               *arg)
+{
+    int    retval = -1;
+    cxobj *xc;
+    int    cstate;
+    int    ret;
+    int    i;
+
+    if (skiptop){
+        for (i=0; i<xml_child_nr(xn); i++){
+            if ((xc = xml_child_i(xn, i)) == NULL || xml_type(xc) != CX_ELMNT)
+                continue;
+            cstate = 0;
+            if ((ret = fn(xc, arg, 0, &cstate)) < 0)
+                goto done;
+            if (ret == 0)
+                continue;
+            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef, fn, arg, cstate) < 0)
                 goto done;
+        }
     }
     else {
-        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef) < 0)
+        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef, fn, arg, 0) < 0)
             goto done;
     }
     retval = 0;
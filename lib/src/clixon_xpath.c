@@ -102,6 +102,7 @@
 #include "clixon_xpath.h"
 #include "clixon_xpath_parse.h"
 #include "clixon_xpath_eval.h"
+#include "clixon_xpath_compile.h"
 
 /* Use apostrophe(') in XPath literals, eg a/[x='foo'], not double-quotes(")
  * If not set, use ": a/[x="foo"]
@@ -110,10 +111,39 @@
  */
 #define XPATH_USE_APOSTROPHE
 
+#ifdef XPATH_CACHE_SIZE
+/*! Entry in the XPath parse cache
+ *
+ * Entries are kept both in a hash table keyed on the XPath string and in a LRU queue
+ * where the first element is the least recently used.
+ * An entry is pinned as long as an evaluation using its tree is in progress (refcnt > 0), since
+ * XPath evaluation may recursively call xpath_vec_ctx, which in turn may evict entries.
+ */
+struct xpath_cache_entry {
+    qelem_t     xe_qelem;   /* LRU queue, first is least recently used */
+    char       *xe_xpath;   /* Key: XPath string */
+    xpath_tree *xe_tree;    /* Parsed XPath tree */
+    int         xe_refcnt;  /* Nr of ongoing evaluations using this tree */
+#ifdef XPATH_COMPILE
+    xpath_prog *xe_prog;    /* Compiled program of tree, or NULL */
+    int         xe_noprog;  /* XPath is not compilable, use xp_eval */
+#endif
+};
+typedef struct xpath_cache_entry xpath_cache_entry;
+#endif /* XPATH_CACHE_SIZE */
+
 /*
  * Variables
  */
 
+#ifdef XPATH_CACHE_SIZE
+static clicon_hash_t     *_xpath_cache = NULL;     /* XPath string -> cache entry */
+static xpath_cache_entry *_xpath_cache_lru = NULL; /* LRU queue, first is oldest */
+static int                _xpath_cache_nr = 0;
+static uint64_t           _xpath_cache_hits = 0;
+static uint64_t           _xpath_cache_misses = 0;
+#endif /* XPATH_CACHE_SIZE */
+
 /* Mapping between XPath_tree node name string <--> int
  * @see xpath_tree_int2str
  */
@@ -604,57 +634,321 @@ xpath_parse(const char  *xpath,
     return retval;
 }
 
-/*! Given XML tree and XPath, parse XPath, eval it and return XPath context,
+#ifdef XPATH_CACHE_SIZE
+/*! Free a cache entry, the entry must be removed from hash and LRU queue
+ */
+static int
+xpath_cache_entry_free(xpath_cache_entry *xe)
+{
+    if (xe->xe_xpath)
+        free(xe->xe_xpath);
+#ifdef XPATH_COMPILE
+    if (xe->xe_prog)
+        xpath_prog_free(xe->xe_prog);
+#endif
+    if (xe->xe_tree)
+        xpath_tree_free(xe->xe_tree);
+    free(xe);
+    return 0;
+}
+
+/*! Evict least recently used entries until the cache is within bounds
+ *
+ * Entries in use by an ongoing evaluation are skipped. If all entries are in use, the cache
+ * may temporarily exceed its bound.
+ */
+static int
+xpath_cache_evict(void)
+{
+    xpath_cache_entry *xe;
+    xpath_cache_entry *xnext;
+    int                i;
+    int                nr;
+
+    nr = _xpath_cache_nr;
+    xe = _xpath_cache_lru;
+    for (i=0; i<nr && _xpath_cache_nr > XPATH_CACHE_SIZE; i++){
+        xnext = NEXTQ(xpath_cache_entry *, xe);
+        if (xe->xe_refcnt == 0){
+            DELQ(xe, _xpath_cache_lru, xpath_cache_entry *);
+            clicon_hash_del(_xpath_cache, xe->xe_xpath);
+            xpath_cache_entry_free(xe);
+            _xpath_cache_nr--;
+        }
+        xe = xnext;
+    }
+    return 0;
+}
+
+/*! Get parsed XPath tree from cache, or parse it and add it to the cache
+ *
+ * @param[in]  xpath  String with XPath 1.0 syntax
+ * @param[out] xep    Pinned cache entry, release with xpath_cache_release
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xpath_cache_get(const char         *xpath,
+                xpath_cache_entry **xep)
+{
+    int                retval = -1;
+    xpath_cache_entry *xe = NULL;
+    xpath_cache_entry **xp;
+
+    if (_xpath_cache == NULL &&
+        (_xpath_cache = clicon_hash_init()) == NULL)
+        goto done;
+    if ((xp = clicon_hash_value(_xpath_cache, xpath, NULL)) != NULL){
+        xe = *xp;
+        _xpath_cache_hits++;
+        /* Move to end of LRU queue (most recently used) */
+        DELQ(xe, _xpath_cache_lru, xpath_cache_entry *);
+        ADDQ(xe, _xpath_cache_lru);
+    }
+    else {
+        _xpath_cache_misses++;
+        if ((xe = malloc(sizeof(*xe))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(xe, 0, sizeof(*xe));
+        if ((xe->xe_xpath = strdup(xpath)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            xpath_cache_entry_free(xe);
+            goto done;
+        }
+        if (xpath_parse(xpath, &xe->xe_tree) < 0){
+            xpath_cache_entry_free(xe);
+            goto done;
+        }
+        if (clicon_hash_add(_xpath_cache, xpath, &xe, sizeof(xe)) == NULL){
+            xpath_cache_entry_free(xe);
+            goto done;
+        }
+        ADDQ(xe, _xpath_cache_lru);
+        _xpath_cache_nr++;
+    }
+    xe->xe_refcnt++;
+    if (_xpath_cache_nr > XPATH_CACHE_SIZE &&
+        xpath_cache_evict() < 0)
+        goto done;
+    *xep = xe;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Release a cache entry pinned by xpath_cache_get
+ */
+static int
+xpath_cache_release(xpath_cache_entry *xe)
+{
+    if (xe->xe_refcnt > 0)
+        xe->xe_refcnt--;
+    if (_xpath_cache_nr > XPATH_CACHE_SIZE)
+        xpath_cache_evict();
+    return 0;
+}
+
+#ifdef XPATH_COMPILE
+/*! Evaluate XPath using the compiled program of a cache entry, compile if necessary
+ *
+ * The program is recompiled if the namespace context or localonly differs from the previous
+ * evaluation.
+ * @param[in]  xe        Pinned cache entry
+ * @param[in]  xcur      XML-tree where to search
+ * @param[in]  nsc       External XML namespace context, or NULL
+ * @param[in]  localonly Skip prefix and namespace tests
+ * @param[in]  limit     Stop when result has this many nodes, 0 means no limit
+ * @param[out] xrp       Return XPath context
+ * @retval     1         OK, evaluated
+ * @retval     0         Not compilable or busy, use xp_eval
+ * @retval    -1         Error
+ */
+static int
+xpath_cache_prog_eval(xpath_cache_entry *xe,
+                      cxobj             *xcur,
+                      cvec              *nsc,
+                      int                localonly,
+                      int                limit,
+                      xp_ctx           **xrp)
+{
+    int ret;
+
+    if (xe->xe_noprog)
+        return 0;
+    if (xe->xe_prog && !xpath_prog_match(xe->xe_prog, nsc, localonly)){
+        if (xe->xe_refcnt > 1) /* Program may be in use by an outer evaluation */
+            return 0;
+        xpath_prog_free(xe->xe_prog);
+        xe->xe_prog = NULL;
+    }
+    if (xe->xe_prog == NULL){
+        if ((ret = xpath_compile(xe->xe_tree, nsc, localonly, &xe->xe_prog)) < 0)
+            return -1;
+        if (ret == 0){
+            xe->xe_noprog = 1;
+            return 0;
+        }
+    }
+    return xpath_prog_eval(xe->xe_prog, xcur, limit, xrp);
+}
+#endif /* XPATH_COMPILE */
+#endif /* XPATH_CACHE_SIZE */
+
+/*! Get XPath parse cache statistics
+ *
+ * @param[out] hits    Nr of lookups found in cache
+ * @param[out] misses  Nr of lookups that needed parsing
+ * @param[out] nr      Nr of entries in cache
+ * @retval     0       OK
+ * @see XPATH_CACHE_SIZE
+ */
+int
+xpath_cache_stats(uint64_t *hits,
+                  uint64_t *misses,
+                  uint64_t *nr)
+{
+#ifdef XPATH_CACHE_SIZE
+    if (hits)
+        *hits = _xpath_cache_hits;
+    if (misses)
+        *misses = _xpath_cache_misses;
+    if (nr)
+        *nr = _xpath_cache_nr;
+#endif
+    return 0;
+}
+
+/*! Free all entries of the XPath parse cache
+ *
+ * Call on exit, no XPath evaluation may be in progress
+ */
+void
+xpath_cache_exit(void)
+{
+#ifdef XPATH_CACHE_SIZE
+    xpath_cache_entry *xe;
+
+    while ((xe = _xpath_cache_lru) != NULL){
+        DELQ(xe, _xpath_cache_lru, xpath_cache_entry *);
+        xpath_cache_entry_free(xe);
+    }
+    if (_xpath_cache){
+        clicon_hash_free(_xpath_cache);
+        _xpath_cache = NULL;
+    }
+    _xpath_cache_nr = 0;
+#endif
+}
+
+/*! Given XML tree and XPath, parse XPath, eval it and return XPath context, with limit
  *
- * This is a raw form of XPath where you can do type conversion of the return
- * value, etc, not just a nodeset.
  * @param[in]  xcur   XML-tree where to search
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPath 1.0 syntax
  * @param[in]  localonly Skip prefix and namespace tests
+ * @param[in]  limit  Stop when result has this many nodes, 0 means no limit
  * @param[out] xrp    Return XPath context
  * @retval     0      OK
  * @retval    -1      Error
- * @code
- *   xp_ctx     *xc = NULL;
- *   if (xpath_vec_ctx(x, NULL, xpath, 0, &xc) < 0)
- *     err;
- *   if (xc)
- *      ctx_free(xc);
- * @endcode
+ * @see xpath_vec_ctx
+ * @see xp_eval_limit
  */
-int
-xpath_vec_ctx(cxobj      *xcur,
-              cvec       *nsc,
-              const char *xpath,
-              int         localonly,
-              xp_ctx    **xrp)
+static int
+xpath_vec_ctx1(cxobj      *xcur,
+               cvec       *nsc,
+               const char *xpath,
+               int         localonly,
+               int         limit,
+               xp_ctx    **xrp)
 {
-    int         retval = -1;
-    xpath_tree *xptree = NULL;
-    xp_ctx      xc = {0,};
+    int                retval = -1;
+    xpath_tree        *xptree = NULL;
+    xp_ctx             xc = {0,};
+#ifdef XPATH_CACHE_SIZE
+    xpath_cache_entry *xe = NULL;
+#ifdef XPATH_COMPILE
+    int                ret;
+#endif
+#endif
 
     clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s", xpath);
+    ctx_arena_enter(); /* Pool intermediate contexts until evaluation is done */
+#ifdef XPATH_CACHE_SIZE
+    if (xpath == NULL){
+        clixon_err(OE_XML, EINVAL, "XPath is NULL");
+        goto done;
+    }
+    if (xpath_cache_get(xpath, &xe) < 0)
+        goto done;
+    xptree = xe->xe_tree;
+#ifdef XPATH_COMPILE
+    if ((ret = xpath_cache_prog_eval(xe, xcur, nsc, localonly, limit, xrp)) < 0)
+        goto done;
+    if (ret == 1)
+        goto ok;
+#endif
+#else
     if (xpath_parse(xpath, &xptree) < 0)
         goto done;
+#endif
     xc.xc_type = XT_NODESET;
     xc.xc_node = xcur;
     xc.xc_initial = xcur;
     if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
         goto done;
-    if (xp_eval(&xc, xptree, nsc, localonly, xrp) < 0)
+    if (xp_eval_limit(&xc, xptree, nsc, localonly, limit, xrp) < 0)
         goto done;
+#ifdef XPATH_COMPILE
+ ok:
+#endif
     retval = 0;
  done:
     if (xc.xc_nodeset){
         free(xc.xc_nodeset);
         xc.xc_nodeset = NULL;
     }
+#ifdef XPATH_CACHE_SIZE
+    if (xe)
+        xpath_cache_release(xe);
+#else
     if (xptree)
         xpath_tree_free(xptree);
+#endif
+    ctx_arena_exit();
     return retval;
 }
 
+/*! Given XML tree and XPath, parse XPath, eval it and return XPath context,
+ *
+ * This is a raw form of XPath where you can do type conversion of the return
+ * value, etc, not just a nodeset.
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPath 1.0 syntax
+ * @param[in]  localonly Skip prefix and namespace tests
+ * @param[out] xrp    Return XPath context
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @code
+ *   xp_ctx     *xc = NULL;
+ *   if (xpath_vec_ctx(x, NULL, xpath, 0, &xc) < 0)
+ *     err;
+ *   if (xc)
+ *      ctx_free(xc);
+ * @endcode
+ */
+int
+xpath_vec_ctx(cxobj      *xcur,
+              cvec       *nsc,
+              const char *xpath,
+              int         localonly,
+              xp_ctx    **xrp)
+{
+    return xpath_vec_ctx1(xcur, nsc, xpath, localonly, 0, xrp);
+}
+
 /*! XPath nodeset function where only the first matching entry is returned
  *
  * @param[in]  xcur      XML tree where to search
@@ -704,7 +998,7 @@ xpath_first(cxobj      *xcur,
         goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
+    if (xpath_vec_ctx1(xcur, nsc, xpath, 0, 1, &xr) < 0)
         goto done;
     if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
         cx = xr->xc_nodeset[0];
@@ -763,7 +1057,7 @@ xpath_first_localonly(cxobj      *xcur,
         goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, NULL, xpath, 1, &xr) < 0)
+    if (xpath_vec_ctx1(xcur, NULL, xpath, 1, 1, &xr) < 0)
         goto done;
     if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
         cx = xr->xc_nodeset[0];
@@ -964,7 +1258,7 @@ xpath_vec_bool(cxobj      *xcur,
         goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
+    if (xpath_vec_ctx1(xcur, nsc, xpath, 0, 1, &xr) < 0)
         goto done;
     if (xr)
         retval = ctx2boolean(xr);
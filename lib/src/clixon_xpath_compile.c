@@ -0,0 +1,790 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2020-2025 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Clixon XML XPath 1.0 according to https://www.w3.org/TR/xpath-10
+ * Compilation of XPath parse trees to flat programs. See XPATH_COMPILE
+ *
+ * The regular evaluator xp_eval() interprets the XPath parse tree recursively. For each step
+ * it allocates new contexts and for every node it resolves the XPath prefix via the namespace
+ * context. Most XPaths used internally and in filters are however simple location paths, eg:
+ *    /a:x/a:y[a:k='foo']/a:z
+ *    groups/group[user-name='admin']
+ *    //interface[name='eth0' and type='x']
+ * Such XPaths are compiled here to a flat vector of steps where:
+ * - prefixes are pre-resolved to namespace URIs using the namespace context
+ * - predicates are equality tests of a child or self against a literal
+ * - nodesets are kept in two buffers in the program that are reused between evaluations
+ * Anything else, such as functions, other axes and non-equality predicates, is not compiled
+ * and is evaluated by xp_eval() as before.
+ * Evaluation of a compiled program should give exactly the same result as xp_eval(), including
+ * its peculiarities.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <syslog.h>
+#include <fcntl.h>
+#include <math.h> /* NaN */
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_map.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_string.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_xpath_optimize.h"
+#include "clixon_xpath_eval.h"
+#include "clixon_xpath_compile.h"
+
+#ifdef XPATH_COMPILE
+
+/* Nodetest modes, see nodetest_eval() */
+enum xpc_mode{
+    XPC_NAMESPACE, /* Full namespace test */
+    XPC_PREFIX,    /* No namespace context: compare prefixes */
+    XPC_LOCAL,     /* localonly: compare names only */
+};
+
+/*! Compiled nodetest
+ *
+ * Strings are borrowed from the XPath tree
+ */
+struct xpc_test{
+    char   *pt_prefix;  /* XPath prefix or NULL */
+    char   *pt_name;    /* Local name or "*" */
+    char   *pt_ns;      /* Namespace of prefix resolved at compile-time, or NULL */
+};
+
+/*! Compiled equality predicate: [name='literal'], [name=nr] or [.='literal']
+ */
+struct xpc_pred{
+    int             pp_self;    /* Compare body of context node, ie "." */
+    struct xpc_test pp_test;    /* Nodetest of child (if not self) */
+    int             pp_isnr;    /* Literal is a number */
+    double          pp_nr;      /* Number literal */
+    char           *pp_str;     /* String literal, borrowed from XPath tree */
+};
+
+/*! Compiled location step
+ */
+struct xpc_step{
+    enum axis_type   ps_axis;       /* A_CHILD, A_PARENT or A_SELF */
+    int              ps_descendant; /* Search all descendants, ie // */
+    struct xpc_test  ps_test;       /* Nodetest (A_CHILD only) */
+    xpath_tree      *ps_xs;         /* Original step, used in xpath_optimize_check */
+    struct xpc_pred *ps_preds;      /* Vector of predicates, all must be true */
+    int              ps_npreds;
+};
+
+/*! Compiled XPath program
+ */
+struct xpath_prog{
+    int              pr_abs;        /* Absolute path */
+    enum xpc_mode    pr_mode;       /* Nodetest mode */
+    int              pr_localonly;  /* Compiled with localonly */
+    cvec            *pr_nsc;        /* Copy of namespace context compiled against */
+    struct xpc_step *pr_steps;      /* Vector of steps */
+    int              pr_nsteps;
+    cxobj          **pr_vec[2];     /* Nodeset buffers, reused between steps and evaluations */
+    int              pr_len[2];     /* Nr of nodes in buffer */
+    int              pr_max[2];     /* Allocated size of buffer */
+    int              pr_busy;       /* Evaluation in progress, guard against re-entrance */
+};
+
+/*! Skip single-child XPath tree nodes that pass their child result through unchanged
+ */
+static xpath_tree *
+xpc_unwrap(xpath_tree *xs)
+{
+    while (xs != NULL && xs->xs_c1 == NULL){
+        switch (xs->xs_type){
+        case XP_EXP:
+        case XP_AND:
+        case XP_RELEX:
+        case XP_ADD:
+        case XP_UNION:
+        case XP_PATHEXPR:
+        case XP_FILTEREXPR:
+        case XP_PRI0:
+            xs = xs->xs_c0;
+            break;
+        default:
+            return xs;
+        }
+    }
+    return xs;
+}
+
+/*! Compile nodetest, resolve prefix using namespace context
+ *
+ * @retval  1  OK
+ * @retval  0  Not compilable
+ */
+static int
+xpc_test_compile(xpath_prog      *pr,
+                 xpath_tree      *xs,
+                 struct xpc_test *pt)
+{
+    if (xs == NULL || xs->xs_type != XP_NODE || xs->xs_s1 == NULL)
+        return 0;
+    pt->pt_prefix = xs->xs_s0;
+    pt->pt_name = xs->xs_s1;
+    if (pr->pr_mode == XPC_NAMESPACE)
+        pt->pt_ns = xml_nsctx_get(pr->pr_nsc, pt->pt_prefix);
+    return 1;
+}
+
+/*! Check that predicate tree is empty, ie no [..]
+ */
+static int
+xpc_pred_empty(xpath_tree *xs)
+{
+    return xs == NULL || (xs->xs_type == XP_PRED && xs->xs_c0 == NULL && xs->xs_c1 == NULL);
+}
+
+/*! Compile predicate expression consisting of equalities, possibly combined with "and"
+ *
+ * @retval  1  OK
+ * @retval  0  Not compilable
+ * @retval -1  Error
+ */
+static int
+xpc_pred_expr(xpath_prog      *pr,
+              struct xpc_step *ps,
+              xpath_tree      *xs)
+{
+    int              ret;
+    xpath_tree      *xl;
+    xpath_tree      *xr;
+    xpath_tree      *xstep;
+    struct xpc_pred *pp;
+
+    if ((xs = xpc_unwrap(xs)) == NULL)
+        return 0;
+    if (xs->xs_type == XP_AND && xs->xs_int == XO_AND){
+        if ((ret = xpc_pred_expr(pr, ps, xs->xs_c0)) != 1)
+            return ret;
+        return xpc_pred_expr(pr, ps, xs->xs_c1);
+    }
+    if (xs->xs_type != XP_RELEX || xs->xs_int != XO_EQ)
+        return 0;
+    /* Left: child or self step without predicates */
+    if ((xl = xpc_unwrap(xs->xs_c0)) == NULL ||
+        xl->xs_type != XP_LOCPATH ||
+        (xl = xl->xs_c0) == NULL ||
+        xl->xs_type != XP_RELLOCPATH ||
+        xl->xs_c1 != NULL ||
+        (xstep = xl->xs_c0) == NULL ||
+        xstep->xs_type != XP_STEP ||
+        !xpc_pred_empty(xstep->xs_c1))
+        return 0;
+    if (xstep->xs_int != A_CHILD && xstep->xs_int != A_SELF)
+        return 0;
+    /* Right: literal */
+    if ((xr = xpc_unwrap(xs->xs_c1)) == NULL ||
+        (xr->xs_type != XP_PRIME_STR && xr->xs_type != XP_PRIME_NR))
+        return 0;
+    if ((ps->ps_preds = realloc(ps->ps_preds, (ps->ps_npreds+1)*sizeof(*pp))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    pp = &ps->ps_preds[ps->ps_npreds++];
+    memset(pp, 0, sizeof(*pp));
+    if (xstep->xs_int == A_SELF)
+        pp->pp_self = 1;
+    else if (xpc_test_compile(pr, xstep->xs_c0, &pp->pp_test) == 0)
+        return 0;
+    if (xr->xs_type == XP_PRIME_NR){
+        pp->pp_isnr = 1;
+        pp->pp_nr = xr->xs_double;
+    }
+    else
+        pp->pp_str = xr->xs_s0?xr->xs_s0:"";
+    return 1;
+}
+
+/*! Compile predicates, evaluated left to right
+ *
+ * @retval  1  OK
+ * @retval  0  Not compilable
+ * @retval -1  Error
+ */
+static int
+xpc_preds(xpath_prog      *pr,
+          struct xpc_step *ps,
+          xpath_tree      *xs)
+{
+    int ret;
+
+    if (xs == NULL)
+        return 1;
+    if (xs->xs_type != XP_PRED)
+        return 0;
+    if (xs->xs_c0 && (ret = xpc_preds(pr, ps, xs->xs_c0)) != 1)
+        return ret;
+    if (xs->xs_c1)
+        return xpc_pred_expr(pr, ps, xs->xs_c1);
+    return 1;
+}
+
+/*! Compile a location step and append it to program
+ *
+ * @retval  1  OK
+ * @retval  0  Not compilable
+ * @retval -1  Error
+ */
+static int
+xpc_step_compile(xpath_prog *pr,
+                 xpath_tree *xs,
+                 int         descendant)
+{
+    struct xpc_step *ps;
+
+    if (xs == NULL || xs->xs_type != XP_STEP)
+        return 0;
+    switch (xs->xs_int){
+    case A_CHILD:
+        break;
+    case A_PARENT:
+    case A_SELF:
+        /* Descendant context is propagated through these axes in xp_eval_step */
+        if (descendant)
+            return 0;
+        break;
+    default:
+        return 0;
+    }
+    if ((pr->pr_steps = realloc(pr->pr_steps, (pr->pr_nsteps+1)*sizeof(*ps))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    ps = &pr->pr_steps[pr->pr_nsteps++];
+    memset(ps, 0, sizeof(*ps));
+    ps->ps_axis = xs->xs_int;
+    ps->ps_descendant = descendant;
+    ps->ps_xs = xs;
+    if (ps->ps_axis == A_CHILD &&
+        xpc_test_compile(pr, xs->xs_c0, &ps->ps_test) == 0)
+        return 0;
+    return xpc_preds(pr, ps, xs->xs_c1);
+}
+
+/*! Compile a relative location path into steps
+ *
+ * Note that xp_eval sets the descendant flag of the incoming context if any "//" is present
+ * in a relative location path, which makes the first step a descendant search.
+ * @param[out] anydesc  Set if "//" is present
+ * @retval     1        OK
+ * @retval     0        Not compilable
+ * @retval    -1        Error
+ */
+static int
+xpc_rellocpath(xpath_prog *pr,
+               xpath_tree *xs,
+               int         first,
+               int        *anydesc)
+{
+    int ret;
+    int descendant;
+
+    if (xs == NULL || xs->xs_type != XP_RELLOCPATH)
+        return 0;
+    if (xs->xs_c1 == NULL) /* rellocpath -> step */
+        return xpc_step_compile(pr, xs->xs_c0, first);
+    descendant = (xs->xs_int == A_DESCENDANT_OR_SELF);
+    if (descendant){
+        *anydesc = 1;
+        first = 1;
+    }
+    if ((ret = xpc_rellocpath(pr, xs->xs_c0, first, anydesc)) != 1)
+        return ret;
+    return xpc_step_compile(pr, xs->xs_c1, descendant);
+}
+
+/*! Free compiled XPath program
+ */
+int
+xpath_prog_free(xpath_prog *pr)
+{
+    int i;
+
+    for (i=0; i<pr->pr_nsteps; i++)
+        if (pr->pr_steps[i].ps_preds)
+            free(pr->pr_steps[i].ps_preds);
+    if (pr->pr_steps)
+        free(pr->pr_steps);
+    if (pr->pr_nsc)
+        cvec_free(pr->pr_nsc);
+    for (i=0; i<2; i++)
+        if (pr->pr_vec[i])
+            free(pr->pr_vec[i]);
+    free(pr);
+    return 0;
+}
+
+/*! Compile XPath tree and namespace context into a flat program
+ *
+ * @param[in]  xs        XPath tree, must not be freed before program
+ * @param[in]  nsc       XML Namespace context, or NULL
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] prp       Compiled program, free with xpath_prog_free
+ * @retval     1         OK, program compiled
+ * @retval     0         XPath is not compilable, use xp_eval
+ * @retval    -1         Error
+ */
+int
+xpath_compile(xpath_tree  *xs,
+              cvec        *nsc,
+              int          localonly,
+              xpath_prog **prp)
+{
+    int         retval = -1;
+    xpath_prog *pr = NULL;
+    xpath_tree *xl;
+    int         first = 0;
+    int         anydesc = 0;
+    int         ret;
+
+    if ((pr = malloc(sizeof(*pr))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(pr, 0, sizeof(*pr));
+    pr->pr_localonly = localonly;
+    if (localonly)
+        pr->pr_mode = XPC_LOCAL;
+    else if (nsc == NULL)
+        pr->pr_mode = XPC_PREFIX;
+    else {
+        pr->pr_mode = XPC_NAMESPACE;
+        if ((pr->pr_nsc = cvec_dup(nsc)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_dup");
+            goto done;
+        }
+    }
+    if ((xl = xpc_unwrap(xs)) == NULL ||
+        xl->xs_type != XP_LOCPATH ||
+        (xl = xl->xs_c0) == NULL)
+        goto fail;
+    if (xl->xs_type == XP_ABSPATH){
+        pr->pr_abs = 1;
+        if (xl->xs_int == A_DESCENDANT_OR_SELF)
+            first = 1;
+        if ((xl = xl->xs_c0) == NULL) /* Single "/" */
+            goto fail;
+    }
+    if ((ret = xpc_rellocpath(pr, xl, first, &anydesc)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    /* First step is descendant if "//" anywhere in the path */
+    if (anydesc){
+        if (pr->pr_steps[0].ps_axis != A_CHILD)
+            goto fail;
+        pr->pr_steps[0].ps_descendant = 1;
+    }
+    *prp = pr;
+    pr = NULL;
+    retval = 1;
+ done:
+    if (pr)
+        xpath_prog_free(pr);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Check if compiled program was compiled for this namespace context and mode
+ *
+ * @param[in]  pr        Compiled XPath program
+ * @param[in]  nsc       XML Namespace context, or NULL
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @retval     1         Program matches
+ * @retval     0         No match, needs recompile
+ */
+int
+xpath_prog_match(xpath_prog *pr,
+                 cvec       *nsc,
+                 int         localonly)
+{
+    cg_var *cv0 = NULL;
+    cg_var *cv1 = NULL;
+
+    if (pr->pr_localonly != localonly)
+        return 0;
+    if (localonly)
+        return 1;
+    if (nsc == NULL || pr->pr_nsc == NULL)
+        return nsc == pr->pr_nsc;
+    if (cvec_len(nsc) != cvec_len(pr->pr_nsc))
+        return 0;
+    while ((cv0 = cvec_each(nsc, cv0)) != NULL &&
+           (cv1 = cvec_each(pr->pr_nsc, cv1)) != NULL){
+        if (clicon_strcmp(cv_name_get(cv0), cv_name_get(cv1)) != 0 ||
+            clicon_strcmp(cv_string_get(cv0), cv_string_get(cv1)) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+/*! Append node to program nodeset buffer, grow geometrically
+ */
+static int
+xpc_append(xpath_prog *pr,
+           int         i,
+           cxobj      *x)
+{
+    int max;
+
+    if (pr->pr_len[i] >= pr->pr_max[i]){
+        max = pr->pr_max[i] ? 2*pr->pr_max[i] : 16;
+        if ((pr->pr_vec[i] = realloc(pr->pr_vec[i], max*sizeof(cxobj *))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        pr->pr_max[i] = max;
+    }
+    pr->pr_vec[i][pr->pr_len[i]++] = x;
+    return 0;
+}
+
+/*! Eval compiled nodetest, same semantics as nodetest_eval for XP_NODE
+ *
+ * @retval    1     Match
+ * @retval    0     No match
+ */
+static int
+xpc_test_eval(xpath_prog      *pr,
+              struct xpc_test *pt,
+              cxobj           *x)
+{
+    char *ns1 = NULL;
+
+    if (strcmp(pt->pt_name, "*") != 0 &&
+        strcmp(xml_name(x), pt->pt_name) != 0)
+        return 0;
+    switch (pr->pr_mode){
+    case XPC_LOCAL:
+        break;
+    case XPC_PREFIX:
+        if (clicon_strcmp(xml_prefix(x), pt->pt_prefix) != 0)
+            return 0;
+        break;
+    case XPC_NAMESPACE:
+        if (xml2ns(x, xml_prefix(x), &ns1) < 0)
+            return 0;
+        if (ns1 == NULL)
+            return 0;
+        if (pt->pt_ns == NULL){
+#ifndef XPATH_NS_ACCEPT_UNRESOLVED
+            return 0;
+#endif
+        }
+        else if (strcmp(ns1, pt->pt_ns) != 0)
+            return 0;
+        break;
+    }
+    return 1;
+}
+
+/*! Eval body of node against predicate literal, same semantics as xp_relop XO_EQ
+ */
+static int
+xpc_body_eq(struct xpc_pred *pp,
+            cxobj           *x)
+{
+    char  *body;
+    double n;
+
+    body = xml_body(x);
+    if (pp->pp_isnr){
+        if (body == NULL || sscanf(body, "%lf", &n) != 1)
+            n = NAN;
+        return n == pp->pp_nr;
+    }
+    return strcmp(body?body:"", pp->pp_str) == 0;
+}
+
+/*! Eval all predicates of a step on a node
+ *
+ * @retval    1     All predicates true
+ * @retval    0     Some predicate false
+ */
+static int
+xpc_preds_eval(xpath_prog      *pr,
+               struct xpc_step *ps,
+               cxobj           *x)
+{
+    struct xpc_pred *pp;
+    cxobj           *xc;
+    int              i;
+
+    for (i=0; i<ps->ps_npreds; i++){
+        pp = &ps->ps_preds[i];
+        if (pp->pp_self){
+            if (!xpc_body_eq(pp, x))
+                return 0;
+            continue;
+        }
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+            if (xpc_test_eval(pr, &pp->pp_test, xc) == 1 &&
+                xpc_body_eq(pp, xc))
+                break;
+        }
+        if (xc == NULL)
+            return 0;
+    }
+    return 1;
+}
+
+/*! Append all descendants matching nodetest, see nodetest_recursive
+ *
+ * Stop when buffer i has limit nodes, if limit is not 0
+ */
+static int
+xpc_descendants(xpath_prog      *pr,
+                struct xpc_test *pt,
+                cxobj           *xn,
+                xp_prune        *xpr,
+                yang_stmt       *yspec,
+                int              limit,
+                int              i)
+{
+    cxobj     *x = NULL;
+    yang_stmt *ysub = NULL;
+#ifdef XPATH_DESCENDANT_PRUNE
+    int        ret;
+#endif
+
+    while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
+        if (limit && pr->pr_len[i] >= limit)
+            break;
+        if (xpc_test_eval(pr, pt, x) == 1 &&
+            xpc_append(pr, i, x) < 0)
+            return -1;
+#ifdef XPATH_DESCENDANT_PRUNE
+        if ((ret = xp_prune_check(xpr, x, yspec, &ysub)) < 0)
+            return -1;
+        if (ret == 1)
+            continue;
+#endif
+        if (xpc_descendants(pr, pt, x, xpr, ysub, limit, i) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Eval one step from buffer i0 to buffer i1
+ *
+ * Stop when buffer i1 has limit nodes, if limit is not 0. Compiled predicates do not
+ * depend on position, so also a filtered step can stop early
+ */
+static int
+xpc_step_eval(xpath_prog      *pr,
+              struct xpc_step *ps,
+              int              limit,
+              int              i0,
+              int              i1)
+{
+    int      retval = -1;
+    int      i;
+    int      j;
+    cxobj   *xv;
+    cxobj   *x;
+    cxobj  **vec = NULL;
+    int      veclen = 0;
+    int      ret;
+    xp_prune xpr = {0,};
+    int      steplimit;
+
+#ifdef XPATH_DESCENDANT_PRUNE
+    if (ps->ps_descendant)
+        xp_prune_init(&xpr, ps->ps_xs->xs_c0);
+#endif
+    steplimit = ps->ps_npreds ? 0 : limit;
+    pr->pr_len[i1] = 0;
+    for (i=0; i<pr->pr_len[i0]; i++){
+        if (steplimit && pr->pr_len[i1] >= steplimit)
+            break;
+        xv = pr->pr_vec[i0][i];
+        switch (ps->ps_axis){
+        case A_CHILD:
+            if (ps->ps_descendant){
+                if (xpc_descendants(pr, &ps->ps_test, xv, &xpr, NULL, steplimit, i1) < 0)
+                    goto done;
+                break;
+            }
+            /* Same binary search optimization as xp_eval_step */
+            if ((ret = xpath_optimize_check(ps->ps_xs, xv, &vec, &veclen)) < 0)
+                goto done;
+            if (ret == 1){
+                for (j=0; j<veclen; j++)
+                    if (xpc_append(pr, i1, vec[j]) < 0)
+                        goto done;
+                if (vec){
+                    free(vec);
+                    vec = NULL;
+                }
+                veclen = 0;
+                break;
+            }
+            x = NULL;
+            while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
+                if (steplimit && pr->pr_len[i1] >= steplimit)
+                    break;
+                if (xpc_test_eval(pr, &ps->ps_test, x) == 1 &&
+                    xpc_append(pr, i1, x) < 0)
+                    goto done;
+            }
+            break;
+        case A_PARENT:
+            if ((x = xml_parent(xv)) != NULL
+#ifdef XML_PARENT_CANDIDATE
+                || (x = xml_parent_candidate(xv)) != NULL
+#endif
+                )
+                if (xpc_append(pr, i1, x) < 0)
+                    goto done;
+            break;
+        case A_SELF:
+        default:
+            if (xpc_append(pr, i1, xv) < 0)
+                goto done;
+            break;
+        }
+    }
+    /* Filter on predicates in place */
+    if (ps->ps_npreds){
+        j = 0;
+        for (i=0; i<pr->pr_len[i1]; i++){
+            if (limit && j >= limit)
+                break;
+            x = pr->pr_vec[i1][i];
+            if (xpc_preds_eval(pr, ps, x))
+                pr->pr_vec[i1][j++] = x;
+        }
+        pr->pr_len[i1] = j;
+    }
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+}
+
+/*! Evaluate compiled XPath program on an XML tree
+ *
+ * @param[in]  pr    Compiled XPath program
+ * @param[in]  xcur  XML-tree where to search
+ * @param[in]  limit Stop when last step has this many nodes, 0 means no limit
+ * @param[out] xrp   Resulting nodeset context, free with ctx_free
+ * @retval     1     OK, result in xrp
+ * @retval     0     Program busy (re-entrant call), use xp_eval
+ * @retval    -1     Error
+ */
+int
+xpath_prog_eval(xpath_prog *pr,
+                cxobj      *xcur,
+                int         limit,
+                xp_ctx    **xrp)
+{
+    int     retval = -1;
+    xp_ctx *xr = NULL;
+    cxobj  *x;
+    int     i;
+    int     cur = 0;
+
+    if (pr->pr_busy)
+        return 0;
+    pr->pr_busy++;
+    x = xcur;
+    if (pr->pr_abs){
+#ifdef XML_PARENT_CANDIDATE
+        while (xml_parent(x) != NULL || xml_parent_candidate(x) != NULL)
+            x = xml_parent(x)?xml_parent(x):xml_parent_candidate(x);
+#else
+        while (xml_parent(x) != NULL)
+            x = xml_parent(x);
+#endif
+    }
+    pr->pr_len[cur] = 0;
+    if (xpc_append(pr, cur, x) < 0)
+        goto done;
+    for (i=0; i<pr->pr_nsteps; i++){
+        if (xpc_step_eval(pr, &pr->pr_steps[i],
+                          (i == pr->pr_nsteps-1) ? limit : 0, cur, !cur) < 0)
+            goto done;
+        cur = !cur;
+    }
+    if ((xr = ctx_new()) == NULL)
+        goto done;
+    xr->xc_type = XT_NODESET;
+    xr->xc_node = x;
+    xr->xc_initial = xcur;
+    for (i=0; i<pr->pr_len[cur]; i++)
+        if (ctx_nodeset_append(xr, pr->pr_vec[cur][i]) < 0)
+            goto done;
+    *xrp = xr;
+    xr = NULL;
+    retval = 1;
+ done:
+    pr->pr_len[0] = pr->pr_len[1] = 0;
+    pr->pr_busy--;
+    if (xr)
+        ctx_free(xr);
+    return retval;
+}
+
+#endif /* XPATH_COMPILE */
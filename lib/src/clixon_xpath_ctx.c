@@ -36,6 +36,10 @@
  * Clixon XML XPath 1.0 according to https://www.w3.org/TR/xpath-10
  * This file defines XPath contexts used in traversing the XPath parse tree.
  */
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -43,6 +47,7 @@
 #include <string.h>
 #include <limits.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <syslog.h>
 #include <fcntl.h>
 #include <math.h>  /* NaN */
@@ -75,44 +80,258 @@ const map_str2int ctxmap[] = {
     {NULL,        -1}
 };
 
-/*! Free xpath context */
+/*! Pool of XPath contexts of an ongoing evaluation
+ *
+ * Contexts freed during an evaluation are kept, with their nodeset buffers, and reused by
+ * ctx_new. The pool is released when the outermost evaluation returns.
+ * @see ctx_arena_enter
+ */
+struct xp_arena {
+    int       xa_depth; /* Nesting of ctx_arena_enter */
+    xp_ctx  **xa_pool;  /* Free contexts */
+    int       xa_len;   /* Nr of free contexts */
+    int       xa_max;   /* Allocated length of xa_pool */
+};
+
+static struct xp_arena _xp_arena = {0,};
+
+/* Allocation counters of the last (or ongoing) XPath evaluation, see ctx_arena_stats */
+static uint64_t _ctx_allocs = 0;
+static uint64_t _ctx_reuses = 0;
+static uint64_t _ctx_vec_allocs = 0;
+
+/*! Create new empty xpath context
+ *
+ * @retval  xc    XPath context, free with ctx_free
+ * @retval  NULL  Error
+ */
+xp_ctx *
+ctx_new(void)
+{
+    xp_ctx  *xc;
+#ifdef XPATH_ARENA
+    cxobj  **vec;
+    int      max;
+
+    if (_xp_arena.xa_len){
+        xc = _xp_arena.xa_pool[--_xp_arena.xa_len];
+        /* Keep nodeset buffer for reuse */
+        vec = xc->xc_nodeset;
+        max = xc->xc_max;
+        memset(xc, 0, sizeof(*xc));
+        xc->xc_nodeset = vec;
+        xc->xc_max = max;
+        _ctx_reuses++;
+        return xc;
+    }
+#endif
+    if ((xc = malloc(sizeof(*xc))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(xc, 0, sizeof(*xc));
+    _ctx_allocs++;
+    return xc;
+}
+
+/*! Free xpath context
+ *
+ * If an evaluation is ongoing, the context is put in the arena pool for reuse
+ */
 int
 ctx_free(xp_ctx *xc)
 {
+    if (xc->xc_string){
+        free(xc->xc_string);
+        xc->xc_string = NULL;
+    }
+#ifdef XPATH_ARENA
+    if (_xp_arena.xa_depth){
+        if (_xp_arena.xa_len >= _xp_arena.xa_max){
+            int      max = _xp_arena.xa_max ? 2*_xp_arena.xa_max : 16;
+            xp_ctx **pool;
+
+            if ((pool = realloc(_xp_arena.xa_pool, max*sizeof(*pool))) == NULL)
+                goto nopool;
+            _xp_arena.xa_pool = pool;
+            _xp_arena.xa_max = max;
+        }
+        _xp_arena.xa_pool[_xp_arena.xa_len++] = xc;
+        return 0;
+    }
+ nopool:
+#endif
     if (xc->xc_nodeset)
         free(xc->xc_nodeset);
-    if (xc->xc_string)
-        free(xc->xc_string);
     free(xc);
     return 0;
 }
 
+/*! Ensure room for n nodes in an XML vector
+ *
+ * Grows geometrically, instead of by one node as cxvec_append
+ * @param[in,out] vec  XML vector
+ * @param[in]     len  Nr of used entries
+ * @param[in,out] max  Allocated entries, may be lower than actual (eg 0)
+ * @param[in]     n    Nr of entries needed
+ * @retval        0    OK
+ * @retval       -1    Error
+ */
+static int
+ctx_vec_reserve(cxobj ***vec,
+                int      len,
+                int     *max,
+                int      n)
+{
+    int     m;
+    cxobj **v;
+
+    if (*vec != NULL && n <= *max)
+        return 0;
+    m = *max > len ? *max : len;
+    if (m < 16)
+        m = 16;
+    while (m < n)
+        m *= 2;
+    if ((v = realloc(*vec, m*sizeof(cxobj *))) == NULL){
+        clixon_err(OE_XML, errno, "realloc");
+        return -1;
+    }
+    *vec = v;
+    *max = m;
+    _ctx_vec_allocs++;
+    return 0;
+}
+
+/*! Append a node to an XML vector, with geometric growth
+ *
+ * Same as cxvec_append but with allocated length
+ * @param[in]     x    XML node
+ * @param[in,out] vec  XML vector
+ * @param[in,out] len  Nr of used entries
+ * @param[in,out] max  Allocated entries, initialize to 0
+ * @retval        0    OK
+ * @retval       -1    Error
+ * @see cxvec_append
+ */
+int
+ctx_vec_append(cxobj   *x,
+               cxobj ***vec,
+               int     *len,
+               int     *max)
+{
+    if (*vec == NULL || *len >= *max)
+        if (ctx_vec_reserve(vec, *len, max, *len+1) < 0)
+            return -1;
+    (*vec)[(*len)++] = x;
+    return 0;
+}
+
+/*! Append a node to nodeset of XPath context
+ *
+ * @param[in]  xc   XPath context
+ * @param[in]  x    XML node
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+ctx_nodeset_append(xp_ctx *xc,
+                   cxobj  *x)
+{
+    return ctx_vec_append(x, &xc->xc_nodeset, &xc->xc_size, &xc->xc_max);
+}
+
 /*! Duplicate xpath context */
 xp_ctx *
 ctx_dup(xp_ctx *xc0)
 {
-    xp_ctx *xc = NULL;
+    xp_ctx  *xc = NULL;
+    cxobj  **vec;
+    int      max;
 
-    if ((xc = malloc(sizeof(*xc))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xc = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xc, 0, sizeof(*xc));
+    vec = xc->xc_nodeset;
+    max = xc->xc_max;
     *xc = *xc0;
+    xc->xc_nodeset = vec;
+    xc->xc_max = max;
+    xc->xc_size = 0;
+    xc->xc_string = NULL;
     if (xc0->xc_size){
-        if ((xc->xc_nodeset = calloc(xc0->xc_size, sizeof(cxobj*))) == NULL){
-            clixon_err(OE_UNIX, errno, "calloc");
-            goto done;
-        }
-        memcpy(xc->xc_nodeset, xc0->xc_nodeset, xc->xc_size*sizeof(cxobj*));
+        if (ctx_vec_reserve(&xc->xc_nodeset, 0, &xc->xc_max, xc0->xc_size) < 0)
+            goto err;
+        memcpy(xc->xc_nodeset, xc0->xc_nodeset, xc0->xc_size*sizeof(cxobj*));
+        xc->xc_size = xc0->xc_size;
     }
     if (xc0->xc_string)
         if ((xc->xc_string = strdup(xc0->xc_string)) == NULL){
             clixon_err(OE_UNIX, errno, "strdup");
-            goto done;
+            goto err;
         }
  done:
     return xc;
+ err:
+    ctx_free(xc);
+    return NULL;
+}
+
+/*! Start an XPath evaluation, contexts freed from now on are pooled
+ *
+ * Calls may be nested, eg when XPath functions evaluate other XPaths.
+ * @see ctx_arena_exit
+ */
+void
+ctx_arena_enter(void)
+{
+    if (_xp_arena.xa_depth++ == 0)
+        _ctx_allocs = _ctx_reuses = _ctx_vec_allocs = 0;
+}
+
+/*! End an XPath evaluation, the outermost call releases all pooled contexts at once
+ *
+ * @see ctx_arena_enter
+ */
+void
+ctx_arena_exit(void)
+{
+    xp_ctx *xc;
+    int     i;
+
+    if (_xp_arena.xa_depth == 0 || --_xp_arena.xa_depth > 0)
+        return;
+    for (i=0; i<_xp_arena.xa_len; i++){
+        xc = _xp_arena.xa_pool[i];
+        if (xc->xc_nodeset)
+            free(xc->xc_nodeset);
+        free(xc);
+    }
+    if (_xp_arena.xa_pool)
+        free(_xp_arena.xa_pool);
+    memset(&_xp_arena, 0, sizeof(_xp_arena));
+    clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "ctx allocs:%" PRIu64 " reuses:%" PRIu64 " nodeset allocs:%" PRIu64,
+                 _ctx_allocs, _ctx_reuses, _ctx_vec_allocs);
+}
+
+/*! Get allocation counters of the last XPath evaluation
+ *
+ * @param[out] allocs     Nr of XPath contexts allocated
+ * @param[out] reuses     Nr of XPath contexts reused from the arena pool
+ * @param[out] vecallocs  Nr of nodeset (re)allocations
+ * @retval     0          OK
+ */
+int
+ctx_arena_stats(uint64_t *allocs,
+                uint64_t *reuses,
+                uint64_t *vecallocs)
+{
+    if (allocs)
+        *allocs = _ctx_allocs;
+    if (reuses)
+        *reuses = _ctx_reuses;
+    if (vecallocs)
+        *vecallocs = _ctx_vec_allocs;
+    return 0;
 }
 
 /*! Print XPath context to CLIgen buf
@@ -332,5 +551,6 @@ ctx_nodeset_replace(xp_ctx   *xc,
         free(xc->xc_nodeset);
     xc->xc_nodeset = vec;
     xc->xc_size = veclen;
+    xc->xc_max = veclen;
     return 0;
 }
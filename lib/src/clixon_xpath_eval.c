@@ -304,19 +304,173 @@ nodetest_eval(cxobj      *x,
     return retval;
 }
 
+#ifdef XPATH_DESCENDANT_PRUNE
+/*! Initialize descendant pruning for a nodetest
+ *
+ * Pruning is only made for named nodetests, not for wildcards or node-type tests
+ * @param[out] xpr       Pruning state
+ * @param[in]  nodetest  XPath nodetest
+ */
+int
+xp_prune_init(xp_prune   *xpr,
+              xpath_tree *nodetest)
+{
+    memset(xpr, 0, sizeof(*xpr));
+    if (nodetest != NULL &&
+        nodetest->xs_type == XP_NODE &&
+        nodetest->xs_s1 != NULL &&
+        strcmp(nodetest->xs_s1, "*") != 0)
+        xpr->xpr_name = nodetest->xs_s1;
+    return 0;
+}
+
+/*! Check if descendants of an XML node can be skipped in a descendant search
+ *
+ * Uses the YANG spec to check whether x can have any descendant with the nodetest name.
+ * Nodes without YANG, mount-points and nodes that are not containers or lists are not pruned.
+ * @param[in]  xpr     Pruning state
+ * @param[in]  x       XML node
+ * @param[in]  yspec   Yang spec of x if known, or NULL
+ * @param[out] yspecp  Yang spec of children of x if known, or NULL
+ * @retval     1       Skip descendants of x
+ * @retval     0       Visit descendants of x
+ * @retval    -1       Error
+ */
+int
+xp_prune_check(xp_prune   *xpr,
+               cxobj      *x,
+               yang_stmt  *yspec,
+               yang_stmt **yspecp)
+{
+    yang_stmt *y;
+
+    *yspecp = NULL;
+    if (xpr->xpr_name == NULL)
+        return 0;
+    if ((y = xml_spec(x)) == NULL)
+        return 0;
+    switch (yang_keyword_get(y)){
+    case Y_CONTAINER:
+    case Y_LIST:
+        break;
+    default:
+        return 0;
+    }
+    if (yang_flag_get(y, YANG_FLAG_MTPOINT_POTENTIAL | YANG_FLAG_MOUNTPOINT) != 0)
+        return 0;
+    if (yspec == NULL && (yspec = ys_spec(y)) == NULL)
+        return 0;
+    if (yspec != xpr->xpr_yspec){
+        if (yang_name_ancestors(yspec, xpr->xpr_name, &xpr->xpr_vec, &xpr->xpr_len) < 0)
+            return -1;
+        xpr->xpr_yspec = yspec;
+    }
+    *yspecp = yspec;
+    if (yang_name_ancestor(xpr->xpr_vec, xpr->xpr_len, y) == 0)
+        return 1;
+    return 0;
+}
+#endif /* XPATH_DESCENDANT_PRUNE */
+
+/*! test node recursive, internal
+ *
+ * @see nodetest_recursive
+ */
+static int
+nodetest_recursive1(cxobj      *xn,
+                    xpath_tree *nodetest,
+                    int         node_type,
+                    uint16_t    flags,
+                    cvec       *nsc,
+                    int         localonly,
+                    xp_prune   *xpr,
+                    yang_stmt  *yspec,
+                    int         limit,
+                    cxobj    ***vec0,
+                    int        *vec0len,
+                    int        *vec0max)
+{
+    int        retval = -1;
+    cxobj     *xsub;
+    cxobj    **vec = *vec0;
+    int        veclen = *vec0len;
+    int        vecmax = *vec0max;
+    yang_stmt *ysub = NULL;
+#ifdef XPATH_DESCENDANT_PRUNE
+    int        ret;
+#endif
+
+    xsub = NULL;
+    while ((xsub = xml_child_each(xn, xsub, node_type)) != NULL) {
+        if (limit && veclen >= limit)
+            break;
+        if (nodetest_eval(xsub, nodetest, nsc, localonly) == 1){
+            clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%x %x", flags, xml_flag(xsub, flags));
+            if (flags==0x0 || xml_flag(xsub, flags))
+                if (ctx_vec_append(xsub, &vec, &veclen, &vecmax) < 0)
+                    goto done;
+            //      continue; /* Don't go deeper */
+        }
+#ifdef XPATH_DESCENDANT_PRUNE
+        if ((ret = xp_prune_check(xpr, xsub, yspec, &ysub)) < 0)
+            goto done;
+        if (ret == 1)
+            continue; /* No descendant can match */
+#endif
+        if (nodetest_recursive1(xsub, nodetest, node_type, flags, nsc, localonly,
+                                xpr, ysub, limit, &vec, &veclen, &vecmax) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    *vec0 = vec;
+    *vec0len = veclen;
+    *vec0max = vecmax;
+    return retval;
+}
+
 /*! test node recursive
  *
+ * If XPATH_DESCENDANT_PRUNE is set, subtrees that cannot contain the nodetest name according
+ * to YANG are skipped.
  * @param[in]  xn
  * @param[in]  nodetest   XPath stack
  * @param[in]  node_type
  * @param[in]  flags
  * @param[in]  nsc        XML Namespace context
  * @param[in]  localonly  Skip prefix and namespace tests (non-standard)
+ * @param[in]  limit      Stop when vec0 has this many nodes, 0 means no limit
  * @param[out] vec0
  * @param[out] vec0len
+ * @param[in,out] vec0max Allocated length of vec0, see ctx_vec_append
  * @retval     0          OK
  * @retval    -1          Error
  */
+static int
+nodetest_recursive_limit(cxobj      *xn,
+                         xpath_tree *nodetest,
+                         int         node_type,
+                         uint16_t    flags,
+                         cvec       *nsc,
+                         int         localonly,
+                         int         limit,
+                         cxobj    ***vec0,
+                         int        *vec0len,
+                         int        *vec0max)
+{
+    xp_prune xpr = {0,};
+
+#ifdef XPATH_DESCENDANT_PRUNE
+    xp_prune_init(&xpr, nodetest);
+#endif
+    return nodetest_recursive1(xn, nodetest, node_type, flags, nsc, localonly,
+                               &xpr, NULL, limit, vec0, vec0len, vec0max);
+}
+
+/*! test node recursive
+ *
+ * @see nodetest_recursive_limit
+ */
 int
 nodetest_recursive(cxobj      *xn,
                    xpath_tree *nodetest,
@@ -327,28 +481,18 @@ nodetest_recursive(cxobj      *xn,
                    cxobj    ***vec0,
                    int        *vec0len)
 {
-    int     retval = -1;
-    cxobj  *xsub;
-    cxobj **vec = *vec0;
-    int     veclen = *vec0len;
+    int vec0max = 0;
 
-    xsub = NULL;
-    while ((xsub = xml_child_each(xn, xsub, node_type)) != NULL) {
-        if (nodetest_eval(xsub, nodetest, nsc, localonly) == 1){
-            clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%x %x", flags, xml_flag(xsub, flags));
-            if (flags==0x0 || xml_flag(xsub, flags))
-                if (cxvec_append(xsub, &vec, &veclen) < 0)
-                    goto done;
-            //      continue; /* Don't go deeper */
-        }
-        if (nodetest_recursive(xsub, nodetest, node_type, flags, nsc, localonly, &vec, &veclen) < 0)
-            goto done;
-    }
-    retval = 0;
-    *vec0 = vec;
-    *vec0len = veclen;
- done:
-    return retval;
+    return nodetest_recursive_limit(xn, nodetest, node_type, flags, nsc, localonly,
+                                    0, vec0, vec0len, &vec0max);
+}
+
+/*! Check if XPath predicate tree is empty, ie a step without [..]
+ */
+static int
+xp_pred_empty(xpath_tree *xs)
+{
+    return xs == NULL || (xs->xs_c0 == NULL && xs->xs_c1 == NULL);
 }
 
 /*! Evaluate xpath step rule of an XML tree
@@ -357,6 +501,7 @@ nodetest_recursive(cxobj      *xn,
  * @param[in]  xs        XPath node tree
  * @param[in]  nsc       XML Namespace context
  * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  limit     Stop when result has this many nodes, 0 means no limit
  * @param[out] xrp       Resulting context
  * @retval     0         OK
  * @retval    -1         Error
@@ -372,6 +517,7 @@ xp_eval_step(xp_ctx     *xc0,
              xpath_tree *xs,
              cvec       *nsc,
              int         localonly,
+             int         limit,
              xp_ctx    **xrp)
 {
     int         retval = -1;
@@ -381,13 +527,17 @@ xp_eval_step(xp_ctx     *xc0,
     cxobj      *xp;
     cxobj     **vec = NULL;
     int         veclen = 0;
+    int         vecmax = 0;
     xpath_tree *nodetest = xs->xs_c0;
     xp_ctx     *xc = NULL;
     int         ret;
+    int         steplimit;
 
     /* Create new xc */
     if ((xc = ctx_dup(xc0)) == NULL)
         goto done;
+    /* Node collection can only stop early if no predicate filters it */
+    steplimit = xp_pred_empty(xs->xs_c1) ? limit : 0;
     switch (xs->xs_int){
     case A_ANCESTOR:
         break;
@@ -398,24 +548,33 @@ xp_eval_step(xp_ctx     *xc0,
     case A_CHILD:
         if (xc->xc_descendant){
             for (i=0; i<xc->xc_size; i++){
+                if (steplimit && veclen >= steplimit)
+                    break;
                 xv = xc->xc_nodeset[i];
-                if (nodetest_recursive(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+                if (nodetest_recursive_limit(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly,
+                                             steplimit, &vec, &veclen, &vecmax) < 0)
                     goto done;
             }
             xc->xc_descendant = 0;
         }
         else{
             for (i=0; i<xc->xc_size; i++){
+                if (steplimit && veclen >= steplimit)
+                    break;
                 xv = xc->xc_nodeset[i];
                 x = NULL;
                 if ((ret = xpath_optimize_check(xs, xv, &vec, &veclen)) < 0)
                     goto done;
-                if (ret == 0){/* regular code, no optimization made */
+                if (ret == 1) /* vec may have been reallocated to exact length */
+                    vecmax = veclen;
+                else{ /* regular code, no optimization made */
                     while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
+                        if (steplimit && veclen >= steplimit)
+                            break;
                         /* xs->xs_c0 is nodetest */
                         if (nodetest == NULL ||
                             nodetest_eval(x, nodetest, nsc, localonly) == 1){
-                            if (cxvec_append(x, &vec, &veclen) < 0)
+                            if (ctx_vec_append(x, &vec, &veclen, &vecmax) < 0)
                                 goto done;
                         }
                     }
@@ -423,18 +582,20 @@ xp_eval_step(xp_ctx     *xc0,
             }
         }
         ctx_nodeset_replace(xc, vec, veclen);
+        xc->xc_max = vecmax;
         if (vec)
             vec = NULL;
         break;
     case A_DESCENDANT_OR_SELF:
         for (i=0; i<xc->xc_size; i++){
             xv = xc->xc_nodeset[i];
-            if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+            if (nodetest_recursive_limit(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly,
+                                         0, &vec, &veclen, &vecmax) < 0)
                 goto done;
         }
         for (i=0; i<veclen; i++){
             x = vec[i];
-            if (cxvec_append(x, &xc->xc_nodeset, &xc->xc_size) < 0)
+            if (ctx_nodeset_append(xc, x) < 0)
                 goto done;
         }
         if (vec){
@@ -445,7 +606,8 @@ xp_eval_step(xp_ctx     *xc0,
     case A_DESCENDANT:
         for (i=0; i<xc->xc_size; i++){
             xv = xc->xc_nodeset[i];
-            if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+            if (nodetest_recursive_limit(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly,
+                                         0, &vec, &veclen, &vecmax) < 0)
                 goto done;
         }
         ctx_nodeset_replace(xc, vec, veclen);
@@ -460,6 +622,7 @@ xp_eval_step(xp_ctx     *xc0,
         veclen = xc->xc_size;
         vec = xc->xc_nodeset;
         xc->xc_size = 0;
+        xc->xc_max = 0;
         xc->xc_nodeset = NULL;
         for (i=0; i<veclen; i++){
             x = vec[i];
@@ -469,7 +632,7 @@ xp_eval_step(xp_ctx     *xc0,
                 || (xp = xml_parent_candidate(x)) != NULL
 #endif /* XML_PARENT_CANDIDATE */
                 )
-                if (cxvec_append(xp, &xc->xc_nodeset, &xc->xc_size) < 0)
+                if (ctx_nodeset_append(xc, xp) < 0)
                     goto done;
         }
         if (vec){
@@ -489,7 +652,7 @@ xp_eval_step(xp_ctx     *xc0,
         break;
     }
     if (xs->xs_c1){
-        if (xp_eval(xc, xs->xs_c1, nsc, localonly, xrp) < 0)
+        if (xp_eval_limit(xc, xs->xs_c1, nsc, localonly, limit, xrp) < 0)
             goto done;
     }
     else{
@@ -514,6 +677,7 @@ xp_eval_step(xp_ctx     *xc0,
  * @param[in]  xs      XPath node tree
  * @param[in]  nsc     XML Namespace context
  * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  limit   Stop when result has this many nodes, 0 means no limit
  * @param[out] xrp     Resulting context
  * @retval     0       OK
  * @retval    -1       Error
@@ -538,6 +702,7 @@ xp_eval_predicate(xp_ctx     *xc,
                   xpath_tree *xs,
                   cvec       *nsc,
                   int         localonly,
+                  int         limit,
                   xp_ctx    **xrp)
 {
     int      retval = -1;
@@ -561,29 +726,26 @@ xp_eval_predicate(xp_ctx     *xc,
         /* Loop over each node in the nodeset 
          * XXX: alt to check xr0 is nodeset: set new var nodeset to NULL
          */
-        if ((xr1 = malloc(sizeof(*xr1))) == NULL){
-            clixon_err(OE_UNIX, errno, "malloc");
+        if ((xr1 = ctx_new()) == NULL)
             goto done;
-        }
-        memset(xr1, 0, sizeof(*xr1));
         xr1->xc_type = XT_NODESET;
         xr1->xc_node = xc->xc_node;
         xr1->xc_initial = xc->xc_initial;
         for (i=0; i<xr0->xc_size; i++){
+            /* Positions are counted in xr0, so stopping here does not affect them */
+            if (limit && xr1->xc_size >= limit)
+                break;
             x = xr0->xc_nodeset[i];
             /* Create new context */
-            if ((xcc = malloc(sizeof(*xcc))) == NULL){
-                clixon_err(OE_XML, errno, "malloc");
+            if ((xcc = ctx_new()) == NULL)
                 goto done;
-            }
-            memset(xcc, 0, sizeof(*xcc));
             xcc->xc_type = XT_NODESET;
             xcc->xc_initial = xc->xc_initial;
             xcc->xc_node = x;
             xcc->xc_position = i;
             /* For each node in the node-set to be filtered, the PredicateExpr is
              * evaluated with that node as the context node */
-            if (cxvec_append(x, &xcc->xc_nodeset, &xcc->xc_size) < 0)
+            if (ctx_nodeset_append(xcc, x) < 0)
                 goto done;
             if (xp_eval(xcc, xs->xs_c1, nsc, localonly, &xrc) < 0)
                 goto done;
@@ -593,14 +755,14 @@ xp_eval_predicate(xp_ctx     *xc,
                 /* If the result is a number, the result will be converted to true
                    if the number is equal to the context position */
                 if ((int)xrc->xc_number == i)
-                    if (cxvec_append(x, &xr1->xc_nodeset, &xr1->xc_size) < 0)
+                    if (ctx_nodeset_append(xr1, x) < 0)
                         goto done;
             }
             else {
                 /* if PredicateExpr evaluates to true for that node, the node is
                    included in the new node-set */
                 if (ctx2boolean(xrc))
-                    if (cxvec_append(x, &xr1->xc_nodeset, &xr1->xc_size) < 0)
+                    if (ctx_nodeset_append(xr1, x) < 0)
                         goto done;
             }
             if (xrc)
@@ -651,11 +813,8 @@ xp_logop(xp_ctx    *xc1,
     int     b1;
     int     b2;
 
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_initial = xc1->xc_initial;
     xr->xc_type = XT_BOOL;
     if ((b1 = ctx2boolean(xc1)) < 0)
@@ -705,11 +864,8 @@ xp_numop(xp_ctx    *xc1,
     double  n1;
     double  n2;
 
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_initial = xc1->xc_initial;
     xr->xc_type = XT_NUMBER;
     if (ctx2number(xc1, &n1) < 0)
@@ -868,11 +1024,8 @@ xp_relop(xp_ctx    *xc1,
         clixon_err(OE_UNIX, EINVAL, "xc1 or xc2 NULL");
         goto done;
     }
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_initial = xc1->xc_initial;
     xr->xc_type = XT_BOOL;
     if (xc1->xc_type == xc2->xc_type){ /* cases (2-3) above */
@@ -1156,19 +1309,16 @@ xp_union(xp_ctx    *xc1,
                    __FUNCTION__, clicon_int2str(xpopmap,op));
         goto done;
     }
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_initial = xc1->xc_initial;
     xr->xc_type = XT_NODESET;
 
     for (i=0; i<xc1->xc_size; i++)
-        if (cxvec_append(xc1->xc_nodeset[i], &xr->xc_nodeset, &xr->xc_size) < 0)
+        if (ctx_nodeset_append(xr, xc1->xc_nodeset[i]) < 0)
             goto done;
     for (i=0; i<xc2->xc_size; i++){
-        if (cxvec_append(xc2->xc_nodeset[i], &xr->xc_nodeset, &xr->xc_size) < 0)
+        if (ctx_nodeset_append(xr, xc2->xc_nodeset[i]) < 0)
             goto done;
     }
     *xrp = xr;
@@ -1180,6 +1330,35 @@ xp_union(xp_ctx    *xc1,
     return retval;
 }
 
+/*! Check if result of XPath node is result of its last child, ie a limit can be passed on
+ *
+ * @param[in]  xs   XPath node tree
+ * @retval     1    Result is (a subset of) the result of the last child
+ * @retval     0    No, result is computed from children, eg by a function or operator
+ */
+static int
+xp_eval_passlimit(xpath_tree *xs)
+{
+    switch (xs->xs_type){
+    case XP_EXP:
+    case XP_AND:
+    case XP_RELEX:
+    case XP_ADD:
+    case XP_UNION:
+    case XP_FILTEREXPR:
+    case XP_LOCPATH:
+    case XP_ABSPATH:
+    case XP_PRI0:
+        return xs->xs_c1 == NULL;
+    case XP_PATHEXPR:
+    case XP_RELLOCPATH:
+        return 1;
+    default:
+        break;
+    }
+    return 0;
+}
+
 /*! Evaluate an XPath on an XML tree
  *
  * The initial sequence of steps selects a set of nodes relative to a context node. 
@@ -1191,6 +1370,7 @@ xp_union(xp_ctx    *xc1,
  * @param[out] xrp  Resulting context
  * @retval     0    OK
  * @retval    -1    Error
+ * @see xp_eval_limit
  */
 int
 xp_eval(xp_ctx     *xc,
@@ -1198,6 +1378,33 @@ xp_eval(xp_ctx     *xc,
         cvec       *nsc,
         int         localonly,
         xp_ctx    **xrp)
+{
+    return xp_eval_limit(xc, xs, nsc, localonly, 0, xrp);
+}
+
+/*! Evaluate an XPath on an XML tree, stop when a number of nodes are found
+ *
+ * Used when only the first node(s) are of interest, eg xpath_first
+ * The limit is only passed on along the last location step of a path, nodes of
+ * intermediate steps, operator and function arguments are evaluated in full.
+ * The result is the first limit nodes of the result of xp_eval (in the same order),
+ * but may contain more nodes.
+ * @param[in]  xc   Incoming context
+ * @param[in]  xs   XPath node tree
+ * @param[in]  nsc  XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  limit Stop when result has this many nodes, 0 means no limit
+ * @param[out] xrp  Resulting context
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xp_eval_limit(xp_ctx     *xc,
+              xpath_tree *xs,
+              cvec       *nsc,
+              int         localonly,
+              int         limit,
+              xp_ctx    **xrp)
 {
     int        retval = -1;
     cxobj     *x;
@@ -1232,12 +1439,12 @@ xp_eval(xp_ctx     *xc,
             xc->xc_descendant = 1; /* XXX need to set to 0 in sub */
         break;
     case XP_STEP:    /* XP_NODE is first argument -not called explicitly */
-        if (xp_eval_step(xc, xs, nsc, localonly, xrp) < 0)
+        if (xp_eval_step(xc, xs, nsc, localonly, limit, xrp) < 0)
             goto done;
         goto ok; /* Skip generic child traverse */
         break;
     case XP_PRED:
-        if (xp_eval_predicate(xc, xs, nsc, localonly, xrp) < 0)
+        if (xp_eval_predicate(xc, xs, nsc, localonly, limit, xrp) < 0)
             goto done;
         goto ok;
         break;
@@ -1362,7 +1569,9 @@ xp_eval(xp_ctx     *xc,
     /* Eval first child c0
      */
     if (xs->xs_c0){
-        if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
+        if (xp_eval_limit(xc, xs->xs_c0, nsc, localonly,
+                          (limit && xs->xs_c1 == NULL && xp_eval_passlimit(xs)) ? limit : 0,
+                          &xr0) < 0)
             goto done;
     }
     /* Actions between first and second child
@@ -1390,16 +1599,13 @@ xp_eval(xp_ctx     *xc,
         use_xr0++;
         /* Special case, no c0 or c1, single "/" */
         if (xs->xs_c0 == NULL){
-            if ((xr0 = malloc(sizeof(*xr0))) == NULL){
-                clixon_err(OE_UNIX, errno, "malloc");
+            if ((xr0 = ctx_new()) == NULL)
                 goto done;
-            }
-            memset(xr0, 0, sizeof(*xr0));
             xr0->xc_initial = xc->xc_initial;
             xr0->xc_type = XT_NODESET;
             x = NULL;
             while ((x = xml_child_each(xc->xc_node, x, CX_ELMNT)) != NULL) {
-                if (cxvec_append(x, &xr0->xc_nodeset, &xr0->xc_size) < 0)
+                if (ctx_nodeset_append(xr0, x) < 0)
                     goto done;
             }
         }
@@ -1420,21 +1626,15 @@ xp_eval(xp_ctx     *xc,
     case XP_PRI0:
         break;
     case XP_PRIME_NR: /* primaryexpr -> [<number>] */
-        if ((xr0 = malloc(sizeof(*xr0))) == NULL){
-            clixon_err(OE_UNIX, errno, "malloc");
+        if ((xr0 = ctx_new()) == NULL)
             goto done;
-        }
-        memset(xr0, 0, sizeof(*xr0));
         xr0->xc_initial = xc->xc_initial;
         xr0->xc_type = XT_NUMBER;
         xr0->xc_number = xs->xs_double;
         break;
     case XP_PRIME_STR:
-        if ((xr0 = malloc(sizeof(*xr0))) == NULL){
-            clixon_err(OE_UNIX, errno, "malloc");
+        if ((xr0 = ctx_new()) == NULL)
             goto done;
-        }
-        memset(xr0, 0, sizeof(*xr0));
         xr0->xc_initial = xc->xc_initial;
         xr0->xc_type = XT_STRING;
         xr0->xc_string = xs->xs_s0?strdup(xs->xs_s0):NULL;
@@ -1446,7 +1646,8 @@ xp_eval(xp_ctx     *xc,
      * Note, some operators like locationpath, need transitive context (use_xr0)
      */
     if (xs->xs_c1){
-        if (xp_eval(use_xr0?xr0:xc, xs->xs_c1, nsc, localonly, &xr1) < 0)
+        if (xp_eval_limit(use_xr0?xr0:xc, xs->xs_c1, nsc, localonly,
+                          xp_eval_passlimit(xs) ? limit : 0, &xr1) < 0)
             goto done;
         /* Actions after second child
          */
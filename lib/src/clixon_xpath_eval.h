@@ -37,6 +37,19 @@
 #ifndef _CLIXON_XPATH_EVAL_H
 #define _CLIXON_XPATH_EVAL_H
 
+/*
+ * Types
+ */
+/*! Descendant search pruning state, see XPATH_DESCENDANT_PRUNE
+ */
+struct xp_prune{
+    char       *xpr_name;  /* Nodetest name, or NULL if no pruning */
+    yang_stmt  *xpr_yspec; /* Yang spec of ancestor set */
+    yang_stmt **xpr_vec;   /* Yang nodes that may have descendants named xpr_name */
+    int         xpr_len;
+};
+typedef struct xp_prune xp_prune;
+
 /*
  * Variables
  */
@@ -45,6 +58,9 @@ extern const map_str2int xpopmap[];
 /*
  * Prototypes
  */
+int xp_prune_init(xp_prune *xpr, xpath_tree *nodetest);
+int xp_prune_check(xp_prune *xpr, cxobj *x, yang_stmt *yspec, yang_stmt **yspecp);
 int xp_eval(xp_ctx *xc, xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
+int xp_eval_limit(xp_ctx *xc, xpath_tree *xs, cvec *nsc, int localonly, int limit, xp_ctx **xrp);
 
 #endif /* _CLIXON_XPATH_EVAL_H */
@@ -243,11 +243,8 @@ xp_function_re_match(xp_ctx            *xc,
     if ((ret = cligen_regex_posix_exec(re, s0)) < 0)
         goto done;
 #endif
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_BOOL;
     xr->xc_bool = ret;
     *xrp = xr;
@@ -359,6 +356,7 @@ derived_from_one(char  *baseidentity,
     char      *id = NULL;
     cbuf      *cb = NULL;
     char      *baseid = NULL;
+    int        derived;
 
     /* Split baseidentity to get its id (w/o prefix) */
     if (nodeid_split(baseidentity, NULL, &baseid) < 0)
@@ -402,6 +400,10 @@ derived_from_one(char  *baseidentity,
         strcmp(baseid, id) == 0){
         ; /* match */
     }
+    else if (yang_identity_derived(ybaseid, yang_find(ymod, Y_IDENTITY, id), &derived) == 1){
+        if (!derived)
+            goto nomatch;
+    }
     else {
         /* Allocate cbuf */
         if ((cb = cbuf_new()) == NULL){
@@ -476,11 +478,8 @@ xp_function_derived_from(xp_ctx            *xc,
     if (ctx2string(xr1, &identity) < 0)
         goto done;
     /* Allocate a return struct of type boolean */
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_BOOL;
     /* ANY node is an identityref and its value an identity that is derived ... */
     for (i=0; i<xr0->xc_size; i++){
@@ -552,11 +551,8 @@ xp_function_bit_is_set(xp_ctx            *xc,
         goto done;
     if (ctx2string(xr1, &s1) < 0)
         goto done;
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_BOOL;
     /* The first node in document order in the argument "nodes" 
      * is a node of type "bits") and # NOT IMPLEMENTED
@@ -598,11 +594,8 @@ xp_function_position(xp_ctx            *xc,
     int         retval = -1;
     xp_ctx     *xr = NULL;
 
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_initial = xc->xc_initial;
     xr->xc_type = XT_NUMBER;
     xr->xc_number = xc->xc_position;
@@ -633,11 +626,8 @@ xp_function_count(xp_ctx            *xc,
     }
     if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
         goto done;
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_NUMBER;
     xr->xc_number = xr0->xc_size;
     *xrp = xr;
@@ -675,11 +665,8 @@ xp_function_name(xp_ctx            *xc,
     }
     if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
         goto done;
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_STRING;
     for (i=0; i<xr0->xc_size; i++){
         if ((x = xr0->xc_nodeset[i]) == NULL)
@@ -739,11 +726,8 @@ xp_function_string(xp_ctx            *xc,
             goto done;
         }
     }
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_STRING;
     xr->xc_string = s0;
     s0 = NULL;
@@ -798,11 +782,8 @@ xp_function_contains(xp_ctx            *xc,
         goto done;
     if (ctx2string(xr1, &s1) < 0)
         goto done;
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_BOOL;
     if (starts)
         xr->xc_bool = (strncmp(s0, s1, strlen(s1)) == 0);
@@ -865,11 +846,8 @@ xp_function_substring_str(xp_ctx            *xc,
         goto done;
     if (ctx2string(xr1, &s1) < 0)
         goto done;
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_STRING;
     sp = strstr(s0, s1);
     if (before) {
@@ -969,11 +947,8 @@ xp_function_substring(xp_ctx            *xc,
         i1 = 0;
     else
         i1 = i10;
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_STRING;
     if (i1 < strlen(s0))
         s0p = &s0[i1];
@@ -1050,11 +1025,8 @@ xp_function_string_length(xp_ctx            *xc,
             goto done;
         }
     }
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_NUMBER;
     xr->xc_number = strlen(s0);
     s0 = NULL;
@@ -1135,11 +1107,8 @@ xp_function_translate(xp_ctx            *xc,
         if (ctx2string(xr2, &s2) < 0)
             goto done;
     }
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_STRING;
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
@@ -1209,11 +1178,8 @@ xp_function_boolean(xp_ctx            *xc,
     if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
         goto done;
     bool = ctx2boolean(xr0);
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_BOOL;
     xr->xc_bool = bool;
     *xrp = xr;
@@ -1254,11 +1220,8 @@ xp_function_true(xp_ctx            *xc,
     int         retval = -1;
     xp_ctx     *xr = NULL;
 
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_BOOL;
     xr->xc_bool = 1;
     *xrp = xr;
@@ -1280,11 +1243,8 @@ xp_function_false(xp_ctx            *xc,
     int         retval = -1;
     xp_ctx     *xr = NULL;
 
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new()) == NULL)
         goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
     xr->xc_type = XT_BOOL;
     xr->xc_bool = 0;
     *xrp = xr;
@@ -71,24 +71,57 @@
 #include "clixon_xpath_optimize.h"
 
 #ifdef XPATH_LIST_OPTIMIZE
-static xpath_tree *_xmtop = NULL; /* pattern match tree top */
-static xpath_tree *_xm = NULL;
-static xpath_tree *_xe = NULL;
+static xpath_tree *_xmtop = NULL;  /* pattern match tree top */
+static xpath_tree *_xm = NULL;     /* step pattern: _x[..] */
+static xpath_tree *_xr = NULL;     /* predicate pattern: _y='_z' */
+static xpath_tree *_xltop = NULL;  /* leaf-list pattern match tree top */
+static xpath_tree *_xrl = NULL;    /* leaf-list predicate pattern: .='_z' */
 static int _optimize_enable = 1;
-static int _optimize_hits = 0;
+static int _optimize_hits[XPATH_OPTIMIZE_MAX] = {0,};
 #endif /* XPATH_LIST_OPTIMIZE */
 
-/* XXX development in clixon_xpath_eval */
+/*! Get and reset nr of optimized lookups made
+ *
+ * @param[out] hits  Total nr of optimized lookups of all patterns
+ * @retval     0     OK
+ * @see xpath_list_optimize_pattern_stats  for hits per pattern
+ */
 int
 xpath_list_optimize_stats(int *hits)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    *hits = _optimize_hits;
-    _optimize_hits = 0;
+    int i;
+
+    *hits = 0;
+    for (i=0; i<XPATH_OPTIMIZE_MAX; i++){
+        *hits += _optimize_hits[i];
+        _optimize_hits[i] = 0;
+    }
 #endif
     return 0;
 }
 
+/*! Get and reset nr of optimized lookups made per pattern
+ *
+ * @param[out] hits  Vector of XPATH_OPTIMIZE_MAX elements indexed by xpath_optimize_pattern
+ * @retval     0     OK
+ */
+int
+xpath_list_optimize_pattern_stats(int *hits)
+{
+    int i;
+
+    for (i=0; i<XPATH_OPTIMIZE_MAX; i++){
+#ifdef XPATH_LIST_OPTIMIZE
+        hits[i] = _optimize_hits[i];
+        _optimize_hits[i] = 0;
+#else
+        hits[i] = 0;
+#endif
+    }
+    return 0;
+}
+
 /*! Enable xpath optimize
  *
  * Cant replace this with option since there is no handle in xpath functions,...
@@ -106,8 +139,15 @@ void
 xpath_optimize_exit(void)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    if (_xmtop)
+    if (_xmtop){
         xpath_tree_free(_xmtop);
+        _xmtop = NULL;
+    }
+    if (_xltop){
+        xpath_tree_free(_xltop);
+        _xltop = NULL;
+    }
+    _xm = _xr = _xrl = NULL;
 #endif
 }
 
@@ -115,14 +155,19 @@ xpath_optimize_exit(void)
 /*! Initialize xpath module
  *
  * XXX move to clixon_xpath.c 
+ * @param[out] xm   Step pattern: _x[..]
+ * @param[out] xr   Relational expression pattern of list predicate: _y='_z'
+ * @param[out] xrl  Relational expression pattern of leaf-list predicate: .='_z'
  * @see loop_preds
  */
 int
 xpath_optimize_init(xpath_tree **xm,
-                    xpath_tree **xe)
+                    xpath_tree **xr,
+                    xpath_tree **xrl)
 {
     int         retval = -1;
     xpath_tree *xs;
+    xpath_tree *xe;
 
     if (_xm == NULL){
         /* Initialize xpath-tree */
@@ -140,92 +185,240 @@ xpath_optimize_init(xpath_tree **xm,
             goto done;
         xs->xs_match++;
         /* get expression [_y=_z] */
-        if ((_xe = xpath_tree_traverse(xs, 1, -1)) == NULL)
+        if ((xe = xpath_tree_traverse(xs, 1, -1)) == NULL)
+            goto done;
+        /* get relational expression _y=_z below expr and andexpr */
+        if ((_xr = xpath_tree_traverse(xe, 0, 0, -1)) == NULL)
             goto done;
         /* get keyname (_y) */
-        if ((xs = xpath_tree_traverse(_xe, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1)) == NULL)
+        if ((xs = xpath_tree_traverse(_xr, 0, 0, 0, 0, 0, 0, 0, 0, -1)) == NULL)
             goto done;
-        xs->xs_match++; /* in loop_preds get name in xs_s1 XXX: leaf-list is different */
+        xs->xs_match++; /* in loop_preds get name in xs_s1 */
         /* get keyval (_z) */
-        if ((xs = xpath_tree_traverse(_xe, 0, 0, 1, 0, 0, 0, 0, -1)) == NULL)
+        if ((xs = xpath_tree_traverse(_xr, 1, 0, 0, 0, 0, -1)) == NULL)
             goto done;
         xs->xs_match++; /* in loop_preds get value in xs_s0 or xs_strnr */
+        /* Leaf-list: same structure but self (.) instead of keyname */
+        if (xpath_parse("_x[.='_z']", &_xltop) < 0)
+            goto done;
+        if ((_xrl = xpath_tree_traverse(_xltop, 0, 0, 1, 1, 0, 0, -1)) == NULL)
+            goto done;
+        if ((xs = xpath_tree_traverse(_xrl, 1, 0, 0, 0, 0, -1)) == NULL)
+            goto done;
+        xs->xs_match++;
     }
     *xm = _xm;
-    *xe = _xe;
+    *xr = _xr;
+    *xrl = _xrl;
     retval = 0;
  done:
     return retval;
 }
 
-/*! Recursive function to loop over all EXPR and pattern match them
+/*! Pattern match a relational expression and add <keyname>:<keyval> to vector
  *
- * @param[in]  xt    XPath tree of type PRED
- * @param[in]  xepat Pattern matching XPath tree of type EXPR
+ * @param[in]  xt    XPath tree of type RELEX
+ * @param[in]  xr    Pattern of list predicate (_y='_z')
+ * @param[in]  xrl   Pattern of leaf-list predicate (.='_z'), keyname is "."
  * @param[out] cvk   Vector of <keyname>:<keyval> pairs
  * @retval     1     Match
  * @retval     0     No match
  * @retval    -1     Error
- * @see xpath_optimize_init
  */
 static int
-loop_preds(xpath_tree *xt,
-           xpath_tree *xepat,
-           cvec       *cvk)
+relex_match(xpath_tree *xt,
+            xpath_tree *xr,
+            xpath_tree *xrl,
+            cvec       *cvk)
 {
     int          retval = -1;
     int          ret;
-    xpath_tree  *xe;
     xpath_tree **vec = NULL;
     size_t       veclen = 0;
     cg_var      *cvi;
+    char        *name;
+    xpath_tree  *xv;
 
-    if (xt->xs_type == XP_PRED && xt->xs_c0){
-        if ((ret = loop_preds(xt->xs_c0, xepat, cvk)) < 0)
-            goto done;
-        if (ret == 0)
-            goto ok;
+    if ((ret = xpath_tree_eq(xr, xt, &vec, &veclen)) < 0)
+        goto done;
+    if (ret == 1 && veclen == 2){
+        name = vec[0]->xs_s1;
+        xv = vec[1];
     }
-    if ((xe = xt->xs_c1) && (xe->xs_type == XP_EXP)){
-        if ((ret = xpath_tree_eq(xepat, xe, &vec, &veclen)) < 0)
-            goto done;
-        if (ret == 0)
-            goto ok;
-        if (veclen != 2)
-            goto ok;
-        if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
-            clixon_err(OE_XML, errno, "cvec_add");
-            goto done;
+    else {
+        if (vec){
+            free(vec);
+            vec = NULL;
         }
-        cv_name_set(cvi, vec[0]->xs_s1);
-        if (vec[1]->xs_type == XP_PRIME_NR)
-            cv_string_set(cvi, vec[1]->xs_strnr);
-        else
-            cv_string_set(cvi, vec[1]->xs_s0);
+        veclen = 0;
+        if ((ret = xpath_tree_eq(xrl, xt, &vec, &veclen)) < 0)
+            goto done;
+        if (ret == 0 || veclen != 1)
+            goto fail;
+        name = ".";
+        xv = vec[0];
     }
+    if (name == NULL) /* eg prefix:* */
+        goto fail;
+    if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
+        clixon_err(OE_XML, errno, "cvec_add");
+        goto done;
+    }
+    cv_name_set(cvi, name);
+    if (xv->xs_type == XP_PRIME_NR)
+        cv_string_set(cvi, xv->xs_strnr);
+    else
+        cv_string_set(cvi, xv->xs_s0);
     retval = 1;
  done:
     if (vec)
         free(vec);
     return retval;
- ok: /* no match, not special case */
+ fail:
     retval = 0;
     goto done;
 }
 
+/*! Recursive function to loop over and-expressions and pattern match them
+ *
+ * @param[in]  xt    XPath tree of type AND
+ * @param[in]  xr    Pattern of list predicate
+ * @param[in]  xrl   Pattern of leaf-list predicate
+ * @param[out] cvk   Vector of <keyname>:<keyval> pairs
+ * @retval     1     Match
+ * @retval     0     No match
+ * @retval    -1     Error
+ */
+static int
+loop_and(xpath_tree *xt,
+         xpath_tree *xr,
+         xpath_tree *xrl,
+         cvec       *cvk)
+{
+    int ret;
+
+    if (xt == NULL || xt->xs_type != XP_AND)
+        return 0;
+    if (xt->xs_c1 == NULL) /* andexpr -> relexpr */
+        return relex_match(xt->xs_c0, xr, xrl, cvk);
+    if (xt->xs_int != XO_AND)
+        return 0;
+    if ((ret = loop_and(xt->xs_c0, xr, xrl, cvk)) != 1)
+        return ret;
+    return relex_match(xt->xs_c1, xr, xrl, cvk);
+}
+
+/*! Recursive function to loop over all predicates and pattern match them
+ *
+ * All predicates must be equalities on the form [_y='_z'] or [.='_z'], possibly combined with
+ * "and". Since these are independent of position, the order of the predicates does not matter.
+ * @param[in]  xt    XPath tree of type PRED
+ * @param[in]  xr    Pattern of list predicate
+ * @param[in]  xrl   Pattern of leaf-list predicate
+ * @param[out] cvk   Vector of <keyname>:<keyval> pairs
+ * @retval     1     Match
+ * @retval     0     No match
+ * @retval    -1     Error
+ * @see xpath_optimize_init
+ */
+static int
+loop_preds(xpath_tree *xt,
+           xpath_tree *xr,
+           xpath_tree *xrl,
+           cvec       *cvk)
+{
+    int          ret;
+    xpath_tree  *xe;
+
+    if (xt->xs_type != XP_PRED)
+        return 0;
+    if (xt->xs_c0){
+        if ((ret = loop_preds(xt->xs_c0, xr, xrl, cvk)) != 1)
+            return ret;
+    }
+    if ((xe = xt->xs_c1) != NULL){
+        /* expr -> andexpr, "or" is not optimized */
+        if (xe->xs_type != XP_EXP || xe->xs_c1 != NULL)
+            return 0;
+        return loop_and(xe->xs_c0, xr, xrl, cvk);
+    }
+    return 1;
+}
+
+/*! Select keys, explicit index or leaf-list value among predicates
+ *
+ * Predicates not selected are evaluated on the search result by the regular xpath code.
+ * @param[in]  yc    Yang of list or leaf-list
+ * @param[in]  cvk   Vector of <keyname>:<keyval> pairs from predicates
+ * @param[out] cvs   Vector of <keyname>:<keyval> used in the search, in yang key order
+ * @retval     pat   Optimization pattern (xpath_optimize_pattern)
+ * @retval    -1     No match
+ */
+static int
+select_keys(yang_stmt *yc,
+            cvec      *cvk,
+            cvec      *cvs)
+{
+    cvec      *cvv;
+    cg_var    *cvi;
+    cg_var    *cvy;
+#ifdef XML_EXPLICIT_INDEX
+    yang_stmt *yi;
+#endif
+
+    if (yang_keyword_get(yc) == Y_LEAF_LIST){
+        /* First value is enough, remaining are filtered by regular code */
+        cvi = NULL;
+        while ((cvi = cvec_each(cvk, cvi)) != NULL)
+            if (strcmp(cv_name_get(cvi), ".") != 0)
+                return -1;
+        if (cvec_append_var(cvs, cvec_i(cvk, 0)) == NULL)
+            return -1;
+        return XPATH_OPTIMIZE_LEAFLIST;
+    }
+    /* List: all keys in yang order, predicates may come in any order */
+    if ((cvv = yang_cvec_get(yc)) != NULL && cvec_len(cvv)){
+        cvy = NULL;
+        while ((cvy = cvec_each(cvv, cvy)) != NULL)
+            if (cvec_find(cvk, cv_string_get(cvy)) == NULL)
+                break;
+        if (cvy == NULL){
+            while ((cvy = cvec_each(cvv, cvy)) != NULL)
+                if (cvec_append_var(cvs, cvec_find(cvk, cv_string_get(cvy))) == NULL)
+                    return -1;
+            return cvec_len(cvv)>1?XPATH_OPTIMIZE_MULTIKEY:XPATH_OPTIMIZE_KEY;
+        }
+    }
+#ifdef XML_EXPLICIT_INDEX
+    /* Explicit search index, eg a non-key leaf */
+    cvi = NULL;
+    while ((cvi = cvec_each(cvk, cvi)) != NULL){
+        if ((yi = yang_find(yc, Y_LEAF, cv_name_get(cvi))) != NULL &&
+            yang_flag_get(yi, YANG_FLAG_INDEX) != 0){
+            if (cvec_append_var(cvs, cvi) == NULL)
+                return -1;
+            return XPATH_OPTIMIZE_INDEX;
+        }
+    }
+#endif
+    return -1;
+}
+
 /*! Pattern matching to find fastpath
  *
  * @param[in]  xt     XPath tree
  * @param[in]  xv     XML base node
  * @param[out] xvec   Array of found nodes
- * @param[out] xlen   Len of xvec
- * @param[out] key
- * @param[out] keyval
  * @retval     1      Match
  * @retval     0      No match - use non-optimized lookup
  * @retval    -1      Error
- *  XPath:
- *  y[k=3] # corresponds to: <name>[<keyname>=<keyval>]
+ *  XPath patterns, where all predicates are equalities in any order, possibly using "and":
+ *  y[k1=3][k2='a']  # list with all keys
+ *  y[i=3]           # list with explicit search index on non-key leaf
+ *  y[.='a']         # leaf-list value
+ *  Other equality predicates may also be present, they are evaluated on the result of the
+ *  search. Chains of steps such as a/y[k=3]/z[k=4] are handled by each step since xv may be
+ *  a list entry.
  */
 static int
 xpath_list_optimize_fn(xpath_tree  *xt,
@@ -234,19 +427,17 @@ xpath_list_optimize_fn(xpath_tree  *xt,
 {
     int          retval = -1;
     xpath_tree  *xm = NULL;
-    xpath_tree  *xem = NULL;
+    xpath_tree  *xr = NULL;
+    xpath_tree  *xrl = NULL;
     char        *name;
     yang_stmt   *yp;
     yang_stmt   *yc;
-    cvec        *cvv = NULL;
     xpath_tree **vec = NULL;
     size_t       veclen = 0;
-    xpath_tree  *xtp;
     int          ret;
-    cvec        *cvk = NULL; /* vector of index keys */
-    cg_var      *cvi;
-    int          i;
-    yang_stmt   *ypp;
+    cvec        *cvk = NULL; /* vector of predicate keys */
+    cvec        *cvs = NULL; /* vector of index keys used in search */
+    int          pat;
 
     /* revert to non-optimized if no yang */
     if ((yp = xml_spec(xv)) == NULL)
@@ -254,17 +445,8 @@ xpath_list_optimize_fn(xpath_tree  *xt,
     /* or if not config data (state data should not be ordered) */
     if (yang_config_ancestor(yp) == 0)
         goto ok;
-    /* Check that there is no "outer" list. */
-    ypp = yp;
-    do {
-        if (yang_keyword_get(ypp) == Y_LIST)
-            goto ok;
-    } while((ypp = yang_parent_get(ypp)) != NULL);
-    /* Check yang and that only a list with key as index is a special case can do bin search 
-     * That is, ONLY check optimize cases of this type:_x[_y='_z']
-     * Should we extend this simple example and have more cases (all cases?)
-     */
-    xpath_optimize_init(&xm, &xem);
+    if (xpath_optimize_init(&xm, &xr, &xrl) < 0)
+        goto done;
     /* Here is where pattern is checked for equality and where variable binding is made (if
      * equal) */
     if ((ret = xpath_tree_eq(xm, xt, &vec, &veclen)) < 0)
@@ -273,44 +455,38 @@ xpath_list_optimize_fn(xpath_tree  *xt,
         goto ok; /* no match */
     if (veclen != 2)
         goto ok;
-    name = vec[0]->xs_s1;
+    if ((name = vec[0]->xs_s1) == NULL) /* prefix:* */
+        goto ok;
     /* Extract variables */
-    if ((yc = yang_find(yp, Y_LIST, name)) == NULL)
-#ifdef NOTYET /* leaf-list is not detected by xpath optimize detection */
-        if ((yc = yang_find(yp, Y_LEAF_LIST, name)) == NULL) /* XXX */
-#endif
-            goto ok;
-    /* Validate keys */
-    if ((cvv = yang_cvec_get(yc)) == NULL)
+    if ((yc = yang_find_datanode(yp, name)) == NULL)
+        goto ok;
+    if (yang_keyword_get(yc) != Y_LIST && yang_keyword_get(yc) != Y_LEAF_LIST)
         goto ok;
-    xtp = vec[1];
     if ((cvk = cvec_new(0)) == NULL){
         clixon_err(OE_YANG, errno, "cvec_new");
         goto done;
     }
-    if ((ret = loop_preds(xtp, xem, cvk)) < 0)
+    if ((ret = loop_preds(vec[1], xr, xrl, cvk)) < 0)
         goto done;
-    if (ret == 0)
-        goto ok;
-
-    if (cvec_len(cvv) != cvec_len(cvk))
+    if (ret == 0 || cvec_len(cvk) == 0)
         goto ok;
-    i = 0;
-    cvi = NULL;
-    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-        if (strcmp(cv_name_get(cvi), cv_string_get(cvec_i(cvv,i))))
-            goto ok;
-        i++;
+    if ((cvs = cvec_new(0)) == NULL){
+        clixon_err(OE_YANG, errno, "cvec_new");
+        goto done;
     }
-    /* Use 2a form since yc allready given to compute cvk */
-    if (clixon_xml_find_index(xv, yp, NULL, name, cvk, xvec) < 0)
+    if ((pat = select_keys(yc, cvk, cvs)) < 0)
+        goto ok;
+    if (clixon_xml_find_index(xv, yp, NULL, name, cvs, xvec) < 0)
         goto done;
+    _optimize_hits[pat]++;
     retval = 1; /* match */
  done:
     if (vec)
         free(vec);
     if (cvk)
         cvec_free(cvk);
+    if (cvs)
+        cvec_free(cvs);
     return retval;
  ok: /* no match, not special case */
     retval = 0;
@@ -334,6 +510,7 @@ xpath_optimize_check(xpath_tree *xs,
 #ifdef XPATH_LIST_OPTIMIZE
     int          retval = -1;
     int          ret;
+    int          i;
     clixon_xvec *xvec = NULL;
 
     if (!_optimize_enable)
@@ -344,14 +521,16 @@ xpath_optimize_check(xpath_tree *xs,
     else if ((ret = xpath_list_optimize_fn(xs, xv, xvec)) < 0)
         goto done;
     else if (ret == 1){
-        if (xvec0 && *xvec0){
-            free(*xvec0);
-            *xvec0 = NULL;
+        /* Append to nodes found from previous context nodes */
+        if (*xvec0 == NULL){
+            if (clixon_xvec_extract(xvec, xvec0, xlen0, NULL) < 0)
+                goto done;
         }
-        if (clixon_xvec_extract(xvec, xvec0, xlen0, NULL) < 0){
-            goto done;
+        else {
+            for (i=0; i<clixon_xvec_len(xvec); i++)
+                if (cxvec_append(clixon_xvec_i(xvec, i), xvec0, xlen0) < 0)
+                    goto done;
         }
-        _optimize_hits++;
         retval = 1; /* Optimized */
         goto done;
     }
@@ -59,6 +59,7 @@
 #include <sys/stat.h>
 #include <sys/param.h>
 #include <netinet/in.h>
+#include <pthread.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -88,6 +89,7 @@
 #include "clixon_yang_parse_lib.h"
 #include "clixon_yang_cardinality.h"
 #include "clixon_yang_type.h"
+#include "clixon_regex.h"
 #include "clixon_yang_schema_mount.h"
 #include "clixon_yang_internal.h" /* internal included by this file only, not API */
 
@@ -183,8 +185,72 @@ static map_ptr2ptr *_yang_mymodule_map = NULL;
 /* See option CLICON_YANG_USE_ORIGINAL */
 static int _yang_use_orig = 0;
 
+/*! Set of yang statements having a data node descendant with a given name
+ *
+ * Sorted on pointer value for binary search
+ */
+struct yang_name_set{
+    yang_stmt **ns_vec;
+    int         ns_len;
+};
+
+/*! Per yang-spec cache of name -> yang_name_set
+ *
+ * @see yang_name_ancestors
+ */
+struct yang_name_cache{
+    qelem_t        yc_qelem;      /* List of caches, one per yang-spec */
+    yang_stmt     *yc_yspec;      /* Yang spec */
+    uint64_t       yc_generation; /* Value of _yang_generation when created */
+    clicon_hash_t *yc_hash;       /* name -> struct yang_name_set */
+};
+typedef struct yang_name_cache yang_name_cache;
+
+static yang_name_cache *_yang_name_caches = NULL;
+
+/* Incremented when yang statements are added or removed, invalidates name and child caches
+ * Atomic since yang statements may be created by parse threads, see YANG_PARSE_THREADS */
+static _Atomic uint64_t _yang_generation = 0;
+
+#ifdef YANG_FIND_INDEX
+/* Kinds of child index entries, stored in the two upper bits of an index slot */
+#define YX_EXACT     0  /* Keyword and argument */
+#define YX_KEYWORD   1  /* Keyword, first child with any argument */
+#define YX_ARGUMENT  2  /* Argument, first child with any keyword */
+#define YX_DATANODE  3  /* Argument, first data node child */
+#define YX_SHIFT     30
+#define YX_POSMASK   ((1U<<YX_SHIFT) - 1)
+
+/*! Hash index of the children of a yang statement
+ *
+ * A slot is 0 if empty, otherwise <kind> << YX_SHIFT | (child position + 1)
+ * Built on the second lookup without intermediate changes of the yang tree.
+ * @see yang_find
+ */
+struct yang_index {
+    uint64_t    yx_generation; /* Value of _yang_generation when last looked up */
+    uint32_t    yx_mask;       /* Nr of slots - 1 */
+    uint32_t   *yx_slots;      /* Hash table, NULL if not built */
+    uint32_t   *yx_trans;      /* Positions of choice/input/output children */
+    int         yx_ntrans;
+    yang_stmt **yx_incs;       /* Resolved included submodules, in order */
+    int         yx_nincs;
+};
+
+/* Protects all child indexes: yang_find and yang_find_datanode build, invalidate and read
+ * them, and are called by YANG parse threads and backend read threads as well as the main
+ * thread. Recursive since included submodules and choices are searched with the lock held
+ */
+static pthread_mutex_t _yang_index_mutex;
+static pthread_once_t  _yang_index_once = PTHREAD_ONCE_INIT;
+#endif /* YANG_FIND_INDEX */
+
 /* Forward static */
 static int yang_type_cache_free(yang_type_cache *ycache);
+static int yang_name_cache_free(yang_stmt *yspec);
+#ifdef YANG_FIND_INDEX
+static int yang_index_free(struct yang_index *yx);
+#endif
 
 /* Access functions
  */
@@ -253,6 +319,7 @@ yang_argument_set(yang_stmt *ys,
                   char      *arg)
 {
     ys->ys_argument = arg; /* not strdup/copied */
+    _yang_generation++;
     return 0;
 }
 
@@ -274,6 +341,7 @@ yang_argument_dup(yang_stmt *ys,
         return -1;
     }
     ys->ys_argument = dup; /* not strdup/copied */
+    _yang_generation++;
     return 0;
 }
 
@@ -775,8 +843,8 @@ yang_mymodule_set(yang_stmt *ys,
 
 /* End access functions */
 
-/* Stats */
-static uint64_t _stats_yang_nr = 0;
+/* Stats, atomic since yang statements may be created by parse threads, see YANG_PARSE_THREADS */
+static _Atomic uint64_t _stats_yang_nr = 0;
 
 /*! Get global statistics about YANG statements: created - freed
  *
@@ -822,6 +890,12 @@ yang_stats_one(yang_stmt *ys,
                  sz += cvec_size(yc->yc_regexps);
          }
          break;
+#ifdef YANG_IDENTITY_BITSET
+    case Y_IDENTITY:
+        if (ys->ys_identity)
+            sz += sizeof(struct yang_identity) + ys->ys_identity->yi_nwords*sizeof(uint64_t);
+        break;
+#endif
     case Y_MODULE:
     case Y_SUBMODULE:
         if (ys->ys_filename)
@@ -968,6 +1042,96 @@ yspec_new_shared(clixon_handle h,
     return yspec1;
 }
 
+/*! Get mounted yspec from top-level mount index
+ *
+ * @param[in]  ymounts  Top-level yang mounts
+ * @param[in]  yanglib  If 0 key is a canonical mount xpath, if 1 key is yang-library content
+ * @param[in]  key      Index key
+ * @param[out] yspecp   Mounted yspec, or NULL if not found
+ * @retval     1        Found, yspecp is set
+ * @retval     0        Not found or no index, search mount-points instead
+ * @note Mounts added without the index, eg with yspec_new_shared, are only found by search
+ * @see yang_mount_index_set
+ */
+int
+yang_mount_index_get(yang_stmt   *ymounts,
+                     int          yanglib,
+                     const char  *key,
+                     yang_stmt  **yspecp)
+{
+#ifdef YANG_SCHEMA_MOUNT_INDEX
+    struct yang_mount_index *ymi;
+    clicon_hash_t           *hash;
+    yang_stmt              **yp;
+
+    *yspecp = NULL;
+    if (ymounts == NULL || ymounts->ys_keyword != Y_MOUNTS)
+        return 0;
+    if ((ymi = ymounts->ys_mntindex) == NULL ||
+        (hash = yanglib ? ymi->ymi_yanglibs : ymi->ymi_xpaths) == NULL ||
+        (yp = clicon_hash_value(hash, key, NULL)) == NULL)
+        return 0;
+    *yspecp = *yp;
+    return 1;
+#else
+    *yspecp = NULL;
+    return 0;
+#endif
+}
+
+/*! Set or remove mounted yspec in top-level mount index
+ *
+ * @param[in]  ymounts  Top-level yang mounts
+ * @param[in]  yanglib  If 0 key is a canonical mount xpath, if 1 key is yang-library content
+ * @param[in]  key      Index key
+ * @param[in]  yspec    Mounted yspec (not consumed), if NULL remove key
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see yang_mount_index_get
+ */
+int
+yang_mount_index_set(yang_stmt  *ymounts,
+                     int         yanglib,
+                     const char *key,
+                     yang_stmt  *yspec)
+{
+    int                      retval = -1;
+#ifdef YANG_SCHEMA_MOUNT_INDEX
+    struct yang_mount_index *ymi;
+    clicon_hash_t          **hashp;
+
+    if (ymounts == NULL || ymounts->ys_keyword != Y_MOUNTS){
+        clixon_err(OE_YANG, EINVAL, "ymounts is not of type Y_MOUNTS");
+        goto done;
+    }
+    if ((ymi = ymounts->ys_mntindex) == NULL){
+        if (yspec == NULL)
+            goto ok;
+        if ((ymi = calloc(1, sizeof(*ymi))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        ymounts->ys_mntindex = ymi;
+    }
+    hashp = yanglib ? &ymi->ymi_yanglibs : &ymi->ymi_xpaths;
+    if (yspec == NULL){
+        if (*hashp && clicon_hash_lookup(*hashp, key) != NULL)
+            clicon_hash_del(*hashp, key);
+        goto ok;
+    }
+    if (*hashp == NULL && (*hashp = clicon_hash_init()) == NULL)
+        goto done;
+    if (clicon_hash_add(*hashp, key, &yspec, sizeof(yspec)) == NULL)
+        goto done;
+ ok:
+#endif
+    retval = 0;
+#ifdef YANG_SCHEMA_MOUNT_INDEX
+ done:
+#endif
+    return retval;
+}
+
 /*! Create new yang domain
  *
  * @param[in] h       Clixon handle
@@ -1068,6 +1232,12 @@ ys_free1(yang_stmt *ys,
     }
     if (ys->ys_stmt)
         free(ys->ys_stmt);
+#ifdef YANG_FIND_INDEX
+    if (ys->ys_index){
+        yang_index_free(ys->ys_index);
+        ys->ys_index = NULL;
+    }
+#endif
     switch (ys->ys_keyword) {     /* type-specifi union fields */
     case Y_ACTION:
         while((rc = ys->ys_action_cb) != NULL) {
@@ -1085,6 +1255,28 @@ ys_free1(yang_stmt *ys,
             ys->ys_typecache = NULL;
         }
         break;
+#ifdef YANG_SCHEMA_MOUNT_INDEX
+    case Y_MOUNTS:
+        if (ys->ys_mntindex){
+            if (ys->ys_mntindex->ymi_xpaths)
+                clicon_hash_free(ys->ys_mntindex->ymi_xpaths);
+            if (ys->ys_mntindex->ymi_yanglibs)
+                clicon_hash_free(ys->ys_mntindex->ymi_yanglibs);
+            free(ys->ys_mntindex);
+            ys->ys_mntindex = NULL;
+        }
+        break;
+#endif
+#ifdef YANG_IDENTITY_BITSET
+    case Y_IDENTITY:
+        if (ys->ys_identity){
+            if (ys->ys_identity->yi_derived)
+                free(ys->ys_identity->yi_derived);
+            free(ys->ys_identity);
+            ys->ys_identity = NULL;
+        }
+        break;
+#endif
     case Y_MODULE:
     case Y_SUBMODULE:
         if (ys->ys_filename)
@@ -1105,6 +1297,8 @@ ys_free1(yang_stmt *ys,
     default:
         break;
     }
+    if (ys->ys_keyword == Y_SPEC)
+        yang_name_cache_free(ys);
     if (self){
         free(ys);
         _stats_yang_nr--;
@@ -1140,6 +1334,7 @@ ys_prune(yang_stmt *yp,
     }
     yp->ys_len--;
     yp->ys_stmt[yp->ys_len] = NULL;
+    _yang_generation++;
  done:
     return yc;
 }
@@ -1197,6 +1392,7 @@ ys_freechildren(yang_stmt *ys)
         free(ys->ys_stmt);
         ys->ys_stmt = NULL;
     }
+    _yang_generation++;
     return 0;
 }
 
@@ -1232,6 +1428,7 @@ yn_realloc(yang_stmt *yn)
         return -1;
     }
     yn->ys_stmt[yn->ys_len - 1] = NULL; /* init field */
+    _yang_generation++;
 #ifdef OPTIMIZE_YSPEC_NAMESPACE
     if (yn->ys_keyword == Y_SPEC && yn->ys_nscache){         /* Clear cache */
         yspec_nscache_clear(yn);
@@ -1295,6 +1492,33 @@ uses_orig_ptr(enum rfc_6020 keyword)
         ;
 }
 
+/*! Read-only statements shared with the original node of a grouping expansion
+ *
+ * Only statements that are always accessed via yang_find, not by iterating the children,
+ * and that are not modified except by refine or deviation.
+ * @param[in] keyword  Yang keyword
+ * @retval    1        Statement is not copied, it is found in the original node
+ * @retval    0        Statement is copied
+ * @see YANG_USES_SHARED
+ */
+static int
+uses_shared_ptr(enum rfc_6020 keyword)
+{
+    return
+        keyword == Y_DESCRIPTION
+        || keyword == Y_ERROR_APP_TAG
+        || keyword == Y_ERROR_MESSAGE
+        || keyword == Y_MANDATORY
+        || keyword == Y_MAX_ELEMENTS
+        || keyword == Y_MIN_ELEMENTS
+        || keyword == Y_ORDERED_BY
+        || keyword == Y_PRESENCE
+        || keyword == Y_REFERENCE
+        || keyword == Y_STATUS
+        || keyword == Y_UNITS
+        ;
+}
+
 /*! Copy single yang statement no children
  *
  * @param[in] ynew  New empty (but created) yang statement (to)
@@ -1322,6 +1546,9 @@ ys_cp_one(yang_stmt *ynew,
     memcpy(ynew, yold, sz);
     yang_flag_reset(ynew, YANG_FLAG_WHEN); /* Dont inherit WHENs */
     ynew->ys_parent = NULL;
+#ifdef YANG_FIND_INDEX
+    ynew->ys_index = NULL;
+#endif
     if (yold->ys_stmt)
         if ((ynew->ys_stmt = calloc(yold->ys_len, sizeof(yang_stmt *))) == NULL){
             clixon_err(OE_YANG, errno, "calloc");
@@ -1353,6 +1580,11 @@ ys_cp_one(yang_stmt *ynew,
         if (yang_typecache_get(yold)) /* Dont copy type cache, use only original */
             yang_typecache_set(ynew, NULL);
         break;
+#ifdef YANG_IDENTITY_BITSET
+    case Y_IDENTITY: /* Copy is not numbered, derived-from falls back to derived list */
+        ynew->ys_identity = NULL;
+        break;
+#endif
 #ifdef OPTIMIZE_NO_PRESENCE_CONTAINER
     case Y_CONTAINER:
         yold->ys_nopres_cache = NULL;
@@ -1440,6 +1672,90 @@ ys_dup(yang_stmt *old)
     return nw;
 }
 
+/*! Create a copy of a grouping node sharing read-only statements with the original
+ *
+ * Statements according to uses_shared_ptr() are not copied, the new nodes are marked
+ * with YANG_FLAG_SHARED and yang_find looks up such statements in the original instead.
+ * Nodes derived from the original in other ways, eg refined, are copied as in ys_dup
+ * @param[in] old  Old existing yang statement (from)
+ * @retval    nw   New created yang statement
+ * @retval    NULL Error
+ * @see ys_dup
+ * @see yang_unshare  before modifying a shared node
+ */
+yang_stmt *
+ys_dup_shared(yang_stmt *old)
+{
+    yang_stmt *nw;
+    yang_stmt *yco;
+    yang_stmt *ycn;
+    int        i;
+    int        j;
+
+    if (yang_orig_get(old) != NULL && yang_flag_get(old, YANG_FLAG_SHARED) == 0)
+        return ys_dup(old);
+    if ((nw = ys_new(old->ys_keyword)) == NULL)
+        return NULL;
+    if (ys_cp_one(nw, old) < 0)
+        goto fail;
+    yang_orig_set(nw, old);
+    yang_flag_set(nw, YANG_FLAG_SHARED);
+    for (i=0,j=0; i<old->ys_len; i++){
+        yco = old->ys_stmt[i];
+        if (uses_shared_ptr(yang_keyword_get(yco))) {
+            nw->ys_len--;
+            continue;
+        }
+        if ((ycn = ys_dup_shared(yco)) == NULL)
+            goto fail;
+        nw->ys_stmt[j++] = ycn;
+        ycn->ys_parent = nw;
+    }
+    return nw;
+ fail:
+    ys_free(nw);
+    return NULL;
+}
+
+/*! Copy the shared statements of a node from its original before it is modified
+ *
+ * No-op unless the node is marked with YANG_FLAG_SHARED
+ * @param[in] ys  Yang statement node
+ * @retval    0   OK
+ * @retval   -1   Error
+ * @see ys_dup_shared
+ */
+int
+yang_unshare(yang_stmt *ys)
+{
+    int        retval = -1;
+    yang_stmt *yorig;
+    yang_stmt *yc;
+    yang_stmt *yc1;
+    int        inext;
+
+    if (yang_flag_get(ys, YANG_FLAG_SHARED) == 0)
+        goto ok;
+    yang_flag_reset(ys, YANG_FLAG_SHARED);
+    if ((yorig = yang_orig_get(ys)) == NULL)
+        goto ok;
+    inext = 0;
+    while ((yc = yn_iter(yorig, &inext)) != NULL) {
+        if (!uses_shared_ptr(yang_keyword_get(yc)))
+            continue;
+        if ((yc1 = ys_dup(yc)) == NULL)
+            goto done;
+        if (yn_insert(ys, yc1) < 0){
+            ys_free(yc1);
+            goto done;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Replace yold with ynew (insert ynew at the exact place of yold). Keep yold pointer as-is.
  *
  * @param[in] yorig  Existing yang statement
@@ -1540,6 +1856,291 @@ yn_iter(yang_stmt *yparent,
     return yc;
 }
 
+/*! Notify that yang statements have been modified without using the yang API
+ *
+ * Invalidates caches derived from the yang tree, such as child indexes and name caches.
+ * Call after modifying the children vector of a yang statement directly
+ * @retval  0   OK
+ */
+int
+yang_changed(void)
+{
+    _yang_generation++;
+    return 0;
+}
+
+#ifdef YANG_FIND_INDEX
+/*! Free child index
+ */
+static int
+yang_index_free(struct yang_index *yx)
+{
+    if (yx->yx_slots)
+        free(yx->yx_slots);
+    if (yx->yx_trans)
+        free(yx->yx_trans);
+    if (yx->yx_incs)
+        free(yx->yx_incs);
+    free(yx);
+    return 0;
+}
+
+/*! Hash of child index key (FNV-1a)
+ */
+static uint32_t
+yang_index_hash(int         kind,
+                int         keyword,
+                const char *argument)
+{
+    uint32_t h = 2166136261U;
+
+    h = (h ^ (uint32_t)kind) * 16777619U;
+    h = (h ^ (uint32_t)keyword) * 16777619U;
+    if (argument)
+        while (*argument)
+            h = (h ^ (uint8_t)*argument++) * 16777619U;
+    return h;
+}
+
+/*! Check if child matches child index key
+ */
+static int
+yang_index_match(yang_stmt  *ys,
+                 int         kind,
+                 int         keyword,
+                 const char *argument)
+{
+    switch (kind){
+    case YX_EXACT:
+        return ys->ys_keyword == keyword && strcmp(ys->ys_argument, argument) == 0;
+    case YX_KEYWORD:
+        return ys->ys_keyword == keyword;
+    default:
+        return strcmp(ys->ys_argument, argument) == 0;
+    }
+}
+
+/*! Lookup child in index
+ *
+ * @param[in]  yn       Yang statement
+ * @param[in]  yx       Built child index of yn
+ * @param[in]  kind     Kind of entry, see YX_EXACT and others
+ * @param[in]  keyword  Keyword, 0 if not used by kind
+ * @param[in]  argument Argument, NULL if not used by kind
+ * @param[out] pos      Position of child
+ * @retval     ys       First matching child
+ * @retval     NULL     No match
+ */
+static yang_stmt *
+yang_index_lookup(yang_stmt         *yn,
+                  struct yang_index *yx,
+                  int                kind,
+                  int                keyword,
+                  const char        *argument,
+                  uint32_t          *pos)
+{
+    uint32_t   i;
+    uint32_t   slot;
+    yang_stmt *ys;
+
+    i = yang_index_hash(kind, keyword, argument) & yx->yx_mask;
+    while ((slot = yx->yx_slots[i]) != 0){
+        if ((slot >> YX_SHIFT) == kind){
+            ys = yn->ys_stmt[(slot & YX_POSMASK) - 1];
+            if (yang_index_match(ys, kind, keyword, argument)){
+                if (pos)
+                    *pos = (slot & YX_POSMASK) - 1;
+                return ys;
+            }
+        }
+        i = (i + 1) & yx->yx_mask;
+    }
+    return NULL;
+}
+
+/*! Add child to index unless an earlier child already has the same key
+ */
+static void
+yang_index_add(yang_stmt         *yn,
+               struct yang_index *yx,
+               int                kind,
+               uint32_t           pos)
+{
+    yang_stmt *ys = yn->ys_stmt[pos];
+    uint32_t   i;
+    uint32_t   slot;
+
+    switch (kind){
+    case YX_EXACT:
+        i = yang_index_hash(kind, ys->ys_keyword, ys->ys_argument);
+        break;
+    case YX_KEYWORD:
+        i = yang_index_hash(kind, ys->ys_keyword, NULL);
+        break;
+    default:
+        i = yang_index_hash(kind, 0, ys->ys_argument);
+        break;
+    }
+    i &= yx->yx_mask;
+    while ((slot = yx->yx_slots[i]) != 0){
+        if ((slot >> YX_SHIFT) == kind &&
+            yang_index_match(yn->ys_stmt[(slot & YX_POSMASK) - 1], kind,
+                             ys->ys_keyword, ys->ys_argument))
+            return;
+        i = (i + 1) & yx->yx_mask;
+    }
+    yx->yx_slots[i] = ((uint32_t)kind << YX_SHIFT) | (pos + 1);
+}
+
+/*! Build child index of yang statement
+ *
+ * @param[in]  yn   Yang statement
+ * @param[in]  yx   Empty child index
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+yang_index_build(yang_stmt         *yn,
+                 struct yang_index *yx)
+{
+    int           retval = -1;
+    uint32_t      size;
+    uint32_t      pos;
+    yang_stmt    *ys;
+    yang_stmt    *yspec = NULL;
+    enum rfc_6020 keyw;
+    int           module;
+
+    /* At most four entries per child, at most half full */
+    for (size = 16; size < 8 * (uint32_t)yn->ys_len; size <<= 1)
+        ;
+    if ((yx->yx_slots = calloc(size, sizeof(uint32_t))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    yx->yx_mask = size - 1;
+    module = yn->ys_keyword == Y_MODULE || yn->ys_keyword == Y_SUBMODULE;
+    if (module)
+        yspec = ys_spec(yn);
+    for (pos=0; pos<yn->ys_len; pos++){
+        if ((ys = yn->ys_stmt[pos]) == NULL)
+            continue;
+        keyw = ys->ys_keyword;
+        yang_index_add(yn, yx, YX_KEYWORD, pos);
+        if (keyw == Y_CHOICE || keyw == Y_INPUT || keyw == Y_OUTPUT){
+            if ((yx->yx_trans = realloc(yx->yx_trans, (yx->yx_ntrans+1)*sizeof(uint32_t))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            yx->yx_trans[yx->yx_ntrans++] = pos;
+        }
+        if (module && keyw == Y_INCLUDE && yspec != NULL &&
+            (ys = yang_find_module_by_name(yspec, ys->ys_argument)) != NULL){
+            if ((yx->yx_incs = realloc(yx->yx_incs, (yx->yx_nincs+1)*sizeof(yang_stmt *))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            yx->yx_incs[yx->yx_nincs++] = ys;
+            ys = yn->ys_stmt[pos];
+        }
+        if (ys->ys_argument == NULL)
+            continue;
+        yang_index_add(yn, yx, YX_EXACT, pos);
+        yang_index_add(yn, yx, YX_ARGUMENT, pos);
+        if (yang_datanode(ys))
+            yang_index_add(yn, yx, YX_DATANODE, pos);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Create recursive child index mutex, called once
+ */
+static void
+yang_index_mutex_init(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&_yang_index_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+/*! Lock child indexes if yang statement has enough children to be indexed
+ *
+ * @param[in]  yn   Yang statement
+ * @retval     1    Locked, call yang_index_get and then yang_index_unlock
+ * @retval     0    Not indexed, not locked, search linearly
+ */
+static int
+yang_index_lock(yang_stmt *yn)
+{
+    if (yn->ys_len < YANG_FIND_INDEX || yn->ys_len > YX_POSMASK)
+        return 0;
+    pthread_once(&_yang_index_once, yang_index_mutex_init);
+    pthread_mutex_lock(&_yang_index_mutex);
+    return 1;
+}
+
+/*! Unlock child indexes
+ */
+static void
+yang_index_unlock(void)
+{
+    pthread_mutex_unlock(&_yang_index_mutex);
+}
+
+/*! Get child index of yang statement, build it if needed
+ *
+ * The index is built on the second lookup if the yang tree has not changed since the first,
+ * to avoid building indexes while the tree is being parsed and expanded.
+ * A lookup may thus allocate, free or build the index, so the caller must hold the lock of
+ * yang_index_lock while getting and using the index.
+ * @param[in]  yn   Yang statement
+ * @retval     yx   Child index
+ * @retval     NULL Not available, search linearly
+ */
+static struct yang_index *
+yang_index_get(yang_stmt *yn)
+{
+    struct yang_index *yx;
+
+    if ((yx = yn->ys_index) == NULL){
+        if ((yx = calloc(1, sizeof(*yx))) == NULL)
+            return NULL;
+        yx->yx_generation = _yang_generation;
+        yn->ys_index = yx;
+        return NULL;
+    }
+    if (yx->yx_generation != _yang_generation){
+        if (yx->yx_slots){
+            free(yx->yx_slots);
+            yx->yx_slots = NULL;
+        }
+        if (yx->yx_trans){
+            free(yx->yx_trans);
+            yx->yx_trans = NULL;
+        }
+        yx->yx_ntrans = 0;
+        if (yx->yx_incs){
+            free(yx->yx_incs);
+            yx->yx_incs = NULL;
+        }
+        yx->yx_nincs = 0;
+        yx->yx_generation = _yang_generation;
+        return NULL;
+    }
+    if (yx->yx_slots == NULL && yang_index_build(yn, yx) < 0){
+        yn->ys_index = NULL;
+        yang_index_free(yx);
+        return NULL;
+    }
+    return yx;
+}
+#endif /* YANG_FIND_INDEX */
+
 /*! Find first child yang_stmt with matching keyword and argument
  *
  * Find child given keyword and argument.
@@ -1565,12 +2166,39 @@ yang_find(yang_stmt  *yn,
     yang_stmt *yspec;
     yang_stmt *ym;
     yang_stmt *yorig;
+#ifdef YANG_FIND_INDEX
+    struct yang_index *yx;
+#endif
 
     if (_yang_use_orig &&
         (yorig = yang_orig_get(yn)) != NULL &&
         uses_orig_ptr(keyword)){
         return yang_find(yorig, keyword, argument);
     }
+    if (yang_flag_get(yn, YANG_FLAG_SHARED) &&
+        uses_shared_ptr(keyword) &&
+        (yorig = yang_orig_get(yn)) != NULL){
+        return yang_find(yorig, keyword, argument);
+    }
+#ifdef YANG_FIND_INDEX
+    if ((keyword != 0 || argument != NULL) &&
+        yang_index_lock(yn)){
+        if ((yx = yang_index_get(yn)) != NULL){
+            if (keyword == 0)
+                yret = yang_index_lookup(yn, yx, YX_ARGUMENT, 0, argument, NULL);
+            else if (argument == NULL)
+                yret = yang_index_lookup(yn, yx, YX_KEYWORD, keyword, NULL, NULL);
+            else
+                yret = yang_index_lookup(yn, yx, YX_EXACT, keyword, argument, NULL);
+            if (yret == NULL && keyword != Y_NAMESPACE)
+                for (i=0; i<yx->yx_nincs && yret == NULL; i++)
+                    yret = yang_find(yx->yx_incs[i], keyword, argument);
+            yang_index_unlock();
+            return yret;
+        }
+        yang_index_unlock();
+    }
+#endif
     for (i=0; i<yn->ys_len; i++){
         ys = yn->ys_stmt[i];
         if (keyword == 0 || ys->ys_keyword == keyword){
@@ -1598,6 +2226,36 @@ yang_find(yang_stmt  *yn,
     return yret?yret:yretsub;
 }
 
+/*! Find data node with matching argument in the cases of a choice
+ *
+ * @param[in]  ys         Yang choice statement
+ * @param[in]  argument   Argument that data node should match with
+ * @retval     ymatch     Matching data node
+ * @retval     NULL       No match
+ * @see yang_find_datanode
+ */
+static yang_stmt *
+yang_find_datanode_choice(yang_stmt *ys,
+                          char      *argument)
+{
+    yang_stmt *yc = NULL;
+    yang_stmt *ysmatch = NULL;
+    int        inext = 0;
+
+    while ((yc = yn_iter(ys, &inext)) != NULL){
+        if (yang_keyword_get(yc) == Y_CASE) /* Look for its children */
+            ysmatch = yang_find_datanode(yc, argument);
+        else
+            if (yang_datanode(yc)){
+                if (yc->ys_argument && strcmp(argument, yc->ys_argument) == 0)
+                    ysmatch = yc;
+            }
+        if (ysmatch)
+            break;
+    }
+    return ysmatch;
+}
+
 /*! Find child data node with matching argument (container, leaf, list, leaf-list)
  *
  * @param[in]  yn         Yang node, current context node.
@@ -1619,23 +2277,42 @@ yang_find_datanode(yang_stmt *yn,
     yang_stmt *ysmatch = NULL;
     char      *name;
     int        inext;
-    int        inext2;
-
+#ifdef YANG_FIND_INDEX
+    struct yang_index *yx;
+    uint32_t           pos = 0;
+    int                i;
+
+    if (argument != NULL &&
+        yang_index_lock(yn)){
+        if ((yx = yang_index_get(yn)) != NULL){
+            ysmatch = yang_index_lookup(yn, yx, YX_DATANODE, 0, argument, &pos);
+            /* Choice, input and output children before a direct match are searched first */
+            for (i=0; i<yx->yx_ntrans; i++){
+                if (ysmatch && yx->yx_trans[i] > pos)
+                    break;
+                ys = yn->ys_stmt[yx->yx_trans[i]];
+                if (yang_keyword_get(ys) == Y_CHOICE)
+                    yc = yang_find_datanode_choice(ys, argument);
+                else
+                    yc = yang_find_datanode(ys, argument);
+                if (yc){
+                    ysmatch = yc;
+                    break;
+                }
+            }
+            for (i=0; i<yx->yx_nincs && ysmatch == NULL; i++)
+                ysmatch = yang_find_datanode(yx->yx_incs[i], argument);
+            yang_index_unlock();
+            goto done;
+        }
+        yang_index_unlock();
+    }
+#endif
     inext = 0;
     while ((ys = yn_iter(yn, &inext)) != NULL){
         if (yang_keyword_get(ys) == Y_CHOICE){ /* Look for its children */
-            inext2 = 0;
-            while ((yc = yn_iter(ys, &inext2)) != NULL){
-                if (yang_keyword_get(yc) == Y_CASE) /* Look for its children */
-                    ysmatch = yang_find_datanode(yc, argument);
-                else
-                    if (yang_datanode(yc)){
-                        if (yc->ys_argument && strcmp(argument, yc->ys_argument) == 0)
-                            ysmatch = yc;
-                    }
-                if (ysmatch)
-                    goto done; // maybe break?
-            }
+            if ((ysmatch = yang_find_datanode_choice(ys, argument)) != NULL)
+                goto done; // maybe break?
         } /* Y_CHOICE */
         else if (yang_keyword_get(ys) == Y_INPUT ||
                  yang_keyword_get(ys) == Y_OUTPUT){ /* Look for its children */
@@ -2562,11 +3239,24 @@ yang_print_cbuf(cbuf      *cb,
     enum rfc_6020 keyw;
     char         *arg;
     int           inext;
+    yang_stmt    *yorig = NULL;
+    yang_stmt    *yo;
+    int           inext0;
+    int           len;
 
     if (yn == NULL || cb == NULL){
         clixon_err(OE_YANG, EINVAL, "cb or yn is NULL");
         goto done;
     }
+    len = yang_len_get(yn);
+    /* Shared statements are printed from the original, see ys_dup_shared */
+    if (yang_flag_get(yn, YANG_FLAG_SHARED) &&
+        (yorig = yang_orig_get(yn)) != NULL){
+        inext0 = 0;
+        while ((yo = yn_iter(yorig, &inext0)) != NULL)
+            if (uses_shared_ptr(yang_keyword_get(yo)))
+                len++;
+    }
     keyw = yang_keyword_get(yn);
     if (keyw == Y_UNKNOWN){ /* dont print unknown - proxy for extension*/
         if (pretty)
@@ -2586,11 +3276,23 @@ yang_print_cbuf(cbuf      *cb,
             cprintf(cb, " %s", arg);
     }
     //    cprintf(cb, " %p ", yn);  For debugging object ptr
-    if (yang_len_get(yn)){
+    if (len){
         cprintf(cb, " {");
         if (pretty)
             cprintf(cb, "\n");
         inext = 0;
+        if (yorig){
+            /* Keep the order of the original statements */
+            inext0 = 0;
+            while ((yo = yn_iter(yorig, &inext0)) != NULL) {
+                if (uses_shared_ptr(yang_keyword_get(yo)))
+                    ys = yo;
+                else if ((ys = yn_iter(yn, &inext)) == NULL)
+                    continue;
+                if (yang_print_cbuf(cb, ys, marginal + PRETTYPRINT_INDENT, pretty) < 0)
+                    goto done;
+            }
+        }
         while ((ys = yn_iter(yn, &inext)) != NULL) {
             if (yang_print_cbuf(cb, ys, marginal + PRETTYPRINT_INDENT, pretty) < 0)
                 goto done;
@@ -2658,6 +3360,9 @@ yang_deviation(yang_stmt *ys,
            goto done;
         */
     }
+    /* Target may share statements with original grouping node, copy before modifying */
+    if (yang_unshare(ytarget) < 0)
+        goto done;
     /* Go through deviates of deviation */
     inext0 = 0;
     while ((yd = yn_iter(ys, &inext0)) != NULL) {
@@ -3174,6 +3879,66 @@ ys_populate_type(clixon_handle h,
     return retval;
 }
 
+#ifdef YANG_IDENTITY_BITSET
+/* Next identity number. Numbers are unique in the process, not only per yang-spec */
+static uint32_t _yang_identity_nr = 0;
+
+/*! Get identity number and bitset struct, number the identity if not done before
+ *
+ * @param[in] ys    Yang identity statement
+ * @retval    yi    Identity struct
+ * @retval    NULL  Error
+ */
+static struct yang_identity *
+ys_identity_number(yang_stmt *ys)
+{
+    struct yang_identity *yi;
+
+    if ((yi = ys->ys_identity) == NULL){
+        if ((yi = calloc(1, sizeof(*yi))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            return NULL;
+        }
+        yi->yi_nr = _yang_identity_nr++;
+        ys->ys_identity = yi;
+    }
+    return yi;
+}
+
+/*! Mark identity as derived from base identity in the bitset of the base
+ *
+ * @param[in] ybaseid  Base identity
+ * @param[in] yid      Identity derived from ybaseid
+ * @retval    0        OK
+ * @retval   -1        Error
+ */
+static int
+ys_identity_derived_set(yang_stmt *ybaseid,
+                        yang_stmt *yid)
+{
+    struct yang_identity *yb;
+    struct yang_identity *yi;
+    uint32_t              nwords;
+    uint64_t             *vec;
+
+    if ((yb = ys_identity_number(ybaseid)) == NULL ||
+        (yi = ys_identity_number(yid)) == NULL)
+        return -1;
+    if (yi->yi_nr/64 >= yb->yi_nwords){
+        nwords = yi->yi_nr/64 + 1;
+        if ((vec = realloc(yb->yi_derived, nwords*sizeof(uint64_t))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        memset(vec + yb->yi_nwords, 0, (nwords - yb->yi_nwords)*sizeof(uint64_t));
+        yb->yi_derived = vec;
+        yb->yi_nwords = nwords;
+    }
+    yb->yi_derived[yi->yi_nr/64] |= (uint64_t)1 << (yi->yi_nr%64);
+    return 0;
+}
+#endif /* YANG_IDENTITY_BITSET */
+
 /*! Sanity check yang identity statement recursively and create derived id list
  *
  * Find base identities if any and add this identity to derived identity list.
@@ -3183,6 +3948,7 @@ ys_populate_type(clixon_handle h,
  * @param[in] h     Clixon handle
  * @param[in] ys    The yang identity to populate.
  * @param[in] idref If set contains the derived identifier(NULL on top call)
+ * @param[in] yid   If set the derived identity statement (NULL on top call)
  * @retval    0     OK
  * @retval   -1     Error
  * @see validate_identityref  which in runtime validates actual values
@@ -3190,7 +3956,8 @@ ys_populate_type(clixon_handle h,
 static int
 ys_populate_identity(clixon_handle h,
                      yang_stmt    *ys,
-                     char         *idref)
+                     char         *idref,
+                     yang_stmt    *yid)
 {
     int             retval = -1;
     yang_stmt      *yc = NULL;
@@ -3220,6 +3987,11 @@ ys_populate_identity(clixon_handle h,
         }
         cprintf(cb, "%s:%s", yang_argument_get(ymod), id);
         idref = cbuf_get(cb);
+        yid = ys;
+#ifdef YANG_IDENTITY_BITSET
+        if (ys_identity_number(ys) == NULL)
+            goto done;
+#endif
     }
     /* Iterate through all base statements and check the base identity exists 
      * AND populate the base identity recursively
@@ -3245,8 +4017,12 @@ ys_populate_identity(clixon_handle h,
             clixon_err(OE_UNIX, errno, "cv_new");
             goto done;
         }
+#ifdef YANG_IDENTITY_BITSET
+        if (ys_identity_derived_set(ybaseid, yid) < 0)
+            goto done;
+#endif
         /* Transitive to the root */
-        if (ys_populate_identity(h, ybaseid, idref) < 0)
+        if (ys_populate_identity(h, ybaseid, idref, yid) < 0)
             goto done;
     }
     retval = 0;
@@ -3260,6 +4036,109 @@ ys_populate_identity(clixon_handle h,
     return retval;
 }
 
+/*! Check if an identity is derived from a base identity using the derived bitset
+ *
+ * @param[in]  ybaseid  Base identity
+ * @param[in]  yid      Identity to check, or NULL if not found
+ * @param[out] derived  1 if yid is derived from ybaseid (not itself), 0 if not
+ * @retval     1        OK, derived is set
+ * @retval     0        Identities not numbered, check the derived list instead
+ * @see validate_identityref
+ * @see yang_identity_bitset_build
+ */
+int
+yang_identity_derived(yang_stmt *ybaseid,
+                      yang_stmt *yid,
+                      int       *derived)
+{
+#ifdef YANG_IDENTITY_BITSET
+    struct yang_identity *yb;
+    uint32_t              nr;
+
+    if ((yb = ybaseid->ys_identity) == NULL)
+        return 0;
+    if (yid == NULL){
+        *derived = 0;
+        return 1;
+    }
+    if (yid->ys_identity == NULL)
+        return 0;
+    nr = yid->ys_identity->yi_nr;
+    *derived = nr/64 < yb->yi_nwords &&
+        (yb->yi_derived[nr/64] & ((uint64_t)1 << (nr%64))) != 0;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/*! Number identities and build derived bitsets from the derived identity lists
+ *
+ * Used when the derived lists are set without populating identities, such as when
+ * loading a yang-spec from the yang cache.
+ * @param[in] yspec  Yang spec
+ * @retval    0      OK
+ * @retval   -1      Error
+ * @see ys_populate_identity  Builds bitsets when populating
+ */
+int
+yang_identity_bitset_build(yang_stmt *yspec)
+{
+    int        retval = -1;
+#ifdef YANG_IDENTITY_BITSET
+    yang_stmt *ymod;
+    yang_stmt *ybaseid;
+    yang_stmt *ym;
+    yang_stmt *yid;
+    cg_var    *cv;
+    char      *modname = NULL;
+    char      *id = NULL;
+    int        inext;
+    int        inext2;
+
+    inext = 0;
+    while ((ymod = yn_iter(yspec, &inext)) != NULL) {
+        if (ymod->ys_keyword != Y_MODULE && ymod->ys_keyword != Y_SUBMODULE)
+            continue;
+        inext2 = 0;
+        while ((ybaseid = yn_iter(ymod, &inext2)) != NULL) {
+            if (ybaseid->ys_keyword != Y_IDENTITY)
+                continue;
+            if (ys_identity_number(ybaseid) == NULL)
+                goto done;
+            cv = NULL;
+            while ((cv = cvec_each(ybaseid->ys_cvec, cv)) != NULL){
+                if (nodeid_split(cv_name_get(cv), &modname, &id) < 0)
+                    goto done;
+                if (modname &&
+                    ((ym = yang_find(yspec, Y_MODULE, modname)) != NULL ||
+                     (ym = yang_find(yspec, Y_SUBMODULE, modname)) != NULL) &&
+                    (yid = yang_find(ym, Y_IDENTITY, id)) != NULL &&
+                    ys_identity_derived_set(ybaseid, yid) < 0)
+                    goto done;
+                if (modname){
+                    free(modname);
+                    modname = NULL;
+                }
+                if (id){
+                    free(id);
+                    id = NULL;
+                }
+            }
+        }
+    }
+    retval = 0;
+ done:
+    if (modname)
+        free(modname);
+    if (id)
+        free(id);
+#else
+    retval = 0;
+#endif
+    return retval;
+}
+
 /*! Return 1 if feature is enabled, 0 if not using the populated yang tree
  *
  * @param[in] yspec   yang specification
@@ -3539,7 +4418,7 @@ ys_populate(yang_stmt    *ys,
 
     switch(ys->ys_keyword){
     case Y_IDENTITY:
-        if (ys_populate_identity(h, ys, NULL) < 0)
+        if (ys_populate_identity(h, ys, NULL, NULL) < 0)
             goto done;
         break;
     case Y_LENGTH:
@@ -3692,6 +4571,7 @@ yang_features(clixon_handle h,
                         yt->ys_stmt[j-1] = yt->ys_stmt[j];
                     yt->ys_len--;
                     yt->ys_stmt[yt->ys_len] = NULL;
+                    _yang_generation++;
                     ys_free(ys);
                     continue; /* Don't increment i */
                     break;
@@ -4244,6 +5124,12 @@ yang_type_cache_set2(yang_stmt *ys,
             goto done;
         }
     }
+#ifdef YANG_TYPE_VALIDATOR
+    if (resolved != NULL &&
+        yang_type_validator_new(resolved, options, ycache->yc_cvv, ycache->yc_regexps,
+                                fraction, &ycache->yc_validator) < 0)
+        goto done;
+#endif
     retval = 0;
  done:
     return retval;
@@ -4298,6 +5184,25 @@ yang_type_cache_get2(yang_stmt  *ytype,
     return retval;
 }
 
+/*! Get compiled validator from yang type cache
+ *
+ * @param[in] ytype  Yang type statement
+ * @retval    yv     Compiled validator
+ * @retval    NULL   No cache or not compiled
+ * @see YANG_TYPE_VALIDATOR
+ */
+struct yang_type_validator *
+yang_type_cache_validator(yang_stmt *ytype)
+{
+#ifdef YANG_TYPE_VALIDATOR
+    yang_type_cache *ycache;
+
+    if ((ycache = yang_typecache_get(ytype)) != NULL)
+        return ycache->yc_validator;
+#endif
+    return NULL;
+}
+
 /*! Free yang type cache
  */
 static int
@@ -4306,6 +5211,10 @@ yang_type_cache_free(yang_type_cache *ycache)
     cg_var *cv;
     void   *p;
 
+#ifdef YANG_TYPE_VALIDATOR
+    if (ycache->yc_validator)
+        yang_type_validator_free(ycache->yc_validator);
+#endif
     if (ycache->yc_cvv)
         cvec_free(ycache->yc_cvv);
     if (ycache->yc_patterns)
@@ -4329,6 +5238,10 @@ yang_type_cache_free(yang_type_cache *ycache)
                     cv_void_set(cv, NULL);
                 }
                 break;
+            case REGEXP_PCRE2:
+                regex_pcre2_free(cv_void_get(cv));
+                cv_void_set(cv, NULL);
+                break;
             default:
                 break;
             }
@@ -4693,6 +5606,196 @@ yang_init(clixon_handle h)
     return retval;
 }
 
+/*! Compare yang statement pointers, for qsort and bsearch
+ */
+static int
+yang_ptr_cmp(const void *a,
+             const void *b)
+{
+    uintptr_t pa = (uintptr_t)*(yang_stmt **)a;
+    uintptr_t pb = (uintptr_t)*(yang_stmt **)b;
+
+    return pa < pb ? -1 : pa > pb ? 1 : 0;
+}
+
+/*! Collect all ancestors of data nodes named name
+ *
+ * Ancestors of anydata and mount-points are also collected since they may contain any name.
+ * Groupings are skipped since uses are expanded in the data tree
+ * @param[in]     ys    Yang statement
+ * @param[in]     name  Data node name
+ * @param[in,out] ns    Set of ancestors, unsorted and with duplicates
+ */
+static int
+yang_name_collect(yang_stmt            *ys,
+                  const char           *name,
+                  struct yang_name_set *ns)
+{
+    yang_stmt *yc;
+    yang_stmt *yp;
+    int        i;
+
+    for (i=0; i<ys->ys_len; i++){
+        if ((yc = ys->ys_stmt[i]) == NULL)
+            continue;
+        if (yc->ys_keyword == Y_GROUPING)
+            continue;
+        /* Anydata and mount-points may contain any name */
+        if (yang_datanode(yc) &&
+            (strcmp(yc->ys_argument, name) == 0 ||
+             yc->ys_keyword == Y_ANYDATA ||
+             yc->ys_keyword == Y_ANYXML ||
+             yang_flag_get(yc, YANG_FLAG_MTPOINT_POTENTIAL) != 0)){
+            for (yp = ys; yp && yp->ys_keyword != Y_SPEC; yp = yp->ys_parent){
+                if ((ns->ns_vec = realloc(ns->ns_vec, (ns->ns_len+1)*sizeof(yang_stmt *))) == NULL){
+                    clixon_err(OE_UNIX, errno, "realloc");
+                    return -1;
+                }
+                ns->ns_vec[ns->ns_len++] = yp;
+            }
+        }
+        if (yang_name_collect(yc, name, ns) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Free name cache of a yang spec
+ *
+ * @param[in]  yspec  Yang spec
+ */
+static int
+yang_name_cache_free(yang_stmt *yspec)
+{
+    yang_name_cache      *yc;
+    struct yang_name_set *ns;
+    char                **keys = NULL;
+    size_t                klen = 0;
+    int                   i;
+
+    if ((yc = _yang_name_caches) != NULL){
+        do {
+            if (yc->yc_yspec == yspec)
+                break;
+            yc = NEXTQ(yang_name_cache *, yc);
+        } while (yc && yc != _yang_name_caches);
+        if (yc == NULL || yc->yc_yspec != yspec)
+            return 0;
+        DELQ(yc, _yang_name_caches, yang_name_cache *);
+        if (yc->yc_hash){
+            if (clicon_hash_keys(yc->yc_hash, &keys, &klen) == 0){
+                for (i=0; i<klen; i++)
+                    if ((ns = clicon_hash_value(yc->yc_hash, keys[i], NULL)) != NULL &&
+                        ns->ns_vec)
+                        free(ns->ns_vec);
+            }
+            if (keys)
+                free(keys);
+            clicon_hash_free(yc->yc_hash);
+        }
+        free(yc);
+    }
+    return 0;
+}
+
+/*! Get set of yang statements that may have a data node descendant with a given name
+ *
+ * Used to prune descendant searches, such as //name in XPath: an XML node whose yang
+ * statement is not in the set cannot have any such descendant.
+ * The set is computed once per yang-spec and name, and recomputed if the yang-spec changes.
+ * Anydata and mount-points are assumed to contain any name, but the caller needs to check
+ * those nodes themselves since their children are not in the same yang-spec.
+ * @param[in]  yspec  Yang spec
+ * @param[in]  name   Data node name (without prefix)
+ * @param[out] vec    Sorted vector of yang statements, do not free
+ * @param[out] len    Length of vec
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see yang_name_ancestor
+ */
+int
+yang_name_ancestors(yang_stmt   *yspec,
+                    const char  *name,
+                    yang_stmt ***vec,
+                    int         *len)
+{
+    int                   retval = -1;
+    yang_name_cache      *yc;
+    struct yang_name_set *ns;
+    struct yang_name_set  ns0 = {NULL, 0};
+    clicon_hash_t         h;
+    int                   i;
+    int                   j;
+
+    if ((yc = _yang_name_caches) != NULL){
+        do {
+            if (yc->yc_yspec == yspec)
+                break;
+            yc = NEXTQ(yang_name_cache *, yc);
+        } while (yc != _yang_name_caches);
+        if (yc->yc_yspec != yspec)
+            yc = NULL;
+    }
+    if (yc && yc->yc_generation != _yang_generation){
+        yang_name_cache_free(yspec);
+        yc = NULL;
+    }
+    if (yc == NULL){
+        if ((yc = malloc(sizeof(*yc))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(yc, 0, sizeof(*yc));
+        yc->yc_yspec = yspec;
+        yc->yc_generation = _yang_generation;
+        if ((yc->yc_hash = clicon_hash_init()) == NULL){
+            free(yc);
+            goto done;
+        }
+        ADDQ(yc, _yang_name_caches);
+    }
+    if ((ns = clicon_hash_value(yc->yc_hash, name, NULL)) == NULL){
+        if (yang_name_collect(yspec, name, &ns0) < 0)
+            goto done;
+        if (ns0.ns_len){
+            qsort(ns0.ns_vec, ns0.ns_len, sizeof(yang_stmt *), yang_ptr_cmp);
+            for (i=1, j=1; i<ns0.ns_len; i++)
+                if (ns0.ns_vec[i] != ns0.ns_vec[j-1])
+                    ns0.ns_vec[j++] = ns0.ns_vec[i];
+            ns0.ns_len = j;
+        }
+        if ((h = clicon_hash_add(yc->yc_hash, name, &ns0, sizeof(ns0))) == NULL)
+            goto done;
+        ns0.ns_vec = NULL;
+        ns = h->h_val;
+    }
+    *vec = ns->ns_vec;
+    *len = ns->ns_len;
+    retval = 0;
+ done:
+    if (ns0.ns_vec)
+        free(ns0.ns_vec);
+    return retval;
+}
+
+/*! Check if yang statement is in a set returned by yang_name_ancestors
+ *
+ * @param[in]  vec   Sorted vector of yang statements
+ * @param[in]  len   Length of vec
+ * @param[in]  ys    Yang statement
+ * @retval     1     Yes, ys may have a descendant with the name
+ * @retval     0     No
+ */
+int
+yang_name_ancestor(yang_stmt **vec,
+                   int         len,
+                   yang_stmt  *ys)
+{
+    if (len == 0)
+        return 0;
+    return bsearch(&ys, vec, len, sizeof(yang_stmt *), yang_ptr_cmp) != NULL;
+}
+
 /*! Start yang code. Called after yang options loaded
  *
  * Called after YANG config and -o options and plugins init
@@ -0,0 +1,1366 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2020-2025 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Precompiled YANG spec cache
+ *
+ * Every clixon process parses and post-processes (expands groupings, augments, resolves
+ * types, etc) all its YANG modules on startup. If CLICON_YANG_CACHE_DIR is set, the fully
+ * processed YANG spec of a process is saved in <dir>/<name>.yangcache and loaded directly
+ * on the next startup instead.
+ * The cache is only used if the clixon version, the YANG-related options, the set of YANG
+ * files in the YANG directories, the loaded plugins and the contents of all loaded YANG
+ * files are the same as when it was saved. Otherwise it is silently rebuilt.
+ *
+ * File format (native byte order, not portable between hosts):
+ *   magic, format version, clixon version, config hash
+ *   nr of files, <filename, content hash>*
+ *   nr of nodes, nodes in pre-order excluding the yang spec itself:
+ *     keyword, flags, nr of children, argument, line, orig, cv, cvec,
+ *     module filename (modules), type cache (types)
+ *   nr of when entries, <node, when>*
+ *   nr of my-module entries, <node, module>*
+ * Pointers between nodes are saved as pre-order indexes where 0 is the yang spec.
+ * Compiled regexps are not saved, they are compiled from the saved patterns on load.
+ * @note Side-effects of plugin extension callbacks outside of the YANG tree are not
+ *       replayed when the spec is loaded from the cache
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <syslog.h>
+#include <regex.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_file.h"
+#include "clixon_yang_module.h"
+#include "clixon_plugin.h"
+#include "clixon_data.h"
+#include "clixon_options.h"
+#include "clixon_yang_type.h"
+#include "clixon_yang_cache.h"
+#include "clixon_yang_internal.h" /* internal included by this file only, not API */
+
+/* Generated in build.c */
+extern const char CLIXON_VERSION[];
+
+/*! Cache file magic, first bytes of file including null */
+#define YANG_CACHE_MAGIC     "CLIXON-YANG-CACHE"
+
+/*! Cache file format version, increment when the format changes */
+#define YANG_CACHE_VERSION   1
+
+/*! Length of a NULL string */
+#define YANG_CACHE_NULL      0xffffffff
+
+/* FNV-1a 64-bit hash */
+#define YANG_CACHE_HASH_INIT  0xcbf29ce484222325ULL
+#define YANG_CACHE_HASH_PRIME 0x100000001b3ULL
+
+/*! Options apart from CLICON_YANG_* that affect which YANG is loaded */
+static const char *ycache_options[] = {
+    "CLICON_FEATURE",
+    "CLICON_XMLDB_MODSTATE",
+    "CLICON_BACKEND_RESTCONF_PROCESS",
+    "CLICON_STREAM_DISCOVERY_RFC5277",
+    "CLICON_STREAM_DISCOVERY_RFC8040",
+    "CLICON_XML_CHANGELOG",
+    "CLICON_NETCONF_MONITORING",
+    "CLICON_NACM_MODE",
+    NULL
+};
+
+/*! Pointer to index entry, used when saving */
+struct ycache_idx {
+    yang_stmt *yi_ys;
+    int        yi_idx;
+};
+
+/*! Save context */
+struct ycache_wr {
+    FILE              *yw_f;
+    yang_stmt        **yw_vec;   /* Nodes in pre-order, 0 is yang spec */
+    int                yw_len;
+    int                yw_max;
+    struct ycache_idx *yw_idx;   /* Nodes sorted on pointer */
+};
+
+/*! Saved type cache, applied after all nodes are read */
+struct ycache_type {
+    yang_stmt *yt_ys;
+    int32_t    yt_resolved;
+    uint32_t   yt_options;
+    uint8_t    yt_fraction;
+    cvec      *yt_cvv;
+    cvec      *yt_patterns;
+};
+
+/*! Load context */
+struct ycache_rd {
+    char               *yr_buf;
+    size_t              yr_len;
+    size_t              yr_off;
+    int                 yr_fail;  /* Format error: cache is ignored */
+    yang_stmt         **yr_vec;   /* Nodes in pre-order, 0 is yang spec */
+    int32_t            *yr_orig;  /* Orig index of each node */
+    int                 yr_nr;    /* Nodes read */
+    int                 yr_max;   /* Nodes in file */
+    struct ycache_type *yr_types;
+    int                 yr_ntypes;
+    int                 yr_maxtypes;
+};
+
+static uint64_t
+ycache_hash(uint64_t    hash,
+            const void *buf,
+            size_t      len)
+{
+    const uint8_t *p = buf;
+    size_t         i;
+
+    for (i=0; i<len; i++){
+        hash ^= p[i];
+        hash *= YANG_CACHE_HASH_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t
+ycache_hash_str(uint64_t    hash,
+                const char *str)
+{
+    if (str == NULL)
+        return ycache_hash(hash, "", 1);
+    return ycache_hash(hash, str, strlen(str)+1);
+}
+
+/*! Hash contents of a file
+ *
+ * @param[in]  filename  File
+ * @param[out] hash      Hash of contents
+ * @retval     1         OK
+ * @retval     0         File cannot be read
+ */
+static int
+ycache_file_hash(const char *filename,
+                 uint64_t   *hash)
+{
+    int     fd;
+    char    buf[8192];
+    ssize_t n;
+    uint64_t h = YANG_CACHE_HASH_INIT;
+
+    if ((fd = open(filename, O_RDONLY)) < 0)
+        return 0;
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+        h = ycache_hash(h, buf, n);
+    close(fd);
+    if (n < 0)
+        return 0;
+    *hash = h;
+    return 1;
+}
+
+/*! Hash YANG files found in a directory
+ *
+ * The hash is independent of the order files are found
+ * @param[in]     dir   Directory, searched recursively
+ * @param[in,out] hash  Sum of hashes of file names and paths
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+static int
+ycache_dir_hash(const char *dir,
+                uint64_t   *hash)
+{
+    int     retval = -1;
+    cvec   *cvv = NULL;
+    cg_var *cv = NULL;
+
+    if ((cvv = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    if (clicon_files_recursive(dir, "^.*\\.yang$", cvv) < 0)
+        goto done;
+    while ((cv = cvec_each(cvv, cv)) != NULL)
+        *hash += ycache_hash_str(ycache_hash_str(YANG_CACHE_HASH_INIT, cv_name_get(cv)),
+                                 cv_string_get(cv));
+    retval = 0;
+ done:
+    if (cvv)
+        cvec_free(cvv);
+    return retval;
+}
+
+/*! Compute hash of everything that decides which YANG files are loaded and how
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  name  Cache name
+ * @param[out] hash  Config hash
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+ycache_config_hash(clixon_handle h,
+                   const char   *name,
+                   uint64_t     *hash)
+{
+    int              retval = -1;
+    cxobj           *x;
+    cxobj           *xc;
+    char            *xname;
+    char            *dir;
+    uint64_t         hd = 0;
+    uint64_t         hh;
+    int              i;
+    clixon_plugin_t *cp = NULL;
+    struct stat      st;
+
+    hh = ycache_hash_str(YANG_CACHE_HASH_INIT, name);
+    if ((x = clicon_conf_xml(h)) != NULL){
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+            xname = xml_name(xc);
+            if (strncmp(xname, "CLICON_YANG", strlen("CLICON_YANG")) != 0){
+                for (i=0; ycache_options[i]; i++)
+                    if (strcmp(xname, ycache_options[i]) == 0)
+                        break;
+                if (ycache_options[i] == NULL)
+                    continue;
+            }
+            hh = ycache_hash_str(hh, xname);
+            hh = ycache_hash_str(hh, xml_body(xc));
+            if ((strcmp(xname, "CLICON_YANG_DIR") == 0 ||
+                 strcmp(xname, "CLICON_YANG_MAIN_DIR") == 0) &&
+                (dir = xml_body(xc)) != NULL)
+                if (ycache_dir_hash(dir, &hd) < 0)
+                    goto done;
+        }
+    }
+    hh = ycache_hash(hh, &hd, sizeof(hd));
+    /* Plugins may add YANG or change it in extension callbacks */
+    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+        hh = ycache_hash_str(hh, clixon_plugin_name_get(cp));
+        if (stat(clixon_plugin_name_get(cp), &st) == 0){
+            hh = ycache_hash(hh, &st.st_size, sizeof(st.st_size));
+            hh = ycache_hash(hh, &st.st_mtime, sizeof(st.st_mtime));
+        }
+    }
+    *hash = hh;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get cache filename
+ */
+static int
+ycache_filename(const char *dir,
+                const char *name,
+                cbuf       *cb)
+{
+    cprintf(cb, "%s/%s.yangcache", dir, name);
+    return 0;
+}
+
+/*
+ * Save
+ */
+static void
+ycw_u8(struct ycache_wr *yw,
+       uint8_t           v)
+{
+    fwrite(&v, sizeof(v), 1, yw->yw_f);
+}
+
+static void
+ycw_u16(struct ycache_wr *yw,
+        uint16_t          v)
+{
+    fwrite(&v, sizeof(v), 1, yw->yw_f);
+}
+
+static void
+ycw_u32(struct ycache_wr *yw,
+        uint32_t          v)
+{
+    fwrite(&v, sizeof(v), 1, yw->yw_f);
+}
+
+static void
+ycw_i32(struct ycache_wr *yw,
+        int32_t           v)
+{
+    fwrite(&v, sizeof(v), 1, yw->yw_f);
+}
+
+static void
+ycw_u64(struct ycache_wr *yw,
+        uint64_t          v)
+{
+    fwrite(&v, sizeof(v), 1, yw->yw_f);
+}
+
+static void
+ycw_str(struct ycache_wr *yw,
+        const char       *str)
+{
+    uint32_t len;
+
+    if (str == NULL){
+        ycw_u32(yw, YANG_CACHE_NULL);
+        return;
+    }
+    len = strlen(str);
+    ycw_u32(yw, len);
+    fwrite(str, 1, len+1, yw->yw_f);
+}
+
+static int
+ycache_idx_cmp(const void *a,
+               const void *b)
+{
+    const struct ycache_idx *ia = a;
+    const struct ycache_idx *ib = b;
+
+    if (ia->yi_ys < ib->yi_ys)
+        return -1;
+    else if (ia->yi_ys > ib->yi_ys)
+        return 1;
+    return 0;
+}
+
+/*! Find pre-order index of yang node
+ *
+ * @retval  idx  Index, 0 is yang spec
+ * @retval  -1   Not found in this spec
+ */
+static int
+ycache_index(struct ycache_wr *yw,
+             yang_stmt        *ys)
+{
+    struct ycache_idx  key = {ys, 0};
+    struct ycache_idx *yi;
+
+    if ((yi = bsearch(&key, yw->yw_idx, yw->yw_len, sizeof(*yi), ycache_idx_cmp)) == NULL)
+        return -1;
+    return yi->yi_idx;
+}
+
+/*! Collect all yang nodes in pre-order
+ *
+ * @retval  1   OK
+ * @retval  0   Spec cannot be saved, shared sub-trees
+ * @retval -1   Error
+ */
+static int
+ycache_collect(struct ycache_wr *yw,
+               yang_stmt        *ys)
+{
+    int i;
+    int ret;
+
+    if (ys->ys_ref > 0)
+        return 0;
+    if (yw->yw_len >= yw->yw_max){
+        yw->yw_max = yw->yw_max ? 2*yw->yw_max : 1024;
+        if ((yw->yw_vec = realloc(yw->yw_vec, yw->yw_max*sizeof(yang_stmt *))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+    }
+    yw->yw_vec[yw->yw_len++] = ys;
+    for (i=0; i<ys->ys_len; i++)
+        if ((ret = ycache_collect(yw, ys->ys_stmt[i])) < 1)
+            return ret;
+    return 1;
+}
+
+/*! Write cligen variable
+ *
+ * @retval  1   OK
+ * @retval  0   Cannot be saved, void pointer outside spec
+ * @retval -1   Error
+ */
+static int
+ycache_write_cv(struct ycache_wr *yw,
+                cg_var           *cv)
+{
+    enum cv_type type;
+    char        *str;
+    void        *p;
+    int          idx = -1;
+
+    if (cv == NULL){
+        ycw_u8(yw, 0);
+        return 1;
+    }
+    ycw_u8(yw, 1);
+    type = cv_type_get(cv);
+    ycw_u32(yw, type);
+    ycw_str(yw, cv_name_get(cv));
+    ycw_u8(yw, cv_flag(cv, 0xff));
+    switch (type){
+    case CGV_ERR:
+    case CGV_EMPTY:
+        break;
+    case CGV_VOID:
+        if ((p = cv_void_get(cv)) != NULL &&
+            (idx = ycache_index(yw, p)) < 0)
+            return 0;
+        ycw_i32(yw, idx);
+        break;
+    default:
+        if (type == CGV_DEC64)
+            ycw_u8(yw, cv_dec64_n_get(cv));
+        if ((str = cv2str_dup(cv)) == NULL){
+            clixon_err(OE_UNIX, errno, "cv2str_dup");
+            return -1;
+        }
+        ycw_str(yw, str);
+        free(str);
+        break;
+    }
+    return 1;
+}
+
+static int
+ycache_write_cvec(struct ycache_wr *yw,
+                  cvec             *cvv)
+{
+    cg_var *cv = NULL;
+    int     ret;
+
+    if (cvv == NULL){
+        ycw_u8(yw, 0);
+        return 1;
+    }
+    ycw_u8(yw, 1);
+    ycw_u32(yw, cvec_len(cvv));
+    while ((cv = cvec_each(cvv, cv)) != NULL)
+        if ((ret = ycache_write_cv(yw, cv)) < 1)
+            return ret;
+    return 1;
+}
+
+/*! Write one yang node, not its children
+ *
+ * @retval  1   OK
+ * @retval  0   Cannot be saved
+ * @retval -1   Error
+ */
+static int
+ycache_write_node(struct ycache_wr *yw,
+                  yang_stmt        *ys)
+{
+    int              idx = -1;
+    int              ret;
+    yang_type_cache *ycache;
+
+    ycw_u8(yw, ys->ys_keyword);
+    ycw_u16(yw, ys->ys_flags);
+    ycw_u32(yw, ys->ys_len);
+    ycw_str(yw, ys->ys_argument);
+    ycw_u32(yw, yang_linenum_get(ys));
+    if (ys->ys_orig && (idx = ycache_index(yw, ys->ys_orig)) < 0)
+        return 0;
+    ycw_i32(yw, idx);
+    if ((ret = ycache_write_cv(yw, ys->ys_cv)) < 1)
+        return ret;
+    if ((ret = ycache_write_cvec(yw, ys->ys_cvec)) < 1)
+        return ret;
+    switch (ys->ys_keyword){
+    case Y_MODULE:
+    case Y_SUBMODULE:
+        ycw_str(yw, ys->ys_filename);
+        break;
+    case Y_TYPE:
+        if ((ycache = ys->ys_typecache) == NULL){
+            ycw_u8(yw, 0);
+            break;
+        }
+        ycw_u8(yw, 1);
+        idx = -1;
+        if (ycache->yc_resolved &&
+            (idx = ycache_index(yw, ycache->yc_resolved)) < 0)
+            return 0;
+        ycw_i32(yw, idx);
+        ycw_u32(yw, ycache->yc_options);
+        ycw_u8(yw, ycache->yc_fraction);
+        if ((ret = ycache_write_cvec(yw, ycache->yc_cvv)) < 1)
+            return ret;
+        if ((ret = ycache_write_cvec(yw, ycache->yc_patterns)) < 1)
+            return ret;
+        break;
+    default:
+        break;
+    }
+    return 1;
+}
+
+/*! Write when or my-module map entries
+ *
+ * @param[in]  flag  YANG_FLAG_WHEN or YANG_FLAG_MYMODULE
+ * @retval  1   OK
+ * @retval  0   Cannot be saved
+ * @retval -1   Error
+ */
+static int
+ycache_write_map(clixon_handle     h,
+                 struct ycache_wr *yw,
+                 uint16_t          flag)
+{
+    int        retval = -1;
+    int32_t   *vec = NULL;
+    int        n = 0;
+    int        i;
+    yang_stmt *ys;
+    yang_stmt *yt;
+    int        idx;
+
+    if ((vec = calloc(2*yw->yw_len, sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=1; i<yw->yw_len; i++){
+        ys = yw->yw_vec[i];
+        if (yang_flag_get(ys, flag) == 0)
+            continue;
+        if (flag == YANG_FLAG_WHEN){
+            if (ys->ys_orig != NULL)
+                goto fail;
+            yt = yang_when_get(h, ys);
+        }
+        else
+            yt = yang_mymodule_get(ys);
+        if (yt == NULL)
+            continue;
+        if ((idx = ycache_index(yw, yt)) < 0)
+            goto fail;
+        vec[n++] = i;
+        vec[n++] = idx;
+    }
+    ycw_u32(yw, n/2);
+    for (i=0; i<n; i++)
+        ycw_i32(yw, vec[i]);
+    retval = 1;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Save fully processed yang spec to cache file
+ *
+ * Does nothing if CLICON_YANG_CACHE_DIR is not set. Failure to write the file is logged
+ * but not an error.
+ * @param[in]  h      Clixon handle
+ * @param[in]  name   Cache name, typically the application, eg "backend"
+ * @param[in]  yspec  Yang spec with all modules loaded
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see yang_spec_cache_load
+ */
+int
+yang_spec_cache_save(clixon_handle h,
+                     const char   *name,
+                     yang_stmt    *yspec)
+{
+    int              retval = -1;
+    char            *dir;
+    cbuf            *fcb = NULL;
+    cbuf            *tcb = NULL;
+    struct ycache_wr yw = {0,};
+    uint64_t         hash;
+    uint64_t         fhash;
+    yang_stmt       *ym;
+    int              nfiles = 0;
+    int              i;
+    int              ret;
+
+    if ((dir = clicon_option_str(h, "CLICON_YANG_CACHE_DIR")) == NULL)
+        goto ok;
+    if (ycache_config_hash(h, name, &hash) < 0)
+        goto done;
+    if ((ret = ycache_collect(&yw, yspec)) < 0)
+        goto done;
+    if (ret == 0)
+        goto nosave;
+    if ((yw.yw_idx = calloc(yw.yw_len, sizeof(*yw.yw_idx))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; i<yw.yw_len; i++){
+        yw.yw_idx[i].yi_ys = yw.yw_vec[i];
+        yw.yw_idx[i].yi_idx = i;
+    }
+    qsort(yw.yw_idx, yw.yw_len, sizeof(*yw.yw_idx), ycache_idx_cmp);
+    if ((fcb = cbuf_new()) == NULL || (tcb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    ycache_filename(dir, name, fcb);
+    cprintf(tcb, "%s.%u", cbuf_get(fcb), getpid());
+    if ((yw.yw_f = fopen(cbuf_get(tcb), "w")) == NULL){
+        clixon_log(h, LOG_WARNING, "%s: %s: %s", __FUNCTION__, cbuf_get(tcb), strerror(errno));
+        goto ok;
+    }
+    /* Header */
+    fwrite(YANG_CACHE_MAGIC, 1, strlen(YANG_CACHE_MAGIC)+1, yw.yw_f);
+    ycw_u32(&yw, YANG_CACHE_VERSION);
+    ycw_str(&yw, CLIXON_VERSION);
+    ycw_u64(&yw, hash);
+    /* Files */
+    for (i=0; i<yspec->ys_len; i++)
+        if (yang_filename_get(yspec->ys_stmt[i]) != NULL)
+            nfiles++;
+    ycw_u32(&yw, nfiles);
+    for (i=0; i<yspec->ys_len; i++){
+        ym = yspec->ys_stmt[i];
+        if (yang_filename_get(ym) == NULL)
+            continue;
+        if (ycache_file_hash(yang_filename_get(ym), &fhash) == 0)
+            goto nosave;
+        ycw_str(&yw, yang_filename_get(ym));
+        ycw_u64(&yw, fhash);
+    }
+    /* Nodes */
+    ycw_u32(&yw, yw.yw_len - 1);
+    for (i=1; i<yw.yw_len; i++){
+        if ((ret = ycache_write_node(&yw, yw.yw_vec[i])) < 0)
+            goto done;
+        if (ret == 0)
+            goto nosave;
+    }
+    /* Maps */
+    if ((ret = ycache_write_map(h, &yw, YANG_FLAG_WHEN)) < 0)
+        goto done;
+    if (ret == 0)
+        goto nosave;
+    if ((ret = ycache_write_map(h, &yw, YANG_FLAG_MYMODULE)) < 0)
+        goto done;
+    if (ret == 0)
+        goto nosave;
+    ret = ferror(yw.yw_f);
+    if (fclose(yw.yw_f) != 0 || ret != 0){
+        yw.yw_f = NULL;
+        clixon_log(h, LOG_WARNING, "%s: %s: write error", __FUNCTION__, cbuf_get(tcb));
+        unlink(cbuf_get(tcb));
+        goto ok;
+    }
+    yw.yw_f = NULL;
+    if (rename(cbuf_get(tcb), cbuf_get(fcb)) < 0){
+        clixon_log(h, LOG_WARNING, "%s: %s: %s", __FUNCTION__, cbuf_get(fcb), strerror(errno));
+        unlink(cbuf_get(tcb));
+        goto ok;
+    }
+    clixon_debug(CLIXON_DBG_YANG, "saved %d yang nodes to %s", yw.yw_len - 1, cbuf_get(fcb));
+ ok:
+    retval = 0;
+ done:
+    if (yw.yw_f)
+        fclose(yw.yw_f);
+    if (yw.yw_vec)
+        free(yw.yw_vec);
+    if (yw.yw_idx)
+        free(yw.yw_idx);
+    if (fcb)
+        cbuf_free(fcb);
+    if (tcb)
+        cbuf_free(tcb);
+    return retval;
+ nosave:
+    clixon_debug(CLIXON_DBG_YANG, "yang spec %s cannot be cached", name);
+    if (yw.yw_f){
+        fclose(yw.yw_f);
+        yw.yw_f = NULL;
+        unlink(cbuf_get(tcb));
+    }
+    goto ok;
+}
+
+/*
+ * Load
+ */
+static const void *
+ycr_get(struct ycache_rd *yr,
+        size_t            len)
+{
+    const void *p;
+
+    if (yr->yr_fail || yr->yr_off + len > yr->yr_len){
+        yr->yr_fail++;
+        return NULL;
+    }
+    p = yr->yr_buf + yr->yr_off;
+    yr->yr_off += len;
+    return p;
+}
+
+static uint8_t
+ycr_u8(struct ycache_rd *yr)
+{
+    uint8_t     v = 0;
+    const void *p;
+
+    if ((p = ycr_get(yr, sizeof(v))) != NULL)
+        memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint16_t
+ycr_u16(struct ycache_rd *yr)
+{
+    uint16_t    v = 0;
+    const void *p;
+
+    if ((p = ycr_get(yr, sizeof(v))) != NULL)
+        memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t
+ycr_u32(struct ycache_rd *yr)
+{
+    uint32_t    v = 0;
+    const void *p;
+
+    if ((p = ycr_get(yr, sizeof(v))) != NULL)
+        memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static int32_t
+ycr_i32(struct ycache_rd *yr)
+{
+    int32_t     v = 0;
+    const void *p;
+
+    if ((p = ycr_get(yr, sizeof(v))) != NULL)
+        memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t
+ycr_u64(struct ycache_rd *yr)
+{
+    uint64_t    v = 0;
+    const void *p;
+
+    if ((p = ycr_get(yr, sizeof(v))) != NULL)
+        memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*! Read string, points into read buffer
+ *
+ * @retval  str   String, or NULL if NULL was saved or on format error
+ */
+static const char *
+ycr_str(struct ycache_rd *yr)
+{
+    uint32_t    len;
+    const char *str;
+
+    if ((len = ycr_u32(yr)) == YANG_CACHE_NULL)
+        return NULL;
+    if ((str = ycr_get(yr, (size_t)len+1)) == NULL)
+        return NULL;
+    if (str[len] != '\0'){
+        yr->yr_fail++;
+        return NULL;
+    }
+    return str;
+}
+
+/*! Read cligen variable
+ *
+ * Void pointers are stored as index+1 and translated when all nodes are read
+ * @param[in]  yr   Read context
+ * @param[in]  cvv  Add to this vector, or NULL to create a single cv
+ * @param[out] cvp  Cligen variable, or NULL if not present
+ * @retval     0    OK (or format error in yr_fail)
+ * @retval    -1    Error
+ */
+static int
+ycache_read_cv(struct ycache_rd *yr,
+               cvec             *cvv,
+               cg_var          **cvp)
+{
+    int          retval = -1;
+    cg_var      *cv = NULL;
+    enum cv_type type;
+    const char  *name;
+    const char  *str;
+    uint8_t      flags;
+    uint8_t      n = 0;
+    int32_t      idx;
+    char        *reason = NULL;
+    int          ret;
+
+    *cvp = NULL;
+    if (ycr_u8(yr) == 0)
+        goto ok;
+    type = ycr_u32(yr);
+    name = ycr_str(yr);
+    flags = ycr_u8(yr);
+    if (yr->yr_fail || type > CGV_EMPTY)
+        goto fail;
+    if ((cv = cvv ? cvec_add(cvv, type) : cv_new(type)) == NULL){
+        clixon_err(OE_UNIX, errno, "cv_new");
+        goto done;
+    }
+    if (name && cv_name_set(cv, name) == NULL){
+        clixon_err(OE_UNIX, errno, "cv_name_set");
+        goto done;
+    }
+    switch (type){
+    case CGV_ERR:
+    case CGV_EMPTY:
+        break;
+    case CGV_VOID:
+        idx = ycr_i32(yr);
+        if (yr->yr_fail || idx < -1 || idx > yr->yr_max)
+            goto fail;
+        cv_void_set(cv, (void*)(intptr_t)(idx+1));
+        break;
+    default:
+        if (type == CGV_DEC64){
+            n = ycr_u8(yr);
+            cv_dec64_n_set(cv, n);
+        }
+        str = ycr_str(yr);
+        if (yr->yr_fail)
+            goto fail;
+        if (str != NULL){
+            if ((ret = cv_parse1(str, cv, &reason)) < 0){
+                clixon_err(OE_UNIX, errno, "cv_parse1");
+                goto done;
+            }
+            if (ret == 0)
+                goto fail;
+        }
+        break;
+    }
+    cv_flag_set(cv, flags);
+    *cvp = cv;
+    cv = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    if (cv && cvv == NULL)
+        cv_free(cv);
+    return retval;
+ fail:
+    yr->yr_fail++;
+    goto ok;
+}
+
+/*! Read cligen variable vector
+ *
+ * @param[in]  yr    Read context
+ * @param[out] cvvp  Cligen vector, or NULL if not present
+ * @retval     0     OK (or format error in yr_fail)
+ * @retval    -1     Error
+ */
+static int
+ycache_read_cvec(struct ycache_rd *yr,
+                 cvec            **cvvp)
+{
+    int      retval = -1;
+    cvec    *cvv = NULL;
+    uint32_t len;
+    uint32_t i;
+    cg_var  *cv;
+
+    *cvvp = NULL;
+    if (ycr_u8(yr) == 0)
+        goto ok;
+    len = ycr_u32(yr);
+    if (yr->yr_fail || len > yr->yr_len - yr->yr_off){
+        yr->yr_fail++;
+        goto ok;
+    }
+    if ((cvv = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    for (i=0; i<len && yr->yr_fail == 0; i++)
+        if (ycache_read_cv(yr, cvv, &cv) < 0)
+            goto done;
+    *cvvp = cvv;
+    cvv = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (cvv)
+        cvec_free(cvv);
+    return retval;
+}
+
+/*! Read one yang node and its children recursively and add it to parent
+ *
+ * @param[in]  yr    Read context
+ * @param[in]  yp    Parent
+ * @retval     0     OK (or format error in yr_fail)
+ * @retval    -1     Error
+ */
+static int
+ycache_read_node(struct ycache_rd *yr,
+                 yang_stmt        *yp)
+{
+    int                 retval = -1;
+    yang_stmt          *ys;
+    enum rfc_6020       keyword;
+    uint16_t            flags;
+    uint32_t            nchildren;
+    const char         *str;
+    uint32_t            linenum;
+    int32_t             orig;
+    uint32_t            i;
+    struct ycache_type *yt;
+
+    keyword = ycr_u8(yr);
+    flags = ycr_u16(yr);
+    nchildren = ycr_u32(yr);
+    str = ycr_str(yr);
+    linenum = ycr_u32(yr);
+    orig = ycr_i32(yr);
+    if (yr->yr_fail || keyword < Y_ACTION || keyword >= Y_MOUNTS ||
+        yr->yr_nr >= yr->yr_max || nchildren > yr->yr_max - yr->yr_nr ||
+        orig < -1 || orig > yr->yr_max)
+        goto fail;
+    if ((ys = ys_new(keyword)) == NULL)
+        goto done;
+    /* Add to parent first, it is freed with parent on error */
+    if (yp->ys_keyword == Y_SPEC){
+        if (yn_insert(yp, ys) < 0){
+            ys_free(ys);
+            goto done;
+        }
+    }
+    else {
+        yp->ys_stmt[yp->ys_len++] = ys;
+        ys->ys_parent = yp;
+    }
+    yr->yr_nr++;
+    yr->yr_vec[yr->yr_nr] = ys;
+    yr->yr_orig[yr->yr_nr] = orig;
+    /* when and my-module flags are set when the maps are read */
+    ys->ys_flags = flags & ~(YANG_FLAG_WHEN|YANG_FLAG_MYMODULE);
+    if (str && (ys->ys_argument = strdup(str)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    yang_linenum_set(ys, linenum);
+    if (ycache_read_cv(yr, NULL, &ys->ys_cv) < 0)
+        goto done;
+    if (ycache_read_cvec(yr, &ys->ys_cvec) < 0)
+        goto done;
+    switch (keyword){
+    case Y_MODULE:
+    case Y_SUBMODULE:
+        if ((str = ycr_str(yr)) != NULL &&
+            yang_filename_set(ys, str) < 0)
+            goto done;
+        break;
+    case Y_TYPE:
+        if (ycr_u8(yr) == 0)
+            break;
+        if (yr->yr_ntypes >= yr->yr_maxtypes){
+            yr->yr_maxtypes = yr->yr_maxtypes ? 2*yr->yr_maxtypes : 256;
+            if ((yr->yr_types = realloc(yr->yr_types, yr->yr_maxtypes*sizeof(*yt))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+        }
+        yt = &yr->yr_types[yr->yr_ntypes++];
+        memset(yt, 0, sizeof(*yt));
+        yt->yt_ys = ys;
+        yt->yt_resolved = ycr_i32(yr);
+        yt->yt_options = ycr_u32(yr);
+        yt->yt_fraction = ycr_u8(yr);
+        if (yt->yt_resolved < -1 || yt->yt_resolved > yr->yr_max)
+            goto fail;
+        if (ycache_read_cvec(yr, &yt->yt_cvv) < 0)
+            goto done;
+        if (ycache_read_cvec(yr, &yt->yt_patterns) < 0)
+            goto done;
+        break;
+    default:
+        break;
+    }
+    if (yr->yr_fail)
+        goto ok;
+    if (nchildren){
+        if ((ys->ys_stmt = calloc(nchildren, sizeof(yang_stmt *))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        for (i=0; i<nchildren && yr->yr_fail == 0; i++)
+            if (ycache_read_node(yr, ys) < 0)
+                goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+ fail:
+    yr->yr_fail++;
+    goto ok;
+}
+
+/*! Translate void pointer index to yang node
+ */
+static int
+ycache_void_fix(struct ycache_rd *yr,
+                cg_var           *cv)
+{
+    intptr_t idx;
+
+    if (cv == NULL || cv_type_get(cv) != CGV_VOID)
+        return 0;
+    if ((idx = (intptr_t)cv_void_get(cv)) == 0)
+        return 0;
+    if (idx - 1 > yr->yr_nr){
+        yr->yr_fail++;
+        return 0;
+    }
+    cv_void_set(cv, yr->yr_vec[idx - 1]);
+    return 0;
+}
+
+/*! Read when or my-module map entries and optionally add them
+ *
+ * Entries are first read without being added to validate the file, since the maps are
+ * global and not cleared when yang nodes are freed
+ * @param[in]  h      Clixon handle
+ * @param[in]  yr     Read context
+ * @param[in]  flag   YANG_FLAG_WHEN or YANG_FLAG_MYMODULE
+ * @param[in]  apply  Add entries to map
+ * @retval     0      OK (or format error in yr_fail)
+ * @retval    -1      Error
+ */
+static int
+ycache_read_map(clixon_handle     h,
+                struct ycache_rd *yr,
+                uint16_t          flag,
+                int               apply)
+{
+    uint32_t n;
+    uint32_t i;
+    int32_t  i0;
+    int32_t  i1;
+
+    n = ycr_u32(yr);
+    for (i=0; i<n && yr->yr_fail == 0; i++){
+        i0 = ycr_i32(yr);
+        i1 = ycr_i32(yr);
+        if (yr->yr_fail || i0 < 1 || i0 > yr->yr_nr || i1 < 0 || i1 > yr->yr_nr){
+            yr->yr_fail++;
+            break;
+        }
+        if (!apply)
+            continue;
+        if (flag == YANG_FLAG_WHEN){
+            if (yang_when_set(h, yr->yr_vec[i0], yr->yr_vec[i1]) < 0)
+                return -1;
+        }
+        else if (yang_mymodule_set(yr->yr_vec[i0], yr->yr_vec[i1]) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Remove all modules from yang spec after a failed load
+ */
+static int
+ycache_spec_clear(yang_stmt *yspec)
+{
+    int i;
+
+    for (i=0; i<yspec->ys_len; i++)
+        ys_free(yspec->ys_stmt[i]);
+    if (yspec->ys_stmt)
+        free(yspec->ys_stmt);
+    yspec->ys_stmt = NULL;
+    yspec->ys_len = 0;
+    return 0;
+}
+
+/*! Read whole cache file
+ *
+ * @retval  1   OK
+ * @retval  0   No file
+ * @retval -1   Error
+ */
+static int
+ycache_read_file(const char *filename,
+                 char      **bufp,
+                 size_t     *lenp)
+{
+    int         retval = -1;
+    int         fd = -1;
+    struct stat st;
+    char       *buf = NULL;
+    size_t      len = 0;
+    ssize_t     n;
+
+    if ((fd = open(filename, O_RDONLY)) < 0){
+        if (errno == ENOENT){
+            retval = 0;
+            goto done;
+        }
+        clixon_err(OE_UNIX, errno, "open(%s)", filename);
+        goto done;
+    }
+    if (fstat(fd, &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat(%s)", filename);
+        goto done;
+    }
+    if ((buf = malloc(st.st_size + 1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    while (len < st.st_size){
+        if ((n = read(fd, buf + len, st.st_size - len)) < 0){
+            clixon_err(OE_UNIX, errno, "read(%s)", filename);
+            goto done;
+        }
+        if (n == 0)
+            break;
+        len += n;
+    }
+    *bufp = buf;
+    buf = NULL;
+    *lenp = len;
+    retval = 1;
+ done:
+    if (buf)
+        free(buf);
+    if (fd != -1)
+        close(fd);
+    return retval;
+}
+
+/*! Load yang spec from cache file
+ *
+ * The cache is only loaded into an empty yang spec and only if it is valid, ie it was saved by
+ * the same clixon version with the same YANG-related config, and no loaded YANG file has changed.
+ * After a successful load, loading the same modules again is a no-op.
+ * @param[in]  h      Clixon handle
+ * @param[in]  name   Cache name, typically the application, eg "backend"
+ * @param[in]  yspec  Empty yang spec
+ * @retval     1      Loaded
+ * @retval     0      Not loaded: not enabled, no cache or not valid
+ * @retval    -1      Error
+ * @see yang_spec_cache_save
+ */
+int
+yang_spec_cache_load(clixon_handle h,
+                     const char   *name,
+                     yang_stmt    *yspec)
+{
+    int                 retval = -1;
+    char               *dir;
+    cbuf               *fcb = NULL;
+    struct ycache_rd    yr = {0,};
+    const char         *str;
+    const char         *filename;
+    uint64_t            hash;
+    uint64_t            fhash;
+    uint32_t            nfiles;
+    uint32_t            i;
+    int                 j;
+    yang_stmt          *ys;
+    cg_var             *cv;
+    struct ycache_type *yt;
+    cvec               *regexps = NULL;
+    size_t              off;
+    int                 ret;
+
+    if ((dir = clicon_option_str(h, "CLICON_YANG_CACHE_DIR")) == NULL ||
+        yspec->ys_len != 0)
+        goto nocache;
+    if ((fcb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    ycache_filename(dir, name, fcb);
+    if ((ret = ycache_read_file(cbuf_get(fcb), &yr.yr_buf, &yr.yr_len)) < 0)
+        goto done;
+    if (ret == 0)
+        goto nocache;
+    /* Header */
+    if ((str = ycr_get(&yr, strlen(YANG_CACHE_MAGIC)+1)) == NULL ||
+        memcmp(str, YANG_CACHE_MAGIC, strlen(YANG_CACHE_MAGIC)+1) != 0 ||
+        ycr_u32(&yr) != YANG_CACHE_VERSION ||
+        (str = ycr_str(&yr)) == NULL ||
+        strcmp(str, CLIXON_VERSION) != 0)
+        goto invalid;
+    if (ycache_config_hash(h, name, &hash) < 0)
+        goto done;
+    if (ycr_u64(&yr) != hash)
+        goto invalid;
+    /* Files */
+    nfiles = ycr_u32(&yr);
+    for (i=0; i<nfiles && yr.yr_fail == 0; i++){
+        filename = ycr_str(&yr);
+        fhash = ycr_u64(&yr);
+        if (yr.yr_fail || filename == NULL ||
+            ycache_file_hash(filename, &hash) == 0 ||
+            hash != fhash)
+            goto invalid;
+    }
+    /* Nodes */
+    yr.yr_max = ycr_u32(&yr);
+    if (yr.yr_fail || yr.yr_max > yr.yr_len)
+        goto invalid;
+    if ((yr.yr_vec = calloc(yr.yr_max + 1, sizeof(yang_stmt *))) == NULL ||
+        (yr.yr_orig = calloc(yr.yr_max + 1, sizeof(int32_t))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    yr.yr_vec[0] = yspec;
+    while (yr.yr_nr < yr.yr_max && yr.yr_fail == 0)
+        if (ycache_read_node(&yr, yspec) < 0)
+            goto done;
+    if (yr.yr_fail)
+        goto invalid;
+    /* Translate indexes to pointers */
+    for (j=1; j<=yr.yr_nr; j++){
+        ys = yr.yr_vec[j];
+        if (yr.yr_orig[j] >= 0)
+            ys->ys_orig = yr.yr_vec[yr.yr_orig[j]];
+        ycache_void_fix(&yr, ys->ys_cv);
+        cv = NULL;
+        while ((cv = cvec_each(ys->ys_cvec, cv)) != NULL)
+            ycache_void_fix(&yr, cv);
+    }
+    if (yr.yr_fail)
+        goto invalid;
+    off = yr.yr_off;
+    ycache_read_map(h, &yr, YANG_FLAG_WHEN, 0);
+    ycache_read_map(h, &yr, YANG_FLAG_MYMODULE, 0);
+    if (yr.yr_fail || yr.yr_off != yr.yr_len)
+        goto invalid;
+    yr.yr_off = off;
+    if (ycache_read_map(h, &yr, YANG_FLAG_WHEN, 1) < 0)
+        goto done;
+    if (ycache_read_map(h, &yr, YANG_FLAG_MYMODULE, 1) < 0)
+        goto done;
+    /* Identity numbers and derived bitsets are not stored, build from derived lists */
+    if (yang_identity_bitset_build(yspec) < 0)
+        goto done;
+    /* Type caches with compiled regexps */
+    for (j=0; j<yr.yr_ntypes; j++){
+        yt = &yr.yr_types[j];
+        if (yt->yt_patterns && cvec_len(yt->yt_patterns)){
+            if ((regexps = cvec_new(0)) == NULL){
+                clixon_err(OE_UNIX, errno, "cvec_new");
+                goto done;
+            }
+            if (compile_pattern2regexp(h, yt->yt_ys, yt->yt_patterns, regexps) < 1)
+                goto done;
+        }
+        if (yang_type_cache_set2(yt->yt_ys,
+                                 yt->yt_resolved < 0 ? NULL : yr.yr_vec[yt->yt_resolved],
+                                 yt->yt_options, yt->yt_cvv, yt->yt_patterns,
+                                 yt->yt_fraction, clicon_yang_regexp(h), regexps) < 0)
+            goto done;
+        if (regexps){
+            cvec_free(regexps);
+            regexps = NULL;
+        }
+    }
+    clixon_debug(CLIXON_DBG_YANG, "loaded %d yang nodes from %s", yr.yr_nr, cbuf_get(fcb));
+    retval = 1;
+ done:
+    if (retval < 0)
+        ycache_spec_clear(yspec);
+    if (regexps)
+        cvec_free(regexps);
+    for (j=0; j<yr.yr_ntypes; j++){
+        yt = &yr.yr_types[j];
+        if (yt->yt_cvv)
+            cvec_free(yt->yt_cvv);
+        if (yt->yt_patterns)
+            cvec_free(yt->yt_patterns);
+    }
+    if (yr.yr_types)
+        free(yr.yr_types);
+    if (yr.yr_vec)
+        free(yr.yr_vec);
+    if (yr.yr_orig)
+        free(yr.yr_orig);
+    if (yr.yr_buf)
+        free(yr.yr_buf);
+    if (fcb)
+        cbuf_free(fcb);
+    return retval;
+ invalid:
+    clixon_debug(CLIXON_DBG_YANG, "yang cache %s is not valid", cbuf_get(fcb));
+    ycache_spec_clear(yspec);
+ nocache:
+    retval = 0;
+    goto done;
+}
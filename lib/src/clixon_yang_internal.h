@@ -57,9 +57,38 @@ struct yang_type_cache{
     cvec      *yc_patterns; /* List of regexp, if cvec_len() > 0 */
     cvec      *yc_regexps;  /* List of _compiled_ regexp, if cvec_len() > 0 */
     yang_stmt *yc_resolved; /* Resolved type object, can be NULL - note direct ptr */
+#ifdef YANG_TYPE_VALIDATOR
+    struct yang_type_validator *yc_validator; /* Compiled from the fields above */
+#endif
 };
 typedef struct yang_type_cache yang_type_cache;
 
+#ifdef YANG_SCHEMA_MOUNT_INDEX
+/*! Index of mounted yang-specs in top-level yang mounts
+ *
+ * Hash values are yspec pointers, not owned by the index
+ * @see yang_mount_index_get
+ */
+struct yang_mount_index{
+    clicon_hash_t *ymi_xpaths;   /* Canonical mount xpath -> mounted yspec */
+    clicon_hash_t *ymi_yanglibs; /* Yang-library content -> shared yspec */
+};
+#endif
+
+#ifdef YANG_IDENTITY_BITSET
+/*! Identity number and bitset of derived identities
+ *
+ * Identities are numbered densely when populated. Bit n of yi_derived is set if the
+ * identity numbered n is derived from this identity (not including itself)
+ * @see ys_populate_identity
+ */
+struct yang_identity{
+    uint32_t   yi_nr;       /* Identity number */
+    uint32_t   yi_nwords;   /* Length of yi_derived in 64-bit words */
+    uint64_t  *yi_derived;  /* Bitset of transitively derived identities */
+};
+#endif
+
 /*! yang statement 
  *
  * This is an internal type, not exposed in the API
@@ -109,10 +138,19 @@ struct yang_stmt {
                                         Y_UNKNOWN: app-dep: yang-mount-points
                                      */
     yang_stmt         *ys_orig;      /* Pointer to original (for uses/augment copies) */
+#ifdef YANG_FIND_INDEX
+    struct yang_index *ys_index;     /* Child index built on demand, see yang_find */
+#endif
     union {                          /* Depends on ys_keyword */
         rpc_callback_t  *ysu_action_cb; /* Y_ACTION: Action callback list*/
         char            *ysu_filename;  /* Y_MODULE/Y_SUBMODULE: For debug/errors: filename */
         yang_type_cache *ysu_typecache; /* Y_TYPE: cache all typedef data except unions */
+#ifdef YANG_IDENTITY_BITSET
+        struct yang_identity *ysu_identity; /* Y_IDENTITY: number and derived bitset */
+#endif
+#ifdef YANG_SCHEMA_MOUNT_INDEX
+        struct yang_mount_index *ysu_mntindex; /* Y_MOUNTS: index of mounted yspecs */
+#endif
 #ifdef OPTIMIZE_YSPEC_NAMESPACE
         map_str2ptr     *ysu_nscache;   /* Y_SPEC: namespace to module cache */
 #endif
@@ -126,6 +164,12 @@ struct yang_stmt {
 #define ys_action_cb      u.ysu_action_cb
 #define ys_filename       u.ysu_filename
 #define ys_typecache      u.ysu_typecache
+#ifdef YANG_IDENTITY_BITSET
+#define ys_identity       u.ysu_identity
+#endif
+#ifdef YANG_SCHEMA_MOUNT_INDEX
+#define ys_mntindex       u.ysu_mntindex
+#endif
 #ifdef OPTIMIZE_YSPEC_NAMESPACE
 #define ys_nscache        u.ysu_nscache
 #endif
@@ -57,10 +57,13 @@ struct clixon_yang_yacc {
     int                   yy_linenum;      /* Number of \n in parsed buffer */
     char                 *yy_parse_string; /* original (copy of) parse string */
     void                 *yy_lexbuf;       /* internal parse buffer from lex */
+    void                 *yy_scanner;      /* Reentrant lex scanner */
     struct ys_stack      *yy_stack;     /* Stack of levels: push/pop on () and [] */
     int                   yy_lex_state;  /* lex start condition (ESCAPE/COMMENT) */
     int                   yy_lex_string_state; /* lex start condition (STRING) */
     yang_stmt            *yy_module;       /* top-level (sub)module - return value of parser */
+    int                   yy_deferred;     /* Parsed by worker thread: no errors reported and
+                                              statement syntax checked later */
 };
 typedef struct clixon_yang_yacc clixon_yang_yacc;
 
@@ -79,11 +82,6 @@ struct yang_userdata{
     char              du_vector;    /* (clicon) Possibly more than one element */
 };
 
-/*
- * Variables
- */
-extern char *clixon_yang_parsetext;
-
 /*
  * Prototypes
  */
@@ -93,7 +91,8 @@ int yang_scan_exit(clixon_yang_yacc *ya);
 int yang_parse_init(clixon_yang_yacc *ya);
 int yang_parse_exit(clixon_yang_yacc *ya);
 
-int clixon_yang_parselex(void *_ya);
+int clixon_yang_parselex(void *lvalp, void *_ya);
+char *clixon_yang_parseget_text(void *yyscanner);
 int clixon_yang_parseparse(void *);
 void clixon_yang_parseerror(void *_ya, char*);
 
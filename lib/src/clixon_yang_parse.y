@@ -158,6 +158,7 @@
 %token D_DELETE
 %token D_REPLACE
 
+%define api.pure /* Reentrant: YANG files may be parsed by worker threads */
 %lex-param     {void *_yy} /* Add this argument to parse() and lex() function */
 %parse-param   {void *_yy}
 
@@ -167,7 +168,7 @@
 /* typecast macro */
 #define _YY ((clixon_yang_yacc *)_yy)
 
-#define _YYERROR(msg) {clixon_debug(CLIXON_DBG_YANG, "YYERROR %s '%s' %d", (msg), clixon_yang_parsetext, _YY->yy_linenum); YYERROR;}
+#define _YYERROR(msg) {clixon_debug(CLIXON_DBG_YANG, "YYERROR %s '%s' %d", (msg), clixon_yang_parseget_text(_YY->yy_scanner), _YY->yy_linenum); YYERROR;}
 
 /* add _yy to error parameters */
 #define YY_(msgid) msgid
@@ -211,21 +212,22 @@
 #define _PARSE_DEBUG1(s, s1)
 #endif
 
-extern int clixon_yang_parseget_lineno  (void);
-
 /*
    clixon_yang_parseerror
    also called from yacc generated code *
+   Not reported if deferred, the file is then parsed again to get the error
 */
 void
 clixon_yang_parseerror(void *_yy,
                        char *s)
 {
+    if (_YY->yy_deferred)
+        return;
     clixon_err(OE_YANG, 0, "%s on line %d: %s at or before: '%s'",
                _YY->yy_name,
                _YY->yy_linenum,
                s,
-               clixon_yang_parsetext);
+               clixon_yang_parseget_text(_YY->yy_scanner));
   return;
 }
 
@@ -303,6 +305,7 @@ ysp_add(clixon_yang_yacc *yy,
     struct ys_stack *ystack = yy->yy_stack;
     yang_stmt       *ys = NULL;
     yang_stmt       *yn;
+    cg_var          *cv;
 
     ystack = yy->yy_stack;
     if (ystack == NULL){
@@ -320,7 +323,22 @@ ysp_add(clixon_yang_yacc *yy,
     if (yn_insert(yn, ys) < 0) /* Insert into hierarchy */
         goto err;
     yang_linenum_set(ys, yy->yy_linenum); /* For error/debugging */
-    if (ys_parse_sub(ys, yy->yy_name, extra) < 0)     /* Check statement-specific syntax */
+    if (yy->yy_deferred){
+        /* Worker thread: save extra and check syntax later, see ys_parse_sub_deferred */
+        if (extra != NULL){
+            if ((cv = cv_new(CGV_STRING)) == NULL){
+                free(extra);
+                goto err2;
+            }
+            yang_cv_set(ys, cv);
+            if (cv_string_set(cv, extra) == NULL){
+                free(extra);
+                goto err2;
+            }
+            free(extra);
+        }
+    }
+    else if (ys_parse_sub(ys, yy->yy_name, extra) < 0)     /* Check statement-specific syntax */
         goto err2; /* dont free since part of tree */
     return ys;
   err:
@@ -70,6 +70,7 @@
 #include <sys/param.h>
 #include <netinet/in.h>
 #include <libgen.h>
+#include <pthread.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -486,6 +487,9 @@ ys_do_refine(yang_stmt *yr,
     int           i;
     int           inext;
 
+    /* Target may share statements with original grouping node, copy before modifying */
+    if (yang_unshare(yt) < 0)
+        goto done;
     /* Loop through refine node children. First if remove do that first 
      * In some cases remove a set of nodes.
      */
@@ -598,6 +602,7 @@ yang_expand_uses_node(clixon_handle h,
     int        k;
     yang_stmt *ywhen;
     int        inext;
+    int        shared = 0;
 
     /* Split argument into prefix and name */
     if (nodeid_split(yang_argument_get(ys), &prefix, &id) < 0)
@@ -645,6 +650,10 @@ yang_expand_uses_node(clixon_handle h,
     }
     /* Find when statement, if present */
     ywhen = yang_find(ys, Y_WHEN, NULL);
+#ifdef YANG_USES_SHARED
+    /* Without refinements, read-only statements need not be copied */
+    shared = (yang_find(ys, Y_REFINE, NULL) == NULL);
+#endif
     /* Make a copy of the grouping, then make refinements to this copy
      * Note this ygrouping2 object does not have a parent and does not work in many
      * functions which assume a full hierarchy, use the original ygrouping in those cases.
@@ -662,7 +671,11 @@ yang_expand_uses_node(clixon_handle h,
 
         for (i=0; i<ygrouping2->ys_len; i++){
             yco = ygrouping->ys_stmt[i];
-            if ((ycn = ys_dup(yco)) == NULL)
+            if (shared)
+                ycn = ys_dup_shared(yco);
+            else
+                ycn = ys_dup(yco);
+            if (ycn == NULL)
                 goto done;
             ygrouping2->ys_stmt[i] = ycn;
             ycn->ys_parent = ygrouping2;
@@ -769,6 +782,8 @@ yang_expand_uses_node(clixon_handle h,
         yang_flag_set(yg, YANG_FLAG_GROUPING);
         k++;
     }
+    /* Children of yn were modified directly */
+    yang_changed();
     /* Remove the grouping copy */
     ygrouping2->ys_len = 0; /* Cant do with get access function */
     ys_free(ygrouping2);
@@ -846,22 +861,22 @@ yang_expand_grouping(clixon_handle h,
     return retval;
 }
 
-/*! Parse a string containing a YANG spec into a parse-tree
- * 
- * Syntax parsing. A string is input and a YANG syntax-tree is returned (or error). 
- * As a side-effect, Yang modules present in the text will be inserted under the global Yang 
- * specification
- * @param[in] str    String of yang statements
- * @param[in] name   Log string, typically filename
- * @param[in] yspec  Yang specification. 
- * @retval    ymod   Top-level yang (sub)module
- * @retval    NULL   Error encountered
- * See top of file for diagram of calling order
+/*! Parse a string containing a YANG spec into a parse-tree, possibly deferred
+ *
+ * @param[in] str      String of yang statements
+ * @param[in] name     Log string, typically filename
+ * @param[in] yspec    Yang specification.
+ * @param[in] deferred Called from worker thread: do not report errors or check statement
+ *                     syntax, see yang_prefetch_take
+ * @retval    ymod     Top-level yang (sub)module
+ * @retval    NULL     Error encountered
+ * @see yang_parse_str
  */
-yang_stmt *
-yang_parse_str(char         *str,
-               const char   *name, /* just for errs */
-               yang_stmt    *yspec)
+static yang_stmt *
+yang_parse_str1(char         *str,
+                const char   *name,
+                yang_stmt    *yspec,
+                int           deferred)
 {
     clixon_yang_yacc yy = {0,};
     yang_stmt       *ymod = NULL;
@@ -876,17 +891,23 @@ yang_parse_str(char         *str,
     yy.yy_parse_string = str;
     yy.yy_stack        = NULL;
     yy.yy_module       = NULL; /* this is the return value - the module/sub-module */
+    yy.yy_deferred     = deferred;
     if (ystack_push(&yy, yspec) == NULL)
         goto done;
     if (strlen(str)){ /* Not empty */
-        if (yang_scan_init(&yy) < 0)
+        if (yang_scan_init(&yy) < 0){
+            if (!deferred)
+                clixon_err(OE_YANG, errno, "yang_scan_init");
             goto done;
+        }
         if (yang_parse_init(&yy) < 0)
             goto done;
         if (clixon_yang_parseparse(&yy) != 0) { /* yacc returns 1 on error */
-            clixon_log(NULL, LOG_NOTICE, "Yang error: %s on line %d", name, yy.yy_linenum);
-            if (clixon_err_category() == 0)
-                clixon_err(OE_YANG, 0, "yang parser error with no error code (should not happen)");
+            if (!deferred){
+                clixon_log(NULL, LOG_NOTICE, "Yang error: %s on line %d", name, yy.yy_linenum);
+                if (clixon_err_category() == 0)
+                    clixon_err(OE_YANG, 0, "yang parser error with no error code (should not happen)");
+            }
             yang_parse_exit(&yy);
             yang_scan_exit(&yy);
             goto done;
@@ -897,9 +918,12 @@ yang_parse_str(char         *str,
             goto done;
     }
     if ((ymod = yy.yy_module) == NULL){
-        clixon_err(OE_YANG, 0, "No module in YANG %s", name);
+        if (!deferred)
+            clixon_err(OE_YANG, 0, "No module in YANG %s", name);
         goto done;
     }
+    if (deferred)
+        goto done;
     /* Add filename for debugging and errors, see also ys_linenum on (each symbol?) */
     if (yang_filename_set(ymod, name) < 0)
         goto done;
@@ -914,6 +938,26 @@ yang_parse_str(char         *str,
     return ymod;  /* top-level (sub)module */
 }
 
+/*! Parse a string containing a YANG spec into a parse-tree
+ * 
+ * Syntax parsing. A string is input and a YANG syntax-tree is returned (or error). 
+ * As a side-effect, Yang modules present in the text will be inserted under the global Yang 
+ * specification
+ * @param[in] str    String of yang statements
+ * @param[in] name   Log string, typically filename
+ * @param[in] yspec  Yang specification. 
+ * @retval    ymod   Top-level yang (sub)module
+ * @retval    NULL   Error encountered
+ * See top of file for diagram of calling order
+ */
+yang_stmt *
+yang_parse_str(char         *str,
+               const char   *name, /* just for errs */
+               yang_stmt    *yspec)
+{
+    return yang_parse_str1(str, name, yspec, 0);
+}
+
 /*! Parse yang spec from an open file descriptor
  *
  * @param[in] fd     File descriptor containing the YANG file as ASCII characters
@@ -1141,6 +1185,456 @@ done:
     goto done;
 }
 
+#ifdef YANG_PARSE_THREADS
+/*! YANG file parsed in advance by a worker thread, see yang_prefetch_parse
+ */
+typedef struct {
+    char      *yf_filename; /* Full filename */
+    yang_stmt *yf_yspec;    /* Private yang spec that the file is parsed into */
+    yang_stmt *yf_module;   /* Parsed (sub)module, NULL if not parsed, failed or taken */
+} yang_prefetch;
+
+/*! Result of yang_file_find_match for an import or include parsed in advance
+ */
+typedef struct {
+    char      *ym_module;   /* Module or submodule name */
+    char      *ym_revision; /* Revision or NULL */
+    int        ym_index;    /* Index of file in _yang_prefetch */
+} yang_prefetch_match;
+
+/* Set when parsing in advance has been started, see yang_prefetch_start */
+static int                  _yang_prefetch_active = 0;
+
+/* Files parsed in advance, taken by yang_parse_filename */
+static yang_prefetch       *_yang_prefetch = NULL;
+static int                  _yang_prefetch_len = 0;
+
+/* Next file to parse by a worker thread, protected by mutex */
+static int                  _yang_prefetch_next = 0;
+static pthread_mutex_t      _yang_prefetch_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Module and revision to filename matches, used by yang_parse_module */
+static yang_prefetch_match *_yang_prefetch_matches = NULL;
+static int                  _yang_prefetch_nmatches = 0;
+
+/*! Read and parse a YANG file in a worker thread
+ *
+ * Thread-safe version of yang_parse_filename: errors are not reported, instead the file is
+ * parsed again by yang_parse_filename.
+ * @param[in] filename Name of file
+ * @param[in] yspec    Private yang spec
+ * @retval    ymod     Top-level yang (sub)module
+ * @retval    NULL     Error
+ */
+static yang_stmt *
+yang_parse_filename_deferred(const char *filename,
+                             yang_stmt  *yspec)
+{
+    yang_stmt  *ymod = NULL;
+    FILE       *fp = NULL;
+    struct stat st;
+    char       *buf = NULL;
+
+    if ((fp = fopen(filename, "r")) == NULL)
+        goto done;
+    if (fstat(fileno(fp), &st) < 0)
+        goto done;
+    if ((buf = malloc(st.st_size + 1)) == NULL)
+        goto done;
+    if (fread(buf, 1, st.st_size, fp) != (size_t)st.st_size)
+        goto done;
+    buf[st.st_size] = '\0';
+    ymod = yang_parse_str1(buf, filename, yspec, 1);
+ done:
+    if (buf)
+        free(buf);
+    if (fp)
+        fclose(fp);
+    return ymod;
+}
+
+/*! Worker thread: parse files until there are no more
+ *
+ * @param[in] arg  Not used
+ * @retval    NULL
+ */
+static void *
+yang_prefetch_worker(void *arg)
+{
+    yang_prefetch *yf;
+    int            i;
+
+    while (1){
+        pthread_mutex_lock(&_yang_prefetch_mutex);
+        i = _yang_prefetch_next++;
+        pthread_mutex_unlock(&_yang_prefetch_mutex);
+        if (i >= _yang_prefetch_len)
+            break;
+        yf = &_yang_prefetch[i];
+        yf->yf_module = yang_parse_filename_deferred(yf->yf_filename, yf->yf_yspec);
+    }
+    return NULL;
+}
+
+/*! Start parsing YANG files in advance
+ *
+ * Not started if already started, if debugging or if there is only one processor
+ * @retval    1   Started, stop with yang_prefetch_exit
+ * @retval    0   Not started
+ */
+static int
+yang_prefetch_start(void)
+{
+    if (_yang_prefetch_active)
+        return 0;
+    if (clixon_debug_get() != 0) /* Debug logging is not thread-safe */
+        return 0;
+    if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+        return 0;
+    _yang_prefetch_active = 1;
+    return 1;
+}
+
+/*! Stop parsing in advance and free files that were parsed but not taken
+ */
+static void
+yang_prefetch_exit(void)
+{
+    int i;
+
+    for (i=0; i<_yang_prefetch_len; i++){
+        free(_yang_prefetch[i].yf_filename);
+        ys_free(_yang_prefetch[i].yf_yspec);
+    }
+    if (_yang_prefetch)
+        free(_yang_prefetch);
+    _yang_prefetch = NULL;
+    _yang_prefetch_len = 0;
+    _yang_prefetch_next = 0;
+    for (i=0; i<_yang_prefetch_nmatches; i++){
+        free(_yang_prefetch_matches[i].ym_module);
+        if (_yang_prefetch_matches[i].ym_revision)
+            free(_yang_prefetch_matches[i].ym_revision);
+    }
+    if (_yang_prefetch_matches)
+        free(_yang_prefetch_matches);
+    _yang_prefetch_matches = NULL;
+    _yang_prefetch_nmatches = 0;
+    _yang_prefetch_active = 0;
+}
+
+/*! Add a YANG file to be parsed in advance
+ *
+ * @param[in] filename  Full filename
+ * @retval    i         Index of file
+ * @retval   -1         Error
+ */
+static int
+yang_prefetch_file(const char *filename)
+{
+    yang_prefetch *yf;
+    int            i;
+
+    for (i=0; i<_yang_prefetch_len; i++)
+        if (strcmp(_yang_prefetch[i].yf_filename, filename) == 0)
+            return i;
+    if ((yf = realloc(_yang_prefetch, (_yang_prefetch_len+1)*sizeof(*yf))) == NULL){
+        clixon_err(OE_YANG, errno, "realloc");
+        return -1;
+    }
+    _yang_prefetch = yf;
+    yf = &_yang_prefetch[_yang_prefetch_len];
+    memset(yf, 0, sizeof(*yf));
+    if ((yf->yf_filename = strdup(filename)) == NULL){
+        clixon_err(OE_YANG, errno, "strdup");
+        return -1;
+    }
+    if ((yf->yf_yspec = ys_new(Y_SPEC)) == NULL){
+        free(yf->yf_filename);
+        return -1;
+    }
+    return _yang_prefetch_len++;
+}
+
+/*! Get filename of module and revision matched when parsing in advance
+ *
+ * @param[in] module    Module or submodule name
+ * @param[in] revision  Revision or NULL
+ * @retval    filename  Filename
+ * @retval    NULL      Not matched in advance
+ * @see yang_file_find_match
+ */
+static char *
+yang_prefetch_match_get(const char *module,
+                        const char *revision)
+{
+    yang_prefetch_match *ym;
+    int                  i;
+
+    for (i=0; i<_yang_prefetch_nmatches; i++){
+        ym = &_yang_prefetch_matches[i];
+        if (strcmp(ym->ym_module, module) == 0 &&
+            clicon_strcmp(ym->ym_revision, (char*)revision) == 0)
+            return _yang_prefetch[ym->ym_index].yf_filename;
+    }
+    return NULL;
+}
+
+/*! Find a YANG module file and add it to be parsed in advance
+ *
+ * @param[in] h         Clixon handle
+ * @param[in] module    Module or submodule name
+ * @param[in] revision  Revision or NULL
+ * @retval    0         OK, also if not found, then it is reported when parsed in order
+ * @retval   -1         Error
+ */
+static int
+yang_prefetch_module(clixon_handle h,
+                     const char   *module,
+                     const char   *revision)
+{
+    int                  retval = -1;
+    cbuf                *fbuf = NULL;
+    yang_prefetch_match *ym;
+    int                  i;
+    int                  nr;
+
+    if (yang_prefetch_match_get(module, revision) != NULL)
+        goto ok;
+    if ((fbuf = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if ((nr = yang_file_find_match(h, module, revision, NULL, fbuf)) < 0)
+        goto done;
+    if (nr == 0)
+        goto ok;
+    if ((i = yang_prefetch_file(cbuf_get(fbuf))) < 0)
+        goto done;
+    if ((ym = realloc(_yang_prefetch_matches, (_yang_prefetch_nmatches+1)*sizeof(*ym))) == NULL){
+        clixon_err(OE_YANG, errno, "realloc");
+        goto done;
+    }
+    _yang_prefetch_matches = ym;
+    ym = &_yang_prefetch_matches[_yang_prefetch_nmatches];
+    memset(ym, 0, sizeof(*ym));
+    ym->ym_index = i;
+    if ((ym->ym_module = strdup(module)) == NULL){
+        clixon_err(OE_YANG, errno, "strdup");
+        goto done;
+    }
+    if (revision && (ym->ym_revision = strdup(revision)) == NULL){
+        free(ym->ym_module);
+        clixon_err(OE_YANG, errno, "strdup");
+        goto done;
+    }
+    _yang_prefetch_nmatches++;
+ ok:
+    retval = 0;
+ done:
+    if (fbuf)
+        cbuf_free(fbuf);
+    return retval;
+}
+
+/*! Add files in a YANG directory to be parsed in advance
+ *
+ * Selects the same files as yang_spec_load_dir: x.yang, or if it does not exist, the
+ * newest x@rev.yang, unless x is already loaded.
+ * @param[in] dir    Directory
+ * @param[in] dp     Sorted yang files in directory
+ * @param[in] ndp    Number of files
+ * @param[in] yspec  Yang specification the files will be loaded into
+ * @retval    0      OK
+ * @retval   -1      Error
+ */
+static int
+yang_prefetch_dir(char          *dir,
+                  struct dirent *dp,
+                  int            ndp,
+                  yang_stmt     *yspec)
+{
+    int      retval = -1;
+    char     filename[MAXPATHLEN];
+    char    *base = NULL;
+    char    *nextbase = NULL;
+    uint32_t revf;
+    int      last;  /* Last file with this base */
+    int      taken = 0;
+    int      i;
+
+    for (i = 0; i < ndp; i++){
+        if (filename2revision(dp[i].d_name, &base, &revf) < 0)
+            goto done;
+        if (i+1 < ndp &&
+            filename2revision(dp[i+1].d_name, &nextbase, NULL) < 0)
+            goto done;
+        last = nextbase == NULL || strcmp(base, nextbase) != 0;
+        if ((revf == 0 || (last && !taken)) &&
+            yang_find(yspec, Y_MODULE, base) == NULL &&
+            yang_find(yspec, Y_SUBMODULE, base) == NULL){
+            snprintf(filename, MAXPATHLEN-1, "%s/%s", dir, dp[i].d_name);
+            if (yang_prefetch_file(filename) < 0)
+                goto done;
+        }
+        taken = last ? 0 : (taken || revf == 0);
+        free(base);
+        base = NULL;
+        if (nextbase){
+            free(nextbase);
+            nextbase = NULL;
+        }
+    }
+    retval = 0;
+ done:
+    if (base)
+        free(base);
+    if (nextbase)
+        free(nextbase);
+    return retval;
+}
+
+/*! Parse added files and their imports and includes in advance using worker threads
+ *
+ * Files are parsed in rounds: first the added files, then the imports and includes of
+ * the parsed files that are not already loaded, and so on.
+ * The main thread also parses files while waiting for the worker threads.
+ * @param[in] h      Clixon handle
+ * @param[in] yspec  Yang specification the files will be loaded into
+ * @retval    0      OK
+ * @retval   -1      Error
+ * @see yang_parse_recurse which loads the files in order
+ */
+static int
+yang_prefetch_parse(clixon_handle h,
+                    yang_stmt    *yspec)
+{
+    int            retval = -1;
+    pthread_t     *tids = NULL;
+    int            ntids;
+    int            nthreads;
+    int            i;
+    int            j;
+    int            from;
+    yang_stmt     *ymod;
+    yang_stmt     *yi;
+    yang_stmt     *yrev;
+    enum rfc_6020  keyw;
+    int            inext;
+
+    if ((nthreads = sysconf(_SC_NPROCESSORS_ONLN)) > YANG_PARSE_THREADS)
+        nthreads = YANG_PARSE_THREADS;
+    if ((tids = calloc(nthreads, sizeof(*tids))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    while ((from = _yang_prefetch_next) < _yang_prefetch_len){
+        ntids = 0;
+        for (i=1; i<nthreads && i<_yang_prefetch_len-from; i++){
+            /* If thread cannot be created, the remaining threads parse the files */
+            if (pthread_create(&tids[ntids], NULL, yang_prefetch_worker, NULL) != 0)
+                break;
+            ntids++;
+        }
+        yang_prefetch_worker(NULL);
+        for (i=0; i<ntids; i++)
+            pthread_join(tids[i], NULL);
+        _yang_prefetch_next = _yang_prefetch_len;
+        /* Add imports and includes of parsed files */
+        for (j=from; j<_yang_prefetch_next; j++){
+            if ((ymod = _yang_prefetch[j].yf_module) == NULL)
+                continue;
+            inext = 0;
+            while ((yi = yn_iter(ymod, &inext)) != NULL){
+                keyw = yang_keyword_get(yi);
+                if (keyw != Y_IMPORT && keyw != Y_INCLUDE)
+                    continue;
+                if (yang_find(yspec, keyw==Y_IMPORT?Y_MODULE:Y_SUBMODULE, yang_argument_get(yi)) != NULL)
+                    continue;
+                yrev = yang_find(yi, Y_REVISION_DATE, NULL);
+                if (yang_prefetch_module(h, yang_argument_get(yi), yrev?yang_argument_get(yrev):NULL) < 0)
+                    goto done;
+            }
+        }
+    }
+    retval = 0;
+ done:
+    if (tids)
+        free(tids);
+    return retval;
+}
+
+/*! Check statement syntax of a (sub)module parsed in advance
+ *
+ * @param[in] ys        Yang statement
+ * @param[in] filename  Name of file
+ * @retval    0         OK
+ * @retval   -1         Error
+ * @see ysp_add which checks the syntax when parsing in order
+ */
+static int
+ys_parse_sub_deferred(yang_stmt  *ys,
+                      const char *filename)
+{
+    yang_stmt *yc;
+    int        inext;
+
+    if (ys_parse_sub(ys, filename, NULL) < 0){
+        clixon_log(NULL, LOG_NOTICE, "Yang error: %s on line %d", filename, yang_linenum_get(ys));
+        return -1;
+    }
+    inext = 0;
+    while ((yc = yn_iter(ys, &inext)) != NULL)
+        if (ys_parse_sub_deferred(yc, filename) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Take a YANG file parsed in advance and add it to yang spec
+ *
+ * @param[in]  filename  Full filename
+ * @param[in]  yspec     Yang specification
+ * @param[out] ymodp     Top-level yang (sub)module
+ * @retval     1         Taken
+ * @retval     0         Not parsed in advance or failed, parse it again
+ * @retval    -1         Error
+ */
+static int
+yang_prefetch_take(const char *filename,
+                   yang_stmt  *yspec,
+                   yang_stmt **ymodp)
+{
+    yang_prefetch *yf;
+    yang_stmt     *ymod;
+    int            i;
+
+    for (i=0; i<_yang_prefetch_len; i++)
+        if (strcmp(_yang_prefetch[i].yf_filename, filename) == 0)
+            break;
+    if (i == _yang_prefetch_len)
+        return 0;
+    yf = &_yang_prefetch[i];
+    if ((ymod = yf->yf_module) == NULL)
+        return 0;
+    yf->yf_module = NULL;
+    if (ys_prune_self(ymod) < 0)
+        return -1;
+    if (yn_insert(yspec, ymod) < 0){
+        ys_free(ymod);
+        return -1;
+    }
+    if (yang_filename_set(ymod, filename) < 0)
+        return -1;
+#ifdef OPTIMIZE_YSPEC_NAMESPACE
+    yspec_nscache_clear(yspec);
+#endif
+    if (ys_parse_sub_deferred(ymod, filename) < 0)
+        return -1;
+    *ymodp = ymod;
+    return 1;
+}
+#endif /* YANG_PARSE_THREADS */
+
 /*! Open a file, read into a string and invoke yang parsing
  *
  * Similar to clicon_yang_str(), just read a file first
@@ -1161,8 +1655,18 @@ yang_parse_filename(clixon_handle h,
     yang_stmt    *ymod = NULL;
     FILE         *fp = NULL;
     struct stat   st;
+#ifdef YANG_PARSE_THREADS
+    int           ret;
+#endif
 
     clixon_debug(CLIXON_DBG_YANG, "%s", filename);
+#ifdef YANG_PARSE_THREADS
+    /* Parsed in advance by worker thread */
+    if ((ret = yang_prefetch_take(filename, yspec, &ymod)) < 0)
+        goto done;
+    if (ret == 1)
+        goto patch;
+#endif
     if (stat(filename, &st) < 0){
         clixon_err(OE_YANG, errno, "%s not found", filename);
         goto done;
@@ -1173,6 +1677,9 @@ yang_parse_filename(clixon_handle h,
     }
     if ((ymod = yang_parse_file(fp, filename, yspec)) < 0)
         goto done;
+#ifdef YANG_PARSE_THREADS
+ patch:
+#endif
     /* YANG patch hook */
     if (ymod && h && clixon_plugin_yang_patch_all(h, ymod) < 0)
         goto done;
@@ -1218,8 +1725,18 @@ yang_parse_module(clixon_handle h,
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
+    nr = 0;
+#ifdef YANG_PARSE_THREADS
+    /* Matched when parsing in advance */
+    if (domain == NULL &&
+        (filename = yang_prefetch_match_get(module, revision)) != NULL){
+        cprintf(fbuf, "%s", filename);
+        nr = 1;
+    }
+#endif
     /* Match a yang file with or without revision in yang-dir list */
-    if ((nr = yang_file_find_match(h, module, revision, domain, fbuf)) < 0)
+    if (nr == 0 &&
+        (nr = yang_file_find_match(h, module, revision, domain, fbuf)) < 0)
         goto done;
     if (nr == 0){
         if ((cb = cbuf_new()) == NULL){
@@ -1665,6 +2182,9 @@ yang_spec_parse_module(clixon_handle h,
     int         retval = -1;
     int         modmin;       /* Existing number of modules */
     char       *base = NULL;;
+#ifdef YANG_PARSE_THREADS
+    int         prefetch = 0;
+#endif
 
     if (yspec == NULL){
         clixon_err(OE_YANG, EINVAL, "yang spec is NULL");
@@ -1679,6 +2199,15 @@ yang_spec_parse_module(clixon_handle h,
     /* Do not load module if it already exists */
     if (yang_find_module_by_name_revision(yspec, name, revision) != NULL)
         goto ok;
+#ifdef YANG_PARSE_THREADS
+    /* Parse module and its imports and includes in advance */
+    if ((prefetch = yang_prefetch_start()) == 1){
+        if (yang_prefetch_module(h, name, revision) < 0)
+            goto done;
+        if (yang_prefetch_parse(h, yspec) < 0)
+            goto done;
+    }
+#endif
     /* Find a yang module and parse it and all its submodules */
     if (yang_parse_module(h, name, revision, yspec, NULL, NULL) == NULL)
         goto done;
@@ -1687,6 +2216,10 @@ yang_spec_parse_module(clixon_handle h,
  ok:
     retval = 0;
  done:
+#ifdef YANG_PARSE_THREADS
+    if (prefetch)
+        yang_prefetch_exit();
+#endif
     if (base)
         free(base);
     return retval;
@@ -1711,6 +2244,9 @@ yang_spec_parse_file(clixon_handle h,
     int         retval = -1;
     int         modmin;       /* Existing number of modules */
     char       *base = NULL;;
+#ifdef YANG_PARSE_THREADS
+    int         prefetch = 0;
+#endif
 
     /* Apply steps 2.. on new modules, ie ones after modmin. */
     modmin = yang_len_get(yspec);
@@ -1727,6 +2263,15 @@ yang_spec_parse_file(clixon_handle h,
         *index(base, '@') = '\0';
     if (yang_find(yspec, Y_MODULE, base) != NULL)
         goto ok;
+#ifdef YANG_PARSE_THREADS
+    /* Parse file and its imports and includes in advance */
+    if ((prefetch = yang_prefetch_start()) == 1){
+        if (yang_prefetch_file(filename) < 0)
+            goto done;
+        if (yang_prefetch_parse(h, yspec) < 0)
+            goto done;
+    }
+#endif
     if (yang_parse_filename(h, filename, yspec) == NULL)
         goto done;
     if (yang_parse_post(h, yspec, modmin) < 0)
@@ -1734,6 +2279,10 @@ yang_spec_parse_file(clixon_handle h,
  ok:
     retval = 0;
  done:
+#ifdef YANG_PARSE_THREADS
+    if (prefetch)
+        yang_prefetch_exit();
+#endif
     if (base)
         free(base);
     return retval;
@@ -1776,6 +2325,9 @@ yang_spec_load_dir(clixon_handle h,
     uint32_t       rev0; /* revision in existing module */
     char          *oldbase = NULL;
     int            taken = 0;
+#ifdef YANG_PARSE_THREADS
+    int            prefetch = 0;
+#endif
 
     /* Get yang files names from yang module directory. Note that these
      * are sorted alphatetically:
@@ -1789,6 +2341,15 @@ yang_spec_load_dir(clixon_handle h,
         goto ok;
     /* Apply post steps on new modules, ie ones after modmin. */
     modmin = yang_len_get(yspec);
+#ifdef YANG_PARSE_THREADS
+    /* Parse files and their imports and includes in advance */
+    if ((prefetch = yang_prefetch_start()) == 1){
+        if (yang_prefetch_dir(dir, dp, ndp, yspec) < 0)
+            goto done;
+        if (yang_prefetch_parse(h, yspec) < 0)
+            goto done;
+    }
+#endif
     /* Load all yang files in dir */
     for (i = 0; i < ndp; i++) {
         /* base = module name [+ @rev ] + .yang */
@@ -1860,6 +2421,10 @@ yang_spec_load_dir(clixon_handle h,
  ok:
     retval = 0;
   done:
+#ifdef YANG_PARSE_THREADS
+    if (prefetch)
+        yang_prefetch_exit();
+#endif
     if (dp)
         free(dp);
     if (base)
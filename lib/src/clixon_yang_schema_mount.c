@@ -211,6 +211,11 @@ yang_mount_get(yang_stmt  *ys,
         clixon_err(OE_YANG, ENOENT, "Top-level yang mounts not found");
         goto done;
     }
+    /* Index miss: the mount may be added without index, eg by yspec_new_shared */
+    if (xpath != NULL && yang_mount_index_get(ymounts, 0, xpath, &yspec) == 1){
+        *yspecp = yspec;
+        goto ok;
+    }
     inext = 0;
     ydomain = NULL;
     while ((ydomain = yn_iter(ymounts, &inext)) != NULL) {
@@ -227,6 +232,7 @@ yang_mount_get(yang_stmt  *ys,
             break;
     }
     *yspecp = yspec;
+ ok:
     retval = 0;
  done:
     return retval;
@@ -705,6 +711,50 @@ yang_schema_mount_statedata(clixon_handle h,
     goto done;
 }
 
+#ifdef YANG_SCHEMA_MOUNT_INDEX
+/*! Given yanglib, find existing yspec with same yang-library content
+ *
+ * The key is the serialized yang-library, ie equal content shares one yspec
+ * @param[in]   h        Clixon handle
+ * @param[in]   xyanglib yanglib in XML
+ * @param[out]  key      Yang-library content key, free with cbuf_free
+ * @param[out]  yspecp   Yang spec, or NULL if not found
+ * @retval      0        OK
+ * @retval     -1        Error
+ */
+static int
+yang_schema_find_share(clixon_handle h,
+                       cxobj        *xyanglib,
+                       cbuf        **key,
+                       yang_stmt   **yspecp)
+{
+    int        retval = -1;
+    cbuf      *cb = NULL;
+    yang_stmt *ymounts;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cb, xyanglib, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    if ((ymounts = clixon_yang_mounts_get(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "Top-level yang mounts not found");
+        goto done;
+    }
+    *yspecp = NULL;
+    if (yang_mount_index_get(ymounts, 1, cbuf_get(cb), yspecp) < 0)
+        goto done;
+    *key = cb;
+    cb = NULL;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+#else /* YANG_SCHEMA_MOUNT_INDEX */
 /*! Given xml mount-point and yanglib, find existing yspec
  *
  * Get and loop through all XML from xt mount-points.
@@ -768,6 +818,7 @@ yang_schema_find_share(clixon_handle h,
         cvec_free(cvv);
     return retval;
 }
+#endif /* YANG_SCHEMA_MOUNT_INDEX */
 
 /*! Given yanglib, mount it, potentially create a new yspec, and parse all its yangs
  *
@@ -794,6 +845,7 @@ yang_schema_yanglib_mount_parse(clixon_handle h,
     yang_stmt *yspec1 = NULL;
     char      *xpath = NULL;
     cbuf      *cb = NULL;
+    cbuf      *key = NULL;
     int        ret;
     static unsigned int nr = 0;
 
@@ -819,8 +871,13 @@ yang_schema_yanglib_mount_parse(clixon_handle h,
             goto done;
     }
     /* Optimization: find equal yspec from other mount-point */
+#ifdef YANG_SCHEMA_MOUNT_INDEX
+    if (yang_schema_find_share(h, xyanglib, &key, &yspec0) < 0)
+        goto done;
+#else
     if (yang_schema_find_share(h, xt, xyanglib, &yspec0) < 0)
         goto done;
+#endif
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_YANG, errno, "cbuf_new");
         goto done;
@@ -839,6 +896,11 @@ yang_schema_yanglib_mount_parse(clixon_handle h,
     }
     if (xml_yang_mount_set(h, xt, yspec1) < 0)
         goto done;
+    if (yang_mount_index_set(ymounts, 0, xpath, yspec1) < 0)
+        goto done;
+    if (key && yspec0 == NULL &&
+        yang_mount_index_set(ymounts, 1, cbuf_get(key), yspec1) < 0)
+        goto done;
     if (yspecp)
         *yspecp = yspec1;
     yspec1 = NULL;
@@ -848,6 +910,8 @@ yang_schema_yanglib_mount_parse(clixon_handle h,
         ys_free(yspec1);
     if (cb)
         cbuf_free(cb);
+    if (key)
+        cbuf_free(key);
     if (xpath)
         free(xpath);
     return retval;
@@ -958,6 +1022,8 @@ yang_schema_yspec_rm(clixon_handle h,
     if (ret == 1 && xpath != NULL && yspec != NULL){
         if (yang_cvec_rm(yspec, xpath) < 0)
             goto done;
+        if (yang_mount_index_set(ys_mounts(yspec), 0, xpath, NULL) < 0)
+            goto done;
 #if 0
         cvec      *cvv;
         /* see https://github.com/clicon/clixon-controller/issues/169
@@ -160,6 +160,48 @@ static const map_str2int ytmap2[] = {
     {NULL,         -1}
 };
 
+#ifdef YANG_TYPE_VALIDATOR
+/*! Kind of compiled type validator, given by the resolved built-in type
+ */
+enum yv_kind{
+    YV_BASIC,   /* Ranges, lengths and patterns only */
+    YV_ENUM,    /* enumeration: value is one of the enum names */
+    YV_BITS,    /* bits: value is a list of bit names */
+    YV_UNION,   /* union: first member type that validates */
+    YV_LEAFREF, /* leafref: validated as referred node */
+};
+
+/*! Range or length interval of a compiled type validator
+ */
+struct yv_interval{
+    union {
+        int64_t  i;  /* Signed integers and decimal64 */
+        uint64_t u;  /* Unsigned integers and string lengths */
+    } yi_min, yi_max;
+};
+
+/*! Compiled validator of a resolved yang type, built with the yang type cache
+ *
+ * The range/length cvec and the compiled regexps are owned by the type cache
+ * @see ys_cv_validate
+ */
+struct yang_type_validator{
+    enum yv_kind        yv_kind;
+    enum cv_type        yv_cvtype;     /* Cligen type of resolved type */
+    uint8_t             yv_fraction;   /* Fraction digits for decimal64 */
+    int                 yv_signed;     /* Intervals are signed */
+    int                 yv_nintervals; /* Nr of range or length intervals, 0 if none */
+    struct yv_interval *yv_intervals;
+    cvec               *yv_cvv;        /* Range or length cvec for error messages */
+    cvec               *yv_regexps;    /* Compiled patterns, NULL if none */
+    char              **yv_names;      /* Sorted enum or bit names */
+    int                 yv_nnames;
+    yang_stmt         **yv_members;    /* Union member types */
+    int                 yv_nmembers;
+    yang_stmt          *yv_restype;    /* Resolved type */
+};
+#endif /* YANG_TYPE_VALIDATOR */
+
 /* return 1 if built-in, 0 if not */
 static int
 yang_builtin(char *type)
@@ -180,7 +222,7 @@ yang_builtin(char *type)
  * @see match_regexp  in cligen code
  * @see yang_type_resolve_restrictions  where patterns is set
  */
-static int
+int
 compile_pattern2regexp(clixon_handle h,
                        yang_stmt    *ytype,
                        cvec         *patterns,
@@ -989,6 +1031,516 @@ ys_cv_validate_union(clixon_handle h,
     return retval;
 }
 
+#ifdef YANG_TYPE_VALIDATOR
+static int
+yv_strcmp(const void *a,
+          const void *b)
+{
+    return strcmp(*(char **)a, *(char **)b);
+}
+
+/*! Collect names of enum or bit children of resolved type, sorted
+ */
+static int
+yv_names_compile(yang_type_validator *yv,
+                 yang_stmt           *yrestype,
+                 enum rfc_6020        keyword)
+{
+    int        retval = -1;
+    yang_stmt *yc;
+    int        inext;
+
+    if ((yv->yv_names = calloc(yang_len_get(yrestype)+1, sizeof(char *))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    inext = 0;
+    while ((yc = yn_iter(yrestype, &inext)) != NULL){
+        if (yang_keyword_get(yc) == keyword)
+            yv->yv_names[yv->yv_nnames++] = yang_argument_get(yc);
+    }
+    qsort(yv->yv_names, yv->yv_nnames, sizeof(char *), yv_strcmp);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Translate range or length cvec to interval table, see cv_validate1 for the format
+ */
+static int
+yv_intervals_compile(yang_type_validator *yv,
+                     cvec                *cvv)
+{
+    int                 retval = -1;
+    cg_var             *cv1;
+    cg_var             *cv2;
+    struct yv_interval *yi;
+    int                 i;
+
+    switch (yv->yv_cvtype){
+    case CGV_INT8:
+    case CGV_INT16:
+    case CGV_INT32:
+    case CGV_INT64:
+    case CGV_DEC64:
+        yv->yv_signed = 1;
+        break;
+    case CGV_UINT8:
+    case CGV_UINT16:
+    case CGV_UINT32:
+    case CGV_UINT64:
+    case CGV_STRING:
+    case CGV_REST:
+        break;
+    default: /* No range check */
+        goto ok;
+    }
+    if ((yv->yv_intervals = calloc(cvec_len(cvv), sizeof(*yv->yv_intervals))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    i = 0;
+    while (i<cvec_len(cvv)){
+        cv1 = cvec_i(cvv, i++); /* Increment to check for max pair */
+        if (strcmp(cv_name_get(cv1),"range_min") != 0){
+            clixon_err(OE_YANG, EINVAL, "Internal error, expected range_min");
+            goto done;
+        }
+        if (i<cvec_len(cvv) &&
+            (cv2 = cvec_i(cvv, i)) != NULL &&
+            strcmp(cv_name_get(cv2),"range_max") == 0){
+            i++;
+        }
+        else
+            cv2 = cv1;
+        yi = &yv->yv_intervals[yv->yv_nintervals++];
+        switch (yv->yv_cvtype){
+        case CGV_INT8:
+            yi->yi_min.i = cv_int8_get(cv1);
+            yi->yi_max.i = cv_int8_get(cv2);
+            break;
+        case CGV_INT16:
+            yi->yi_min.i = cv_int16_get(cv1);
+            yi->yi_max.i = cv_int16_get(cv2);
+            break;
+        case CGV_INT32:
+            yi->yi_min.i = cv_int32_get(cv1);
+            yi->yi_max.i = cv_int32_get(cv2);
+            break;
+        case CGV_INT64:
+        case CGV_DEC64:
+            yi->yi_min.i = cv_int64_get(cv1);
+            yi->yi_max.i = cv_int64_get(cv2);
+            break;
+        case CGV_UINT8:
+            yi->yi_min.u = cv_uint8_get(cv1);
+            yi->yi_max.u = cv_uint8_get(cv2);
+            break;
+        case CGV_UINT16:
+            yi->yi_min.u = cv_uint16_get(cv1);
+            yi->yi_max.u = cv_uint16_get(cv2);
+            break;
+        case CGV_UINT32:
+            yi->yi_min.u = cv_uint32_get(cv1);
+            yi->yi_max.u = cv_uint32_get(cv2);
+            break;
+        default: /* uint64 and string length */
+            yi->yi_min.u = cv_uint64_get(cv1);
+            yi->yi_max.u = cv_uint64_get(cv2);
+            break;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Compile validator of a resolved yang type
+ *
+ * Called when the type cache is set. Types that cannot be translated to a cligen type
+ * are not compiled and are validated as before via yang_type_get.
+ * @param[in]  yrestype Resolved built-in type
+ * @param[in]  options  Flags field of optional values, see YANG_OPTIONS_*
+ * @param[in]  cvv      Cvec with min/max range or length (owned by type cache)
+ * @param[in]  regexps  Compiled regexps (owned by type cache)
+ * @param[in]  fraction For decimal64, how many digits after period
+ * @param[out] yvp      Compiled validator, or NULL if not compiled. Free with yang_type_validator_free
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+int
+yang_type_validator_new(yang_stmt            *yrestype,
+                        int                   options,
+                        cvec                 *cvv,
+                        cvec                 *regexps,
+                        uint8_t               fraction,
+                        yang_type_validator **yvp)
+{
+    int                  retval = -1;
+    yang_type_validator *yv = NULL;
+    char                *restype;
+    enum cv_type         cvtype;
+    yang_stmt           *yc;
+    int                  inext;
+
+    *yvp = NULL;
+    if ((restype = yang_argument_get(yrestype)) == NULL)
+        goto ok;
+    if (yang2cv_type(restype, &cvtype) < 0)
+        goto done;
+    if (cvtype == CGV_ERR)
+        goto ok;
+    if ((yv = calloc(1, sizeof(*yv))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    yv->yv_kind = YV_BASIC;
+    yv->yv_cvtype = cvtype;
+    yv->yv_fraction = fraction;
+    yv->yv_restype = yrestype;
+    yv->yv_cvv = cvv;
+    if (regexps && cvec_len(regexps))
+        yv->yv_regexps = regexps;
+    if (strcmp(restype, "union") == 0){
+        yv->yv_kind = YV_UNION;
+        if ((yv->yv_members = calloc(yang_len_get(yrestype)+1, sizeof(yang_stmt *))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        inext = 0;
+        while ((yc = yn_iter(yrestype, &inext)) != NULL){
+            if (yang_keyword_get(yc) == Y_TYPE)
+                yv->yv_members[yv->yv_nmembers++] = yc;
+        }
+    }
+    else if (strcmp(restype, "leafref") == 0)
+        yv->yv_kind = YV_LEAFREF;
+    else if (strcmp(restype, "enumeration") == 0){
+        yv->yv_kind = YV_ENUM;
+        if (yv_names_compile(yv, yrestype, Y_ENUM) < 0)
+            goto done;
+    }
+    else if (strcmp(restype, "bits") == 0){
+        yv->yv_kind = YV_BITS;
+        if (yv_names_compile(yv, yrestype, Y_BIT) < 0)
+            goto done;
+    }
+    if ((options & (YANG_OPTIONS_RANGE|YANG_OPTIONS_LENGTH)) != 0 && cvv != NULL){
+        if (yv_intervals_compile(yv, cvv) < 0)
+            goto done;
+    }
+    *yvp = yv;
+    yv = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (yv)
+        yang_type_validator_free(yv);
+    return retval;
+}
+
+/*! Free compiled type validator
+ *
+ * @param[in]  yv  Compiled validator
+ */
+int
+yang_type_validator_free(yang_type_validator *yv)
+{
+    if (yv->yv_intervals)
+        free(yv->yv_intervals);
+    if (yv->yv_names)
+        free(yv->yv_names);
+    if (yv->yv_members)
+        free(yv->yv_members);
+    free(yv);
+    return 0;
+}
+
+/*! Get compiled validator of a leaf or leaf-list, using original tree as yang_type_get
+ */
+static yang_type_validator *
+ys_type_validator(yang_stmt *ys)
+{
+    yang_stmt *ytype;
+    yang_stmt *yorig;
+    yang_stmt *yt;
+
+    if ((ytype = yang_find(ys, Y_TYPE, NULL)) == NULL)
+        return NULL;
+    if ((yorig = yang_orig_get(ys)) != NULL && yang_flag_get(ytype, YANG_FLAG_REFINE) == 0 &&
+        (yt = yang_find(yorig, Y_TYPE, NULL)) != NULL)
+        ytype = yt;
+    return yang_type_cache_validator(ytype);
+}
+
+/*! Validate cligen variable with compiled validator, same semantics as cv_validate1
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  yv      Compiled validator
+ * @param[in]  cv      A cligen variable to validate. This is a correctly parsed cv.
+ * @param[out] reason  If given, and return value is 0, contains malloced str
+ * @retval     1       Validation OK
+ * @retval     0       Validation not OK, malloced reason is returned. Free reason with free()
+ * @retval    -1       Error
+ */
+static int
+yv_validate(clixon_handle        h,
+            yang_type_validator *yv,
+            cg_var              *cv,
+            char               **reason)
+{
+    int                 retval = -1;
+    struct yv_interval *yi;
+    int64_t             ii = 0;
+    uint64_t            uu = 0;
+    char               *str;
+    char              **vec = NULL;
+    int                 nvec;
+    char               *v;
+    int                 i;
+    int                 ret;
+
+    if (reason && *reason){
+        free(*reason);
+        *reason = NULL;
+    }
+    if (yv->yv_nintervals){
+        switch (yv->yv_cvtype){
+        case CGV_INT8:
+            ii = cv_int8_get(cv);
+            break;
+        case CGV_INT16:
+            ii = cv_int16_get(cv);
+            break;
+        case CGV_INT32:
+            ii = cv_int32_get(cv);
+            break;
+        case CGV_INT64:
+        case CGV_DEC64:
+            ii = cv_int64_get(cv);
+            break;
+        case CGV_UINT8:
+            uu = cv_uint8_get(cv);
+            break;
+        case CGV_UINT16:
+            uu = cv_uint16_get(cv);
+            break;
+        case CGV_UINT32:
+            uu = cv_uint32_get(cv);
+            break;
+        case CGV_UINT64:
+            uu = cv_uint64_get(cv);
+            break;
+        default: /* String length, no string equals empty string */
+            if ((str = cv_string_get(cv)) != NULL)
+                uu = strlen(str);
+            break;
+        }
+        for (i=0; i<yv->yv_nintervals; i++){
+            yi = &yv->yv_intervals[i];
+            if (yv->yv_signed){
+                if (ii >= yi->yi_min.i && ii <= yi->yi_max.i)
+                    break;
+            }
+            else if (uu >= yi->yi_min.u && uu <= yi->yi_max.u)
+                break;
+        }
+        if (i == yv->yv_nintervals){
+            if (reason){
+                if (yv->yv_cvtype == CGV_STRING || yv->yv_cvtype == CGV_REST){
+                    if (outoflength(uu, yv->yv_cvv, reason) < 0)
+                        goto done;
+                }
+                else if (outofrange(cv, yv->yv_cvv, reason) < 0)
+                    goto done;
+            }
+            goto fail;
+        }
+    }
+    switch (yv->yv_cvtype){
+    case CGV_STRING:
+    case CGV_REST:
+        str = cv_string_get(cv);
+        if (yv->yv_kind == YV_ENUM){
+            if (str == NULL ||
+                bsearch(&str, yv->yv_names, yv->yv_nnames, sizeof(char *), yv_strcmp) == NULL){
+                if (reason)
+                    *reason = cligen_reason("'%s' does not match enumeration", str);
+                goto fail;
+            }
+        }
+        else if (yv->yv_kind == YV_BITS && str != NULL){
+            /* Space-separated list of the names of the bits that are set */
+            str = clixon_trim2(str, " \t\n");
+            nvec = 0;
+            if ((vec = clicon_strsep(str, " \t", &nvec)) == NULL)
+                goto done;
+            for (i=0; i<nvec; i++){
+                if ((v = vec[i]) == NULL || !strlen(v))
+                    continue;
+                if (bsearch(&v, yv->yv_names, yv->yv_nnames, sizeof(char *), yv_strcmp) == NULL){
+                    if (reason)
+                        *reason = cligen_reason("'%s' does not match enumeration", v);
+                    goto fail;
+                }
+            }
+        }
+        if (yv->yv_regexps){
+            if ((ret = cv_validate_pattern(h, yv->yv_regexps, yv->yv_restype, str, reason)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+        break;
+    default:
+        break;
+    }
+    retval = 1; /* validation OK */
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Validate union with compiled validator, same semantics as ys_cv_validate_union
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  ys     Yang leaf or leaf-list
+ * @param[in]  yv     Compiled validator of union
+ * @param[in]  val    Value to match
+ * @param[out] ysubp  Member type of union that matches val
+ * @param[out] reason If given, and return value is 0, contains malloced string
+ * @retval     1      Validation OK
+ * @retval     0      Validation not OK, malloced reason is returned. Free reason with free()
+ * @retval    -1      Error
+ */
+static int
+yv_validate_union(clixon_handle        h,
+                  yang_stmt           *ys,
+                  yang_type_validator *yv,
+                  char                *val,
+                  yang_stmt          **ysubp,
+                  char               **reason)
+{
+    int                  retval = 1; /* valid */
+    yang_type_validator *ym;
+    yang_stmt           *yt;
+    cg_var              *cvt;
+    char                *reason1 = NULL;  /* saved reason */
+    int                  i;
+
+    for (i=0; i<yv->yv_nmembers; i++){
+        yt = yv->yv_members[i];
+        if ((ym = yang_type_cache_validator(yt)) == NULL)
+            retval = ys_cv_validate_union_one(h, ys, reason, yt, yang_argument_get(yt), val);
+        else if (ym->yv_kind == YV_UNION)
+            retval = yv_validate_union(h, ys, ym, val, NULL, reason);
+        else if (ym->yv_kind == YV_LEAFREF)
+            retval = ys_cv_validate_leafref(h, val, ys, ym->yv_restype, NULL, reason);
+        else if (val == NULL) /* Fail validation on NULL */
+            retval = 0;
+        else {
+            /* reparse value with the member type */
+            if ((cvt = cv_new(ym->yv_cvtype)) == NULL){
+                clixon_err(OE_UNIX, errno, "cv_new");
+                retval = -1;
+                goto done;
+            }
+            if (ym->yv_cvtype == CGV_DEC64)
+                cv_dec64_n_set(cvt, ym->yv_fraction);
+            if ((retval = cv_parse1(val, cvt, reason)) < 0)
+                clixon_err(OE_UNIX, errno, "cv_parse");
+            else if (retval == 1)
+                retval = yv_validate(h, ym, cvt, reason);
+            cv_free(cvt);
+        }
+        if (retval < 0)
+            goto done;
+        /* If validation failed, save reason, reset error and continue,
+         * save latest reason if nothing validates.
+         */
+        if (retval == 0 && reason && *reason != NULL){
+            if (reason1)
+                free(reason1);
+            reason1 = *reason;
+            *reason = NULL;
+        }
+        /* Enough that one type validates value */
+        if (retval == 1) {
+            if (ysubp)
+                *ysubp = yt;
+            break;
+        }
+    }
+ done:
+    if (retval == 0 && reason1){
+        *reason = reason1;
+        reason1 = NULL;
+    }
+    if (reason1)
+        free(reason1);
+    return retval;
+}
+
+/*! Validate cligen variable of leaf or leaf-list with compiled validator
+ *
+ * @see ys_cv_validate  for arguments and return values
+ */
+static int
+ys_cv_validate_compiled(clixon_handle        h,
+                        cg_var              *cv,
+                        yang_stmt           *ys,
+                        yang_type_validator *yv,
+                        yang_stmt          **ysub,
+                        char               **reason)
+{
+    int     retval = -1;
+    cg_var *ycv;
+    char   *val;
+
+    ycv = yang_cv_get(ys);
+    if (cv_type_get(ycv) != yv->yv_cvtype){
+        /* special case: dbkey has rest syntax-> cv but yang cant have that */
+        if (yv->yv_cvtype == CGV_STRING && cv_type_get(ycv) == CGV_REST)
+            ;
+        else {
+            clixon_err(OE_DB, 0, "Type mismatch data:%s != yang:%s",
+                       cv_type2str(yv->yv_cvtype), cv_type2str(cv_type_get(ycv)));
+            goto done;
+        }
+    }
+    switch (yv->yv_kind){
+    case YV_UNION:
+    case YV_LEAFREF:
+        if (yv->yv_cvtype != CGV_REST){
+            clixon_err(OE_YANG, 0, "%s must be rest cv type but is %d",
+                       yang_argument_get(yv->yv_restype), yv->yv_cvtype);
+            goto done;
+        }
+        /* Instead of NULL, give an empty string to validate */
+        if ((val = cv_string_get(cv)) == NULL)
+            val = "";
+        if (yv->yv_kind == YV_UNION)
+            retval = yv_validate_union(h, ys, yv, val, ysub, reason);
+        else
+            retval = ys_cv_validate_leafref(h, val, ys, yv->yv_restype, ysub, reason);
+        break;
+    default:
+        if ((retval = yv_validate(h, yv, cv, reason)) < 0)
+            goto done;
+        if (ysub)
+            *ysub = ys;
+        break;
+    }
+ done:
+    return retval;
+}
+#endif /* YANG_TYPE_VALIDATOR */
+
 /*! Validate cligen variable cv using yang statement as spec
  *
  * @param[in]  h       Clixon handle     
@@ -1024,6 +1576,9 @@ ys_cv_validate(clixon_handle h,
     int             retval2;
     char           *val;
     cg_var         *cvt = NULL;
+#ifdef YANG_TYPE_VALIDATOR
+    yang_type_validator *yv;
+#endif
 
     if (reason)
         *reason=NULL;
@@ -1031,6 +1586,12 @@ ys_cv_validate(clixon_handle h,
         retval = 1;
         goto done;
     }
+#ifdef YANG_TYPE_VALIDATOR
+    if ((yv = ys_type_validator(ys)) != NULL){
+        retval = ys_cv_validate_compiled(h, cv, ys, yv, ysub, reason);
+        goto done;
+    }
+#endif
     ycv = yang_cv_get(ys);
     if ((patterns = cvec_new(0)) == NULL){
         clixon_err(OE_UNIX, errno, "cvec_new");
@@ -0,0 +1,281 @@
+#!/usr/bin/env bash
+# Backend output queue, see BACKEND_OUTPUT_QUEUE
+# A slow client subscribes to a notification stream, sends get-config requests with large
+# replies, and does not read its socket for a while.
+# 1. Notifications to the client are dropped above CLICON_SOCK_NOTIFY_HIGHWATER, queued
+#    replies are delivered with the same framing as unqueued replies
+# 2. The client is disconnected above CLICON_SOCK_OUTPUT_HIGHWATER, the backend and
+#    other clients are not affected
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries, each get-config reply must be larger than the socket buffer
+: ${perfnr:=20000}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example.yang
+sdb=$dir/startup_db
+cfile=$dir/slow-client.c
+app=$dir/slow-client
+out=$dir/slow-client.out
+
+# Create config with notify and output high-water marks
+# 1: notify high-water
+# 2: output high-water
+function testconfig()
+{
+    notify=$1
+    output=$2
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_STREAM_DISCOVERY_RFC5277>true</CLICON_STREAM_DISCOVERY_RFC5277>
+  <CLICON_NETCONF_MONITORING>true</CLICON_NETCONF_MONITORING>
+  <CLICON_SOCK_NOTIFY_HIGHWATER>$notify</CLICON_SOCK_NOTIFY_HIGHWATER>
+  <CLICON_SOCK_OUTPUT_HIGHWATER>$output</CLICON_SOCK_OUTPUT_HIGHWATER>
+</clixon-config>
+EOF
+}
+
+cat <<EOF > $fyang
+module example {
+  namespace "urn:example:clixon";
+  prefix ex;
+  notification event {
+    leaf event-class {
+      type string;
+    }
+    container reportingEntity {
+      leaf card {
+        type string;
+      }
+    }
+    leaf severity {
+      type string;
+    }
+  }
+  container state {
+    config false;
+    leaf-list op {
+      type string;
+    }
+  }
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+# Slow client: subscribe, send requests, wait without reading, then read until all
+# replies are received or the backend closes the socket
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <syslog.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+int
+main(int    argc,
+     char **argv)
+{
+    int                retval = -1;
+    clixon_handle      h = NULL;
+    struct clicon_msg *msg = NULL;
+    char              *retdata = NULL;
+    clixon_msg_rcv    *mr = NULL;
+    cbuf              *cb = NULL;
+    cbuf              *cbmsg = NULL;
+    int                s = -1;
+    int                eof = 0;
+    int                nr;
+    int                i;
+    int                replies = 0;
+    int                terminated = 0;
+
+    if (argc != 4){
+        fprintf(stderr, "usage: %s <cfg> <requests> <wait s>\n", argv[0]);
+        return -1;
+    }
+    nr = atoi(argv[2]);
+    if ((h = clixon_client_init(argv[1])) == NULL)
+        return -1;
+    if (clicon_rpc_connect(h, &s) < 0)
+        goto done;
+    if ((msg = clicon_msg_encode(0, "<hello xmlns=\"%s\"><capabilities><capability>%s</capability></capabilities></hello>",
+                                 NETCONF_BASE_NAMESPACE, NETCONF_BASE_CAPABILITY_1_1)) == NULL)
+        goto done;
+    if (clicon_rpc(s, NULL, msg, &retdata, &eof) < 0 || eof)
+        goto done;
+    if ((cb = cbuf_new()) == NULL)
+        goto done;
+    cprintf(cb, "<rpc xmlns=\"%s\" message-id=\"1\"><create-subscription xmlns=\"%s\"><stream>EXAMPLE</stream></create-subscription></rpc>",
+            NETCONF_BASE_NAMESPACE, EVENT_RFC5277_NAMESPACE);
+    if (clixon_msg_send11(s, NULL, cb) < 0)
+        goto done;
+    for (i=0; i<nr; i++){
+        cbuf_reset(cb);
+        cprintf(cb, "<rpc xmlns=\"%s\" message-id=\"%d\"><get-config><source><running/></source></get-config></rpc>",
+                NETCONF_BASE_NAMESPACE, i+2);
+        if (clixon_msg_send11(s, NULL, cb) < 0)
+            goto done;
+    }
+    sleep(atoi(argv[3]));
+    if ((mr = clixon_msg_rcv_new(0)) == NULL)
+        goto done;
+    /* Replies to create-subscription and get-config, notifications are skipped */
+    while (replies < nr + 1){
+        if (clixon_msg_rcv_next(s, NULL, mr, &cbmsg, &eof) < 0)
+            goto done;
+        if (eof)
+            break;
+        if (cbmsg == NULL)
+            continue;
+        if (strstr(cbuf_get(cbmsg), "<rpc-reply") != NULL){
+            replies++;
+            /* Replies are null-terminated as sent by send_msg_reply */
+            if (cbuf_len(cbmsg) > 0 && cbuf_get(cbmsg)[cbuf_len(cbmsg)-1] == '\0')
+                terminated++;
+        }
+        cbuf_free(cbmsg);
+        cbmsg = NULL;
+    }
+    printf("replies: %d\n", replies);
+    printf("terminated: %d\n", terminated);
+    if (eof)
+        printf("eof\n");
+    retval = 0;
+ done:
+    if (cbmsg)
+        cbuf_free(cbmsg);
+    if (cb)
+        cbuf_free(cb);
+    if (mr)
+        clixon_msg_rcv_free(mr);
+    if (msg)
+        free(msg);
+    if (retdata)
+        free(retdata);
+    if (s != -1)
+        close(s);
+    clixon_client_terminate(h);
+    return retval;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+new "generate startup config with $perfnr entries"
+echo -n "<config><table xmlns=\"urn:example:clixon\">" > $sdb
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<parameter><name>p$i</name><value>$i</value></parameter>" >> $sdb
+done
+echo "</table></config>" >> $sdb
+
+# Get sessions of netconf monitoring
+SESSIONS="<rpc $DEFAULTNS><get><filter type=\"subtree\"><netconf-state xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-monitoring\"><sessions/></netconf-state></filter></get></rpc>"
+
+# 1. Notify high-water: queue holds a get-config reply, notifications are dropped
+testconfig 1024 0
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg -- -n 1"
+    start_backend -s startup -f $cfg -- -n 1 # notification every second
+fi
+
+new "wait backend"
+wait_backend
+
+new "start slow client: 1 request, 5s without reading"
+sudo $app $cfg 1 5 > $out &
+pid=$!
+
+sleep 3
+
+new "slow client has queued output"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$SESSIONS" "<out-queued-bytes xmlns=\"http://clicon.org/lib\">[1-9][0-9]*</out-queued-bytes>" ""
+
+new "slow client notifications dropped"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$SESSIONS" "<out-notifications-dropped xmlns=\"http://clicon.org/lib\">[1-9][0-9]*</out-notifications-dropped>" ""
+
+new "wait slow client"
+wait $pid
+if [ $? -ne 0 ]; then
+    err1 "slow client exit 0"
+fi
+
+new "slow client got all replies, null-terminated"
+expectpart "$(cat $out)" 0 "replies: 2" "terminated: 2" --not-- "eof"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+fi
+
+# 2. Output high-water: a second get-config reply exceeds the limit, client is disconnected
+testconfig 1024 1000000
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s startup -f $cfg -- -n 1"
+    start_backend -s startup -f $cfg -- -n 1
+fi
+
+new "wait backend"
+wait_backend
+
+new "slow client: 4 requests, 3s without reading"
+expectpart "$(sudo $app $cfg 4 3)" 0 "eof" --not-- "replies: 5"
+
+new "backend alive, other client get-config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='p1']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>p1</name><value>1</value></parameter></table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,106 @@
+#!/usr/bin/env bash
+# Event loop timers with removal handles, see clixon_event_reg_timer
+# Register timers out of order, remove timers from the middle and top of the timer heap,
+# and check that the others fire in time order and that removed timers do not fire.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+cfile=$dir/event-timer.c
+app=$dir/event-timer
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+#define NTIMERS 9
+
+static clixon_event_timer *_th[NTIMERS];
+static int _fired = 0;
+
+/*! Print timer number, the handle must be cleared before the callback
+ */
+static int
+timer_cb(int   s,
+         void *arg)
+{
+    int i = (int)(intptr_t)arg;
+
+    printf("%d%s\n", i, _th[i] != NULL ? " stale handle" : "");
+    if (++_fired == NTIMERS - 3)
+        clixon_exit_set(1);
+    return 0;
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int            retval = -1;
+    clixon_handle  h;
+    struct timeval now;
+    struct timeval t;
+    /* Registration order, timer i fires at now + 50ms * (i+1) */
+    int            order[NTIMERS] = {4, 7, 1, 8, 0, 5, 2, 6, 3};
+    int            i;
+
+    if ((h = clixon_handle_init()) == NULL)
+        return -1;
+    gettimeofday(&now, NULL);
+    for (i=0; i<NTIMERS; i++){
+        t = now;
+        t.tv_usec += 50000 * (order[i] + 1);
+        t.tv_sec += t.tv_usec / 1000000;
+        t.tv_usec %= 1000000;
+        if (clixon_event_reg_timer(t, timer_cb, (void*)(intptr_t)order[i], "timer", &_th[order[i]]) < 0)
+            goto done;
+    }
+    /* Remove the earliest timer, at the top of the heap, and timers further down */
+    if (clixon_event_unreg_timer(&_th[5]) < 0 ||
+        clixon_event_unreg_timer(&_th[0]) < 0 ||
+        clixon_event_unreg_timer(&_th[3]) < 0)
+        goto done;
+    if (_th[5] != NULL || _th[0] != NULL || _th[3] != NULL)
+        printf("handle not cleared\n");
+    if (clixon_event_unreg_timer(&_th[5]) != -1)
+        printf("removed twice\n");
+    if (clixon_event_loop(h) < 0)
+        goto done;
+    retval = 0;
+ done:
+    clixon_handle_exit(h);
+    return retval;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+new "timers fire in time order, removed timers do not fire"
+ret=$($app)
+r=$?
+if [ $r -ne 0 ]; then
+    err1 "exit 0" "$r"
+fi
+match=$(echo "$ret" | tr '\n' ' ')
+if [ "$match" != "1 2 4 6 7 8 " ]; then
+    err1 "1 2 4 6 7 8 " "$match"
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
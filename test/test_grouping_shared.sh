@@ -0,0 +1,223 @@
+#!/usr/bin/env bash
+# Uses expansion sharing read-only statements with the grouping, see YANG_USES_SHARED
+# A grouping is used several times: without refine (shared), with refine, and with a
+# deviation of a shared node. Check that mandatory, max-elements and presence of
+# each expansion follows its own refine/deviation and not the other uses
+# Then compare yang statements and memory of a grouping used $nruses times with the same nodes
+# written inline: only read-only substatements are shared, schema nodes are still copied
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example.yang
+fyang2=$dir/example-dev.yang
+fyang3=$dir/example-uses.yang
+fyang4=$dir/example-inline.yang
+
+# Number of uses of the grouping
+: ${nruses:=20}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$dir</CLICON_YANG_MAIN_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+  yang-version 1.1;
+  namespace "urn:example:example";
+  prefix ex;
+  grouping g{
+    description "Shared grouping";
+    leaf m{
+      description "Mandatory leaf";
+      type string;
+      mandatory true;
+    }
+    leaf-list ll{
+      type string;
+      max-elements 2;
+      ordered-by user;
+    }
+    container p{
+      presence "Presence container";
+      leaf x{
+        type string;
+        units "seconds";
+      }
+    }
+  }
+  container shared{
+    uses g;
+  }
+  container refined{
+    uses g{
+      refine m{
+        mandatory false;
+      }
+      refine ll{
+        max-elements 3;
+      }
+    }
+  }
+  container deviated{
+    uses g;
+  }
+}
+EOF
+
+cat <<EOF > $fyang2
+module example-dev{
+  yang-version 1.1;
+  namespace "urn:example:dev";
+  prefix dev;
+  import example{
+    prefix ex;
+  }
+  deviation "/ex:deviated/ex:m" {
+    deviate replace{
+      mandatory false;
+    }
+  }
+}
+EOF
+
+# Leafs with read-only substatements, in grouping and inline
+leafs=""
+for i in 1 2 3 4; do
+    leafs="$leafs
+    leaf l$i{
+      description \"Leaf $i\";
+      reference \"RFC 7950\";
+      type uint32;
+      units \"seconds\";
+      status current;
+    }"
+done
+
+cat <<EOF > $fyang3
+module example-uses{
+  yang-version 1.1;
+  namespace "urn:example:uses";
+  prefix us;
+  grouping g{
+    $leafs
+  }
+EOF
+cat <<EOF > $fyang4
+module example-inline{
+  yang-version 1.1;
+  namespace "urn:example:inline";
+  prefix in;
+EOF
+for i in $(seq 1 $nruses); do
+    echo "  container c$i{ uses g; }" >> $fyang3
+    echo "  container c$i{ $leafs }" >> $fyang4
+done
+echo "}" >> $fyang3
+echo "}" >> $fyang4
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Shared expansion: missing mandatory leaf"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><shared xmlns=\"urn:example:example\"><ll>a</ll></shared></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate expect mandatory error"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<error-tag>missing-element</error-tag><error-info><bad-element>m</bad-element></error-info>" ""
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Refined expansion: mandatory refined to false, three entries"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><refined xmlns=\"urn:example:example\"><ll>a</ll><ll>b</ll><ll>c</ll></refined></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate ok"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Deviated expansion: mandatory replaced by false"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><deviated xmlns=\"urn:example:example\"><ll>a</ll></deviated></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate ok"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Shared expansion: three entries"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><shared xmlns=\"urn:example:example\"><m>x</m><ll>a</ll><ll>b</ll><ll>c</ll></shared></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate expect max-elements error"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<error-app-tag>too-many-elements</error-app-tag>" ""
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Shared expansion: presence container"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><shared xmlns=\"urn:example:example\"><m>x</m><p/></shared></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf get-config presence container kept"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><shared xmlns=\"urn:example:example\"><m>x</m><p/></shared></data></rpc-reply>"
+
+new "Shared uses: leaf of last expansion"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c$nruses xmlns=\"urn:example:uses\"><l4>42</l4></c$nruses></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Yang statements and memory of grouping used $nruses times and of inline nodes"
+ret=$($clixon_netconf -qf $cfg<<EOF
+$DEFAULTHELLO<rpc $DEFAULTNS><stats xmlns="http://clicon.org/lib"><modules>true</modules></stats></rpc>]]>]]>
+EOF
+)
+usesnr=$(echo "$ret" | sed -n 's/.*<module><name>example-uses<\/name><nr>\([0-9]*\)<\/nr><size>\([0-9]*\)<\/size>.*/\1/p')
+usessz=$(echo "$ret" | sed -n 's/.*<module><name>example-uses<\/name><nr>\([0-9]*\)<\/nr><size>\([0-9]*\)<\/size>.*/\2/p')
+inlinenr=$(echo "$ret" | sed -n 's/.*<module><name>example-inline<\/name><nr>\([0-9]*\)<\/nr><size>\([0-9]*\)<\/size>.*/\1/p')
+inlinesz=$(echo "$ret" | sed -n 's/.*<module><name>example-inline<\/name><nr>\([0-9]*\)<\/nr><size>\([0-9]*\)<\/size>.*/\2/p')
+if [ -z "$usesnr" -o -z "$inlinenr" ]; then
+    err "module stats" "$ret"
+fi
+echo "uses: $usesnr statements $usessz bytes, inline: $inlinenr statements $inlinesz bytes"
+# Without sharing the expansions alone have as many statements as the inline module.
+# With sharing description, reference, units and status, 4 of 6 statements per leaf, are
+# not copied, which more than makes up for the grouping and uses statements
+if [ $usesnr -ge $inlinenr ]; then
+    err1 "less than $inlinenr statements" "$usesnr"
+fi
+if [ $usessz -ge $inlinesz ]; then
+    err1 "less than $inlinesz bytes" "$usessz"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,177 @@
+#!/usr/bin/env bash
+# Event loop connection scaling, see EVENT_LOOP_EPOLL
+# Open $perfnr idle TCP connections to native RESTCONF and time $perfreq GET requests
+# while they are open, then close them and check that RESTCONF still responds.
+# Check that all requests succeed and that a request on the last idle connection is served,
+# with the default $perfnr its descriptor in RESTCONF is above FD_SETSIZE (1024).
+
+# Override default to use http/1.1, comment to use https/2
+RCPROTO=http
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Does not work with fcgi
+if [ "${WITH_RESTCONF}" = "fcgi" ]; then
+    echo "...skipped: Must run with --with-restconf=native"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+# Pin to http/1
+if [ ${HAVE_LIBNGHTTP2} = true -a ${HAVE_HTTP1} = true ]; then
+    HAVE_LIBNGHTTP2=false
+    CURLOPTS=${CURLOPTS/http2/http1.1}
+    HVER=1.1
+fi
+
+# Number of idle connections
+: ${perfnr:=4000}
+
+# Number of requests made while connections are open
+: ${perfreq:=100}
+
+# Both this shell and restconf need a descriptor per connection
+if [ $(ulimit -n) -lt $(( perfnr + 100 )) ]; then
+    ulimit -n $(( perfnr + 100 )) 2> /dev/null || perfnr=$(( $(ulimit -n) - 100 ))
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $dir/startup_db
+<config>
+  <table xmlns="urn:example:clixon">
+    <parameter><name>a</name><value>42</value></parameter>
+  </table>
+</config>
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "open $perfnr idle connections"
+fds=()
+for (( i=0; i<$perfnr; i++ )); do
+    exec {fd}<>/dev/tcp/127.0.0.1/80 || break
+    fds+=($fd)
+done
+if [ ${#fds[@]} -ne $perfnr ]; then
+    err1 "$perfnr connections" "${#fds[@]}"
+fi
+
+new "restconf $perfreq get with $perfnr idle connections, timing"
+{ time -p for (( i=0; i<$perfreq; i++ )); do
+    curl $CURLOPTS -o /dev/null -w "%{http_code}\n" -X GET $RCPROTO://localhost/restconf/data/clixon-example:table/parameter=a
+done > $dir/codes; } 2>&1 | awk '/real/ {print $2}'
+
+new "restconf $perfreq get with $perfnr idle connections, all succeed"
+match=$(grep -cx 200 $dir/codes)
+if [ $match -ne $perfreq ]; then
+    err1 "$perfreq 200" "$(sort $dir/codes | uniq -c)"
+fi
+
+new "restconf get with $perfnr idle connections"
+expectpart "$(curl $CURLOPTS -X GET -H 'Accept: application/yang-data+json' $RCPROTO://localhost/restconf/data/clixon-example:table/parameter=a)" 0 "HTTP/$HVER 200" '{"clixon-example:parameter":\[{"name":"a","value":"42"}\]}'
+
+if [ ${HVER} = 1.1 ]; then
+    new "restconf get on last idle connection"
+    fd=${fds[-1]}
+    printf "GET /restconf/data/clixon-example:table/parameter=a HTTP/1.1\r\nHost: localhost\r\nAccept: application/yang-data+json\r\n\r\n" >&$fd
+    read -t 10 -u $fd line
+    expectpart "$line" 0 "HTTP/1.1 200"
+fi
+
+new "close $perfnr idle connections"
+for fd in ${fds[@]}; do
+    exec {fd}>&-
+done
+unset fds
+
+new "restconf get after close"
+expectpart "$(curl $CURLOPTS -X GET -H 'Accept: application/yang-data+json' $RCPROTO://localhost/restconf/data/clixon-example:table/parameter=a)" 0 "HTTP/$HVER 200" '{"clixon-example:parameter":\[{"name":"a","value":"42"}\]}'
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
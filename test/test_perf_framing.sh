@@ -0,0 +1,147 @@
+#!/usr/bin/env bash
+# Performance of NETCONF message receive with end-of-message (1.0) and chunked (1.1) framing
+# Input is the netconf fuzz corpus in fuzz/netconf/input repeated $perfreq times followed by
+# an edit-config with $perfnr entries, with data containing ']', '>' and '#' near the delimiters.
+# Time clixon_netconf with each framing and check that all rpcs are replied to
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of entries in large edit-config
+: ${perfnr:=20000}
+
+# Number of times the fuzz corpus is repeated
+: ${perfreq:=100}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fuzzdir=fuzz/netconf/input
+feom=$dir/input_eom
+fchunk=$dir/input_chunked
+fbig=$dir/big.xml
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_NETCONF_BASE_CAPABILITY>1</CLICON_NETCONF_BASE_CAPABILITY>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+new "generate edit-config with $perfnr entries"
+echo -n "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\">" > $fbig
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<parameter><name>p$i</name><value>]]#$i]>#</value></parameter>" >> $fbig
+done
+echo -n "</table></config></edit-config></rpc>" >> $fbig
+
+# Number of rpcs: fuzz corpus, large edit-config and get-config
+nrfuzz=$(ls $fuzzdir | wc -l)
+nrrpc=$(( nrfuzz * perfreq + 2 ))
+get="<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='p$(( perfnr - 1 ))']/ex:name\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>"
+
+new "generate eom framing input"
+echo -n "$HELLONO11" > $feom
+for (( i=0; i<$perfreq; i++ )); do
+    cat $fuzzdir/* >> $feom
+done
+cat $fbig >> $feom
+echo -n "]]>]]>" >> $feom
+echo -n "$get]]>]]>" >> $feom
+
+new "generate chunked framing input"
+echo -n "$DEFAULTHELLO" > $fchunk
+for (( i=0; i<$perfreq; i++ )); do
+    for f in $fuzzdir/*; do
+        chunked_framing "$(sed 's/]]>]]>$//' $f)" >> $fchunk
+    done
+done
+chunked_framing "$(cat $fbig)" >> $fchunk
+chunked_framing "$get" >> $fchunk
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+for framing in eom chunked; do
+    if [ $framing = eom ]; then
+        input=$feom
+        base=0
+    else
+        input=$fchunk
+        base=1
+    fi
+
+    new "netconf $framing framing $nrrpc rpcs, timing"
+    { time -p $clixon_netconf -qf $cfg -o CLICON_NETCONF_BASE_CAPABILITY=$base < $input > $dir/reply_$framing; } 2>&1 | awk '/real/ {print $2}'
+
+    new "netconf $framing framing all rpcs replied"
+    match=$(grep -o "<rpc-reply" $dir/reply_$framing | wc -l)
+    if [ $match -ne $nrrpc ]; then
+        err1 "$nrrpc rpc-replies" "$match"
+    fi
+
+    new "netconf $framing framing large edit-config received"
+    match=$(grep -o "<name>p$(( perfnr - 1 ))</name>" $dir/reply_$framing | wc -l)
+    if [ $match -ne 1 ]; then
+        err1 "<name>p$(( perfnr - 1 ))</name>" "$match"
+    fi
+
+    new "netconf discard-changes"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+done
+
+unset framing
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,185 @@
+#!/usr/bin/env bash
+# Performance of identityref validation and derived-from() with many identities
+# See YANG_IDENTITY_BITSET. Generate a module with a wide and deep identity hierarchy,
+# a startup config with identityref values, and time backend startup validation.
+# Then check derived and non-derived values and the derived-from XPath functions, also for
+# identities in the last branch, which are in the last words of the derivation bitsets
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of identities and list entries
+: ${perfnr:=1000}
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/ids.yang
+fyang2=$dir/ids-ext.yang
+sdb=$dir/startup_db
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$dir</CLICON_YANG_MAIN_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+</clixon-config>
+EOF
+
+new "generate yang with $perfnr identities"
+cat <<EOF > $fyang
+module ids{
+  yang-version 1.1;
+  namespace "urn:example:ids";
+  prefix ids;
+  identity root;
+  identity other;
+  identity a0 {
+    base root;
+  }
+EOF
+# Every tenth identity starts a new branch from root, others derive from the previous
+for (( i=1; i<$perfnr; i++ )); do
+    if [ $(( i % 10 )) -eq 0 ]; then
+        echo "  identity a$i { base root; }" >> $fyang
+    else
+        echo "  identity a$i { base a$(( i - 1 )); }" >> $fyang
+    fi
+done
+cat <<EOF >> $fyang
+  container top{
+    list entry{
+      key name;
+      leaf name{
+        type uint32;
+      }
+      leaf kind{
+        type identityref{
+          base root;
+        }
+      }
+      leaf sub{
+        must "derived-from-or-self(../kind, 'ids:a1')";
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+# Identity derived in another module
+cat <<EOF > $fyang2
+module ids-ext{
+  yang-version 1.1;
+  namespace "urn:example:ext";
+  prefix ext;
+  import ids{
+    prefix ids;
+  }
+  identity x{
+    base ids:a1;
+  }
+}
+EOF
+
+new "generate startup config with $perfnr entries"
+echo -n "<config><top xmlns=\"urn:example:ids\">" > $sdb
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<entry><name>$i</name><kind>a$i</kind></entry>" >> $sdb
+done
+echo "</top></config>" >> $sdb
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+fi
+
+new "Startup validation timing"
+{ time -p sudo $clixon_backend -F1 -D $DBG -s startup -f $cfg 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf validate startup config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Not derived from base"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:ids\"><entry><name>0</name><kind>other</kind></entry></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate expect error"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<error-message>Identityref validation failed, other not derived from root in ids.yang" ""
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Base itself is not derived"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:ids\"><entry><name>0</name><kind>root</kind></entry></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate expect error"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<error-message>Identityref validation failed, root not derived from root in ids.yang" ""
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Identity derived in other module, deep in chain, and derived-from-or-self"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:ids\" xmlns:ext=\"urn:example:ext\"><entry><name>1</name><kind>ext:x</kind><sub>y</sub></entry><entry><name>9</name><sub>y</sub></entry></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate ok"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "derived-from-or-self fails in other branch"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:ids\"><entry><name>10</name><sub>y</sub></entry></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate expect must error"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<error-tag>operation-failed</error-tag><error-app-tag>must-violation</error-app-tag>" ""
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "derived-from in xpath get"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ids:top/ids:entry[derived-from(ids:kind, 'ids:a10')]/ids:name\" xmlns:ids=\"urn:example:ids\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:ids\"><entry><name>11</name></entry><entry><name>12</name></entry><entry><name>13</name></entry><entry><name>14</name></entry><entry><name>15</name></entry><entry><name>16</name></entry><entry><name>17</name></entry><entry><name>18</name></entry><entry><name>19</name></entry></top></data></rpc-reply>"
+
+last=$(( perfnr - 1 ))
+first=$(( last - last % 10 ))
+expect=""
+for (( i=$first+1; i<=$last; i++ )); do
+    expect+="<entry><name>$i</name></entry>"
+done
+
+new "derived-from in last branch"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ids:top/ids:entry[derived-from(ids:kind, 'ids:a$first')]/ids:name\" xmlns:ids=\"urn:example:ids\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:ids\">$expect</top></data></rpc-reply>"
+
+new "derived-from-or-self of last identity"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ids:top/ids:entry[derived-from-or-self(ids:kind, 'ids:a$last')]/ids:name\" xmlns:ids=\"urn:example:ids\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:ids\"><entry><name>$last</name></entry></top></data></rpc-reply>"
+
+new "derived-from of last identity is empty"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ids:top/ids:entry[derived-from(ids:kind, 'ids:a$last')]/ids:name\" xmlns:ids=\"urn:example:ids\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,196 @@
+#!/usr/bin/env bash
+# Scaling of RFC8528 YANG Schema Mount with many mount-points, see YANG_SCHEMA_MOUNT_INDEX
+# All mount-points have the same yang-library and share one yspec.
+# Time backend startup with $perfnr mount-points with data, and time access to the data of
+# a mount-point.
+# Also check that the data of the first, last, added and deleted mount-points is found
+# and validated with the mounted yspec.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of mount-points
+: ${perfnr:=10000}
+
+# Number of requests to mount-points
+: ${perfreq:=20}
+
+APPNAME=example
+
+cfg=$dir/conf_mount.xml
+fyang=$dir/clixon-example.yang
+fyang1=$dir/clixon-mount1.yang
+sdb=$dir/startup_db
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${dir}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_LIBRARY>true</CLICON_YANG_LIBRARY>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_SCHEMA_MOUNT>true</CLICON_YANG_SCHEMA_MOUNT>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  import ietf-yang-schema-mount {
+    prefix yangmnt;
+  }
+  container top{
+    list mylist{
+      key name;
+      leaf name{
+        type string;
+      }
+      container root{
+         presence "Otherwise root is not visible";
+         yangmnt:mount-point "mylabel"{
+            description "Root for other yang models";
+         }
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $fyang1
+module clixon-mount1{
+  yang-version 1.1;
+  namespace "urn:example:mount1";
+  prefix m1;
+  container mount1{
+    list mylist1{
+      key name1;
+      leaf name1{
+        type string;
+      }
+      leaf value1{
+        type uint32;
+      }
+    }
+  }
+}
+EOF
+
+new "generate startup config with $perfnr mount-points"
+echo -n "<config><top xmlns=\"urn:example:clixon\">" > $sdb
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<mylist><name>d$i</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>x</name1><value1>$i</value1></mylist1></mount1></root></mylist>" >> $sdb
+done
+echo "</top></config>" >> $sdb
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+fi
+
+new "Startup timing with $perfnr mount-points"
+{ time -p sudo $clixon_backend -F1 -D $DBG -s startup -f $cfg -- -m clixon-mount1 -M urn:example:mount1 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s startup -f $cfg -- -m clixon-mount1 -M urn:example:mount1"
+    start_backend -s startup -f $cfg -- -m clixon-mount1 -M urn:example:mount1
+fi
+
+new "wait backend"
+wait_backend
+
+new "One shared yspec for all mount-points"
+ret=$($clixon_netconf -qf $cfg<<EOF
+$DEFAULTHELLO<rpc $DEFAULTNS><stats xmlns="http://clicon.org/lib"></stats></rpc>]]>]]>
+EOF
+)
+match=$(echo "$ret" | grep -o "<module-set><name>mylabel/" | wc -l)
+if [ $match -ne 1 ]; then
+    err1 "1 module-set" "$match"
+fi
+
+new "get-config of last mount-point"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:mylist[ex:name='d$(($perfnr-1))']/ex:root/m1:mount1\" xmlns:ex=\"urn:example:clixon\" xmlns:m1=\"urn:example:mount1\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:clixon\"><mylist><name>d$(($perfnr-1))</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>x</name1><value1>$(($perfnr-1))</value1></mylist1></mount1></root></mylist></top></data></rpc-reply>"
+
+new "get-config of first mount-point"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:mylist[ex:name='d0']/ex:root/m1:mount1\" xmlns:ex=\"urn:example:clixon\" xmlns:m1=\"urn:example:mount1\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:clixon\"><mylist><name>d0</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>x</name1><value1>0</value1></mylist1></mount1></root></mylist></top></data></rpc-reply>"
+
+new "netconf edit $perfreq mount-points, timing"
+{ time -p for (( i=0; i<$perfreq; i++ )); do
+    rnd=$(( ( RANDOM * 32768 + RANDOM ) % $perfnr ))
+    echo "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:clixon\"><mylist><name>d$rnd</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>y</name1><value1>$i</value1></mylist1></mount1></root></mylist></top></config></edit-config></rpc>]]>]]>"
+done | $clixon_netconf -qf $cfg > /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+new "netconf validate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Add new mount-point"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:clixon\"><mylist><name>new</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>z</name1><value1>42</value1></mylist1></mount1></root></mylist></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Invalid value in new mount-point"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:clixon\"><mylist><name>new</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>z</name1><value1>abc</value1></mylist1></mount1></root></mylist></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate expect error"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<error-tag>bad-element</error-tag><error-info><bad-element>value1</bad-element></error-info>" ""
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Add new mount-point again"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:clixon\"><mylist><name>new</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>z</name1><value1>42</value1></mylist1></mount1></root></mylist></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get-config of new mount-point"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:mylist[ex:name='new']/ex:root/m1:mount1\" xmlns:ex=\"urn:example:clixon\" xmlns:m1=\"urn:example:mount1\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:clixon\"><mylist><name>new</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>z</name1><value1>42</value1></mylist1></mount1></root></mylist></top></data></rpc-reply>"
+
+new "Still one shared yspec with new mount-point"
+ret=$($clixon_netconf -qf $cfg<<EOF
+$DEFAULTHELLO<rpc $DEFAULTNS><stats xmlns="http://clicon.org/lib"></stats></rpc>]]>]]>
+EOF
+)
+match=$(echo "$ret" | grep -o "<module-set><name>mylabel/" | wc -l)
+if [ $match -ne 1 ]; then
+    err1 "1 module-set" "$match"
+fi
+
+new "Delete first mount-point"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\"><mylist nc:operation=\"delete\"><name>d0</name></mylist></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get-config of deleted mount-point"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:mylist[ex:name='d0']/ex:root/m1:mount1\" xmlns:ex=\"urn:example:clixon\" xmlns:m1=\"urn:example:mount1\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "get-config of second mount-point"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:mylist[ex:name='d1']/ex:root/m1:mount1\" xmlns:ex=\"urn:example:clixon\" xmlns:m1=\"urn:example:mount1\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:clixon\"><mylist><name>d1</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>x</name1><value1>1</value1></mylist1></mount1></root></mylist></top></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
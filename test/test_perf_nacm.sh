@@ -0,0 +1,194 @@
+#!/usr/bin/env bash
+# Performance of NACM read access with many rules, see NACM_COMPILED and NACM_READ_FILTER
+# Generate a NACM config with $perfrules data-node rules and a data tree with $perfnr entries
+# and time get-config requests as a user in a group with the rules.
+# Check that exactly the entries of the deny rules are filtered, and that changes of NACM
+# config take effect for data-node and rpc decisions
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=1000}
+
+# Number of NACM rules
+: ${perfrules:=100}
+
+# Number of get requests
+: ${perfreq:=100}
+
+APPNAME=example
+
+# Common NACM scripts
+. ./nacm.sh
+
+cfg=$dir/conf.xml
+fyang=$dir/nacm-example.yang
+sdb=$dir/startup_db
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_NACM_MODE>internal</CLICON_NACM_MODE>
+  <CLICON_NACM_CREDENTIALS>none</CLICON_NACM_CREDENTIALS>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module nacm-example{
+  yang-version 1.1;
+  namespace "urn:example:nacm";
+  prefix ex;
+  import ietf-netconf-acm {
+    prefix nacm;
+  }
+  container top{
+    list entry{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type uint32;
+      }
+    }
+  }
+}
+EOF
+
+new "generate startup config with $perfrules rules and $perfnr entries"
+cat <<EOF > $sdb
+<config>
+   <nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+     <enable-nacm>true</enable-nacm>
+     <read-default>permit</read-default>
+     <write-default>permit</write-default>
+     <exec-default>permit</exec-default>
+     $NGROUPS
+     <rule-list>
+       <name>limited-acl</name>
+       <group>limited</group>
+EOF
+# Deny read of odd entries
+for (( i=1; i<$perfrules; i+=2 )); do
+    echo "<rule><name>r$i</name><module-name>nacm-example</module-name><path xmlns:ex=\"urn:example:nacm\">/ex:top/ex:entry[ex:name='e$i']</path><access-operations>read</access-operations><action>deny</action></rule>" >> $sdb
+done
+cat <<EOF >> $sdb
+     </rule-list>
+     $NADMIN
+   </nacm>
+EOF
+echo -n "<top xmlns=\"urn:example:nacm\">" >> $sdb
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<entry><name>e$i</name><value>$i</value></entry>" >> $sdb
+done
+echo "</top></config>" >> $sdb
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf get-config $perfreq times as limited user, timing"
+{ time -p for (( i=0; i<$perfreq; i++ )); do
+    echo "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top\" xmlns:ex=\"urn:example:nacm\"/></get-config></rpc>]]>]]>"
+done | $clixon_netconf -qf $cfg -U wilma > /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+new "get-config as limited user filters exactly the denied entries"
+ret=$($clixon_netconf -qf $cfg -U wilma<<EOF
+$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source><filter type="xpath" select="/ex:top" xmlns:ex="urn:example:nacm"/></get-config></rpc>]]>]]>
+EOF
+)
+match=$(echo "$ret" | grep -o "<entry>" | wc -l)
+if [ $match -ne $(($perfnr - $perfrules/2)) ]; then
+    err1 "$(($perfnr - $perfrules/2)) entries" "$match"
+fi
+# Entry of the last deny rule is filtered, the next entry without rule is not
+last=$(( ($perfrules-2) | 1 ))
+match=$(echo "$ret" | grep -o "<name>e$last</name>")
+if [ -n "$match" ]; then
+    err "no e$last" "$ret"
+fi
+match=$(echo "$ret" | grep -o "<name>e$(($last+1))</name><value>$(($last+1))</value>")
+if [ -z "$match" ]; then
+    err "e$(($last+1))" "$ret"
+fi
+
+new "get denied entry as limited user"
+ret=$($clixon_netconf -qf $cfg -U wilma<<EOF
+$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source><filter type="xpath" select="/ex:top/ex:entry[ex:name='e1']" xmlns:ex="urn:example:nacm"/></get-config></rpc>]]>]]>
+EOF
+)
+match=$(echo "$ret" | grep -o "<name>e1</name>")
+if [ -n "$match" ]; then
+    err "no e1" "$ret"
+fi
+
+new "get permitted entry as limited user"
+expecteof_netconf "$clixon_netconf -qf $cfg -U wilma" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:entry[ex:name='e2']\" xmlns:ex=\"urn:example:nacm\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:nacm\"><entry><name>e2</name><value>2</value></entry></top></data></rpc-reply>"
+
+new "get denied entry as admin user"
+expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:entry[ex:name='e1']\" xmlns:ex=\"urn:example:nacm\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:nacm\"><entry><name>e1</name><value>1</value></entry></top></data></rpc-reply>"
+
+new "remove deny rule as admin user"
+expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\"><rule-list><name>limited-acl</name><rule nc:operation=\"delete\" xmlns:nc=\"${BASENS}\"><name>r1</name></rule></rule-list></nacm></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get entry no longer denied as limited user"
+expecteof_netconf "$clixon_netconf -qf $cfg -U wilma" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:entry[ex:name='e1']\" xmlns:ex=\"urn:example:nacm\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:nacm\"><entry><name>e1</name><value>1</value></entry></top></data></rpc-reply>"
+
+new "set read-default deny and permit read of one entry as admin user"
+expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\"><read-default>deny</read-default><rule-list><name>limited-acl</name><rule><name>p2</name><module-name>nacm-example</module-name><path xmlns:ex=\"urn:example:nacm\">/ex:top/ex:entry[ex:name='e2']/ex:value</path><access-operations>read</access-operations><action>permit</action></rule></rule-list></nacm></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get only permitted leaf, its ancestors and list key as limited user"
+expecteof_netconf "$clixon_netconf -qf $cfg -U wilma" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top\" xmlns:ex=\"urn:example:nacm\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:nacm\"><entry><name>e2</name><value>2</value></entry></top></data></rpc-reply>"
+
+new "set exec-default deny as admin user"
+expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\"><exec-default>deny</exec-default></nacm></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get-config denied as limited user"
+expecteof_netconf "$clixon_netconf -qf $cfg -U wilma" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>access-denied</error-tag><error-severity>error</error-severity><error-message>default deny</error-message></rpc-error></rpc-reply>"
+
+new "get-config permitted as admin user"
+expecteof_netconf "$clixon_netconf -qf $cfg -U andy" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:entry[ex:name='e2']\" xmlns:ex=\"urn:example:nacm\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:nacm\"><entry><name>e2</name><value>2</value></entry></top></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
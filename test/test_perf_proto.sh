@@ -0,0 +1,166 @@
+#!/usr/bin/env bash
+# Internal protocol get replies with binary XML tree encoding, see PROTO_XML_BINARY,
+# and large replies passed as file descriptor, see PROTO_MSG_FD
+# Get-config and get of $perfnr entries via netconf, where the backend reply is binary
+# and decoded in the frontend. Check that all replies have all entries, and check typed
+# values, namespaces, empty data and with-defaults.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=20000}
+
+# Number of get requests
+: ${perfreq:=20}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fyang2=$dir/clixon-augment.yang
+sdb=$dir/startup_db
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$dir</CLICON_YANG_MAIN_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type uint32;
+      }
+      leaf offset{
+        type int64;
+      }
+      leaf enabled{
+        type boolean;
+      }
+      leaf descr{
+        type string;
+      }
+      leaf mode{
+        type string;
+        default "auto";
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $fyang2
+module clixon-augment{
+  yang-version 1.1;
+  namespace "urn:example:augment";
+  prefix aug;
+  import clixon-example {
+    prefix ex;
+  }
+  augment "/ex:table/ex:parameter" {
+    leaf extra{
+      type int8;
+    }
+  }
+}
+EOF
+
+new "generate startup config with $perfnr entries"
+echo -n "<config><table xmlns=\"urn:example:clixon\">" > $sdb
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<parameter><name>p$i</name><value>$i</value><offset>-$i</offset><enabled>true</enabled><descr>0$i &amp; x</descr><extra xmlns=\"urn:example:augment\">-7</extra></parameter>" >> $sdb
+done
+echo "</table></config>" >> $sdb
+
+last=$(( perfnr - 1 ))
+entry="<name>p$last</name><value>$last</value><offset>-$last</offset><enabled>true</enabled><descr>0$last &amp; x</descr>"
+filter="<filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='p$last']\" xmlns:ex=\"urn:example:clixon\"/>"
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf get-config $perfreq x $perfnr entries, timing"
+{ time -p for (( i=0; i<$perfreq; i++ )); do
+    echo "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>"
+done | $clixon_netconf -qf $cfg -o CLICON_NETCONF_BASE_CAPABILITY=0 > $dir/reply; } 2>&1 | awk '/real/ {print $2}'
+
+new "netconf get-config all replies complete"
+match=$(grep -o "<name>p$last</name>" $dir/reply | wc -l)
+if [ $match -ne $perfreq ]; then
+    err1 "$perfreq <name>p$last</name>" "$match"
+fi
+
+new "netconf get-config all entries"
+match=$(grep -o "<parameter>" $dir/reply | wc -l)
+if [ $match -ne $(($perfreq * $perfnr)) ]; then
+    err1 "$(($perfreq * $perfnr)) <parameter>" "$match"
+fi
+
+new "netconf get $perfreq x $perfnr entries, timing"
+{ time -p for (( i=0; i<$perfreq; i++ )); do
+    echo "$DEFAULTHELLO<rpc $DEFAULTNS><get/></rpc>]]>]]>"
+done | $clixon_netconf -qf $cfg -o CLICON_NETCONF_BASE_CAPABILITY=0 > $dir/reply; } 2>&1 | awk '/real/ {print $2}'
+
+new "netconf get all entries with default value"
+match=$(grep -o "<mode>auto</mode><extra xmlns=\"urn:example:augment\">-7</extra></parameter>" $dir/reply | wc -l)
+if [ $match -ne $(($perfreq * $perfnr)) ]; then
+    err1 "$(($perfreq * $perfnr)) <mode>auto</mode>" "$match"
+fi
+
+new "netconf get-config typed values and augment namespace"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source>$filter</get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter>$entry<extra xmlns=\"urn:example:augment\">-7</extra></parameter></table></data></rpc-reply>"
+
+new "netconf get with default value"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get>$filter</get></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter>$entry<mode>auto</mode><extra xmlns=\"urn:example:augment\">-7</extra></parameter></table></data></rpc-reply>"
+
+new "netconf get with-defaults report-all-tagged"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get>$filter<with-defaults xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults\">report-all-tagged</with-defaults></get></rpc>" "" "<mode wd:default=\"true\">auto</mode>"
+
+new "netconf get-config empty data"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='none']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,177 @@
+#!/usr/bin/env bash
+# Backend read worker threads, see BACKEND_READ_THREADS
+# Get-config of running with $perfnr entries from $perfclients parallel netconf clients.
+# Check that replies are complete, that a commit is seen by the next get-config (new
+# snapshot), that replies during a commit are complete snapshots before or after the
+# commit, and that depth, with-defaults and pipelined requests work.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=20000}
+
+# Number of parallel clients
+: ${perfclients:=4}
+
+# Number of get-config requests per client
+: ${perfreq:=10}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+sdb=$dir/startup_db
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type string;
+      }
+      leaf mode{
+        type string;
+        default "auto";
+      }
+    }
+  }
+}
+EOF
+
+new "generate startup config with $perfnr entries"
+echo -n "<config><table xmlns=\"urn:example:clixon\">" > $sdb
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<parameter><name>p$i</name><value>$i</value></parameter>" >> $sdb
+done
+echo "</table></config>" >> $sdb
+
+last=$(( perfnr - 1 ))
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf get-config $perfclients clients x $perfreq x $perfnr entries, timing"
+{ time -p for (( c=0; c<$perfclients; c++ )); do
+    for (( i=0; i<$perfreq; i++ )); do
+        echo "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>"
+    done | $clixon_netconf -qf $cfg -o CLICON_NETCONF_BASE_CAPABILITY=0 > $dir/reply$c &
+done; wait; } 2>&1 | awk '/real/ {print $2}'
+
+new "netconf get-config all replies complete"
+for (( c=0; c<$perfclients; c++ )); do
+    match=$(grep -o "<name>p$last</name>" $dir/reply$c | wc -l)
+    if [ $match -ne $perfreq ]; then
+        err1 "$perfreq <name>p$last</name>" "$match"
+    fi
+    match=$(grep -o "<parameter>" $dir/reply$c | wc -l)
+    if [ $match -ne $(($perfreq * $perfnr)) ]; then
+        err1 "$(($perfreq * $perfnr)) <parameter>" "$match"
+    fi
+done
+
+new "netconf get-config no default values"
+match=$(grep -c "<mode>" $dir/reply0)
+if [ $match -ne 0 ]; then
+    err1 "no <mode>" "$match"
+fi
+
+new "netconf edit-config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>new</name><value>x</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf get-config after commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<parameter><name>new</name><value>x</value></parameter>"
+
+new "netconf get-config during edit-config and commit"
+for (( i=0; i<$perfreq; i++ )); do
+    echo "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>"
+done | $clixon_netconf -qf $cfg -o CLICON_NETCONF_BASE_CAPABILITY=0 > $dir/snap &
+pid=$!
+echo "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>new2</name><value>y</value></parameter></table></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>" | $clixon_netconf -qf $cfg -o CLICON_NETCONF_BASE_CAPABILITY=0 > /dev/null
+wait $pid
+
+new "netconf get-config replies are snapshots before or after commit"
+# Number of entries in each reply
+ret=$(sed 's/]]>]]>/\n/g' $dir/snap | awk '/<rpc-reply/ {print gsub("<parameter>", "")}')
+match=$(echo "$ret" | grep -c .)
+if [ $match -ne $perfreq ]; then
+    err1 "$perfreq replies" "$match"
+fi
+match=$(echo "$ret" | grep -vx "$(($perfnr + 1))" | grep -vx "$(($perfnr + 2))")
+if [ -n "$match" ]; then
+    err1 "$(($perfnr + 1)) or $(($perfnr + 2)) entries" "$match"
+fi
+
+new "netconf get-config after second commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<parameter><name>new2</name><value>y</value></parameter>"
+
+new "netconf get-config depth"
+ret=$(echo "$DEFAULTHELLO<rpc $DEFAULTNS><get-config depth=\"1\"><source><running/></source></get-config></rpc>]]>]]>" | $clixon_netconf -qf $cfg -o CLICON_NETCONF_BASE_CAPABILITY=0)
+if [ -z "$(echo "$ret" | grep '<data><table xmlns="urn:example:clixon"')" ]; then
+    err "<data><table xmlns=\"urn:example:clixon\"" "$ret"
+fi
+if [ -n "$(echo "$ret" | grep '<parameter>')" ]; then
+    err "no <parameter>" "$ret"
+fi
+
+new "netconf get-config with-defaults report-all"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><with-defaults xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults\">report-all</with-defaults></get-config></rpc>" "" "<parameter><name>new</name><value>x</value><mode>auto</mode></parameter>"
+
+new "netconf pipelined get-config and edit-config replies in order"
+rpc="<rpc $DEFAULTONLY message-id=\"1\"><get-config><source><running/></source></get-config></rpc>]]>]]>"
+rpc+="<rpc $DEFAULTONLY message-id=\"2\"><discard-changes/></rpc>]]>]]>"
+rpc+="<rpc $DEFAULTONLY message-id=\"3\"><get-config><source><running/></source></get-config></rpc>]]>]]>"
+ret=$(echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qf $cfg -o CLICON_NETCONF_BASE_CAPABILITY=0 | grep -o 'message-id="[0-9]"' | tr -d '\n')
+if [ "$ret" != 'message-id="1"message-id="2"message-id="3"' ]; then
+    err1 "message-id 1 2 3" "$ret"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,242 @@
+#!/usr/bin/env bash
+# Performance of YANG pattern validation with the different regexp engines
+# Generate a startup config with ietf-inet-types and ietf-yang-types values that are
+# validated with patterns, and time backend startup validation for each configured
+# CLICON_YANG_REGEXP engine: posix always, libxml2 and pcre2 if configured.
+# Then check that valid and invalid values give the same result with each engine, and
+# with a program that patterns match, do not match, or fail to compile the same way with
+# pcre2 as with posix
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=5000}
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/patterns.yang
+sdb=$dir/startup_db
+cfile=$dir/regexp.c
+app=$dir/regexp
+
+regexlist="posix"
+if [ "${WITH_LIBXML2}" = yes ] ; then
+    regexlist="$regexlist libxml2"
+fi
+if [ "${WITH_PCRE2}" = yes ] ; then
+    regexlist="$regexlist pcre2"
+fi
+
+cat <<EOF > $fyang
+module patterns{
+  yang-version 1.1;
+  namespace "urn:example:patterns";
+  prefix p;
+  import ietf-inet-types {
+    prefix inet;
+  }
+  import ietf-yang-types {
+    prefix yang;
+  }
+  container entries{
+    list entry{
+      key name;
+      leaf name{
+        type string{
+          pattern '[a-zA-Z_][a-zA-Z0-9_\-.]*';
+        }
+      }
+      leaf v6{
+        type inet:ipv6-address;
+      }
+      leaf domain{
+        type inet:domain-name;
+      }
+      leaf time{
+        type yang:date-and-time;
+      }
+      leaf mac{
+        type yang:mac-address;
+      }
+    }
+  }
+}
+EOF
+
+new "generate startup config with $perfnr entries"
+echo -n "<config><entries xmlns=\"urn:example:patterns\">" > $sdb
+for (( i=0; i<$perfnr; i++ )); do
+    a=$(( i / 256 ))
+    b=$(( i % 256 ))
+    echo -n "<entry><name>e_$i</name><v6>2001:db8:$a::$b</v6><domain>host$i.example.com</domain><time>2025-02-01T12:$(printf %02d $(( i % 60 ))):00Z</time><mac>00:11:22:33:$(printf %02x $a):$(printf %02x $b)</mac></entry>" >> $sdb
+done
+echo "</entries></config>" >> $sdb
+
+for regex in $regexlist; do
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_REGEXP>$regex</CLICON_YANG_REGEXP>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+</clixon-config>
+EOF
+
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+    fi
+
+    new "Startup validation timing regex:$regex"
+    { time -p sudo $clixon_backend -F1 -D $DBG -s startup -f $cfg 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+    if [ $BE -ne 0 ]; then
+        new "start backend -s startup -f $cfg"
+        start_backend -s startup -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf validate startup config regex:$regex"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    for xml in "<name>e_0</name><v6>2001:db8::g</v6>" "<name>e_0</name><time>2025-02-01 12:00:00Z</time>" "<name>e_0</name><mac>00:11:22:33:44</mac>" "<name>e_0</name><domain>a..b</domain>" "<name>-x</name>"; do
+        new "edit $xml regex:$regex"
+        expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><entries xmlns=\"urn:example:patterns\"><entry>$xml</entry></entries></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+        new "netconf validate expect error regex:$regex"
+        expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<error-message>regexp match fail: pattern does not match" ""
+
+        new "netconf discard-changes"
+        expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+    done
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+done # regex
+
+unset regex
+
+cat<<'EOF' > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <syslog.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+/* XSD pattern, string and expected result: 1 match, 0 no match, -1 invalid pattern */
+static struct {
+    char *p;
+    char *s;
+    int   r;
+} _cases[] = {
+    {"[a-z]+[0-9]*",        "abc1",       1},
+    {"[a-z]+[0-9]*",        "ABC",        0},
+    {"[a-z]+[0-9]*",        "abc1x",      0}, /* Implicitly anchored */
+    {"\\d{3}-\\d{4}",       "555-1234",   1},
+    {"\\d{3}-\\d{4}",       "55-1234",    0},
+    {"\\i\\c*",             "_x.1",       1},
+    {"\\i\\c*",             "1x",         0},
+    {"\\p{L}+",             "abc",        1},
+    {"\\p{L}+",             "ab1",        0},
+    {"a\\sb",               "a b",        1},
+    {"a\\sb",               "a_b",        0},
+    {"(ab|cd)+",            "abcd",       1},
+    {"(ab|cd)+",            "abx",        0},
+    {"^abc$",               "abc",        1},
+    {"[a-",                 "a",         -1},
+    {"(ab",                 "ab",        -1},
+    {NULL,                  NULL,         0}
+};
+
+int
+main(int    argc,
+     char **argv)
+{
+    int           retval = -1;
+    clixon_handle h;
+    void         *re = NULL;
+    int           ret;
+    int           i;
+
+    if (argc != 2)
+        return -1;
+    if ((h = clixon_handle_init()) == NULL)
+        return -1;
+    if (clicon_option_str_set(h, "CLICON_YANG_REGEXP", argv[1]) < 0)
+        goto done;
+    for (i=0; _cases[i].p; i++){
+        re = NULL;
+        if ((ret = regex_compile(h, _cases[i].p, &re)) < 0)
+            goto done;
+        if (ret == 0) /* Invalid pattern */
+            ret = -1;
+        else {
+            if ((ret = regex_exec(h, re, _cases[i].s)) < 0)
+                goto done;
+            regex_free(h, re);
+        }
+        printf("%s %s: %d\n", _cases[i].p, _cases[i].s, ret);
+        if (ret != _cases[i].r)
+            printf("fail: %s %s: %d expected %d\n", _cases[i].p, _cases[i].s, ret, _cases[i].r);
+    }
+    printf("%d done\n", i);
+    retval = 0;
+ done:
+    clixon_handle_exit(h);
+    return retval;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+new "patterns regex:posix"
+posixret=$($app posix)
+expectpart "$posixret" 0 "^16 done$" --not-- "fail"
+
+# libxml2 is not compared since it has no anchors, ie ^ and $ are literals
+if [ "${WITH_PCRE2}" = yes ] ; then
+    new "patterns regex:pcre2"
+    ret=$($app pcre2)
+    expectpart "$ret" 0 "^16 done$" --not-- "fail"
+
+    new "patterns same result regex:pcre2 as posix"
+    if [ "$ret" != "$posixret" ]; then
+        err "$posixret" "$ret"
+    fi
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,158 @@
+#!/usr/bin/env bash
+# Fair scheduling of backend client requests, see BACKEND_SCHED
+# $perfclients parallel netconf clients pipeline $perfreq get-config requests each, while
+# a single get-config is timed from another session. Check that replies are complete and in
+# order, that closed sessions are removed, and that scheduling weight by transport and peer
+# user and queue state are shown in netconf-monitoring sessions.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=5000}
+
+# Number of parallel clients
+: ${perfclients:=4}
+
+# Number of pipelined get-config requests per client
+: ${perfreq:=20}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+sdb=$dir/startup_db
+
+cat <<EOF2 > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_BACKEND_SCHED_WEIGHT>cl:netconf=3 user:root=5000</CLICON_BACKEND_SCHED_WEIGHT>
+</clixon-config>
+EOF2
+
+cat <<EOF2 > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type string;
+      }
+    }
+  }
+}
+EOF2
+
+new "generate startup config with $perfnr entries"
+echo -n "<config><table xmlns=\"urn:example:clixon\">" > $sdb
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<parameter><name>p$i</name><value>$i</value></parameter>" >> $sdb
+done
+echo "</table></config>" >> $sdb
+
+last=$(( perfnr - 1 ))
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf $perfclients clients x $perfreq pipelined get-config"
+for (( c=0; c<$perfclients; c++ )); do
+    rpc=""
+    for (( i=1; i<=$perfreq; i++ )); do
+        rpc+="<rpc $DEFAULTONLY message-id=\"$i\"><get-config><source><running/></source></get-config></rpc>]]>]]>"
+    done
+    echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qf $cfg -o CLICON_NETCONF_BASE_CAPABILITY=0 > $dir/reply$c &
+done
+
+new "netconf get-config while other sessions are busy, timing"
+{ time -p echo "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='p$last']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" | $clixon_netconf -qf $cfg -o CLICON_NETCONF_BASE_CAPABILITY=0 > $dir/reply; } 2>&1 | awk '/real/ {print $2}'
+wait
+
+new "netconf get-config while other sessions are busy reply"
+match=$(grep -c "<name>p$last</name>" $dir/reply)
+if [ $match -ne 1 ]; then
+    err1 "<name>p$last</name>" "$(cat $dir/reply)"
+fi
+
+new "netconf pipelined replies complete and in order"
+expect=""
+for (( i=1; i<=$perfreq; i++ )); do
+    expect+="message-id=\"$i\""
+done
+for (( c=0; c<$perfclients; c++ )); do
+    match=$(grep -o "<name>p$last</name>" $dir/reply$c | wc -l)
+    if [ $match -ne $perfreq ]; then
+        err1 "$perfreq <name>p$last</name>" "$match"
+    fi
+    match=$(grep -o "<parameter>" $dir/reply$c | wc -l)
+    if [ $match -ne $(($perfreq * $perfnr)) ]; then
+        err1 "$(($perfreq * $perfnr)) <parameter>" "$match"
+    fi
+    ret=$(grep -o 'message-id="[0-9]*"' $dir/reply$c | tr -d '\n')
+    if [ "$ret" != "$expect" ]; then
+        err1 "$expect" "$ret"
+    fi
+done
+
+# Weight of sessions of this user, the root user weight is limited to max
+if [ $(whoami) = root ]; then
+    weight=1024
+else
+    weight=3
+fi
+
+# Get sessions of netconf monitoring
+SESSIONS="<rpc $DEFAULTNS><get><filter type=\"subtree\"><netconf-state xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-monitoring\"><sessions/></netconf-state></filter></get></rpc>"
+
+new "netconf-monitoring session scheduling weight and queue state"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$SESSIONS" "<out-notifications>0</out-notifications>.*<sched-weight xmlns=\"http://clicon.org/lib\">$weight</sched-weight><queued-rpcs xmlns=\"http://clicon.org/lib\">0</queued-rpcs><queued-rpcs-max xmlns=\"http://clicon.org/lib\">[1-9][0-9]*</queued-rpcs-max><rpc-wait-total xmlns=\"http://clicon.org/lib\">[0-9]*</rpc-wait-total><rpc-wait-max xmlns=\"http://clicon.org/lib\">[0-9]*</rpc-wait-max></session>"
+
+new "netconf-monitoring closed sessions removed"
+ret=$(echo "$DEFAULTHELLO$SESSIONS]]>]]>" | $clixon_netconf -qf $cfg -o CLICON_NETCONF_BASE_CAPABILITY=0)
+match=$(echo "$ret" | grep -o "<session>" | wc -l)
+if [ $match -ne 1 ]; then
+    err1 "1 <session>" "$match"
+fi
+
+new "netconf-monitoring root user weight overrides transport weight, limited to max"
+expecteof_netconf "sudo $clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "$SESSIONS" "<username>root</username>.*<sched-weight xmlns=\"http://clicon.org/lib\">1024</sched-weight>" ""
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
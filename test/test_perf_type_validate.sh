@@ -0,0 +1,215 @@
+#!/usr/bin/env bash
+# Performance of leaf type validation with typical ietf-inet-types values, see YANG_TYPE_VALIDATOR
+# Generate a startup config with addresses, prefixes, ports, hosts, enumerations and bits
+# and time backend startup validation.
+# Then check the compiled validators: range and length interval boundaries, sorted
+# enumeration and bit names, and union member order, with the same errors as cv_validate
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=5000}
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/types.yang
+sdb=$dir/startup_db
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module types{
+  yang-version 1.1;
+  namespace "urn:example:types";
+  prefix t;
+  import ietf-inet-types {
+    prefix inet;
+  }
+  typedef proto{
+    type enumeration{
+      enum tcp;
+      enum udp;
+      enum sctp;
+    }
+  }
+  container peers{
+    list peer{
+      key name;
+      leaf name{
+        type string{
+          length "1..32";
+        }
+      }
+      leaf v4{
+        type inet:ipv4-address;
+      }
+      leaf v6{
+        type inet:ipv6-address;
+      }
+      leaf prefix{
+        type inet:ip-prefix;
+      }
+      leaf port{
+        type inet:port-number;
+      }
+      leaf host{
+        type inet:host;
+      }
+      leaf proto{
+        type proto;
+      }
+      leaf flags{
+        type bits{
+          bit up;
+          bit down;
+          bit passive;
+        }
+      }
+      leaf weight{
+        type uint16{
+          range "1..100 | 200..300";
+        }
+      }
+      leaf descr{
+        type string{
+          length "1..32";
+        }
+      }
+    }
+  }
+}
+EOF
+
+new "generate startup config with $perfnr entries"
+echo -n "<config><peers xmlns=\"urn:example:types\">" > $sdb
+for (( i=0; i<$perfnr; i++ )); do
+    a=$(( i / 250 ))
+    b=$(( i % 250 ))
+    echo -n "<peer><name>p$i</name><v4>10.0.$a.$b</v4><v6>2001:db8::$a:$b</v6><prefix>10.$a.$b.0/24</prefix><port>$(( 1024 + i ))</port><host>host$i.example.com</host><proto>udp</proto><flags>up passive</flags><weight>$(( 200 + b % 100 ))</weight></peer>" >> $sdb
+done
+echo "</peers></config>" >> $sdb
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+fi
+
+new "Startup validation timing"
+{ time -p sudo $clixon_backend -F1 -D $DBG -s startup -f $cfg 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf validate startup config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+# Set an invalid value of a leaf in last entry, validate and check error, then discard
+# Argument:
+# 1: leaf value
+# 2: expected error message
+function invalid()
+{
+    xml=$1
+    errmsg=$2
+
+    new "edit $xml"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><peers xmlns=\"urn:example:types\"><peer><name>p$(($perfnr-1))</name>$xml</peer></peers></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf validate expect error"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<error-message>$errmsg" ""
+
+    new "netconf discard-changes"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+invalid "<v4>10.0.0.300</v4>" "regexp match fail: pattern does not match 10.0.0.300"
+invalid "<weight>150</weight>" "Number 150 out of range: 1 - 100, 200 - 300"
+invalid "<proto>icmp</proto>" "'icmp' does not match enumeration"
+invalid "<flags>up sideways</flags>" "'sideways' does not match enumeration"
+invalid "<host>-bad-</host>" "regexp match fail"
+
+# Interval boundaries of range "1..100 | 200..300" and length "1..32"
+invalid "<weight>0</weight>" "Number 0 out of range: 1 - 100, 200 - 300"
+invalid "<weight>101</weight>" "Number 101 out of range: 1 - 100, 200 - 300"
+invalid "<weight>199</weight>" "Number 199 out of range: 1 - 100, 200 - 300"
+invalid "<weight>301</weight>" "Number 301 out of range: 1 - 100, 200 - 300"
+invalid "<descr>$(printf 'd%.0s' {1..33})</descr>" "String length 33 out of range: 1 - 32"
+
+# Set a valid value of a leaf in first entry, validate and check value, then discard
+# Argument:
+# 1: leaf value
+function valid()
+{
+    xml=$1
+
+    new "edit $xml"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><peers xmlns=\"urn:example:types\"><peer><name>p0</name>$xml</peer></peers></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf validate ok"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf get-config $xml"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/t:peers/t:peer[t:name='p0']\" xmlns:t=\"urn:example:types\"/></get-config></rpc>" "$xml" ""
+
+    new "netconf discard-changes"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+valid "<port>0</port>"
+valid "<port>65535</port>"
+valid "<weight>1</weight>"
+valid "<weight>100</weight>"
+valid "<weight>200</weight>"
+valid "<weight>300</weight>"
+valid "<descr>$(printf 'd%.0s' {1..32})</descr>"
+# First and last names in sorted enumeration and bits
+valid "<proto>sctp</proto>"
+valid "<proto>udp</proto>"
+valid "<flags>down</flags>"
+valid "<flags>up</flags>"
+# Union: ipv4 member of host
+valid "<host>10.0.0.1</host>"
+
+new "Valid union member: host as ipv6 address"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><peers xmlns=\"urn:example:types\"><peer><name>p0</name><host>2001:db8::1</host></peer></peers></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate ok"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
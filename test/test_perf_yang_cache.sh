@@ -0,0 +1,266 @@
+#!/usr/bin/env bash
+# Startup performance with precompiled YANG spec cache, see CLICON_YANG_CACHE_DIR
+# Generate many YANG modules with typedefs, patterns, groupings and augments and
+# compare backend startup time without cache, when saving the cache and when loading it.
+# Then check that the cached spec validates and prints the same as a fresh parse, and that
+# the cache is rebuilt when a module changes
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of generated YANG modules
+: ${perfnr:=400}
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+cfgnc=$dir/conf-nocache.xml
+clispec=$dir/clispec
+ydir=$dir/yang
+cdir=$dir/cache
+fyang=$ydir/main.yang
+
+test -d $ydir || mkdir $ydir
+test -d $cdir || mkdir $cdir
+test -d $clispec || mkdir $clispec
+chmod 777 $cdir
+
+# Config without and with cache
+# Argument: cache dir or empty
+function mkcfg()
+{
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$ydir</CLICON_YANG_MAIN_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_CLISPEC_DIR>$clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_MODE>example</CLICON_CLI_MODE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  $1
+</clixon-config>
+EOF
+}
+
+cat <<EOF > $clispec/example.cli
+CLICON_MODE="example";
+CLICON_PROMPT="cli> ";
+
+show("Show a particular state of the system"){
+    yang("Show yang specs"), show_yang(); {
+        main("Show main yang spec"), show_yang("main");
+    }
+}
+EOF
+
+cat <<EOF > $fyang
+module main{
+  yang-version 1.1;
+  namespace "urn:example:main";
+  prefix m;
+  typedef name-type{
+    type string{
+      pattern '[a-z]+[0-9]*';
+    }
+  }
+  grouping entry{
+    leaf name{
+      type name-type;
+    }
+    leaf value{
+      type uint32{
+        range "1..1000";
+      }
+    }
+  }
+  container top{
+    list entry{
+      key name;
+      uses entry;
+    }
+    leaf mode{
+      type string;
+    }
+  }
+}
+EOF
+
+new "generate $perfnr yang modules"
+for (( i=0; i<$perfnr; i++ )); do
+    cat <<EOF > $ydir/mod$i.yang
+module mod$i{
+  yang-version 1.1;
+  namespace "urn:example:mod$i";
+  prefix m$i;
+  import main{
+    prefix m;
+  }
+  typedef t$i{
+    type string{
+      pattern '[a-z]{1,8}-$i';
+    }
+  }
+  grouping g$i{
+    container c$i{
+      leaf l$i{
+        type t$i;
+      }
+      leaf d$i{
+        type decimal64{
+          fraction-digits 2;
+        }
+        default 1.5;
+      }
+      leaf-list ll$i{
+        type m:name-type;
+      }
+    }
+  }
+  augment "/m:top" {
+    when "m:mode = 'x$i'";
+    uses g$i;
+  }
+}
+EOF
+done
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    mkcfg ""
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+fi
+
+new "Startup without cache"
+mkcfg ""
+cp $cfg $cfgnc
+{ time -p sudo $clixon_backend -F1 -D $DBG -s init -f $cfg 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+mkcfg "<CLICON_YANG_CACHE_DIR>$cdir</CLICON_YANG_CACHE_DIR>"
+
+new "Startup saving cache"
+{ time -p sudo $clixon_backend -F1 -D $DBG -s init -f $cfg 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+new "Check cache file"
+if [ ! -f $cdir/backend.yangcache ]; then
+    err "$cdir/backend.yangcache" "No cache file"
+fi
+
+new "Startup loading cache"
+{ time -p sudo $clixon_backend -F1 -D $DBG -s init -f $cfg 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Valid pattern and augment from cached spec"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:main\"><mode>x1</mode><entry><name>abc1</name><value>7</value></entry><c1 xmlns=\"urn:example:mod1\"><l1>abc-1</l1><ll1>xyz</ll1></c1></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Invalid pattern"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:main\"><entry><name>ABC</name></entry></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate invalid pattern from cached spec"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>name</bad-element></error-info><error-severity>error</error-severity><error-message>regexp match fail:" ""
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Invalid range"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:main\"><entry><name>abc</name><value>2000</value></entry></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate invalid range from cached spec"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>value</bad-element></error-info><error-severity>error</error-severity><error-message>Number 2000 out of range: 1 - 1000</error-message></rpc-error></rpc-reply>"
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "cli show yang from fresh parse"
+yfresh=$($clixon_cli -1f $cfgnc show yang 2>&1)
+expectpart "$yfresh" 0 "module mod$(($perfnr-1))"
+
+new "cli show yang saving cache"
+expectpart "$($clixon_cli -1f $cfg show yang 2>&1)" 0 "module mod$(($perfnr-1))"
+
+new "Check cli cache file"
+if [ ! -f $cdir/cli.yangcache ]; then
+    err "$cdir/cli.yangcache" "No cache file"
+fi
+csum=$(cksum < $cdir/cli.yangcache)
+
+new "cli show yang from cached spec same as fresh parse"
+ycached=$($clixon_cli -1f $cfg show yang 2>&1)
+echo "$yfresh" > $dir/yfresh
+echo "$ycached" > $dir/ycached
+if ! diff $dir/yfresh $dir/ycached > $dir/ydiff; then
+    err1 "same yang spec as fresh parse" "$(head -20 $dir/ydiff)"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+new "Change module main, cache is rebuilt"
+sed -i -e 's/leaf mode{/leaf newleaf{ type string; }\n    leaf mode{/' $fyang
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "New leaf in changed module"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:main\"><newleaf>x</newleaf></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "cli show yang of changed module"
+expectpart "$($clixon_cli -1f $cfg show yang main 2>&1)" 0 "newleaf"
+
+new "cli cache file rebuilt"
+if [ "$(cksum < $cdir/cli.yangcache)" = "$csum" ]; then
+    err "changed $cdir/cli.yangcache" "unchanged"
+fi
+
+new "cli show yang of changed module from rebuilt cache"
+expectpart "$($clixon_cli -1f $cfg show yang main 2>&1)" 0 "newleaf"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
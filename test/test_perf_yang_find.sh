@@ -0,0 +1,95 @@
+#!/usr/bin/env bash
+# Performance of binding a large XML tree to YANG with wide YANG statements
+# Exercises yang_find and yang_find_datanode on statements with many children, see
+# YANG_FIND_INDEX.
+# Also check that indexed statements find data nodes in the first and last position, in
+# choices, from groupings and augments, keep keywords apart and reject unknown nodes
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of leafs in list and top-level containers
+: ${perfnr:=500}
+
+# Number of list entries
+: ${perfentries:=200}
+
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+
+fyang=$dir/wide.yang
+fxml=$dir/wide.xml
+
+new "generate yang with $perfnr leafs"
+echo "module wide{" > $fyang
+echo "  yang-version 1.1;" >> $fyang
+echo "  namespace \"urn:example:wide\";" >> $fyang
+echo "  prefix w;" >> $fyang
+echo "  grouping c0{ leaf gu{ type string; } }" >> $fyang
+for (( i=0; i<$perfnr; i++ )); do
+    echo "  container c$i{ leaf x{ type string; } }" >> $fyang
+done
+echo "  container top{" >> $fyang
+echo "    list e{" >> $fyang
+echo "      key k;" >> $fyang
+echo "      leaf k{ type uint32; }" >> $fyang
+for (( i=0; i<$perfnr; i++ )); do
+    echo "      leaf l$i{ type string; }" >> $fyang
+done
+echo "      choice ch{" >> $fyang
+echo "        case a{ leaf ca{ type string; } }" >> $fyang
+echo "        case b{ leaf cb{ type string; } }" >> $fyang
+echo "      }" >> $fyang
+echo "      uses c0;" >> $fyang
+echo "    }" >> $fyang
+echo "  }" >> $fyang
+echo "  augment \"/w:top/w:e\"{ leaf au{ type string; } }" >> $fyang
+echo "}" >> $fyang
+
+new "generate xml with $perfentries entries"
+echo -n "<top xmlns=\"urn:example:wide\">" > $fxml
+for (( j=0; j<$perfentries; j++ )); do
+    echo -n "<e><k>$j</k>" >> $fxml
+    for (( i=$perfnr-1; i>=0; i-=7 )); do
+        echo -n "<l$i>v</l$i>" >> $fxml
+    done
+    echo -n "<cb>x</cb></e>" >> $fxml
+done
+echo "</top>" >> $fxml
+
+new "bind and validate xml"
+expectpart "$($clixon_util_xml -vy $fyang -f $fxml)" 0 '^$'
+
+new "bind and validate xml, timing"
+{ $TIMEFN $clixon_util_xml -vy $fyang -f $fxml; } 2>&1 | awk '/real/ {print $2}'
+
+new "bind choice leaf"
+expecteofx "$clixon_util_xml -ojvy $fyang" 0 '<top xmlns="urn:example:wide"><e><k>1</k><ca>x</ca></e></top>' '{"wide:top":{"e":[{"k":1,"ca":"x"}]}}'
+
+new "bind container in last position"
+expecteofx "$clixon_util_xml -ojvy $fyang" 0 "<c$(($perfnr-1)) xmlns=\"urn:example:wide\"><x>y</x></c$(($perfnr-1))>" "{\"wide:c$(($perfnr-1))\":{\"x\":\"y\"}}"
+
+new "bind leaf in first position"
+expecteofx "$clixon_util_xml -ojvy $fyang" 0 '<top xmlns="urn:example:wide"><e><k>1</k><l0>x</l0></e></top>' '{"wide:top":{"e":[{"k":1,"l0":"x"}]}}'
+
+new "bind leaf from grouping"
+expecteofx "$clixon_util_xml -ojvy $fyang" 0 '<top xmlns="urn:example:wide"><e><k>1</k><gu>x</gu></e></top>' '{"wide:top":{"e":[{"k":1,"gu":"x"}]}}'
+
+new "bind leaf from augment"
+expecteofx "$clixon_util_xml -ojvy $fyang" 0 '<top xmlns="urn:example:wide"><e><k>1</k><au>x</au></e></top>' '{"wide:top":{"e":[{"k":1,"au":"x"}]}}'
+
+new "bind container with same name as grouping"
+expecteofx "$clixon_util_xml -ojvy $fyang" 0 '<c0 xmlns="urn:example:wide"><x>y</x></c0>' '{"wide:c0":{"x":"y"}}'
+
+new "grouping leaf not in container with same name, should fail"
+expecteofx "$clixon_util_xml -ojvy $fyang" 255 '<c0 xmlns="urn:example:wide"><gu>y</gu></c0>' '' 2> /dev/null
+
+new "unknown leaf after last position, should fail"
+expecteofx "$clixon_util_xml -ojvy $fyang" 255 "<top xmlns=\"urn:example:wide\"><e><k>1</k><l$perfnr>x</l$perfnr></e></top>" '' 2> /dev/null
+
+new "unknown container after last position, should fail"
+expecteofx "$clixon_util_xml -ojvy $fyang" 255 "<c$perfnr xmlns=\"urn:example:wide\"><x>y</x></c$perfnr>" '' 2> /dev/null
+
+rm -rf $dir
+
+new "endtest"
+endtest
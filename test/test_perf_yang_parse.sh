@@ -0,0 +1,166 @@
+#!/usr/bin/env bash
+# Load many YANG modules with imports and includes, see YANG_PARSE_THREADS
+# Modules in the main dir are parsed in advance by worker threads and then loaded in order.
+# Check that types from imports and includes are resolved in the first, middle and last
+# module, and that syntax errors are reported as when parsing sequentially
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of generated YANG modules
+: ${perfnr:=400}
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+ydir=$dir/yang
+idir=$dir/import
+
+test -d $ydir || mkdir $ydir
+test -d $idir || mkdir $idir
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$idir</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$ydir</CLICON_YANG_MAIN_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+</clixon-config>
+EOF
+
+new "generate $perfnr yang modules with imports and includes"
+for (( i=0; i<$perfnr; i++ )); do
+    # Imported module and included submodule, not in main dir
+    cat <<EOF > $idir/imp$i.yang
+module imp$i{
+  yang-version 1.1;
+  namespace "urn:example:imp$i";
+  prefix i$i;
+  typedef t$i{
+    type string{
+      pattern '[a-z]+';
+    }
+  }
+}
+EOF
+    cat <<EOF > $idir/sub$i.yang
+submodule sub$i{
+  yang-version 1.1;
+  belongs-to mod$i {
+    prefix m$i;
+  }
+  import imp$i{
+    prefix i$i;
+  }
+  grouping g$i{
+    leaf s$i{
+      type i$i:t$i;
+    }
+  }
+}
+EOF
+    cat <<EOF > $ydir/mod$i.yang
+module mod$i{
+  yang-version 1.1;
+  namespace "urn:example:mod$i";
+  prefix m$i;
+  include sub$i;
+  revision 2025-01-01;
+  container c$i{
+    uses g$i;
+    leaf x$i{
+      when "../s$i = 'abc'";
+      type uint32{
+        range "1..100";
+      }
+      status current;
+    }
+  }
+}
+EOF
+done
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+fi
+
+new "Startup timing"
+{ time -p sudo $clixon_backend -F1 -D $DBG -s init -f $cfg 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Leaf from included submodule and imported type"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c$(($perfnr-1)) xmlns=\"urn:example:mod$(($perfnr-1))\"><s$(($perfnr-1))>abc</s$(($perfnr-1))><x$(($perfnr-1))>42</x$(($perfnr-1))></c$(($perfnr-1))></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf get-config"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c$(($perfnr-1)) xmlns=\"urn:example:mod$(($perfnr-1))\"><s$(($perfnr-1))>abc</s$(($perfnr-1))><x$(($perfnr-1))>42</x$(($perfnr-1))></c$(($perfnr-1))></data></rpc-reply>"
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Invalid pattern of imported type in first module"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c0 xmlns=\"urn:example:mod0\"><s0>ABC</s0></c0></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate invalid pattern"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>s0</bad-element></error-info><error-severity>error</error-severity><error-message>regexp match fail:" ""
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+mid=$(( perfnr / 2 ))
+
+new "Invalid range in middle module"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c$mid xmlns=\"urn:example:mod$mid\"><s$mid>abc</s$mid><x$mid>101</x$mid></c$mid></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate invalid range"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>x$mid</bad-element></error-info><error-severity>error</error-severity><error-message>Number 101 out of range: 1 - 100</error-message></rpc-error></rpc-reply>"
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+new "Syntax error in imported module"
+sed -i -e 's/prefix i1;/prefix i1/' $idir/imp1.yang
+expectpart "$(sudo $clixon_backend -F1s init -f $cfg -l o 2>&1)" 255 "imp1.yang" "syntax error"
+sed -i -e 's/prefix i1$/prefix i1;/' $idir/imp1.yang
+
+new "Statement error in module"
+sed -i -e 's/status current;/status foo;/' $ydir/mod2.yang
+expectpart "$(sudo $clixon_backend -F1s init -f $cfg -l o 2>&1)" 255 "Invalid status: \"foo\", expected current, deprecated, or obsolete"
+sed -i -e 's/status foo;/status current;/' $ydir/mod2.yang
+
+new "Statement error in submodule"
+sed -i -e 's/grouping g3{/revision 20-01-01;\n  grouping g3{/' $idir/sub3.yang
+expectpart "$(sudo $clixon_backend -F1s init -f $cfg -l o 2>&1)" 255 "Revision date 20-01-01, but expected: YYYY-MM-DD"
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,249 @@
+#!/usr/bin/env bash
+# Asynchronous internal rpc, see clicon_rpc_async
+# A client pipelines several get-config requests, each selecting a different list entry,
+# and checks that each reply reaches the callback of its own request.
+# The session also subscribes to a notification stream, notifications on the session must
+# not be paired with a pending request.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of pipelined requests per batch
+: ${nreq:=8}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example.yang
+sdb=$dir/startup_db
+cfile=$dir/async-client.c
+app=$dir/async-client
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DISCOVERY_RFC5277>true</CLICON_STREAM_DISCOVERY_RFC5277>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example {
+  namespace "urn:example:clixon";
+  prefix ex;
+  notification event {
+    leaf event-class {
+      type string;
+    }
+    container reportingEntity {
+      leaf card {
+        type string;
+      }
+    }
+    leaf severity {
+      type string;
+    }
+  }
+  container state {
+    config false;
+    leaf-list op {
+      type string;
+    }
+  }
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+# Batch 1 is sent at once, batch 2 two seconds later when notifications have arrived
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+static int _nreq = $nreq;
+static int _replies = 0;
+static int _batch = 0;
+
+static int send_batch(int s, void *arg);
+
+/*! Reply to get-config of entry p<i>, where i is arg
+ */
+static int
+reply_cb(clixon_handle h,
+         cxobj        *xret,
+         void         *arg)
+{
+    int            i = (int)(intptr_t)arg;
+    cxobj         *x;
+    char           name[32];
+    struct timeval t;
+
+    snprintf(name, sizeof(name), "p%d", i);
+    if (xret == NULL)
+        printf("%d: no reply\n", i);
+    else if ((x = xpath_first(xret, NULL, "//parameter/name")) == NULL ||
+             strcmp(xml_body(x), name) != 0)
+        printf("%d: mismatch\n", i);
+    else
+        _replies++;
+    if (clicon_rpc_async_pending(h) == 0){
+        printf("batch %d: %d replies\n", _batch, _replies);
+        if (_batch == 1){
+            gettimeofday(&t, NULL);
+            t.tv_sec += 2;
+            if (clixon_event_reg_timeout(t, send_batch, h, "batch 2") < 0)
+                return -1;
+        }
+        else
+            clixon_exit_set(1);
+    }
+    return 0;
+}
+
+/*! Reply to create-subscription
+ */
+static int
+subscribe_cb(clixon_handle h,
+             cxobj        *xret,
+             void         *arg)
+{
+    if (xret == NULL || xpath_first(xret, NULL, "//ok") == NULL)
+        printf("subscription failed\n");
+    return 0;
+}
+
+/*! Send pipelined get-config requests without waiting for replies
+ */
+static int
+send_batch(int   s,
+           void *arg)
+{
+    clixon_handle h = (clixon_handle)arg;
+    char          rpc[256];
+    int           i;
+
+    _batch++;
+    _replies = 0;
+    for (i=0; i<_nreq; i++){
+        snprintf(rpc, sizeof(rpc), "<get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='p%d']\" xmlns:ex=\"urn:example:clixon\"/></get-config>", i);
+        if (clicon_rpc_async(h, rpc, reply_cb, (void*)(intptr_t)i, NULL) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Give up if replies do not arrive
+ */
+static int
+timeout_cb(int   s,
+           void *arg)
+{
+    printf("timeout\n");
+    clixon_exit_set(1);
+    return 0;
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int            retval = -1;
+    clixon_handle  h;
+    struct timeval t;
+
+    if (argc != 2){
+        fprintf(stderr, "usage: %s <cfg>\n", argv[0]);
+        return -1;
+    }
+    if ((h = clixon_client_init(argv[1])) == NULL)
+        return -1;
+    if (clicon_rpc_async(h, "<create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream></create-subscription>",
+                         subscribe_cb, NULL, NULL) < 0)
+        goto done;
+    if (send_batch(0, h) < 0)
+        goto done;
+    gettimeofday(&t, NULL);
+    t.tv_sec += 10;
+    if (clixon_event_reg_timeout(t, timeout_cb, NULL, "timeout") < 0)
+        goto done;
+    if (clixon_event_loop(h) < 0)
+        goto done;
+    retval = 0;
+ done:
+    clicon_rpc_async_close(h);
+    clixon_client_terminate(h);
+    return retval;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+new "generate startup config"
+echo -n "<config><table xmlns=\"urn:example:clixon\">" > $sdb
+for (( i=0; i<$nreq; i++ )); do
+    echo -n "<parameter><name>p$i</name><value>$i</value></parameter>" >> $sdb
+done
+echo "</table></config>" >> $sdb
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg -- -n 1"
+    start_backend -s startup -f $cfg -- -n 1 # notification every second
+fi
+
+new "wait backend"
+wait_backend
+
+new "pipelined async rpcs, each reply to its own callback"
+expectpart "$(sudo $app $cfg)" 0 "batch 1: $nreq replies" "batch 2: $nreq replies" --not-- "mismatch" "no reply" "subscription failed" "timeout"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
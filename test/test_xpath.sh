@@ -206,6 +206,19 @@ expectpart "$($clixon_util_xpath -D $DBG -f $xml -p //bbb[0])" 0 "^nodeset:0:<bb
 new "xpath //bbb[ccc=99]"
 expectpart "$($clixon_util_xpath -D $DBG -f $xml -p //bbb[ccc=99])" 0 "^nodeset:0:<bbb x=\"bye\"><ccc>99</ccc></bbb>$"
 
+# Compiled location paths, see XPATH_COMPILE
+new "xpath /aaa/bbb[ccc='42']/ccc"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -p "/aaa/bbb[ccc='42']/ccc")" 0 "^nodeset:0:<ccc>42</ccc>$"
+
+new "xpath /aaa/*[ccc=22 and ccc='22']"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -p "/aaa/*[ccc=22 and ccc='22']")" 0 "^nodeset:0:<ddd><ccc>22</ccc></ddd>$"
+
+new "xpath /aaa/bbb/ccc[.='99']/.."
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -p "/aaa/bbb/ccc[.='99']/..")" 0 "^nodeset:0:<bbb x=\"bye\"><ccc>99</ccc></bbb>$"
+
+new "xpath /aaa/bbb[ccc='42'][ccc=99]"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -p "/aaa/bbb[ccc='42'][ccc=99]")" 0 "^nodeset:$"
+
 new "Negative: xpath [x=] on a variable that has no body"
 expectpart "$($clixon_util_xpath -D $DBG -f $xml -p "/aaa[bbb='a']")" 0 "nodeset:"
 
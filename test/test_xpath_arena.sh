@@ -0,0 +1,127 @@
+#!/usr/bin/env bash
+# XPath context pool and nodeset growth, see XPATH_ARENA and ctx_arena_stats
+# Compile a program that evaluates xpaths on a list with many entries and checks results and
+# allocation counts of each evaluation:
+# 1. A large nodeset is complete and in document order, and is grown geometrically
+# 2. A predicate with a nested absolute path reuses pooled contexts for every entry
+# 3. Counters are reset by the next evaluation
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${nr:=1000}
+
+cfile=$dir/xpath-arena.c
+app=$dir/xpath-arena
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <syslog.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+static int _nr = $nr;
+
+/*! Print allocation counters of last XPath evaluation
+ */
+static void
+stats_print(const char *label)
+{
+    uint64_t allocs;
+    uint64_t reuses;
+    uint64_t vecallocs;
+
+    ctx_arena_stats(&allocs, &reuses, &vecallocs);
+    printf("%s: allocs %llu reuses %llu nodeset allocs %llu\n", label,
+           (unsigned long long)allocs, (unsigned long long)reuses, (unsigned long long)vecallocs);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int       retval = -1;
+    cbuf     *cb = NULL;
+    cxobj    *xt = NULL;
+    cxobj    *x;
+    cxobj   **vec = NULL;
+    size_t    veclen;
+    uint64_t  allocs;
+    uint64_t  reuses;
+    uint64_t  vecallocs;
+    char      k[32];
+    int       ret;
+    int       i;
+
+    if ((cb = cbuf_new()) == NULL)
+        goto done;
+    cprintf(cb, "<a><c>%d</c>", _nr/2);
+    for (i=0; i<_nr; i++)
+        cprintf(cb, "<b><k>%d</k></b>", i);
+    cprintf(cb, "</a>");
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xt, NULL) < 0)
+        goto done;
+    /* 1. All entries, the predicate is not compiled and evaluated per node by xp_eval */
+    if (xpath_vec(xt, NULL, "/a/b[not(k='x')]", &vec, &veclen) < 0)
+        goto done;
+    ctx_arena_stats(&allocs, &reuses, &vecallocs);
+    for (i=0; i<veclen; i++){
+        snprintf(k, sizeof(k), "%d", i);
+        if ((x = xml_find_type(vec[i], NULL, "k", CX_ELMNT)) == NULL ||
+            strcmp(xml_body(x), k) != 0)
+            break;
+    }
+    if (veclen == _nr && i == _nr)
+        printf("nodeset: %zu in order\n", veclen);
+    else
+        printf("fail: nodeset %zu, order breaks at %d\n", veclen, i);
+    /* One reallocation per node without geometric growth */
+    if (vecallocs >= 64)
+        stats_print("fail: nodeset growth");
+    /* 2. Entries up to the match evaluate a nested absolute path in their predicate */
+    if ((x = xpath_first(xt, NULL, "/a/b[k=/a/c]/k")) == NULL)
+        printf("fail: no first\n");
+    else
+        printf("first: %s\n", xml_body(x));
+    ctx_arena_stats(&allocs, &reuses, &vecallocs);
+    if (reuses < _nr/2 || allocs >= 64)
+        stats_print("fail: pool");
+    /* 3. Counters are of the last evaluation only */
+    if ((ret = xpath_vec_bool(xt, NULL, "count(/a/b)=%d", _nr)) < 0)
+        goto done;
+    printf("count: %d\n", ret);
+    ctx_arena_stats(&allocs, &reuses, &vecallocs);
+    if (reuses >= _nr)
+        stats_print("fail: not reset");
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    if (xt)
+        xml_free(xt);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+new "xpath nodeset growth and context pool with $nr entries"
+expectpart "$($app)" 0 "^nodeset: $nr in order$" "^first: $((nr/2))$" "^count: 1$" --not-- "fail"
+
+rm -rf $dir
+
+new "endtest"
+endtest
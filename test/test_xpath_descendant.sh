@@ -0,0 +1,130 @@
+#!/usr/bin/env bash
+# XPath descendant searches (//) with YANG, see XPATH_DESCENDANT_PRUNE
+# Check that subtrees that cannot contain a name are skipped but that names reachable via
+# choice, uses, augment and anydata are found
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_xpath:=clixon_util_xpath}
+
+xml=$dir/xml.xml
+fyang=$dir/a.yang
+fyang2=$dir/b.yang
+
+cat <<EOF > $fyang
+module a{
+  namespace "urn:example:a";
+  prefix a;
+  grouping g{
+    container gc{
+      leaf name{
+        type string;
+      }
+    }
+  }
+  container top{
+    container c1{
+      list l{
+        key name;
+        leaf name{
+          type string;
+        }
+        leaf other{
+          type string;
+        }
+      }
+    }
+    container c2{
+      choice ch{
+        case ca{
+          container cc{
+            leaf name{
+              type string;
+            }
+          }
+        }
+      }
+    }
+    container c3{
+      uses g;
+    }
+    container c4{
+      leaf other{
+        type string;
+      }
+    }
+    container c5{
+      anydata any;
+    }
+  }
+}
+EOF
+
+cat <<EOF > $fyang2
+module b{
+  namespace "urn:example:b";
+  prefix b;
+  import a {
+    prefix a;
+  }
+  augment "/a:top/a:c4" {
+    container aug{
+      leaf name{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $xml
+<top xmlns="urn:example:a">
+  <c1>
+    <l><name>n1</name><other>o1</other></l>
+    <l><name>n2</name><other>o2</other></l>
+  </c1>
+  <c2><cc><name>n3</name></cc></c2>
+  <c3><gc><name>n4</name></gc></c3>
+  <c4><other>o3</other><aug xmlns="urn:example:b"><name>n5</name></aug></c4>
+  <c5><any><name>n6</name></any></c5>
+</top>
+EOF
+
+new "xpath //name"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $dir -l o -p "//name")" 0 "^nodeset:0:<name>n1</name>1:<name>n2</name>2:<name>n3</name>3:<name>n4</name>4:<name>n5</name>5:<name>n6</name>$"
+
+new "xpath //other"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $dir -l o -p "//other")" 0 "^nodeset:0:<other>o1</other>1:<other>o2</other>2:<other>o3</other>$"
+
+new "xpath //l[name='n2']/other"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $dir -l o -p "//l[name='n2']/other")" 0 "^nodeset:0:<other>o2</other>$"
+
+new "xpath /top/c4//name"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $dir -l o -p "/top/c4//name")" 0 "^nodeset:0:<name>n5</name>$"
+
+new "xpath //nonexist"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $dir -l o -p "//nonexist")" 0 "^nodeset:$"
+
+new "xpath count(//name)"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $dir -p "count(//name)")" 0 "^number:6$"
+
+new "xpath boolean(//nonexist)"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $dir -p "boolean(//nonexist)")" 0 "^bool:false$"
+
+new "xpath //c2//name via choice"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $dir -l o -p "//c2//name")" 0 "^nodeset:0:<name>n3</name>$"
+
+new "xpath //c5//name via anydata"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $dir -l o -p "//c5//name")" 0 "^nodeset:0:<name>n6</name>$"
+
+new "xpath /top/c1//other, name not in other subtrees"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $dir -l o -p "/top/c1//other")" 0 "^nodeset:0:<other>o1</other>1:<other>o2</other>$"
+
+new "xpath .//name from /top/c3 via uses"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $dir -l o -p ".//name" -i /top/c3)" 0 "^nodeset:0:<name>n4</name>$"
+
+rm -rf $dir
+
+new "endtest"
+endtest
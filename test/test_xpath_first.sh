@@ -0,0 +1,131 @@
+#!/usr/bin/env bash
+# XPath evaluation that stops at the first match in xpath_first and xpath_vec_bool
+# Compile a program that evaluates xpaths with xpath_first and xpath_vec_bool and compares
+# with the first node and size of the full nodeset of xpath_vec.
+# Positional predicates and function arguments must see the full nodeset.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+cfile=$dir/xpath-first.c
+app=$dir/xpath-first
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <syslog.h>
+
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+static const char *_xml =
+    "<a>"
+    "<b><k>1</k><c>x</c></b>"
+    "<b><k>2</k><c>y</c><c>z</c></b>"
+    "<b><k>3</k></b>"
+    "<d><b><k>4</k></b></d>"
+    "</a>";
+
+/* xpath and expected body of first node, or NULL if no match
+ * Note positions in predicates start at 0 */
+static const char *_first[][2] = {
+    {"/a/b/k",                  "1"},
+    {"/a/b/c",                  "x"},
+    {"/a/b[1]/k",               "2"},
+    {"/a/b[2]/k",               "3"},
+    {"/a/b[position()>0]/k",    "2"},
+    {"/a/b[not(k='1')]/k",      "2"},
+    {"/a/b[c][1]/k",            "2"},
+    {"/a/b[c='z']/k",           "2"},
+    {"//k",                     "1"},
+    {"//b[k=4]/k",              "4"},
+    {"/a/d//k",                 "4"},
+    {"/a/b[k=5]/k",             NULL},
+    {"/a/b[3]/k",               NULL},
+    {NULL,                      NULL}
+};
+
+/* xpath and expected boolean value */
+static const char *_bool[][2] = {
+    {"/a/b",                    "1"},
+    {"/a/b[k=3]",               "1"},
+    {"/a/b[k=5]",               "0"},
+    {"/a/b[2]",                 "1"},
+    {"/a/b[3]",                 "0"},
+    {"count(/a/b)=3",           "1"},
+    {"count(//k)=4",            "1"},
+    {"not(/a/e)",               "1"},
+    {"/a/b[c='z'] and /a/d",    "1"},
+    {"/a/e or /a/d/b",          "1"},
+    {NULL,                      NULL}
+};
+
+int
+main(int    argc,
+     char **argv)
+{
+    int     retval = -1;
+    cxobj  *xt = NULL;
+    cxobj  *x;
+    cxobj **vec = NULL;
+    size_t  veclen;
+    char   *body;
+    int     ret;
+    int     i;
+    int     nr = 0;
+
+    if (clixon_xml_parse_string(_xml, YB_NONE, NULL, &xt, NULL) < 0)
+        goto done;
+    for (i=0; _first[i][0]; i++){
+        x = xpath_first(xt, NULL, "%s", _first[i][0]);
+        body = x ? xml_body(x) : NULL;
+        if ((body == NULL) != (_first[i][1] == NULL) ||
+            (body && strcmp(body, _first[i][1]) != 0))
+            printf("fail: %s: %s expected %s\n", _first[i][0], body?body:"NULL",
+                   _first[i][1]?_first[i][1]:"NULL");
+        /* Same as first node of full nodeset */
+        if (xpath_vec(xt, NULL, "%s", &vec, &veclen, _first[i][0]) < 0)
+            goto done;
+        if ((veclen ? vec[0] : NULL) != x)
+            printf("fail: %s: xpath_vec differs\n", _first[i][0]);
+        if (vec){
+            free(vec);
+            vec = NULL;
+        }
+        nr++;
+    }
+    for (i=0; _bool[i][0]; i++){
+        if ((ret = xpath_vec_bool(xt, NULL, "%s", _bool[i][0])) < 0)
+            goto done;
+        if (ret != atoi(_bool[i][1]))
+            printf("fail: %s: %d expected %s\n", _bool[i][0], ret, _bool[i][1]);
+        nr++;
+    }
+    printf("%d done\n", nr);
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    if (xt)
+        xml_free(xt);
+    return retval;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon -lcligen"
+fi
+expectpart "$($COMPILE)" 0 ""
+
+new "xpath_first and xpath_vec_bool same as full evaluation"
+expectpart "$($app)" 0 "^23 done$" --not-- "fail"
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,112 @@
+#!/usr/bin/env bash
+# XPath list optimization using binary search, see XPATH_LIST_OPTIMIZE
+# Check that optimized lookups give the same results as regular evaluation for:
+# - multiple keys in any order, also using "and"
+# - explicit search index on non-key leaf
+# - leaf-list values
+# - chains of list steps
+# - additional non-key predicates
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_xpath:=clixon_util_xpath -Y /usr/local/share/clixon}
+
+xml=$dir/xml.xml
+ydir=$dir/yang
+
+if [ ! -d $ydir ]; then
+    mkdir $ydir
+fi
+
+cat <<EOF > $ydir/moda.yang
+module moda{
+  namespace "urn:example:a";
+  prefix a;
+  import clixon-config {
+    prefix "cc";
+  }
+  container x{
+    list y{
+      key "k1 k2";
+      leaf k1{
+        type string;
+      }
+      leaf k2{
+        type string;
+      }
+      leaf i{
+        description "explicit index variable";
+        type string;
+        cc:search_index;
+      }
+      leaf j{
+        type string;
+      }
+      list z{
+        key kz;
+        leaf kz{
+          type string;
+        }
+        leaf v{
+          type string;
+        }
+      }
+    }
+    leaf-list ll{
+      type string;
+    }
+  }
+}
+EOF
+
+cat <<EOF > $xml
+<x xmlns="urn:example:a">
+  <y><k1>a</k1><k2>1</k2><i>i1</i><j>j1</j><z><kz>p</kz><v>v1</v></z><z><kz>q</kz><v>v2</v></z></y>
+  <y><k1>a</k1><k2>2</k2><i>i2</i><j>j2</j><z><kz>p</kz><v>v3</v></z></y>
+  <y><k1>b</k1><k2>1</k2><i>i3</i><j>j1</j><z><kz>q</kz><v>v4</v></z></y>
+  <ll>foo</ll>
+  <ll>bar</ll>
+</x>
+EOF
+
+new "xpath keys in order"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $ydir/moda.yang -n a:urn:example:a -p "/a:x/a:y[a:k1='a'][a:k2='2']/a:j")" 0 "^nodeset:0:<j>j2</j>$"
+
+new "xpath keys in reverse order"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $ydir/moda.yang -n a:urn:example:a -p "/a:x/a:y[a:k2='1'][a:k1='b']/a:j")" 0 "^nodeset:0:<j>j1</j>$"
+
+new "xpath keys using and"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $ydir/moda.yang -n a:urn:example:a -p "/a:x/a:y[a:k2='1' and a:k1='a']/a:i")" 0 "^nodeset:0:<i>i1</i>$"
+
+new "xpath keys and non-key predicate match"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $ydir/moda.yang -n a:urn:example:a -p "/a:x/a:y[a:j='j1'][a:k1='b'][a:k2='1']/a:i")" 0 "^nodeset:0:<i>i3</i>$"
+
+new "xpath keys and non-key predicate no match"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $ydir/moda.yang -n a:urn:example:a -p "/a:x/a:y[a:j='j2'][a:k1='b'][a:k2='1']/a:i")" 0 "^nodeset:$"
+
+new "xpath partial keys"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $ydir/moda.yang -n a:urn:example:a -p "/a:x/a:y[a:k1='a']/a:i")" 0 "^nodeset:0:<i>i1</i>1:<i>i2</i>$"
+
+new "xpath explicit index"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $ydir/moda.yang -n a:urn:example:a -p "/a:x/a:y[a:i='i2']/a:k2")" 0 "^nodeset:0:<k2>2</k2>$"
+
+new "xpath non-index leaf"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $ydir/moda.yang -n a:urn:example:a -p "/a:x/a:y[a:j='j1']/a:i")" 0 "^nodeset:0:<i>i1</i>1:<i>i3</i>$"
+
+new "xpath leaf-list value"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $ydir/moda.yang -n a:urn:example:a -p "/a:x/a:ll[.='bar']")" 0 "^nodeset:0:<ll>bar</ll>$"
+
+new "xpath leaf-list no value"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $ydir/moda.yang -n a:urn:example:a -p "/a:x/a:ll[.='baz']")" 0 "^nodeset:$"
+
+new "xpath chain of list steps"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $ydir/moda.yang -n a:urn:example:a -p "/a:x/a:y[a:k1='a'][a:k2='1']/a:z[a:kz='q']/a:v")" 0 "^nodeset:0:<v>v2</v>$"
+
+new "xpath inner list from several list entries"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml -y $ydir/moda.yang -n a:urn:example:a -p "/a:x/a:y/a:z[a:kz='p']/a:v")" 0 "^nodeset:0:<v>v1</v>1:<v>v3</v>$"
+
+rm -rf $dir
+
+new "endtest"
+endtest